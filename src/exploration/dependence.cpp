@@ -0,0 +1,169 @@
+#include "dependence.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+
+
+namespace exploration {
+
+using namespace program_model;
+
+//--------------------------------------------------------------------------------------------------
+
+namespace {
+
+bool writes(const memory_instruction& instr)
+{
+   return instr.operation() != memory_operation::Load;
+}
+
+/// @brief Whether instr joins thread tid.
+
+bool joins(const visible_instruction_t& instr, const Thread::tid_t tid)
+{
+   const auto* thread_instr = boost::get<thread_management_instruction>(&instr);
+   return thread_instr && thread_instr->operation() == thread_management_operation::Join &&
+          thread_instr->operand().tid() == tid;
+}
+
+void join_clock(std::vector<std::size_t>& clock, const std::vector<std::size_t>& other)
+{
+   if (clock.size() < other.size())
+      clock.resize(other.size(), 0);
+   std::transform(other.begin(), other.end(), clock.begin(), clock.begin(),
+                  [](const auto lhs, const auto rhs) { return std::max(lhs, rhs); });
+}
+
+} // end namespace
+
+//--------------------------------------------------------------------------------------------------
+
+bool dependent(const visible_instruction_t& a, const visible_instruction_t& b)
+{
+   const auto tid_a = boost::apply_visitor(get_tid(), a);
+   const auto tid_b = boost::apply_visitor(get_tid(), b);
+   if (tid_a == tid_b)
+      return false;
+
+   if (const auto* memory_a = boost::get<memory_instruction>(&a))
+   {
+      const auto* memory_b = boost::get<memory_instruction>(&b);
+      return memory_b && memory_a->operand() == memory_b->operand() &&
+             (writes(*memory_a) || writes(*memory_b));
+   }
+   if (const auto* lock_a = boost::get<lock_instruction>(&a))
+   {
+      const auto* lock_b = boost::get<lock_instruction>(&b);
+      return lock_b && lock_a->operand() == lock_b->operand();
+   }
+   const auto* thread_b = boost::get<thread_management_instruction>(&b);
+   if (thread_b && thread_b->operation() == thread_management_operation::Spawn &&
+       boost::get<thread_management_instruction>(a).operation() ==
+          thread_management_operation::Spawn)
+   {
+      return true;
+   }
+   return joins(a, tid_b) || joins(b, tid_a);
+}
+
+//--------------------------------------------------------------------------------------------------
+// happens_before
+//--------------------------------------------------------------------------------------------------
+
+happens_before::happens_before(const Execution& E)
+: m_order(E)
+, m_predecessors()
+, m_previous()
+, m_thread_position()
+, m_clocks()
+{
+   std::vector<boost::optional<step_t>> last_steps;
+   std::unordered_map<tid_t, step_t> spawns;
+   step_t step = 0;
+   for (const auto& transition : E)
+   {
+      const auto tid = m_order[step].tid;
+      if (static_cast<std::size_t>(tid) >= last_steps.size())
+         last_steps.resize(tid + 1);
+      const auto previous = last_steps[tid];
+
+      auto predecessors = m_order[step].predecessors;
+      if (!previous)
+      {
+         const auto spawn = spawns.find(tid);
+         if (spawn != spawns.end())
+            predecessors.push_back(spawn->second);
+      }
+      const auto* thread_instr = boost::get<thread_management_instruction>(&transition.instr());
+      if (thread_instr)
+      {
+         const auto operand = thread_instr->operand().tid();
+         if (thread_instr->operation() == thread_management_operation::Spawn)
+         {
+            spawns[operand] = step;
+         }
+         else if (static_cast<std::size_t>(operand) < last_steps.size() && last_steps[operand])
+         {
+            predecessors.push_back(*last_steps[operand]);
+         }
+      }
+
+      std::vector<std::size_t> clock;
+      if (previous)
+         clock = m_clocks[*previous];
+      for (const auto predecessor : predecessors)
+         join_clock(clock, m_clocks[predecessor]);
+      if (clock.size() <= static_cast<std::size_t>(tid))
+         clock.resize(tid + 1, 0);
+      clock[tid] = previous ? m_thread_position[*previous] + 1 : 1;
+
+      m_thread_position.push_back(clock[tid]);
+      m_clocks.push_back(std::move(clock));
+      m_predecessors.push_back(std::move(predecessors));
+      m_previous.push_back(previous);
+      last_steps[tid] = step++;
+   }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::size_t happens_before::size() const
+{
+   return m_clocks.size();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+happens_before::tid_t happens_before::tid(const step_t step) const
+{
+   return m_order[step].tid;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool happens_before::operator()(const step_t i, const step_t j) const
+{
+   if (i >= j)
+      return false;
+   const auto& clock = m_clocks[j];
+   const auto tid_i = static_cast<std::size_t>(tid(i));
+   return tid_i < clock.size() && clock[tid_i] >= m_thread_position[i];
+}
+
+//--------------------------------------------------------------------------------------------------
+
+const std::vector<happens_before::step_t>& happens_before::predecessors(const step_t step) const
+{
+   return m_predecessors[step];
+}
+
+//--------------------------------------------------------------------------------------------------
+
+boost::optional<happens_before::step_t> happens_before::previous(const step_t step) const
+{
+   return m_previous[step];
+}
+
+//--------------------------------------------------------------------------------------------------
+
+} // end namespace exploration
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <partial_order.hpp>
+
+#include <execution.hpp>
+#include <visible_instruction.hpp>
+
+#include <boost/optional.hpp>
+
+#include <cstddef>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------
+/// @file dependence.hpp
+/// @brief The dependence and happens-before relations between the steps of an Execution.
+/// @author Susanne van den Elsen
+/// @date 2015-2017
+//--------------------------------------------------------------------------------------------------
+
+
+namespace exploration {
+
+/// @brief Whether a and b, instructions of different threads, are dependent, i.e. executing them
+/// in the other order may lead to a different State.
+/// @details a and b are dependent if
+/// - they operate on the same object and one of them writes it (Store or ReadModifyWrite), or
+/// - both are lock operations on the same object, or
+/// - both are spawns (spawns determine the tids of the new threads), or
+/// - one of them joins the thread of the other.
+
+bool dependent(const program_model::visible_instruction_t& a,
+               const program_model::visible_instruction_t& b);
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief The happens-before relation between the steps of an Execution, as vector clocks.
+/// @details Extends the partial_order of the Execution with the order of a spawn before the
+/// steps of the new thread, and of the steps of a thread before a join of it.
+
+class happens_before
+{
+public:
+   using tid_t = program_model::Thread::tid_t;
+   /// @brief The index of a Transition in the Execution, starting at 0.
+   using step_t = scheduler::partial_order::step_t;
+
+   explicit happens_before(const program_model::Execution& E);
+
+   std::size_t size() const;
+
+   tid_t tid(const step_t step) const;
+
+   /// @brief Whether step i happens before step j.
+   /// @note Irreflexive: no step happens before itself.
+
+   bool operator()(const step_t i, const step_t j) const;
+
+   /// @brief The direct predecessors of step in other threads.
+
+   const std::vector<step_t>& predecessors(const step_t step) const;
+
+   /// @brief The previous step of the thread of step.
+
+   boost::optional<step_t> previous(const step_t step) const;
+
+private:
+   scheduler::partial_order m_order;
+   std::vector<std::vector<step_t>> m_predecessors;
+   std::vector<boost::optional<step_t>> m_previous;
+
+   /// @brief Per step, the number of steps of its thread up to and including it.
+   std::vector<std::size_t> m_thread_position;
+
+   /// @brief Per step, per tid, the number of steps of that thread that happen before it or are
+   /// the step itself.
+   std::vector<std::vector<std::size_t>> m_clocks;
+
+}; // end class happens_before
+
+} // end namespace exploration
@@ -0,0 +1,224 @@
+#include "preemption_bounding.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+
+namespace exploration {
+
+using namespace program_model;
+
+//--------------------------------------------------------------------------------------------------
+
+namespace {
+
+/// @brief The first length steps of schedule.
+
+scheduler::schedule_t truncate(const scheduler::schedule_t& schedule, std::size_t length)
+{
+   scheduler::schedule_t prefix;
+   for (auto run = schedule.begin(); run != schedule.end() && length > 0; ++run)
+   {
+      const auto run_length = std::min(run->length, length);
+      prefix.push_back(run->tid, run_length);
+      length -= run_length;
+   }
+   return prefix;
+}
+
+/// @brief The key of a State in the visited set: switching away from the previous thread
+/// preempts it or not, so the schedules from the State depend on it.
+
+scheduler::fingerprint_t visited_key(const scheduler::fingerprint_t state,
+                                     const boost::optional<Thread::tid_t>& previous)
+{
+   return state ^ (0x9e3779b97f4a7c15ull * static_cast<scheduler::fingerprint_t>(
+                                              previous ? *previous + 1 : 0));
+}
+
+} // end namespace
+
+//--------------------------------------------------------------------------------------------------
+
+preemption_bounding::preemption_bounding(const unsigned int max_preemptions)
+: m_pending(max_preemptions + 1)
+, m_current()
+, m_preemptions(0)
+, m_statistics(max_preemptions + 1)
+, m_visited()
+{
+   m_pending[0].emplace_back();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+boost::optional<scheduler::schedule_t> preemption_bounding::next_schedule()
+{
+   if (m_current)
+      throw std::logic_error(
+         "preemption_bounding: the Execution of the last schedule was not added");
+   for (unsigned int preemptions = 0; preemptions < m_pending.size(); ++preemptions)
+   {
+      auto& pending = m_pending[preemptions];
+      if (pending.empty())
+      {
+         m_statistics[preemptions].complete = true;
+         continue;
+      }
+      m_current = std::move(pending.back());
+      pending.pop_back();
+      m_preemptions = preemptions;
+      return m_current;
+   }
+   return boost::none;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void preemption_bounding::add_execution(const Execution& E)
+{
+   add_execution(E, nullptr);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void preemption_bounding::add_execution(const Execution& E,
+                                        const std::vector<scheduler::fingerprint_t>& states)
+{
+   if (states.size() < E.size())
+      throw std::invalid_argument("preemption_bounding: fewer State fingerprints than steps");
+   add_execution(E, &states);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void preemption_bounding::add_execution(const Execution& E,
+                                        const std::vector<scheduler::fingerprint_t>* states)
+{
+   if (!m_current)
+      throw std::logic_error("preemption_bounding: add_execution without a schedule");
+   auto& statistics = m_statistics[m_preemptions];
+   prune_t prune;
+   if (states)
+   {
+      prune = [this, &statistics, states](const std::size_t step, const unsigned int preemptions,
+                                          const boost::optional<tid_t>& previous) {
+         // The schedules from a State reached with as few preemptions are explored already
+         const auto visited =
+            m_visited.emplace(visited_key((*states)[step], previous), preemptions);
+         if (!visited.second && visited.first->second <= preemptions)
+         {
+            ++statistics.nr_pruned;
+            return true;
+         }
+         visited.first->second = preemptions;
+         return false;
+      };
+   }
+   auto new_branches = branches(E, *m_current, m_pending.size() - 1, prune);
+   m_current = boost::none;
+   ++statistics.nr_executions;
+   for (auto& branch : new_branches)
+      m_pending[branch.preemptions].push_back(std::move(branch.prefix));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+unsigned int preemption_bounding::preemptions() const
+{
+   return m_preemptions;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+const std::vector<bound_statistics_t>& preemption_bounding::statistics() const
+{
+   return m_statistics;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::vector<branch_t> branches(const Execution& E, const scheduler::schedule_t& prefix,
+                               const unsigned int max_preemptions, const prune_t& prune)
+{
+   using tid_t = Thread::tid_t;
+
+   if (!E.initialized())
+      throw std::invalid_argument("preemption_bounding: the Execution has no States");
+   const auto schedule = scheduler::schedule(E);
+   if (truncate(schedule, prefix.size()) != prefix)
+   {
+      throw std::invalid_argument(
+         "preemption_bounding: the Execution does not follow the schedule");
+   }
+
+   std::vector<branch_t> result;
+   unsigned int preemptions = 0;
+   boost::optional<tid_t> previous;
+   for (std::size_t step = 0; step < E.size(); ++step)
+   {
+      const auto tid = schedule.at(step);
+      const auto& enabled = E[step + 1].pre().enabled();
+      // A switch away from the previous thread preempts it if it could have run on
+      const bool can_preempt = previous && enabled.count(*previous) > 0;
+      if (step >= prefix.size())
+      {
+         if (prune && prune(step, preemptions, previous))
+            break;
+         for (const auto other : enabled)
+         {
+            if (other == tid)
+               continue;
+            const auto branch_preemptions =
+               preemptions + (can_preempt && other != *previous ? 1 : 0);
+            if (branch_preemptions > max_preemptions)
+               continue;
+            auto branch = truncate(schedule, step);
+            branch.push_back(other);
+            result.push_back({std::move(branch), branch_preemptions});
+         }
+      }
+      if (can_preempt && tid != *previous)
+         ++preemptions;
+      previous = tid;
+   }
+   return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::vector<bound_statistics_t> explore_preemption_bounded(const run_t& run,
+                                                           const unsigned int max_preemptions,
+                                                           const on_execution_t& on_execution)
+{
+   preemption_bounding search(max_preemptions);
+   while (const auto schedule = search.next_schedule())
+   {
+      const auto E = run(*schedule);
+      search.add_execution(E);
+      if (!on_execution(E))
+         break;
+   }
+   return search.statistics();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::vector<bound_statistics_t> explore_preemption_bounded(const stateful_run_t& run,
+                                                           const unsigned int max_preemptions,
+                                                           const on_execution_t& on_execution)
+{
+   preemption_bounding search(max_preemptions);
+   while (const auto schedule = search.next_schedule())
+   {
+      const auto recorded = run(*schedule);
+      search.add_execution(recorded.execution, recorded.states);
+      if (!on_execution(recorded.execution))
+         break;
+   }
+   return search.statistics();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+} // end namespace exploration
@@ -0,0 +1,151 @@
+#pragma once
+
+#include "run.hpp"
+
+#include <schedule.hpp>
+
+#include <execution.hpp>
+
+#include <boost/optional.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------
+/// @file preemption_bounding.hpp
+/// @brief Exhaustive exploration of the schedules of a program with at most a given number of
+/// preemptions, in order of their number of preemptions.
+/// @author Susanne van den Elsen
+/// @date 2015-2017
+//--------------------------------------------------------------------------------------------------
+///
+/// A preemption is a step of another thread than the one of the previous step while the latter
+/// is still enabled (Musuvathi and Qadeer, "Iterative Context Bounding for Systematic Testing of
+/// Multithreaded Programs", PLDI 2007). Switching from a thread that blocked or finished is free.
+/// The number of schedules with at most k preemptions is polynomial in the length of the
+/// Executions, and most concurrency bugs need few of them.
+///
+/// Every run is replayed by the Scheduler up to its last scheduled step, after which the
+/// strategy of the Scheduler completes it. The strategy has to be NonPreemptive, so that the
+/// completion adds no preemptions. Each step of the completion that has other enabled threads
+/// in its pre-State branches into the prefixes that schedule one of those instead; a prefix
+/// runs once every prefix with fewer preemptions ran. The runs have to be recorded with their
+/// States, i.e. not in lightweight record mode.
+///
+/// Given the fingerprints of the States of the runs, the exploration is stateful: a run stops
+/// branching at the first State of its completion that an earlier completion reached with the
+/// same previous thread and at most as many preemptions, as the schedules from there are
+/// explored already. The fingerprints leave out the values in memory, so two States that only
+/// differ in those count as the same, and a bug that depends on them may be missed.
+
+
+namespace exploration {
+
+struct bound_statistics_t
+{
+   /// @brief The number of Executions with exactly this number of preemptions.
+   std::size_t nr_executions = 0;
+   /// @brief Whether every schedule with at most this number of preemptions was run.
+   bool complete = false;
+   /// @brief The number of those Executions that stopped branching at a visited State.
+   std::size_t nr_pruned = 0;
+};
+
+//--------------------------------------------------------------------------------------------------
+
+struct branch_t
+{
+   scheduler::schedule_t prefix;
+   unsigned int preemptions;
+};
+
+/// @brief Whether to stop branching at a step, given its number of preemptions before it and the
+/// thread of the step before it.
+
+using prune_t = std::function<bool(const std::size_t step, const unsigned int preemptions,
+                                   const boost::optional<program_model::Thread::tid_t>& previous)>;
+
+/// @brief The branches off E at its steps from the end of prefix on: the schedule of E up to the
+/// step followed by another thread that is enabled in its pre-State, with at most
+/// max_preemptions preemptions.
+/// @param prune If given, stops the branching at the first step for which it returns true.
+/// @throws std::invalid_argument if E was recorded without States or does not follow prefix.
+
+std::vector<branch_t> branches(const program_model::Execution& E,
+                               const scheduler::schedule_t& prefix,
+                               const unsigned int max_preemptions, const prune_t& prune = nullptr);
+
+//--------------------------------------------------------------------------------------------------
+
+class preemption_bounding
+{
+public:
+   using tid_t = program_model::Thread::tid_t;
+
+   explicit preemption_bounding(const unsigned int max_preemptions);
+
+   /// @brief The schedule of the next run, starting with the empty schedule.
+   /// @returns boost::none once every schedule with at most max_preemptions preemptions has
+   /// been run.
+   /// @throws std::logic_error if the Execution of the previous schedule was not added.
+
+   boost::optional<scheduler::schedule_t> next_schedule();
+
+   /// @brief Adds the prefixes that branch off the Execution of the run under the last schedule.
+   /// @throws std::invalid_argument if E was recorded without States or does not follow the
+   /// schedule.
+
+   void add_execution(const program_model::Execution& E);
+
+   /// @brief As above, skipping the branches from the States that were visited before.
+   /// @param states The fingerprints of the States of E, see recorded_run_t.
+   /// @throws std::invalid_argument if there are fewer fingerprints than steps in E.
+
+   void add_execution(const program_model::Execution& E,
+                      const std::vector<scheduler::fingerprint_t>& states);
+
+   /// @brief The number of preemptions of the last schedule.
+
+   unsigned int preemptions() const;
+
+   /// @brief Per number of preemptions up to max_preemptions, the Executions run so far.
+
+   const std::vector<bound_statistics_t>& statistics() const;
+
+private:
+   /// @brief Per number of preemptions, the prefixes still to run, depth-first from the back.
+   std::vector<std::vector<scheduler::schedule_t>> m_pending;
+
+   /// @brief The last schedule, until its Execution is added.
+   boost::optional<scheduler::schedule_t> m_current;
+   unsigned int m_preemptions;
+   std::vector<bound_statistics_t> m_statistics;
+
+   /// @brief Per visited State and previous thread, the fewest preemptions it was reached with.
+   std::unordered_map<scheduler::fingerprint_t, unsigned int> m_visited;
+
+   void add_execution(const program_model::Execution& E,
+                      const std::vector<scheduler::fingerprint_t>* states);
+
+}; // end class preemption_bounding
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief Runs every schedule of a program with at most max_preemptions preemptions, in
+/// increasing order of their number of preemptions.
+/// @param on_execution Called with every Execution, until it returns false.
+/// @returns The statistics per number of preemptions.
+
+std::vector<bound_statistics_t> explore_preemption_bounded(const run_t& run,
+                                                           const unsigned int max_preemptions,
+                                                           const on_execution_t& on_execution);
+
+/// @brief As above, pruning with the fingerprints of the States (see recorded_run_t).
+
+std::vector<bound_statistics_t> explore_preemption_bounded(const stateful_run_t& run,
+                                                           const unsigned int max_preemptions,
+                                                           const on_execution_t& on_execution);
+
+} // end namespace exploration
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <schedule.hpp>
+
+#include <execution.hpp>
+
+#include <functional>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------
+/// @file run.hpp
+/// @brief The interface between an exploration and the runs of the program it explores.
+/// @author Susanne van den Elsen
+/// @date 2015-2017
+//--------------------------------------------------------------------------------------------------
+
+
+namespace exploration {
+
+/// @brief Runs the program under the given schedule, after which the strategy of the Scheduler
+/// completes the run, and returns its recorded Execution, with States.
+
+using run_t = std::function<program_model::Execution(const scheduler::schedule_t&)>;
+
+/// @brief A recorded run with the fingerprints of its States, one per State starting with the
+/// initial one, as the Scheduler writes them to record_states.txt.
+
+struct recorded_run_t
+{
+   program_model::Execution execution;
+   std::vector<scheduler::fingerprint_t> states;
+};
+
+/// @brief As run_t, also returning the fingerprints of the States.
+
+using stateful_run_t = std::function<recorded_run_t(const scheduler::schedule_t&)>;
+
+/// @brief Called with the Executions of an exploration, until it returns false.
+
+using on_execution_t = std::function<bool(const program_model::Execution&)>;
+
+/// @brief As run_t, in a parallel exploration: runs the program in the working directory of the
+/// given worker, where its records stay until the worker runs the program again.
+
+using worker_run_t =
+   std::function<program_model::Execution(const unsigned int worker, const scheduler::schedule_t&)>;
+
+/// @brief As on_execution_t, with the worker whose run recorded the Execution.
+
+using worker_on_execution_t =
+   std::function<bool(const unsigned int worker, const program_model::Execution&)>;
+
+} // end namespace exploration
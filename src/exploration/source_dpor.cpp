@@ -0,0 +1,311 @@
+#include "source_dpor.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+
+namespace exploration {
+
+using namespace program_model;
+
+//--------------------------------------------------------------------------------------------------
+
+namespace {
+
+Thread::tid_t tid_of(const Transition& transition)
+{
+   return boost::apply_visitor(get_tid(), transition.instr());
+}
+
+/// @brief The lock operation of transition on object, if it is one.
+
+const lock_instruction* lock_on(const Transition& transition, const Object& object)
+{
+   const auto* lock_instr = boost::get<lock_instruction>(&transition.instr());
+   return lock_instr && lock_instr->operand() == object ? lock_instr : nullptr;
+}
+
+} // end namespace
+
+//--------------------------------------------------------------------------------------------------
+
+source_dpor::source_dpor()
+: m_stack()
+, m_branch()
+, m_started(false)
+, m_statistics()
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+
+boost::optional<scheduler::schedule_t> source_dpor::next_schedule()
+{
+   if (m_branch)
+      throw std::logic_error("source_dpor: the Execution of the last schedule was not added");
+   if (!m_started)
+   {
+      m_started = true;
+      m_branch = 0;
+      return scheduler::schedule_t();
+   }
+   while (!m_stack.empty())
+   {
+      auto& node = m_stack.back();
+      const auto next = std::find_if(node.backtrack.begin(), node.backtrack.end(),
+                                     [&node](const auto tid) {
+                                        return node.enabled.count(tid) && !node.done.count(tid) &&
+                                               !node.sleep.count(tid);
+                                     });
+      if (next != node.backtrack.end())
+      {
+         // The explored thread sleeps in the States below the new step that it commutes with
+         if (node.chosen)
+            node.sleep.insert(*node.chosen);
+         node.chosen = *next;
+         node.done.insert(*next);
+         m_branch = m_stack.size() - 1;
+
+         scheduler::schedule_t schedule;
+         for (const auto& ancestor : m_stack)
+            schedule.push_back(*ancestor.chosen);
+         return schedule;
+      }
+      m_stack.pop_back();
+   }
+   return boost::none;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool source_dpor::add_execution(const Execution& E)
+{
+   if (!m_branch)
+      throw std::logic_error("source_dpor: add_execution without a schedule");
+   if (!E.initialized())
+      throw std::invalid_argument("source_dpor: the Execution has no States");
+   for (std::size_t step = 0; step < m_stack.size(); ++step)
+   {
+      if (step >= E.size() || tid_of(E[step + 1]) != *m_stack[step].chosen)
+         throw std::invalid_argument("source_dpor: the Execution does not follow the schedule");
+   }
+
+   const auto first = *m_branch;
+   m_branch = boost::none;
+   ++m_statistics.nr_executions;
+   const auto length = extend(E);
+   add_backtrack_points(E, first, length);
+   if (length < E.size())
+   {
+      ++m_statistics.nr_redundant;
+      return false;
+   }
+   return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+const statistics_t& source_dpor::statistics() const
+{
+   return m_statistics;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::size_t source_dpor::extend(const Execution& E)
+{
+   for (std::size_t step = m_stack.size(); step < E.size(); ++step)
+   {
+      const auto& transition = E[step + 1];
+      node_t node;
+      node.enabled = transition.pre().enabled();
+      if (step > 0)
+      {
+         // The sleeping threads that the previous step commutes with sleep on
+         const auto& previous = E[step];
+         const auto& pre = previous.pre();
+         for (const auto tid : m_stack.back().sleep)
+         {
+            if (pre.has_next(tid) && !dependent(pre.next(tid)->second.instr, previous.instr()))
+               node.sleep.insert(tid);
+         }
+      }
+
+      const auto tid = tid_of(transition);
+      if (node.sleep.count(tid))
+      {
+         // The strategy chose a sleeping thread: the next run takes another one, if any
+         const auto awake =
+            std::find_if(node.enabled.begin(), node.enabled.end(),
+                         [&node](const auto other) { return !node.sleep.count(other); });
+         if (awake != node.enabled.end())
+            node.backtrack.insert(*awake);
+         else
+            ++m_statistics.nr_sleep_set_blocked;
+         m_stack.push_back(std::move(node));
+         return step;
+      }
+      node.chosen = tid;
+      node.backtrack.insert(tid);
+      node.done.insert(tid);
+      m_stack.push_back(std::move(node));
+   }
+   return E.size();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void source_dpor::add_backtrack_points(const Execution& E, const std::size_t first,
+                                       const std::size_t length)
+{
+   const happens_before hb(E);
+
+   for (step_t j = first; j < length; ++j)
+   {
+      const auto& instr = E[j + 1].instr();
+
+      // The steps that j may race with, each with a predecessor of j that does not count
+      std::vector<std::pair<step_t, boost::optional<step_t>>> candidates;
+      if (boost::get<memory_instruction>(&instr))
+      {
+         for (const auto i : hb.predecessors(j))
+         {
+            if (boost::get<memory_instruction>(&E[i + 1].instr()))
+               candidates.emplace_back(i, boost::none);
+         }
+      }
+      else if (const auto* lock_instr = boost::get<lock_instruction>(&instr))
+      {
+         // j acquires the lock released by k: j races with the acquisition that k releases
+         if (lock_instr->operation() != lock_operation::Lock)
+            continue;
+         for (const auto k : hb.predecessors(j))
+         {
+            const auto* release = lock_on(E[k + 1], lock_instr->operand());
+            if (!release || release->operation() != lock_operation::Unlock)
+               continue;
+            for (step_t i = k; i-- > 0;)
+            {
+               const auto* acquire = lock_on(E[i + 1], lock_instr->operand());
+               if (acquire && acquire->operation() == lock_operation::Lock &&
+                   hb.tid(i) == hb.tid(k))
+               {
+                  candidates.emplace_back(i, k);
+                  break;
+               }
+            }
+         }
+      }
+
+      for (const auto& candidate : candidates)
+      {
+         const auto i = candidate.first;
+         if (hb.tid(i) == hb.tid(j))
+            continue;
+         // i and j race unless i happens before j through another predecessor of j
+         auto witnesses = hb.predecessors(j);
+         if (const auto previous = hb.previous(j))
+            witnesses.push_back(*previous);
+         const auto& released = candidate.second;
+         const bool ordered = std::any_of(witnesses.begin(), witnesses.end(),
+                                          [&hb, &released, i](const auto witness) {
+                                             return witness != i &&
+                                                    (!released || witness != *released) &&
+                                                    hb(i, witness);
+                                          });
+         if (!ordered)
+            reverse_race(hb, i, j, hb.tid(j), [&hb, j](const auto step) { return hb(step, j); });
+      }
+   }
+
+   if (length < E.size() || E.status() != Execution::Status::DEADLOCK)
+      return;
+   // A thread that blocks on a lock races with the acquisition of the thread that holds it
+   const auto& final = E.final();
+   for (const auto& next : final.next_set())
+   {
+      const auto* lock_instr = boost::get<lock_instruction>(&next.second.instr);
+      if (next.second.enabled || !lock_instr || lock_instr->operation() != lock_operation::Lock)
+         continue;
+      const auto tid = next.first;
+      boost::optional<step_t> last;
+      for (step_t step = 0; step < length; ++step)
+      {
+         if (hb.tid(step) == tid)
+            last = step;
+      }
+      for (step_t i = length; i-- > 0;)
+      {
+         const auto* acquire = lock_on(E[i + 1], lock_instr->operand());
+         if (!acquire || acquire->operation() != lock_operation::Lock)
+            continue;
+         if (hb.tid(i) != tid && (!last || !hb(i, *last)))
+         {
+            reverse_race(hb, i, length, tid, [&hb, &last](const auto step) {
+               return last && (step == *last || hb(step, *last));
+            });
+         }
+         break;
+      }
+   }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void source_dpor::reverse_race(const happens_before& hb, const step_t i, const step_t end,
+                               const tid_t tid,
+                               const std::function<bool(step_t)>& happens_before_second)
+{
+   // v: the steps after i that do not happen after it, followed by the second step of the race
+   std::vector<step_t> v;
+   for (step_t step = i + 1; step < end; ++step)
+   {
+      if (!hb(i, step))
+         v.push_back(step);
+   }
+   Tids initials;
+   Tids seen;
+   for (auto it = v.begin(); it != v.end(); ++it)
+   {
+      if (!seen.insert(hb.tid(*it)).second)
+         continue;
+      if (std::none_of(v.begin(), it, [&hb, it](const auto step) { return hb(step, *it); }))
+         initials.insert(hb.tid(*it));
+   }
+   if (!seen.count(tid) && std::none_of(v.begin(), v.end(), happens_before_second))
+      initials.insert(tid);
+
+   auto& node = m_stack[i];
+   const bool covered = std::any_of(initials.begin(), initials.end(),
+                                    [&node](const auto initial) {
+                                       return node.backtrack.count(initial) > 0;
+                                    });
+   if (covered)
+      return;
+   const auto initial = std::find_if(initials.begin(), initials.end(),
+                                     [&node](const auto initial) {
+                                        return node.enabled.count(initial) > 0;
+                                     });
+   if (initial != initials.end())
+      node.backtrack.insert(*initial);
+   else
+      node.backtrack.insert(node.enabled.begin(), node.enabled.end());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+statistics_t explore(const run_t& run, const on_execution_t& on_execution)
+{
+   source_dpor dpor;
+   while (const auto schedule = dpor.next_schedule())
+   {
+      const auto E = run(*schedule);
+      if (dpor.add_execution(E) && !on_execution(E))
+         break;
+   }
+   return dpor.statistics();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+} // end namespace exploration
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "dependence.hpp"
+#include "run.hpp"
+
+#include <schedule.hpp>
+
+#include <execution.hpp>
+
+#include <boost/optional.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------
+/// @file source_dpor.hpp
+/// @brief Systematic exploration of the schedules of a program with source-DPOR.
+/// @author Susanne van den Elsen
+/// @date 2015-2017
+//--------------------------------------------------------------------------------------------------
+///
+/// Source-DPOR (Abdulla et al., "Optimal Dynamic Partial Order Reduction", POPL 2014) runs one
+/// schedule of every Mazurkiewicz trace of the program, i.e. of every class of Executions that
+/// only differ in the order of independent steps (see dependent). Each Execution is analyzed
+/// for races: pairs of dependent steps of different threads that are not ordered by another
+/// step, and could therefore have run in the other order. Reversing a race adds a thread that
+/// can start the reversed order (an initial, in the paper's terms) to the backtrack set of the
+/// State before the first step of the race, unless the set already contains one. Sleep sets
+/// keep the exploration from running a thread whose steps from that State were all explored
+/// already.
+///
+/// Every run is replayed by the Scheduler up to the step that the exploration changed, after
+/// which the strategy of the Scheduler completes it (NonPreemptive is a good choice). A run that
+/// the strategy led into a sleeping thread is cut off at that step. The runs have to be
+/// recorded with their States, i.e. not in lightweight record mode.
+///
+/// Wake-up trees, which avoid runs that end in a State where every enabled thread sleeps, are
+/// not implemented: such runs are only counted.
+
+
+namespace exploration {
+
+struct statistics_t
+{
+   /// @brief The number of Executions analyzed.
+   std::size_t nr_executions = 0;
+   /// @brief The number of Executions that were cut off at a step of a sleeping thread; their
+   /// traces are explored by other runs.
+   std::size_t nr_redundant = 0;
+   /// @brief The number of Executions that ended in a State where every enabled thread sleeps.
+   std::size_t nr_sleep_set_blocked = 0;
+};
+
+//--------------------------------------------------------------------------------------------------
+
+class source_dpor
+{
+public:
+   using tid_t = program_model::Thread::tid_t;
+   using step_t = happens_before::step_t;
+
+   source_dpor();
+
+   /// @brief The schedule of the next run, starting with the empty schedule.
+   /// @returns boost::none once every trace has been explored.
+   /// @throws std::logic_error if the Execution of the previous schedule was not added.
+
+   boost::optional<scheduler::schedule_t> next_schedule();
+
+   /// @brief Analyzes the Execution of the run under the last schedule.
+   /// @returns false if E was cut off, i.e. is redundant.
+   /// @throws std::invalid_argument if E was recorded without States or does not follow the
+   /// schedule.
+
+   bool add_execution(const program_model::Execution& E);
+
+   const statistics_t& statistics() const;
+
+private:
+   struct node_t
+   {
+      /// @brief The thread that takes the step from this State, if one does already.
+      boost::optional<tid_t> chosen;
+      program_model::Tids enabled;
+      /// @brief The threads to take the step from this State, explored or not.
+      program_model::Tids backtrack;
+      program_model::Tids done;
+      program_model::Tids sleep;
+   };
+
+   /// @brief The States of the current Execution, of which the last one may have no step.
+   std::vector<node_t> m_stack;
+
+   /// @brief The step that the last schedule changed, until its Execution is added.
+   boost::optional<std::size_t> m_branch;
+   bool m_started;
+   statistics_t m_statistics;
+
+   /// @brief Extends m_stack with the States of E after the branch, cutting E off at the first
+   /// step of a sleeping thread.
+   /// @returns The number of steps of E that are explored.
+
+   std::size_t extend(const program_model::Execution& E);
+
+   /// @brief Adds the reversals of the races in the first length steps of E that involve a
+   /// step from first on to the backtrack sets. If E deadlocks, the pending lock operations of
+   /// the blocked threads race with the acquisitions of the locks they wait for.
+
+   void add_backtrack_points(const program_model::Execution& E, const std::size_t first,
+                             const std::size_t length);
+
+   /// @brief Adds an initial of the reversal of the race between step i and a step of tid to
+   /// the backtrack set of the State before i.
+   /// @param end The step before which the second step of the race is taken.
+   /// @param happens_before_second Whether a step before end happens before the second step.
+
+   void reverse_race(const happens_before& hb, const step_t i, const step_t end,
+                     const tid_t tid, const std::function<bool(step_t)>& happens_before_second);
+
+}; // end class source_dpor
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief Explores the traces of a program with source-DPOR.
+/// @param run Runs the program under the given schedule and returns its recorded Execution.
+/// @param on_execution Called with every Execution that is not redundant, until it returns
+/// false.
+/// @returns The statistics of the exploration.
+
+statistics_t explore(const run_t& run, const on_execution_t& on_execution);
+
+} // end namespace exploration
@@ -0,0 +1,229 @@
+#include "work_stealing.hpp"
+
+#include <exception>
+#include <stdexcept>
+#include <thread>
+
+
+namespace exploration {
+
+//--------------------------------------------------------------------------------------------------
+
+work_stealing_frontier::work_stealing_frontier(const unsigned int nr_workers)
+: m_deques()
+, m_outstanding(0)
+, m_nr_pushed(0)
+, m_nr_steals(0)
+, m_stopped(false)
+, m_mutex()
+, m_idle()
+, m_nr_idle(0)
+{
+   if (nr_workers == 0)
+      throw std::invalid_argument("work_stealing_frontier: no workers");
+   for (unsigned int worker = 0; worker < nr_workers; ++worker)
+      m_deques.push_back(std::make_unique<deque_t>());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+unsigned int work_stealing_frontier::nr_workers() const
+{
+   return static_cast<unsigned int>(m_deques.size());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void work_stealing_frontier::push(const unsigned int worker, prefix_t prefix)
+{
+   // Before the prefix can be taken and done
+   ++m_outstanding;
+   {
+      auto& deque = *m_deques.at(worker);
+      std::lock_guard<std::mutex> lock(deque.mutex);
+      deque.prefixes.push_back(std::move(prefix));
+   }
+   ++m_nr_pushed;
+   if (m_nr_idle > 0)
+      wake_all();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+boost::optional<work_stealing_frontier::prefix_t>
+work_stealing_frontier::pop(const unsigned int worker)
+{
+   while (!m_stopped)
+   {
+      // Read before looking at the deques, so that a push after that ends the wait below
+      const std::size_t nr_pushed = m_nr_pushed;
+      if (auto prefix = take(worker))
+         return prefix;
+      if (m_outstanding == 0)
+         return boost::none;
+
+      std::unique_lock<std::mutex> lock(m_mutex);
+      ++m_nr_idle;
+      m_idle.wait(lock, [this, nr_pushed] {
+         return m_nr_pushed != nr_pushed || m_outstanding == 0 || m_stopped;
+      });
+      --m_nr_idle;
+   }
+   return boost::none;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void work_stealing_frontier::done()
+{
+   if (--m_outstanding == 0)
+      wake_all();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void work_stealing_frontier::stop()
+{
+   m_stopped = true;
+   wake_all();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool work_stealing_frontier::stopped() const
+{
+   return m_stopped;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::size_t work_stealing_frontier::nr_steals() const
+{
+   return m_nr_steals;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+boost::optional<work_stealing_frontier::prefix_t>
+work_stealing_frontier::take(const unsigned int worker)
+{
+   {
+      auto& own = *m_deques.at(worker);
+      std::lock_guard<std::mutex> lock(own.mutex);
+      if (!own.prefixes.empty())
+      {
+         auto prefix = std::move(own.prefixes.back());
+         own.prefixes.pop_back();
+         return prefix;
+      }
+   }
+   // Starting at the next worker, so that the victims differ between the thieves
+   for (unsigned int offset = 1; offset < nr_workers(); ++offset)
+   {
+      auto& victim = *m_deques[(worker + offset) % nr_workers()];
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      if (!victim.prefixes.empty())
+      {
+         auto prefix = std::move(victim.prefixes.front());
+         victim.prefixes.pop_front();
+         ++m_nr_steals;
+         return prefix;
+      }
+   }
+   return boost::none;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void work_stealing_frontier::wake_all()
+{
+   // Taking the mutex orders the notification after the check of a worker that is about to wait
+   std::lock_guard<std::mutex> lock(m_mutex);
+   m_idle.notify_all();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+parallel_statistics_t explore_preemption_bounded(const unsigned int nr_workers,
+                                                 const worker_run_t& run,
+                                                 const unsigned int max_preemptions,
+                                                 const worker_on_execution_t& on_execution)
+{
+   parallel_statistics_t statistics;
+   statistics.bounds.resize(max_preemptions + 1);
+   statistics.nr_executions.resize(nr_workers);
+
+   // Per number of preemptions, the prefixes of the later phases
+   std::vector<std::vector<scheduler::schedule_t>> deferred(max_preemptions + 1);
+   deferred[0].emplace_back();
+
+   // Protects deferred, statistics, stopped and error, and serializes on_execution
+   std::mutex mutex;
+   bool stopped = false;
+   std::exception_ptr error;
+
+   for (unsigned int bound = 0; bound <= max_preemptions && !stopped; ++bound)
+   {
+      work_stealing_frontier frontier(nr_workers);
+      auto& pending = deferred[bound];
+      for (std::size_t i = 0; i < pending.size(); ++i)
+         frontier.push(static_cast<unsigned int>(i % nr_workers), std::move(pending[i]));
+      pending.clear();
+
+      const auto work = [&](const unsigned int worker) {
+         while (const auto prefix = frontier.pop(worker))
+         {
+            try
+            {
+               const auto E = run(worker, *prefix);
+               for (auto& branch : branches(E, *prefix, max_preemptions))
+               {
+                  if (branch.preemptions == bound)
+                  {
+                     frontier.push(worker, std::move(branch.prefix));
+                  }
+                  else
+                  {
+                     std::lock_guard<std::mutex> lock(mutex);
+                     deferred[branch.preemptions].push_back(std::move(branch.prefix));
+                  }
+               }
+
+               std::lock_guard<std::mutex> lock(mutex);
+               ++statistics.bounds[bound].nr_executions;
+               ++statistics.nr_executions[worker];
+               if (!stopped && !on_execution(worker, E))
+               {
+                  stopped = true;
+                  frontier.stop();
+               }
+            }
+            catch (...)
+            {
+               std::lock_guard<std::mutex> lock(mutex);
+               if (!error)
+                  error = std::current_exception();
+               stopped = true;
+               frontier.stop();
+            }
+            frontier.done();
+         }
+      };
+
+      std::vector<std::thread> workers;
+      for (unsigned int worker = 0; worker < nr_workers; ++worker)
+         workers.emplace_back(work, worker);
+      for (auto& worker : workers)
+         worker.join();
+
+      statistics.nr_steals += frontier.nr_steals();
+      if (error)
+         std::rethrow_exception(error);
+      statistics.bounds[bound].complete = !stopped;
+   }
+   return statistics;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+} // end namespace exploration
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "preemption_bounding.hpp"
+#include "run.hpp"
+
+#include <schedule.hpp>
+
+#include <boost/optional.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------
+/// @file work_stealing.hpp
+/// @brief The frontier of an exploration shared by workers that run its schedules in parallel.
+/// @author Susanne van den Elsen
+/// @date 2015-2017
+//--------------------------------------------------------------------------------------------------
+///
+/// Every worker owns a deque of the prefixes still to run. It pushes the prefixes that branch
+/// off its own runs to the back of its deque and takes its next prefix from there, so that it
+/// explores depth-first, as the sequential exploration does. A worker whose deque is empty
+/// steals the oldest prefix of another worker, which tends to be the root of the largest
+/// unexplored subtree, and waits only if every deque is empty. The workers only contend on the
+/// deque of a worker that is being stolen from and, when some of them are idle, on waking them.
+
+
+namespace exploration {
+
+class work_stealing_frontier
+{
+public:
+   using prefix_t = scheduler::schedule_t;
+
+   /// @throws std::invalid_argument if nr_workers is 0.
+
+   explicit work_stealing_frontier(const unsigned int nr_workers);
+
+   work_stealing_frontier(const work_stealing_frontier&) = delete;
+   work_stealing_frontier& operator=(const work_stealing_frontier&) = delete;
+
+   unsigned int nr_workers() const;
+
+   /// @brief Adds a prefix to the back of the deque of worker.
+
+   void push(const unsigned int worker, prefix_t prefix);
+
+   /// @brief Takes the last prefix of the deque of worker or else steals the first prefix of
+   /// another deque, waiting while there is none but other workers may still push one.
+   /// @returns boost::none once every pushed prefix is done, or after stop.
+
+   boost::optional<prefix_t> pop(const unsigned int worker);
+
+   /// @brief Marks a popped prefix as done, after the prefixes branching off its run are pushed.
+
+   void done();
+
+   /// @brief Makes every pop return boost::none.
+
+   void stop();
+
+   bool stopped() const;
+
+   /// @brief The number of prefixes taken from the deque of another worker.
+
+   std::size_t nr_steals() const;
+
+private:
+   struct deque_t
+   {
+      std::mutex mutex;
+      std::deque<prefix_t> prefixes;
+   };
+
+   /// @brief Held through pointers, as a mutex cannot move.
+   std::vector<std::unique_ptr<deque_t>> m_deques;
+
+   /// @brief The number of prefixes that were pushed and are not done.
+   std::atomic<std::size_t> m_outstanding;
+   /// @brief Changes with every push, so that a waiting worker knows there may be a prefix.
+   std::atomic<std::size_t> m_nr_pushed;
+   std::atomic<std::size_t> m_nr_steals;
+   std::atomic<bool> m_stopped;
+
+   /// @brief Protects the waiting of the idle workers.
+   std::mutex m_mutex;
+   std::condition_variable m_idle;
+   std::atomic<unsigned int> m_nr_idle;
+
+   boost::optional<prefix_t> take(const unsigned int worker);
+
+   void wake_all();
+
+}; // end class work_stealing_frontier
+
+//--------------------------------------------------------------------------------------------------
+
+struct parallel_statistics_t
+{
+   /// @brief As returned by the sequential explore_preemption_bounded.
+   std::vector<bound_statistics_t> bounds;
+   /// @brief The number of prefixes that a worker took from the deque of another worker.
+   std::size_t nr_steals = 0;
+   /// @brief Per worker, the number of runs it did.
+   std::vector<std::size_t> nr_executions;
+};
+
+/// @brief Runs every schedule of a program with at most max_preemptions preemptions, as the
+/// sequential explore_preemption_bounded does, on nr_workers workers sharing a
+/// work_stealing_frontier.
+/// @details The schedules with fewer preemptions all run before those with more, so the workers
+/// wait for each other once per number of preemptions. Within one number of preemptions, a
+/// worker pushes the prefixes branching off its runs to its own deque. Both functions are
+/// called from the threads of the workers, on_execution by one thread at a time.
+/// @param on_execution Called with every Execution, until it returns false. The runs that
+/// started before that still end, but their Executions are not passed to it.
+/// @throws The first exception thrown by run or on_execution, after every worker stopped.
+
+parallel_statistics_t explore_preemption_bounded(const unsigned int nr_workers,
+                                                 const worker_run_t& run,
+                                                 const unsigned int max_preemptions,
+                                                 const worker_on_execution_t& on_execution);
+
+} // end namespace exploration
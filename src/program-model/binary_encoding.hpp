@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+//--------------------------------------------------------------------------------------------------
+/// @file binary_encoding.hpp
+/// @brief Primitives of the binary trace format.
+/// @author Susanne van den Elsen
+/// @date 2015-2017
+//--------------------------------------------------------------------------------------------------
+
+
+namespace program_model {
+
+class binary_trace_error : public std::runtime_error
+{
+public:
+   explicit binary_trace_error(const std::string& what)
+   : std::runtime_error("binary trace: " + what)
+   {
+   }
+
+}; // end class binary_trace_error
+
+//--------------------------------------------------------------------------------------------------
+
+namespace binary {
+
+/// @brief Magic bytes at the start of every binary trace.
+constexpr char magic[8] = {'R', 'R', 'T', 'R', 'A', 'C', 'E', '\0'};
+
+/// @brief Version of the format written by write_binary.
+/// @details Version 2 added the keyframes. Version 1 traces can still be read.
+constexpr std::uint64_t version = 2;
+
+/// @brief Default number of steps between two keyframes.
+constexpr std::size_t keyframe_interval = 1024;
+
+inline std::uint64_t zigzag(const std::int64_t value)
+{
+   return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+inline std::int64_t unzigzag(const std::uint64_t value)
+{
+   return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief Appends LEB128-encoded unsigned integers and raw bytes to a std::string.
+
+class writer
+{
+public:
+   void varint(std::uint64_t value)
+   {
+      while (value >= 0x80)
+      {
+         m_bytes.push_back(static_cast<char>((value & 0x7f) | 0x80));
+         value >>= 7;
+      }
+      m_bytes.push_back(static_cast<char>(value));
+   }
+
+   void svarint(const std::int64_t value) { varint(zigzag(value)); }
+
+   void bytes(const char* data, const std::size_t size) { m_bytes.append(data, size); }
+
+   void string(const std::string& str)
+   {
+      varint(str.size());
+      bytes(str.data(), str.size());
+   }
+
+   const std::string& data() const { return m_bytes; }
+
+private:
+   std::string m_bytes;
+
+}; // end class writer
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief Reads what a writer wrote from a contiguous range of bytes.
+/// @throws binary_trace_error when reading past the end of the range.
+
+class reader
+{
+public:
+   reader(const char* begin, const char* end)
+   : m_pos(begin)
+   , m_end(end)
+   {
+   }
+
+   bool at_end() const { return m_pos == m_end; }
+
+   const char* position() const { return m_pos; }
+
+   std::uint64_t varint()
+   {
+      std::uint64_t value = 0;
+      for (unsigned shift = 0; shift < 64; shift += 7)
+      {
+         if (m_pos == m_end)
+            throw binary_trace_error("unexpected end of data");
+         const auto byte = static_cast<unsigned char>(*m_pos++);
+         value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+         if ((byte & 0x80) == 0)
+            return value;
+      }
+      throw binary_trace_error("malformed varint");
+   }
+
+   std::int64_t svarint() { return unzigzag(varint()); }
+
+   const char* bytes(const std::size_t size)
+   {
+      if (static_cast<std::size_t>(m_end - m_pos) < size)
+         throw binary_trace_error("unexpected end of data");
+      const char* begin = m_pos;
+      m_pos += size;
+      return begin;
+   }
+
+   std::string string()
+   {
+      const auto size = varint();
+      return std::string(bytes(size), size);
+   }
+
+private:
+   const char* m_pos;
+   const char* m_end;
+
+}; // end class reader
+
+} // end namespace binary
+} // end namespace program_model
@@ -0,0 +1,892 @@
+
+#include "binary_trace.hpp"
+
+#include <boost/variant/static_visitor.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <stdexcept>
+#include <unordered_map>
+
+
+namespace program_model {
+
+//--------------------------------------------------------------------------------------------------
+
+namespace {
+
+/// @brief Builds the tables and the step stream of a binary trace in a single pass over
+/// an Execution.
+
+class trace_encoder
+{
+public:
+   trace_encoder(const Execution& E, const std::size_t keyframe_interval);
+
+   void write(std::ostream& os) const;
+
+private:
+   struct column_entry_encoder;
+
+   using column_t = std::vector<const visible_instruction_t*>;
+
+   Execution::Status m_status;
+   std::map<Thread::tid_t, std::size_t> m_thread_numbers;
+   std::vector<Thread::tid_t> m_threads;
+   std::vector<column_t> m_columns;
+   std::vector<binary::writer> m_column_data;
+
+   std::unordered_map<std::string, std::uint32_t> m_file_ids;
+   std::vector<std::string> m_files;
+   std::map<std::pair<std::uint32_t, unsigned int>, std::uint32_t> m_site_ids;
+   std::vector<binary_trace::site_t> m_sites;
+   std::unordered_map<std::uintptr_t, std::uint32_t> m_object_ids;
+   std::vector<std::uintptr_t> m_objects;
+
+   binary::writer m_steps;
+   std::size_t m_steps_begin;
+
+   const std::size_t m_keyframe_interval;
+   binary::writer m_keyframes;
+   std::size_t m_nr_keyframes;
+
+   // The step and the State encoded last
+   std::size_t m_thread;
+   std::int64_t m_index;
+   std::vector<std::int64_t> m_last;
+   std::vector<std::int64_t> m_next;
+   std::vector<char> m_next_enabled;
+   std::vector<char> m_enabled;
+
+   void add_thread(const Thread::tid_t tid);
+   void add_threads(const State& s);
+   std::size_t thread_number(const Thread::tid_t tid) const;
+
+   std::int64_t column_index(const std::size_t thread, const visible_instruction_t& instr);
+   std::uint32_t object_id(const Object& object);
+   std::uint32_t site_id(const meta_data_t& meta_data);
+
+   void encode_step(const visible_instruction_t& instr);
+   void encode_delta(const State& s);
+   void encode_keyframe(const std::size_t step);
+
+}; // end class trace_encoder
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief Encodes instructions in the format of a column entry.
+
+struct trace_encoder::column_entry_encoder : public boost::static_visitor<void>
+{
+   trace_encoder& encoder;
+   binary::writer& out;
+   Thread::tid_t column_tid;
+
+   column_entry_encoder(trace_encoder& encoder, binary::writer& out, Thread::tid_t column_tid)
+   : encoder(encoder)
+   , out(out)
+   , column_tid(column_tid)
+   {
+   }
+
+   void operator()(const memory_instruction& instr) const
+   {
+      out.varint(static_cast<std::uint64_t>(instr.operation()));
+      out.varint(instr.is_atomic() ? 1 : 0);
+      out.varint(encoder.object_id(instr.operand()));
+      finish(instr.meta_data(), instr.tid());
+   }
+
+   void operator()(const lock_instruction& instr) const
+   {
+      out.varint(static_cast<std::uint64_t>(instr.operation()));
+      out.varint(encoder.object_id(instr.operand()));
+      finish(instr.meta_data(), instr.tid());
+   }
+
+   void operator()(const thread_management_instruction& instr) const
+   {
+      out.varint(static_cast<std::uint64_t>(instr.operation()));
+      out.svarint(instr.operand().tid());
+      out.varint(static_cast<std::uint64_t>(instr.operand().status()));
+      finish(instr.meta_data(), instr.tid());
+   }
+
+   void finish(const meta_data_t& meta_data, const Thread::tid_t tid) const
+   {
+      out.varint(encoder.site_id(meta_data));
+      out.svarint(static_cast<std::int64_t>(tid) - column_tid);
+   }
+
+}; // end struct column_entry_encoder
+
+//--------------------------------------------------------------------------------------------------
+
+trace_encoder::trace_encoder(const Execution& E, const std::size_t keyframe_interval)
+: m_status(E.status())
+, m_steps_begin(0)
+, m_keyframe_interval(keyframe_interval)
+, m_nr_keyframes(0)
+, m_thread(0)
+, m_index(-1)
+{
+   if (!E.initialized())
+      throw binary_trace_error("the Execution has no initial State");
+
+   add_threads(E.s0());
+   for (const auto& trans : E)
+   {
+      add_thread(boost::apply_visitor(program_model::get_tid(), trans.instr()));
+      add_threads(trans.post());
+   }
+   std::size_t number = 0;
+   for (auto& entry : m_thread_numbers)
+   {
+      entry.second = number++;
+      m_threads.push_back(entry.first);
+   }
+   m_columns.resize(m_threads.size());
+   m_column_data.resize(m_threads.size());
+   m_last.assign(m_threads.size(), -1);
+   m_next.assign(m_threads.size(), -1);
+   m_next_enabled.assign(m_threads.size(), 0);
+   m_enabled.assign(m_threads.size(), 0);
+
+   m_steps.varint(E.size());
+   m_steps_begin = m_steps.data().size();
+   encode_delta(E.s0());
+   std::size_t step = 0;
+   for (const auto& trans : E)
+   {
+      encode_step(trans.instr());
+      encode_delta(trans.post());
+      if (m_keyframe_interval > 0 && ++step % m_keyframe_interval == 0)
+         encode_keyframe(step);
+   }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void trace_encoder::write(std::ostream& os) const
+{
+   binary::writer tables;
+   tables.bytes(binary::magic, sizeof(binary::magic));
+   tables.varint(binary::version);
+   tables.varint(static_cast<std::uint64_t>(m_status));
+   tables.varint(m_files.size());
+   for (const auto& file : m_files)
+      tables.string(file);
+   tables.varint(m_sites.size());
+   for (const auto& site : m_sites)
+   {
+      tables.varint(site.file);
+      tables.varint(site.line_number);
+   }
+   tables.varint(m_objects.size());
+   for (const auto address : m_objects)
+      tables.varint(address);
+   tables.varint(m_threads.size());
+   for (std::size_t thread = 0; thread < m_threads.size(); ++thread)
+   {
+      tables.svarint(m_threads[thread]);
+      tables.varint(m_columns[thread].size());
+      tables.bytes(m_column_data[thread].data().data(), m_column_data[thread].data().size());
+   }
+   tables.varint(m_keyframe_interval);
+   tables.varint(m_nr_keyframes);
+   tables.bytes(m_keyframes.data().data(), m_keyframes.data().size());
+   os.write(tables.data().data(), tables.data().size());
+   os.write(m_steps.data().data(), m_steps.data().size());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void trace_encoder::add_thread(const Thread::tid_t tid)
+{
+   if (tid < 0)
+      throw binary_trace_error("negative tid " + std::to_string(tid));
+   m_thread_numbers.emplace(tid, 0);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void trace_encoder::add_threads(const State& s)
+{
+   for (const auto tid : s.enabled())
+      add_thread(tid);
+   for (const auto& entry : s.next_set())
+      add_thread(entry.first);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::size_t trace_encoder::thread_number(const Thread::tid_t tid) const
+{
+   return m_thread_numbers.at(tid);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::int64_t trace_encoder::column_index(const std::size_t thread,
+                                         const visible_instruction_t& instr)
+{
+   auto& column = m_columns[thread];
+   if (m_next[thread] >= 0 && *column[m_next[thread]] == instr)
+      return m_next[thread];
+   if (!column.empty() && *column.back() == instr)
+      return column.size() - 1;
+   column.push_back(&instr);
+   boost::apply_visitor(column_entry_encoder(*this, m_column_data[thread], m_threads[thread]),
+                        instr);
+   return column.size() - 1;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::uint32_t trace_encoder::object_id(const Object& object)
+{
+   const auto address = reinterpret_cast<std::uintptr_t>(object.address());
+   const auto inserted = m_object_ids.emplace(address, m_objects.size());
+   if (inserted.second)
+      m_objects.push_back(address);
+   return inserted.first->second;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::uint32_t trace_encoder::site_id(const meta_data_t& meta_data)
+{
+   const auto file = m_file_ids.emplace(meta_data.file_name, m_files.size());
+   if (file.second)
+      m_files.push_back(meta_data.file_name);
+   const auto site = m_site_ids.emplace(std::make_pair(file.first->second, meta_data.line_number),
+                                        m_sites.size());
+   if (site.second)
+      m_sites.push_back({file.first->second, meta_data.line_number});
+   return site.first->second;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void trace_encoder::encode_step(const visible_instruction_t& instr)
+{
+   const auto thread = thread_number(boost::apply_visitor(program_model::get_tid(), instr));
+   const auto index = column_index(thread, instr);
+   m_steps.varint(thread);
+   m_steps.svarint(index - m_last[thread]);
+   m_last[thread] = index;
+   m_thread = thread;
+   m_index = index;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void trace_encoder::encode_delta(const State& s)
+{
+   binary::writer entries;
+   std::size_t nr_entries = 0;
+   binary::writer toggles;
+   std::size_t nr_toggles = 0;
+   for (std::size_t thread = 0; thread < m_threads.size(); ++thread)
+   {
+      const auto tid = m_threads[thread];
+      const auto next = s.next_set().find(tid);
+      if (next == s.next_set().end())
+      {
+         if (m_next[thread] >= 0)
+         {
+            entries.varint(thread);
+            entries.varint(0);
+            ++nr_entries;
+            m_next[thread] = -1;
+            m_next_enabled[thread] = 0;
+         }
+      }
+      else
+      {
+         const auto index = column_index(thread, next->second.instr);
+         const char enabled = next->second.enabled ? 1 : 0;
+         if (index != m_next[thread] || enabled != m_next_enabled[thread])
+         {
+            entries.varint(thread);
+            entries.varint(1 + ((binary::zigzag(index - m_last[thread]) << 1) | enabled));
+            ++nr_entries;
+            m_last[thread] = index;
+            m_next[thread] = index;
+            m_next_enabled[thread] = enabled;
+         }
+      }
+      const char is_enabled = s.is_enabled(tid) ? 1 : 0;
+      if (is_enabled != m_enabled[thread])
+      {
+         toggles.varint(thread);
+         ++nr_toggles;
+         m_enabled[thread] = is_enabled;
+      }
+   }
+   m_steps.varint(nr_entries);
+   m_steps.bytes(entries.data().data(), entries.data().size());
+   m_steps.varint(nr_toggles);
+   m_steps.bytes(toggles.data().data(), toggles.data().size());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void trace_encoder::encode_keyframe(const std::size_t step)
+{
+   m_keyframes.varint(step);
+   m_keyframes.varint(m_steps.data().size() - m_steps_begin);
+   m_keyframes.varint(m_thread);
+   m_keyframes.varint(m_index);
+   for (std::size_t thread = 0; thread < m_threads.size(); ++thread)
+   {
+      m_keyframes.svarint(m_last[thread]);
+      m_keyframes.svarint(m_next[thread]);
+      m_keyframes.varint(m_next_enabled[thread] | (m_enabled[thread] << 1));
+   }
+   ++m_nr_keyframes;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+mapped_file map_trace(const std::string& file_name)
+{
+   try
+   {
+      return mapped_file(file_name);
+   }
+   catch (const std::runtime_error& error)
+   {
+      throw binary_trace_error(error.what());
+   }
+}
+
+} // end namespace
+
+//--------------------------------------------------------------------------------------------------
+
+void write_binary(std::ostream& os, const Execution& E, const std::size_t keyframe_interval)
+{
+   trace_encoder(E, keyframe_interval).write(os);
+}
+
+//--------------------------------------------------------------------------------------------------
+// binary_trace
+//--------------------------------------------------------------------------------------------------
+
+binary_trace::binary_trace(const std::string& file_name)
+: m_file(map_trace(file_name))
+, m_steps(nullptr)
+, m_status(Execution::Status::RUNNING)
+, m_nr_steps(0)
+, m_keyframe_interval(0)
+{
+   parse();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+const Execution::Status& binary_trace::status() const
+{
+   return m_status;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::size_t binary_trace::size() const
+{
+   return m_nr_steps;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+const std::vector<std::string>& binary_trace::files() const
+{
+   return m_files;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+auto binary_trace::sites() const -> const std::vector<site_t>&
+{
+   return m_sites;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+const std::vector<std::uintptr_t>& binary_trace::objects() const
+{
+   return m_objects;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+const std::vector<Thread::tid_t>& binary_trace::threads() const
+{
+   return m_threads;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+auto binary_trace::column(const std::size_t thread) const -> const column_t&
+{
+   return m_columns[thread];
+}
+
+//--------------------------------------------------------------------------------------------------
+
+visible_instruction_t binary_trace::instruction(const instruction_record& record) const
+{
+   const auto& site = m_sites[record.site];
+   const meta_data_t meta_data{m_files[site.file], site.line_number};
+   switch (record.operation)
+   {
+      case static_cast<int>(memory_operation::Load):
+      case static_cast<int>(memory_operation::Store):
+      case static_cast<int>(memory_operation::ReadModifyWrite):
+         return memory_instruction(record.tid, static_cast<memory_operation>(record.operation),
+                                   Object(reinterpret_cast<Object::ptr_t>(
+                                      m_objects[static_cast<std::size_t>(record.operand)])),
+                                   record.is_atomic, meta_data);
+      case static_cast<int>(lock_operation::Lock):
+      case static_cast<int>(lock_operation::Unlock):
+         return lock_instruction(record.tid, static_cast<lock_operation>(record.operation),
+                                 Object(reinterpret_cast<Object::ptr_t>(
+                                    m_objects[static_cast<std::size_t>(record.operand)])),
+                                 meta_data);
+      default:
+         return thread_management_instruction(
+            record.tid, static_cast<thread_management_operation>(record.operation),
+            Thread(static_cast<Thread::tid_t>(record.operand), record.thread_status), meta_data);
+   }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::size_t binary_trace::keyframe_interval() const
+{
+   return m_keyframe_interval;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+auto binary_trace::begin() const -> cursor
+{
+   return cursor(*this);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+auto binary_trace::seek(const std::size_t index) const -> cursor
+{
+   if (index > m_nr_steps)
+      throw std::out_of_range("binary_trace::seek");
+   const auto keyframe = std::upper_bound(
+      m_keyframes.begin(), m_keyframes.end(), index,
+      [](const std::size_t step, const keyframe_t& keyframe) { return step < keyframe.step; });
+   auto c = keyframe == m_keyframes.begin() ? begin() : cursor(*this, *std::prev(keyframe));
+   while (c.index() < index)
+      c.next();
+   return c;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+State::SharedPtr binary_trace::state(const cursor& c) const
+{
+   NextSet next{};
+   auto enabled = std::make_shared<Tids>();
+   for (std::size_t thread = 0; thread < c.nr_threads(); ++thread)
+   {
+      if (const auto* record = c.next_instr(thread))
+         next.set(m_threads[thread], next_t{instruction(*record), c.next_enabled(thread)});
+      if (c.is_enabled(thread))
+         enabled->insert(m_threads[thread]);
+   }
+   return State::create(std::move(enabled), std::move(next));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Transition binary_trace::transition(const std::size_t index) const
+{
+   if (index == 0 || index > m_nr_steps)
+      throw std::out_of_range("binary_trace::transition");
+   auto c = seek(index - 1);
+   auto pre = state(c);
+   c.next();
+   return Transition(static_cast<int>(index), std::move(pre), instruction(c.instr()), state(c));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::vector<Transition> binary_trace::window(const std::size_t first,
+                                             const std::size_t count) const
+{
+   if (first == 0 || first > m_nr_steps + 1)
+      throw std::out_of_range("binary_trace::window");
+   std::vector<Transition> transitions;
+   transitions.reserve(std::min(count, m_nr_steps + 1 - first));
+   auto c = seek(first - 1);
+   auto pre = state(c);
+   while (transitions.size() < count && c.next())
+   {
+      auto post = state(c);
+      transitions.emplace_back(static_cast<int>(c.index()), pre, instruction(c.instr()), post);
+      pre = std::move(post);
+   }
+   return transitions;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Execution binary_trace::to_execution() const
+{
+   std::vector<std::vector<visible_instruction_t>> instructions(m_columns.size());
+   for (std::size_t thread = 0; thread < m_columns.size(); ++thread)
+   {
+      instructions[thread].reserve(m_columns[thread].size());
+      for (const auto& record : m_columns[thread])
+         instructions[thread].push_back(instruction(record));
+   }
+
+   auto c = begin();
+   NextSet next{};
+   auto enabled = std::make_shared<const Tids>();
+   const auto state = [this, &c, &next, &enabled, &instructions]() {
+      std::unique_ptr<Tids> new_enabled{};
+      for (const auto thread : c.m_changed)
+      {
+         const auto tid = m_threads[thread];
+         if (c.m_next[thread] < 0)
+            next.erase(tid);
+         else
+            next.set(tid, next_t{instructions[thread][c.m_next[thread]],
+                                 c.m_next_enabled[thread] != 0});
+         if (c.is_enabled(thread) != (enabled->count(tid) != 0))
+         {
+            if (!new_enabled)
+               new_enabled = std::make_unique<Tids>(*enabled);
+            if (c.is_enabled(thread))
+               new_enabled->insert(tid);
+            else
+               new_enabled->erase(tid);
+         }
+      }
+      if (new_enabled)
+         enabled = std::move(new_enabled);
+      return State::create(enabled, next);
+   };
+
+   Execution E(state());
+   while (c.next())
+   {
+      E.push_back(instructions[c.m_thread][c.m_instr - m_columns[c.m_thread].data()], state());
+   }
+   E.set_status(m_status);
+   return E;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void binary_trace::parse()
+{
+   binary::reader in(m_file.begin(), m_file.end());
+   if (!std::equal(binary::magic, binary::magic + sizeof(binary::magic),
+                   in.bytes(sizeof(binary::magic))))
+      throw binary_trace_error("not a binary trace");
+   const auto version = in.varint();
+   if (version == 0 || version > binary::version)
+      throw binary_trace_error("unsupported version " + std::to_string(version));
+   const auto status = in.varint();
+   if (status > static_cast<std::uint64_t>(Execution::Status::ERROR))
+      throw binary_trace_error("invalid status");
+   m_status = static_cast<Execution::Status>(status);
+
+   m_files.resize(in.varint());
+   for (auto& file : m_files)
+      file = in.string();
+
+   m_sites.resize(in.varint());
+   for (auto& site : m_sites)
+   {
+      site.file = in.varint();
+      site.line_number = in.varint();
+      if (site.file >= m_files.size())
+         throw binary_trace_error("invalid file id");
+   }
+
+   m_objects.resize(in.varint());
+   for (auto& address : m_objects)
+      address = in.varint();
+
+   m_threads.resize(in.varint());
+   m_columns.resize(m_threads.size());
+   for (std::size_t thread = 0; thread < m_threads.size(); ++thread)
+   {
+      m_threads[thread] = in.svarint();
+      m_columns[thread].resize(in.varint());
+      for (auto& record : m_columns[thread])
+      {
+         record.operation = in.varint();
+         record.is_atomic = false;
+         record.thread_status = Thread::Status::START;
+         switch (record.operation)
+         {
+            case static_cast<int>(memory_operation::Load):
+            case static_cast<int>(memory_operation::Store):
+            case static_cast<int>(memory_operation::ReadModifyWrite):
+               record.is_atomic = in.varint() != 0;
+            // fall through
+            case static_cast<int>(lock_operation::Lock):
+            case static_cast<int>(lock_operation::Unlock):
+               record.operand = in.varint();
+               if (static_cast<std::size_t>(record.operand) >= m_objects.size())
+                  throw binary_trace_error("invalid object id");
+               break;
+            case static_cast<int>(thread_management_operation::Spawn):
+            case static_cast<int>(thread_management_operation::Join):
+               record.operand = in.svarint();
+               record.thread_status = static_cast<Thread::Status>(in.varint());
+               break;
+            default:
+               throw binary_trace_error("invalid operation");
+         }
+         record.site = in.varint();
+         if (record.site >= m_sites.size())
+            throw binary_trace_error("invalid site id");
+         record.tid = m_threads[thread] + in.svarint();
+      }
+   }
+
+   if (version >= 2)
+      parse_keyframes(in);
+
+   m_nr_steps = in.varint();
+   m_steps = in.position();
+   for (const auto& keyframe : m_keyframes)
+   {
+      if (keyframe.step > m_nr_steps ||
+          keyframe.offset > static_cast<std::size_t>(m_file.end() - m_steps))
+         throw binary_trace_error("invalid keyframe");
+   }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void binary_trace::parse_keyframes(binary::reader& in)
+{
+   const auto column_index = [this](const std::size_t thread, const std::int64_t index,
+                                    const bool allow_none) {
+      if ((index < 0 && !(allow_none && index == -1)) ||
+          index >= static_cast<std::int64_t>(m_columns[thread].size()))
+         throw binary_trace_error("invalid keyframe");
+      return index;
+   };
+
+   m_keyframe_interval = in.varint();
+   m_keyframes.resize(in.varint());
+   std::size_t previous = 0;
+   for (auto& keyframe : m_keyframes)
+   {
+      keyframe.step = in.varint();
+      keyframe.offset = in.varint();
+      keyframe.thread = in.varint();
+      if (keyframe.step <= previous || keyframe.thread >= m_threads.size())
+         throw binary_trace_error("invalid keyframe");
+      previous = keyframe.step;
+      keyframe.index = column_index(keyframe.thread, in.varint(), false);
+      keyframe.last.resize(m_threads.size());
+      keyframe.next.resize(m_threads.size());
+      keyframe.next_enabled.resize(m_threads.size());
+      keyframe.enabled.resize(m_threads.size());
+      for (std::size_t thread = 0; thread < m_threads.size(); ++thread)
+      {
+         keyframe.last[thread] = column_index(thread, in.svarint(), true);
+         keyframe.next[thread] = column_index(thread, in.svarint(), true);
+         const auto flags = in.varint();
+         keyframe.next_enabled[thread] = static_cast<char>(flags & 1);
+         keyframe.enabled[thread] = static_cast<char>((flags >> 1) & 1);
+      }
+   }
+}
+
+//--------------------------------------------------------------------------------------------------
+// binary_trace::cursor
+//--------------------------------------------------------------------------------------------------
+
+binary_trace::cursor::cursor(const binary_trace& trace)
+: m_trace(&trace)
+, m_reader(trace.m_steps, trace.m_file.end())
+, m_index(0)
+, m_thread(0)
+, m_instr(nullptr)
+, m_last(trace.m_threads.size(), -1)
+, m_next(trace.m_threads.size(), -1)
+, m_next_enabled(trace.m_threads.size(), 0)
+, m_enabled(trace.m_threads.size(), 0)
+, m_changed()
+{
+   m_changed.reserve(2 * trace.m_threads.size());
+   read_delta();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+binary_trace::cursor::cursor(const binary_trace& trace, const keyframe_t& keyframe)
+: m_trace(&trace)
+, m_reader(trace.m_steps + keyframe.offset, trace.m_file.end())
+, m_index(keyframe.step)
+, m_thread(keyframe.thread)
+, m_instr(&trace.m_columns[keyframe.thread][keyframe.index])
+, m_last(keyframe.last)
+, m_next(keyframe.next)
+, m_next_enabled(keyframe.next_enabled)
+, m_enabled(keyframe.enabled)
+, m_changed()
+{
+   m_changed.reserve(2 * trace.m_threads.size());
+   for (std::size_t thread = 0; thread < trace.m_threads.size(); ++thread)
+      m_changed.push_back(thread);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool binary_trace::cursor::next()
+{
+   if (m_index == m_trace->m_nr_steps)
+      return false;
+   m_thread = read_thread();
+   m_instr = &m_trace->m_columns[m_thread][read_index(m_thread)];
+   read_delta();
+   ++m_index;
+   return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::size_t binary_trace::cursor::index() const
+{
+   return m_index;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::size_t binary_trace::cursor::thread() const
+{
+   return m_thread;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+auto binary_trace::cursor::instr() const -> const instruction_record&
+{
+   return *m_instr;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::size_t binary_trace::cursor::nr_threads() const
+{
+   return m_next.size();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+auto binary_trace::cursor::next_instr(const std::size_t thread) const -> const instruction_record*
+{
+   if (m_next[thread] < 0)
+      return nullptr;
+   return &m_trace->m_columns[thread][m_next[thread]];
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool binary_trace::cursor::next_enabled(const std::size_t thread) const
+{
+   return m_next_enabled[thread] != 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool binary_trace::cursor::is_enabled(const std::size_t thread) const
+{
+   return m_enabled[thread] != 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+const std::vector<std::size_t>& binary_trace::cursor::changed_threads() const
+{
+   return m_changed;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::size_t binary_trace::cursor::read_thread()
+{
+   const auto thread = m_reader.varint();
+   if (thread >= m_next.size())
+      throw binary_trace_error("invalid thread number");
+   return thread;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::int64_t binary_trace::cursor::read_index(const std::size_t thread)
+{
+   return read_index_delta(thread, m_reader.svarint());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::int64_t binary_trace::cursor::read_index_delta(const std::size_t thread,
+                                                    const std::int64_t delta)
+{
+   const auto index = m_last[thread] + delta;
+   if (index < 0 || static_cast<std::size_t>(index) >= m_trace->m_columns[thread].size())
+      throw binary_trace_error("invalid instruction index");
+   m_last[thread] = index;
+   return index;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void binary_trace::cursor::read_delta()
+{
+   m_changed.clear();
+   for (auto nr_entries = m_reader.varint(); nr_entries > 0; --nr_entries)
+   {
+      const auto thread = read_thread();
+      const auto entry = m_reader.varint();
+      if (entry == 0)
+      {
+         m_next[thread] = -1;
+         m_next_enabled[thread] = 0;
+      }
+      else
+      {
+         m_next[thread] = read_index_delta(thread, binary::unzigzag((entry - 1) >> 1));
+         m_next_enabled[thread] = static_cast<char>((entry - 1) & 1);
+      }
+      m_changed.push_back(thread);
+   }
+   for (auto nr_toggles = m_reader.varint(); nr_toggles > 0; --nr_toggles)
+   {
+      const auto thread = read_thread();
+      m_enabled[thread] = !m_enabled[thread];
+      m_changed.push_back(thread);
+   }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Execution read_binary(const std::string& file_name)
+{
+   return binary_trace(file_name).to_execution();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+} // end namespace program_model
@@ -0,0 +1,261 @@
+#pragma once
+
+#include "binary_encoding.hpp"
+#include "execution.hpp"
+#include "mapped_file.hpp"
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------
+/// @file binary_trace.hpp
+/// @brief Compact binary format for Execution and a memory-mapped reader for it.
+/// @author Susanne van den Elsen
+/// @date 2015-2017
+//--------------------------------------------------------------------------------------------------
+///
+/// Layout (all integers are LEB128 varints, tids and deltas are zigzag encoded):
+///
+///    magic[8] version status
+///    files     n { length bytes }
+///    sites     n { file line }
+///    objects   n { address }
+///    threads   n { tid  m { instruction } }
+///    keyframes interval  n { step  offset  thread  index  { last  next  flags } }
+///    steps     n  s0-delta  n { thread  index-delta  post-delta }
+///
+/// Every thread has a column holding the distinct instructions it posted, in order.
+/// An instruction is `operation [is_atomic] operand site tid-delta`. Its operand is an index
+/// into the objects table, or a tid and a Thread::Status. Its tid is stored relative to the tid
+/// of its column.
+///
+/// A step names the executed instruction by its thread and column index. The index is stored
+/// relative to the last index used for that thread.
+///
+/// A delta turns the pre-State into the post-State. It is encoded as
+/// `k { thread entry }  l { thread }`:
+/// - the entry is 0 if the thread's NextSet entry was erased;
+/// - otherwise it is 1 + (zigzag(index-delta) << 1 | enabled);
+/// - the second list toggles the threads' membership of the enabled set.
+/// s0 is stored as a delta of the empty State.
+///
+/// The file name of a visible instruction and its NextSet entries are therefore stored once,
+/// instead of in every State.
+///
+/// A keyframe holds the complete decoder state after every interval-th step, so that a reader
+/// can start decoding there instead of at s0: the byte offset of the next step relative to the
+/// first step, the thread and column index of the step's instruction and, per thread, the
+/// last used column index, the column index of its NextSet entry (-1 if it has none) and
+/// `next_enabled | enabled << 1`. An interval of 0 means there are no keyframes.
+
+namespace program_model {
+
+/// @brief Writes E in the binary format to os, with a keyframe after every
+/// keyframe_interval-th step.
+/// @throws binary_trace_error if E is not initialized or contains negative tids.
+
+void write_binary(std::ostream& os, const Execution& E,
+                  const std::size_t keyframe_interval = binary::keyframe_interval);
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief Read-only view of a binary trace file, mapped into memory.
+/// @details The tables are decoded when the file is opened. The steps are decoded on the fly
+/// by a cursor, which does not allocate while it iterates. seek starts a cursor at the
+/// keyframe nearest before the requested step, so random access decodes at most
+/// keyframe_interval() steps.
+
+class binary_trace
+{
+public:
+   struct site_t
+   {
+      std::uint32_t file;
+      unsigned int line_number;
+   };
+
+   /// @brief Decoded form of a visible_instruction_t, referring to the tables of the trace.
+
+   struct instruction_record
+   {
+      Thread::tid_t tid;
+      /// @brief The operation as given by operation_as_int.
+      int operation;
+      bool is_atomic;
+      /// @brief Index into objects() or, for thread management instructions, the operand's tid.
+      std::int64_t operand;
+      Thread::Status thread_status;
+      std::uint32_t site;
+   };
+
+   using column_t = std::vector<instruction_record>;
+
+   class cursor;
+
+   /// @throws binary_trace_error if the file cannot be mapped or is not a binary trace of
+   /// a supported version.
+
+   explicit binary_trace(const std::string& file_name);
+   binary_trace(const binary_trace&) = delete;
+   binary_trace& operator=(const binary_trace&) = delete;
+
+   const Execution::Status& status() const;
+
+   /// @brief The number of Transitions.
+
+   std::size_t size() const;
+
+   const std::vector<std::string>& files() const;
+   const std::vector<site_t>& sites() const;
+   const std::vector<std::uintptr_t>& objects() const;
+
+   /// @brief The tids of the threads, indexed by the thread numbers used in the trace.
+
+   const std::vector<Thread::tid_t>& threads() const;
+
+   const column_t& column(const std::size_t thread) const;
+
+   visible_instruction_t instruction(const instruction_record& record) const;
+
+   /// @brief The number of steps between two keyframes, 0 if the trace has none.
+
+   std::size_t keyframe_interval() const;
+
+   /// @brief Returns a cursor positioned at s0.
+
+   cursor begin() const;
+
+   /// @brief Returns a cursor positioned at the index-th Transition, or at s0 if index is 0.
+   /// @throws std::out_of_range if index > size().
+
+   cursor seek(const std::size_t index) const;
+
+   /// @brief The State described by the cursor.
+
+   State::SharedPtr state(const cursor& c) const;
+
+   /// @brief The index-th Transition, with its pre- and post-State.
+   /// @throws std::out_of_range unless 1 <= index <= size().
+
+   Transition transition(const std::size_t index) const;
+
+   /// @brief The Transitions first up to (but not including) first + count, or up to the end.
+   /// @details Consecutive Transitions share their States, as in an Execution.
+   /// @throws std::out_of_range unless 1 <= first <= size() + 1.
+
+   std::vector<Transition> window(const std::size_t first, const std::size_t count) const;
+
+   Execution to_execution() const;
+
+private:
+   /// @brief The state of a cursor after step, see the keyframes in the file layout.
+
+   struct keyframe_t
+   {
+      std::size_t step;
+      std::size_t offset;
+      std::size_t thread;
+      std::int64_t index;
+      std::vector<std::int64_t> last;
+      std::vector<std::int64_t> next;
+      std::vector<char> next_enabled;
+      std::vector<char> enabled;
+   };
+
+   mapped_file m_file;
+   const char* m_steps;
+
+   Execution::Status m_status;
+   std::size_t m_nr_steps;
+   std::vector<std::string> m_files;
+   std::vector<site_t> m_sites;
+   std::vector<std::uintptr_t> m_objects;
+   std::vector<Thread::tid_t> m_threads;
+   std::vector<column_t> m_columns;
+   std::size_t m_keyframe_interval;
+   std::vector<keyframe_t> m_keyframes;
+
+   void parse();
+   void parse_keyframes(binary::reader& in);
+
+}; // end class binary_trace
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief Forward iterator over the States and Transitions of a binary_trace.
+/// @details Positioned at index 0 the cursor describes s0, at index i it describes the i-th
+/// Transition and its post-State.
+
+class binary_trace::cursor
+{
+public:
+   /// @brief Advances to the next Transition.
+   /// @returns false if there is none.
+
+   bool next();
+
+   /// @brief The index of the current Transition, 0 for s0.
+
+   std::size_t index() const;
+
+   /// @brief The thread number of the current Transition's instruction.
+   /// @pre index() > 0
+
+   std::size_t thread() const;
+
+   /// @pre index() > 0
+
+   const instruction_record& instr() const;
+
+   std::size_t nr_threads() const;
+
+   /// @brief The NextSet entry of the given thread number in the current State.
+   /// @returns nullptr if there is none.
+
+   const instruction_record* next_instr(const std::size_t thread) const;
+
+   bool next_enabled(const std::size_t thread) const;
+
+   bool is_enabled(const std::size_t thread) const;
+
+   /// @brief The thread numbers whose NextSet entry or enabledness changed in the last step.
+   /// @note A thread number can occur twice. A cursor returned by seek that did not decode
+   /// any step lists every thread number.
+
+   const std::vector<std::size_t>& changed_threads() const;
+
+private:
+   const binary_trace* m_trace;
+   binary::reader m_reader;
+   std::size_t m_index;
+   std::size_t m_thread;
+   const instruction_record* m_instr;
+
+   std::vector<std::int64_t> m_last;
+   std::vector<std::int64_t> m_next;
+   std::vector<char> m_next_enabled;
+   std::vector<char> m_enabled;
+   std::vector<std::size_t> m_changed;
+
+   explicit cursor(const binary_trace& trace);
+   cursor(const binary_trace& trace, const keyframe_t& keyframe);
+
+   std::size_t read_thread();
+   std::int64_t read_index(const std::size_t thread);
+   std::int64_t read_index_delta(const std::size_t thread, const std::int64_t delta);
+   void read_delta();
+
+   friend class binary_trace;
+
+}; // end class binary_trace::cursor
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief Reads the Execution stored in the binary trace file_name.
+/// @throws binary_trace_error
+
+Execution read_binary(const std::string& file_name);
+
+} // end namespace program_model
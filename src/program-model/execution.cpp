@@ -95,6 +95,13 @@ bool Execution::empty() const
 
 //--------------------------------------------------------------------------------------------------
 
+void Execution::reserve(const size_t nr_transitions)
+{
+   mExecution.reserve(nr_transitions);
+}
+
+//--------------------------------------------------------------------------------------------------
+
 bool Execution::initialized() const
 {
    return mS0 != nullptr;
@@ -146,16 +153,17 @@ const State& Execution::final() const
 
 //--------------------------------------------------------------------------------------------------
 
-void Execution::push_back(const instruction_t& instr, const StatePtr& post)
+void Execution::push_back(instruction_t instr, const StatePtr& post)
 {
    /// @pre !empty() || initialized()
    assert(!empty() || initialized());
-   mExecution.emplace_back(size() + 1, final_ptr(), instr, post);
-   if (boost::get<lock_instruction>(&instr))
+   mExecution.emplace_back(size() + 1, final_ptr(), std::move(instr), post);
+   const auto& added = last().instr();
+   if (boost::get<lock_instruction>(&added))
    {
       set_contains_locks();
    }
-   else if (const auto* thread_management_instr = boost::get<thread_management_instruction>(&instr))
+   else if (const auto* thread_management_instr = boost::get<thread_management_instruction>(&added))
    {
       if (thread_management_instr->operation() == thread_management_operation::Spawn)
       {
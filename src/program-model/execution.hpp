@@ -62,6 +62,10 @@ public:
    size_t size() const;
    bool empty() const;
 
+   /// @brief Reserves space for the given number of Transitions.
+
+   void reserve(const size_t nr_transitions);
+
    bool initialized() const;
 
    /// @note Like std::vector::back calling last() on an empty Execution is undefined
@@ -78,7 +82,7 @@ public:
 
    // #todo Assertion should be trivial when s0 is a required argument to
    // Execution's constructor.
-   void push_back(const instruction_t& instr, const StatePtr& post);
+   void push_back(instruction_t instr, const StatePtr& post);
 
    /// @note The popped Transition t still has (valid) pointers to t.pre and t.post.
 
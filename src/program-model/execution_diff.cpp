@@ -0,0 +1,531 @@
+
+#include "execution_diff.hpp"
+
+#include "binary_trace.hpp"
+#include "execution_io.hpp"
+#include "state_io.hpp"
+#include "text_trace.hpp"
+#include "visible_instruction_io.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <fstream>
+#include <ostream>
+#include <set>
+#include <stdexcept>
+#include <unordered_map>
+
+
+namespace program_model {
+
+//--------------------------------------------------------------------------------------------------
+
+namespace {
+
+class text_execution_reader : public execution_reader
+{
+public:
+   explicit text_execution_reader(const std::string& file_name)
+   : m_trace(file_name)
+   {
+      if (!m_trace.initialized())
+         throw std::runtime_error(file_name + ": no initial State");
+   }
+
+   bool next() override { return m_trace.next(); }
+   std::size_t index() const override { return m_trace.index(); }
+   const visible_instruction_t& instr() const override { return m_trace.instr(); }
+   State::SharedPtr state() override { return m_trace.state(); }
+   Execution::Status status() const override { return m_trace.status(); }
+
+private:
+   text_trace_reader m_trace;
+
+}; // end class text_execution_reader
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief Builds the States of a binary trace only when they are asked for.
+
+class binary_execution_reader : public execution_reader
+{
+public:
+   explicit binary_execution_reader(const std::string& file_name)
+   : m_trace(file_name)
+   , m_cursor(m_trace.begin())
+   {
+   }
+
+   bool next() override
+   {
+      if (!m_cursor.next())
+         return false;
+      m_instr = m_trace.instruction(m_cursor.instr());
+      m_state = nullptr;
+      return true;
+   }
+
+   std::size_t index() const override { return m_cursor.index(); }
+   const visible_instruction_t& instr() const override { return *m_instr; }
+
+   State::SharedPtr state() override
+   {
+      if (!m_state)
+         m_state = m_trace.state(m_cursor);
+      return m_state;
+   }
+
+   Execution::Status status() const override { return m_trace.status(); }
+
+private:
+   binary_trace m_trace;
+   binary_trace::cursor m_cursor;
+   boost::optional<visible_instruction_t> m_instr;
+   State::SharedPtr m_state;
+
+}; // end class binary_execution_reader
+
+//--------------------------------------------------------------------------------------------------
+
+Thread::tid_t tid_of(const visible_instruction_t& instr)
+{
+   return boost::apply_visitor(program_model::get_tid(), instr);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief Compares instructions and States of two Executions, matching their Objects as given.
+/// @details By first use, an Object of lhs and one of rhs match if neither was compared before,
+/// or if they were matched before, so that the matching is a bijection.
+
+class object_matcher
+{
+public:
+   explicit object_matcher(const objects match)
+   : m_by_address(match == objects::by_address)
+   {
+   }
+
+   bool equal(const visible_instruction_t& lhs, const visible_instruction_t& rhs)
+   {
+      if (m_by_address)
+         return lhs == rhs;
+      if (lhs.which() != rhs.which() || tid_of(lhs) != tid_of(rhs) ||
+          boost::apply_visitor(operation_as_int(), lhs) !=
+             boost::apply_visitor(operation_as_int(), rhs) ||
+          !(boost::apply_visitor(get_meta_data(), lhs) ==
+            boost::apply_visitor(get_meta_data(), rhs)))
+         return false;
+      if (const auto* lhs_memory = boost::get<memory_instruction>(&lhs))
+      {
+         if (lhs_memory->is_atomic() != boost::get<memory_instruction>(rhs).is_atomic())
+            return false;
+      }
+      const auto lhs_operand = boost::apply_visitor(get_operand(), lhs);
+      const auto rhs_operand = boost::apply_visitor(get_operand(), rhs);
+      if (const auto* lhs_object = boost::get<Object>(&lhs_operand))
+         return match(*lhs_object, boost::get<Object>(rhs_operand));
+      return lhs_operand == rhs_operand;
+   }
+
+   bool equal(const next_t& lhs, const next_t& rhs)
+   {
+      return lhs.enabled == rhs.enabled && equal(lhs.instr, rhs.instr);
+   }
+
+   bool equal(const State& lhs, const State& rhs)
+   {
+      if (m_by_address)
+         return lhs == rhs;
+      return lhs.enabled() == rhs.enabled() &&
+             std::equal(lhs.next_set().begin(), lhs.next_set().end(), rhs.next_set().begin(),
+                        rhs.next_set().end(), [this](const auto& lhs_entry, const auto& rhs_entry) {
+                           return lhs_entry.first == rhs_entry.first &&
+                                  equal(lhs_entry.second, rhs_entry.second);
+                        });
+   }
+
+private:
+   bool m_by_address;
+   std::unordered_map<Object::ptr_t, std::size_t> m_lhs_objects;
+   std::unordered_map<Object::ptr_t, std::size_t> m_rhs_objects;
+
+   bool match(const Object& lhs, const Object& rhs)
+   {
+      const auto lhs_id = m_lhs_objects.find(lhs.address());
+      const auto rhs_id = m_rhs_objects.find(rhs.address());
+      if (lhs_id == m_lhs_objects.end() && rhs_id == m_rhs_objects.end())
+      {
+         const auto id = m_lhs_objects.size();
+         m_lhs_objects.emplace(lhs.address(), id);
+         m_rhs_objects.emplace(rhs.address(), id);
+         return true;
+      }
+      return lhs_id != m_lhs_objects.end() && rhs_id != m_rhs_objects.end() &&
+             lhs_id->second == rhs_id->second;
+   }
+
+}; // end class object_matcher
+
+//--------------------------------------------------------------------------------------------------
+
+divergence_t::side_t current(execution_reader& reader, const bool with_state)
+{
+   divergence_t::side_t side{reader.index(), boost::none, nullptr, boost::none};
+   if (reader.index() > 0)
+      side.instr = reader.instr();
+   if (with_state)
+      side.state = reader.state();
+   return side;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+divergence_t::side_t ended(const execution_reader& reader)
+{
+   return {reader.index() + 1, boost::none, nullptr, reader.status()};
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::vector<Thread::tid_t> differing_threads(const State& lhs, const State& rhs,
+                                             object_matcher& matcher)
+{
+   std::set<Thread::tid_t> tids(lhs.enabled().begin(), lhs.enabled().end());
+   tids.insert(rhs.enabled().begin(), rhs.enabled().end());
+   for (const auto& entry : lhs.next_set())
+      tids.insert(entry.first);
+   for (const auto& entry : rhs.next_set())
+      tids.insert(entry.first);
+
+   std::vector<Thread::tid_t> differing;
+   for (const auto tid : tids)
+   {
+      const auto lhs_next = lhs.next_set().find(tid);
+      const auto rhs_next = rhs.next_set().find(tid);
+      const bool lhs_has_next = lhs_next != lhs.next_set().end();
+      const bool rhs_has_next = rhs_next != rhs.next_set().end();
+      if (lhs.is_enabled(tid) != rhs.is_enabled(tid) || lhs_has_next != rhs_has_next ||
+          (lhs_has_next && !matcher.equal(lhs_next->second, rhs_next->second)))
+         differing.push_back(tid);
+   }
+   return differing;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+divergence_t make_divergence(const divergence_t::kind what, divergence_t::side_t lhs,
+                             divergence_t::side_t rhs,
+                             std::map<Thread::tid_t, divergence_t::context_t> context,
+                             object_matcher& matcher)
+{
+   divergence_t divergence{what, std::move(lhs), std::move(rhs), boost::none, std::move(context),
+                           {}};
+   if (divergence.lhs.instr && divergence.rhs.instr &&
+       tid_of(*divergence.lhs.instr) == tid_of(*divergence.rhs.instr))
+      divergence.tid = tid_of(*divergence.lhs.instr);
+   if (divergence.lhs.state && divergence.rhs.state)
+      divergence.differing_threads =
+         differing_threads(*divergence.lhs.state, *divergence.rhs.state, matcher);
+   return divergence;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+boost::optional<divergence_t> global_divergence(execution_reader& lhs, execution_reader& rhs,
+                                                object_matcher& matcher)
+{
+   using kind = divergence_t::kind;
+
+   std::map<Thread::tid_t, divergence_t::context_t> context;
+   if (!matcher.equal(*lhs.state(), *rhs.state()))
+      return make_divergence(kind::s0, current(lhs, true), current(rhs, true), context, matcher);
+
+   while (true)
+   {
+      const bool lhs_next = lhs.next();
+      const bool rhs_next = rhs.next();
+      if (!lhs_next && !rhs_next)
+      {
+         if (lhs.status() == rhs.status())
+            return boost::none;
+         return make_divergence(kind::status, ended(lhs), ended(rhs), std::move(context),
+                                matcher);
+      }
+      if (!lhs_next || !rhs_next)
+         return make_divergence(kind::length, lhs_next ? current(lhs, true) : ended(lhs),
+                                rhs_next ? current(rhs, true) : ended(rhs), std::move(context),
+                                matcher);
+      if (!matcher.equal(lhs.instr(), rhs.instr()))
+         return make_divergence(kind::instruction, current(lhs, true), current(rhs, true),
+                                std::move(context), matcher);
+      if (!matcher.equal(*lhs.state(), *rhs.state()))
+         return make_divergence(kind::state, current(lhs, true), current(rhs, true),
+                                std::move(context), matcher);
+
+      const auto tid = tid_of(lhs.instr());
+      auto it = context.find(tid);
+      if (it == context.end())
+         context.emplace(tid, divergence_t::context_t{1, lhs.instr()});
+      else
+         it->second = {it->second.nr_steps + 1, lhs.instr()};
+   }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief Pairs the k-th instructions of each thread of two Executions that are read in
+/// lockstep.
+
+class per_thread_aligner
+{
+public:
+   explicit per_thread_aligner(const objects match)
+   : m_matcher(match)
+   {
+   }
+
+   /// @brief Adds the current Transition of one of the Executions.
+   /// @returns the divergence if it pairs with a different instruction.
+
+   boost::optional<divergence_t> add(const bool from_lhs, const execution_reader& reader);
+
+   /// @brief The divergence of the earliest instruction that is left unpaired once both
+   /// Executions ended.
+
+   boost::optional<divergence_t> unpaired(const execution_reader& lhs,
+                                          const execution_reader& rhs);
+
+   /// @brief The divergence of Executions that end with a different status.
+
+   divergence_t status(const execution_reader& lhs, const execution_reader& rhs)
+   {
+      return make_divergence(divergence_t::kind::status, ended(lhs), ended(rhs), m_context,
+                             m_matcher);
+   }
+
+private:
+   struct pending_t
+   {
+      std::size_t step;
+      visible_instruction_t instr;
+   };
+
+   struct thread_t
+   {
+      /// @brief The instructions one Execution executed ahead of the other.
+      std::deque<pending_t> pending;
+      bool lhs_ahead = false;
+   };
+
+   object_matcher m_matcher;
+   std::map<Thread::tid_t, thread_t> m_threads;
+   std::map<Thread::tid_t, divergence_t::context_t> m_context;
+
+}; // end class per_thread_aligner
+
+//--------------------------------------------------------------------------------------------------
+
+boost::optional<divergence_t> per_thread_aligner::add(const bool from_lhs,
+                                                      const execution_reader& reader)
+{
+   const auto tid = tid_of(reader.instr());
+   auto& thread = m_threads[tid];
+   if (thread.pending.empty() || thread.lhs_ahead == from_lhs)
+   {
+      thread.pending.push_back({reader.index(), reader.instr()});
+      thread.lhs_ahead = from_lhs;
+      return boost::none;
+   }
+
+   const auto& other = thread.pending.front();
+   if (!m_matcher.equal(from_lhs ? reader.instr() : other.instr,
+                        from_lhs ? other.instr : reader.instr()))
+   {
+      divergence_t::side_t side{reader.index(), reader.instr(), nullptr, boost::none};
+      divergence_t::side_t other_side{other.step, other.instr, nullptr, boost::none};
+      return from_lhs ? make_divergence(divergence_t::kind::instruction, side, other_side,
+                                        m_context, m_matcher)
+                      : make_divergence(divergence_t::kind::instruction, other_side, side,
+                                        m_context, m_matcher);
+   }
+   thread.pending.pop_front();
+   auto it = m_context.find(tid);
+   if (it == m_context.end())
+      m_context.emplace(tid, divergence_t::context_t{1, reader.instr()});
+   else
+      it->second = {it->second.nr_steps + 1, reader.instr()};
+   return boost::none;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+boost::optional<divergence_t> per_thread_aligner::unpaired(const execution_reader& lhs,
+                                                           const execution_reader& rhs)
+{
+   const thread_t* first = nullptr;
+   for (const auto& entry : m_threads)
+   {
+      const auto& thread = entry.second;
+      if (!thread.pending.empty() &&
+          (!first || thread.pending.front().step < first->pending.front().step))
+         first = &thread;
+   }
+   if (!first)
+      return boost::none;
+
+   const auto& pending = first->pending.front();
+   divergence_t::side_t side{pending.step, pending.instr, nullptr, boost::none};
+   return first->lhs_ahead
+             ? make_divergence(divergence_t::kind::length, side, ended(rhs), m_context, m_matcher)
+             : make_divergence(divergence_t::kind::length, ended(lhs), side, m_context, m_matcher);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+boost::optional<divergence_t> per_thread_divergence(execution_reader& lhs, execution_reader& rhs,
+                                                    const objects match)
+{
+   per_thread_aligner aligner(match);
+   bool lhs_next = true;
+   bool rhs_next = true;
+   while (lhs_next || rhs_next)
+   {
+      if (lhs_next && (lhs_next = lhs.next()))
+      {
+         if (auto divergence = aligner.add(true, lhs))
+            return divergence;
+      }
+      if (rhs_next && (rhs_next = rhs.next()))
+      {
+         if (auto divergence = aligner.add(false, rhs))
+            return divergence;
+      }
+   }
+   if (auto divergence = aligner.unpaired(lhs, rhs))
+      return divergence;
+   if (lhs.status() != rhs.status())
+      return aligner.status(lhs, rhs);
+   return boost::none;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void print_side(std::ostream& os, const std::string& name, const divergence_t::side_t& side)
+{
+   os << name << ": ";
+   if (side.instr)
+      os << "step " << side.step << " " << *side.instr << "\n";
+   else if (side.status)
+      os << "ended after " << side.step - 1 << " steps with status " << *side.status << "\n";
+   else
+      os << "s0\n";
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void print_thread_state(std::ostream& os, const std::string& name, const State& s,
+                        const Thread::tid_t tid)
+{
+   os << "      " << name << ": " << (s.is_enabled(tid) ? "enabled" : "not enabled") << ", next ";
+   const auto next = s.next_set().find(tid);
+   if (next == s.next_set().end())
+      os << "none\n";
+   else
+      os << next->second << "\n";
+}
+
+} // end namespace
+
+//--------------------------------------------------------------------------------------------------
+
+std::unique_ptr<execution_reader> open_execution(const std::string& file_name)
+{
+   char magic[sizeof(binary::magic)] = {};
+   {
+      std::ifstream file(file_name, std::ios::binary);
+      if (!file)
+         throw std::runtime_error(file_name + ": cannot be opened");
+      file.read(magic, sizeof(magic));
+   }
+   if (std::equal(binary::magic, binary::magic + sizeof(binary::magic), magic))
+      return std::make_unique<binary_execution_reader>(file_name);
+   return std::make_unique<text_execution_reader>(file_name);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+boost::optional<divergence_t> first_divergence(execution_reader& lhs, execution_reader& rhs,
+                                               const alignment align, const objects match)
+{
+   if (align == alignment::per_thread)
+      return per_thread_divergence(lhs, rhs, match);
+   object_matcher matcher(match);
+   return global_divergence(lhs, rhs, matcher);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+boost::optional<divergence_t> first_divergence(const std::string& lhs_file,
+                                               const std::string& rhs_file,
+                                               const alignment align, const objects match)
+{
+   const auto lhs = open_execution(lhs_file);
+   const auto rhs = open_execution(rhs_file);
+   return first_divergence(*lhs, *rhs, align, match);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::string to_string(const divergence_t::kind& what)
+{
+   switch (what)
+   {
+      case divergence_t::kind::s0:
+         return "s0";
+      case divergence_t::kind::instruction:
+         return "instruction";
+      case divergence_t::kind::state:
+         return "state";
+      case divergence_t::kind::length:
+         return "length";
+      case divergence_t::kind::status:
+         return "status";
+   }
+   return "";
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::ostream& operator<<(std::ostream& os, const divergence_t& divergence)
+{
+   os << "first divergence: " << to_string(divergence.what);
+   if (divergence.tid)
+      os << " of thread " << *divergence.tid;
+   os << "\n";
+   print_side(os, "lhs", divergence.lhs);
+   print_side(os, "rhs", divergence.rhs);
+
+   os << "thread context:\n";
+   for (const auto& entry : divergence.context)
+   {
+      os << "   thread " << entry.first << ": " << entry.second.nr_steps << " steps, last "
+         << entry.second.last << "\n";
+   }
+
+   if (!divergence.differing_threads.empty())
+   {
+      os << "differing threads:\n";
+      for (const auto tid : divergence.differing_threads)
+      {
+         os << "   thread " << tid << "\n";
+         print_thread_state(os, "lhs", *divergence.lhs.state, tid);
+         print_thread_state(os, "rhs", *divergence.rhs.state, tid);
+      }
+   }
+   return os;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+} // end namespace program_model
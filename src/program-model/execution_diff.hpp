@@ -0,0 +1,167 @@
+#pragma once
+
+#include "execution.hpp"
+
+#include <boost/optional.hpp>
+
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------
+/// @file execution_diff.hpp
+/// @brief Streaming comparison of two recorded Executions.
+/// @author Susanne van den Elsen
+/// @date 2015-2017
+//--------------------------------------------------------------------------------------------------
+
+
+namespace program_model {
+
+/// @brief Sequential access to the Transitions of a recorded Execution, whatever its format.
+
+class execution_reader
+{
+public:
+   virtual ~execution_reader() = default;
+
+   /// @brief Advances to the next Transition.
+   /// @returns false at the end of the Execution.
+
+   virtual bool next() = 0;
+
+   /// @brief The index of the current Transition, 0 for s0.
+
+   virtual std::size_t index() const = 0;
+
+   /// @pre index() > 0
+
+   virtual const visible_instruction_t& instr() const = 0;
+
+   /// @brief s0 or the post-State of the current Transition.
+
+   virtual State::SharedPtr state() = 0;
+
+   /// @brief The status of the Execution, known once next returned false.
+
+   virtual Execution::Status status() const = 0;
+
+}; // end class execution_reader
+
+/// @brief Opens the binary trace or text record file_name, telling them apart by the magic
+/// bytes of the binary format.
+/// @throws std::runtime_error if the file cannot be read or has no initial State.
+
+std::unique_ptr<execution_reader> open_execution(const std::string& file_name);
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief How the Transitions of two Executions are paired.
+
+enum class alignment
+{
+   /// @brief The i-th Transitions are paired, and their post-States are compared.
+   global,
+   /// @brief The k-th instructions of each thread are paired, so that a divergence is found
+   /// even if the interleavings differ. States are not compared.
+   per_thread
+};
+
+/// @brief How the Objects of two Executions are matched.
+
+enum class objects
+{
+   /// @brief Objects match if both Executions first use them at the same point of the
+   /// comparison, so that the Executions of different processes, whose addresses differ from
+   /// run to run, can be equal.
+   by_first_use,
+   /// @brief Objects match if they have the same address.
+   by_address
+};
+
+/// @brief Where two Executions diverge.
+
+struct divergence_t
+{
+   enum class kind
+   {
+      /// @brief The initial States differ.
+      s0,
+      /// @brief The paired Transitions execute different instructions.
+      instruction,
+      /// @brief The paired Transitions execute the same instruction into different post-States.
+      state,
+      /// @brief One Execution (or, per thread, one thread) has a Transition the other lacks.
+      length,
+      /// @brief The Executions agree on all Transitions, but end with a different status.
+      status
+   };
+
+   /// @brief What one of the Executions has at the divergence.
+
+   struct side_t
+   {
+      /// @brief The index of the Transition, 0 for s0, or one past the last Transition if
+      /// the Execution has none to pair.
+      std::size_t step;
+      boost::optional<visible_instruction_t> instr;
+      /// @brief The post-State of the Transition, with global alignment only.
+      State::SharedPtr state;
+      /// @brief The status of the Execution if it ended before the divergence.
+      boost::optional<Execution::Status> status;
+   };
+
+   /// @brief What a thread did before the divergence, in both Executions.
+
+   struct context_t
+   {
+      /// @brief The number of instructions of the thread that were paired.
+      std::size_t nr_steps;
+      /// @brief The last of them.
+      visible_instruction_t last;
+   };
+
+   kind what;
+   side_t lhs;
+   side_t rhs;
+
+   /// @brief The thread of the diverging Transitions, if they have the same one.
+   boost::optional<Thread::tid_t> tid;
+
+   /// @brief Per thread, its last paired instruction.
+   std::map<Thread::tid_t, context_t> context;
+
+   /// @brief The threads whose enabledness or NextSet entry differs between lhs.state and
+   /// rhs.state.
+   std::vector<Thread::tid_t> differing_threads;
+};
+
+/// @brief Reads lhs and rhs in lockstep up to their first divergence.
+/// @details With global alignment only the current States and one instruction per thread are
+/// kept. With per-thread alignment, the instructions of a thread that one Execution executed
+/// ahead of the other wait to be paired, so memory grows with how far the interleavings drift
+/// apart, not with their length; the divergence found first is the one whose later Transition
+/// comes first.
+/// @returns boost::none if the Executions are equal under the alignment.
+
+boost::optional<divergence_t> first_divergence(execution_reader& lhs, execution_reader& rhs,
+                                               const alignment align = alignment::global,
+                                               const objects match = objects::by_first_use);
+
+/// @brief first_divergence of the Executions in the given files, see open_execution.
+
+boost::optional<divergence_t> first_divergence(const std::string& lhs_file,
+                                               const std::string& rhs_file,
+                                               const alignment align = alignment::global,
+                                               const objects match = objects::by_first_use);
+
+std::string to_string(const divergence_t::kind&);
+
+/// @brief Prints a report of the divergence: the diverging Transitions, the context of every
+/// thread and the differing NextSet entries.
+
+std::ostream& operator<<(std::ostream&, const divergence_t&);
+
+} // end namespace program_model
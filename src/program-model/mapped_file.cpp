@@ -0,0 +1,109 @@
+
+#include "mapped_file.hpp"
+
+#include <cerrno>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace program_model {
+
+//--------------------------------------------------------------------------------------------------
+
+constexpr std::size_t mapped_file::read_threshold;
+
+//--------------------------------------------------------------------------------------------------
+
+mapped_file::mapped_file(const std::string& file_name)
+: m_data(nullptr)
+, m_size(0)
+, m_buffer()
+{
+   const int fd = ::open(file_name.c_str(), O_RDONLY);
+   if (fd < 0)
+      throw std::runtime_error("cannot open " + file_name);
+   struct stat info;
+   if (::fstat(fd, &info) != 0)
+   {
+      ::close(fd);
+      throw std::runtime_error("cannot stat " + file_name);
+   }
+   m_size = static_cast<std::size_t>(info.st_size);
+   if (m_size > 0 && m_size < read_threshold)
+   {
+      m_buffer.reset(new char[m_size]);
+      std::size_t nr_read = 0;
+      while (nr_read < m_size)
+      {
+         const auto n = ::read(fd, m_buffer.get() + nr_read, m_size - nr_read);
+         if (n < 0 && errno == EINTR)
+            continue;
+         if (n <= 0)
+         {
+            ::close(fd);
+            throw std::runtime_error("cannot read " + file_name);
+         }
+         nr_read += static_cast<std::size_t>(n);
+      }
+      m_data = m_buffer.get();
+   }
+   // An empty file cannot be mapped, but is a valid (empty) range
+   else if (m_size > 0)
+   {
+      void* data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data == MAP_FAILED)
+      {
+         ::close(fd);
+         throw std::runtime_error("cannot map " + file_name);
+      }
+      m_data = static_cast<const char*>(data);
+   }
+   ::close(fd);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+mapped_file::~mapped_file()
+{
+   if (m_data != nullptr && !m_buffer)
+      ::munmap(const_cast<char*>(m_data), m_size);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+mapped_file::mapped_file(mapped_file&& other) noexcept
+: m_data(other.m_data)
+, m_size(other.m_size)
+, m_buffer(std::move(other.m_buffer))
+{
+   other.m_data = nullptr;
+   other.m_size = 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+const char* mapped_file::begin() const
+{
+   return m_data;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+const char* mapped_file::end() const
+{
+   return m_data + m_size;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::size_t mapped_file::size() const
+{
+   return m_size;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+} // end namespace program_model
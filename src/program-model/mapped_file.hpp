@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+//--------------------------------------------------------------------------------------------------
+/// @file mapped_file.hpp
+/// @author Susanne van den Elsen
+/// @date 2015-2017
+//--------------------------------------------------------------------------------------------------
+
+
+namespace program_model {
+
+/// @brief A file mapped read-only into memory.
+/// @details A file smaller than read_threshold is read into a buffer instead: for the small
+/// records of most test programs, setting up and tearing down the mapping costs more than
+/// copying the file.
+
+class mapped_file
+{
+public:
+   static constexpr std::size_t read_threshold = 1 << 20;
+
+   /// @throws std::runtime_error if the file cannot be opened, mapped or read.
+
+   explicit mapped_file(const std::string& file_name);
+   ~mapped_file();
+
+   mapped_file(mapped_file&& other) noexcept;
+   mapped_file& operator=(mapped_file&& other) = delete;
+   mapped_file(const mapped_file&) = delete;
+   mapped_file& operator=(const mapped_file&) = delete;
+
+   const char* begin() const;
+   const char* end() const;
+   std::size_t size() const;
+
+private:
+   const char* m_data;
+   std::size_t m_size;
+
+   /// @brief Holds the file if it is read rather than mapped.
+   std::unique_ptr<char[]> m_buffer;
+
+}; // end class mapped_file
+
+} // end namespace program_model
@@ -0,0 +1,458 @@
+#include "next_set.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <stdexcept>
+
+
+namespace program_model {
+
+//--------------------------------------------------------------------------------------------------
+
+namespace {
+
+constexpr unsigned int branching_bits = 3;
+constexpr unsigned int branching = 1u << branching_bits;
+
+/// @brief The level of a root that indexes the highest bits of the keys.
+constexpr unsigned int max_level = 31 / branching_bits;
+
+static_assert(sizeof(Thread::tid_t) == sizeof(std::uint32_t), "keys are 32-bit");
+
+/// @brief Maps tid to a key whose unsigned order is the order of the tids.
+
+std::uint32_t key(const Thread::tid_t tid)
+{
+   return static_cast<std::uint32_t>(tid) ^ 0x80000000u;
+}
+
+/// @brief The index of the child of a node at the given level on the path to key.
+
+unsigned int index(const std::uint32_t key, const unsigned int level)
+{
+   return (key >> (branching_bits * level)) % branching;
+}
+
+/// @brief The bits of key above the ones indexing a node at the given level.
+
+std::uint32_t prefix(const std::uint32_t key, const unsigned int level)
+{
+   return level >= max_level ? 0 : key >> (branching_bits * (level + 1));
+}
+
+} // end namespace
+
+//--------------------------------------------------------------------------------------------------
+
+struct NextSet::entry
+{
+   entry(const key_type& tid, next_t next)
+   : value(tid, std::move(next))
+   {
+   }
+
+   mutable std::atomic<std::uint32_t> references{0};
+   const value_type value;
+};
+
+//--------------------------------------------------------------------------------------------------
+
+/// @details The children of a node at level 0 are entries, those of a node at a higher level
+/// are nodes. Nodes without children are removed from their parent.
+
+struct NextSet::node
+{
+   using ptr = boost::intrusive_ptr<node>;
+
+   explicit node(const unsigned int level)
+   : level(level)
+   {
+   }
+
+   node(const node& other)
+   : level(other.level)
+   , children(other.children)
+   {
+      for (const auto* child : children)
+         if (child)
+            retain(child);
+   }
+
+   node& operator=(const node&) = delete;
+
+   ~node()
+   {
+      for (const auto* child : children)
+         if (child)
+            release(child);
+   }
+
+   const node* child_node(const unsigned int i) const
+   {
+      return static_cast<const node*>(children[i]);
+   }
+
+   const entry* child_entry(const unsigned int i) const
+   {
+      return static_cast<const entry*>(children[i]);
+   }
+
+   void replace(const unsigned int i, const void* child)
+   {
+      if (child)
+         retain(child);
+      if (children[i])
+         release(children[i]);
+      children[i] = child;
+   }
+
+   /// @brief The first entry below this node.
+
+   const entry* first() const
+   {
+      const auto it = std::find_if(children.begin(), children.end(),
+                                   [](const void* child) { return child != nullptr; });
+      return level == 0 ? static_cast<const entry*>(*it) : static_cast<const node*>(*it)->first();
+   }
+
+   /// @brief The first entry below this node whose key is not less than key.
+   /// @pre key has the prefix of this node.
+
+   const entry* lower_bound(const std::uint32_t key) const
+   {
+      const auto i = index(key, level);
+      for (auto j = i; j < branching; ++j)
+      {
+         if (!children[j])
+            continue;
+         if (level == 0)
+            return child_entry(j);
+         const auto* found = j == i ? child_node(j)->lower_bound(key) : child_node(j)->first();
+         if (found)
+            return found;
+      }
+      return nullptr;
+   }
+
+   /// @brief Returns a copy of n (or a new node at level if n is null) in which e is the entry
+   /// for key, and sets inserted if n had no entry for key yet.
+   /// @details Only the nodes on the path to key are copied, all others are shared with n.
+
+   static ptr assign(const node* n, const unsigned int level, const std::uint32_t key,
+                     const entry* e, bool& inserted)
+   {
+      ptr copy(n ? new node(*n) : new node(level));
+      const auto i = index(key, level);
+      if (level == 0)
+      {
+         inserted = copy->children[i] == nullptr;
+         copy->replace(i, e);
+      }
+      else
+      {
+         copy->replace(i, assign(copy->child_node(i), level - 1, key, e, inserted).get());
+      }
+      return copy;
+   }
+
+   /// @brief Returns a copy of n without the entry for key, or null if that leaves n empty.
+   /// @pre n has an entry for key.
+
+   static ptr remove(const node& n, const std::uint32_t key)
+   {
+      ptr copy(new node(n));
+      const auto i = index(key, n.level);
+      copy->replace(i, n.level == 0 ? nullptr : remove(*n.child_node(i), key).get());
+      if (std::all_of(copy->children.begin(), copy->children.end(),
+                      [](const void* child) { return child == nullptr; }))
+         return nullptr;
+      return copy;
+   }
+
+   mutable std::atomic<std::uint32_t> references{0};
+   const unsigned int level;
+   std::array<const void*, branching> children{};
+
+private:
+   void retain(const void* child) const
+   {
+      if (level == 0)
+         intrusive_ptr_add_ref(static_cast<const entry*>(child));
+      else
+         intrusive_ptr_add_ref(static_cast<const node*>(child));
+   }
+
+   void release(const void* child) const
+   {
+      if (level == 0)
+         intrusive_ptr_release(static_cast<const entry*>(child));
+      else
+         intrusive_ptr_release(static_cast<const node*>(child));
+   }
+};
+
+//--------------------------------------------------------------------------------------------------
+
+void intrusive_ptr_add_ref(const NextSet::node* n)
+{
+   n->references.fetch_add(1, std::memory_order_relaxed);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void intrusive_ptr_release(const NextSet::node* n)
+{
+   if (n->references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      delete n;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void intrusive_ptr_add_ref(const NextSet::entry* e)
+{
+   e->references.fetch_add(1, std::memory_order_relaxed);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void intrusive_ptr_release(const NextSet::entry* e)
+{
+   if (e->references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      delete e;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+NextSet::const_iterator::const_iterator(const node* root, const unsigned int level,
+                                        const entry* current)
+: m_root(root)
+, m_level(level)
+, m_entry(current)
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+
+auto NextSet::const_iterator::dereference() const -> const value_type&
+{
+   return m_entry->value;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool NextSet::const_iterator::equal(const const_iterator& other) const
+{
+   return m_entry == other.m_entry;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void NextSet::const_iterator::increment()
+{
+   const auto current = key(m_entry->value.first);
+   const auto next = current + 1;
+   // The entries below the root share the prefix of current
+   if (next == 0 || prefix(next, m_level) != prefix(current, m_level))
+      m_entry = nullptr;
+   else
+      m_entry = m_root->lower_bound(next);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+NextSet::NextSet()
+: m_root()
+, m_level(0)
+, m_prefix(0)
+, m_size(0)
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+
+NextSet::NextSet(std::initializer_list<value_type> entries)
+: NextSet(entries.begin(), entries.end())
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool NextSet::operator==(const NextSet& other) const
+{
+   if (m_root == other.m_root)
+      return true;
+   if (m_size != other.m_size)
+      return false;
+   return std::equal(begin(), end(), other.begin(), [](const auto& lhs, const auto& rhs) {
+      return &lhs == &rhs || (lhs.first == rhs.first && lhs.second == rhs.second);
+   });
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool NextSet::operator!=(const NextSet& other) const
+{
+   return !(*this == other);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+auto NextSet::begin() const -> const_iterator
+{
+   return const_iterator(m_root.get(), m_level, m_root ? m_root->first() : nullptr);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+auto NextSet::end() const -> const_iterator
+{
+   return const_iterator(m_root.get(), m_level, nullptr);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+auto NextSet::cbegin() const -> const_iterator
+{
+   return begin();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+auto NextSet::cend() const -> const_iterator
+{
+   return end();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+auto NextSet::size() const -> size_type
+{
+   return m_size;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool NextSet::empty() const
+{
+   return m_size == 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+auto NextSet::find(const key_type& tid) const -> const_iterator
+{
+   return const_iterator(m_root.get(), m_level, find_entry(tid));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+auto NextSet::count(const key_type& tid) const -> size_type
+{
+   return find_entry(tid) ? 1 : 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+const next_t& NextSet::at(const key_type& tid) const
+{
+   const auto* e = find_entry(tid);
+   if (!e)
+      throw std::out_of_range("NextSet::at");
+   return e->value.second;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+const next_t& NextSet::operator[](const key_type& tid) const
+{
+   return at(tid);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+auto NextSet::insert(const value_type& entry) -> std::pair<const_iterator, bool>
+{
+   const auto it = find(entry.first);
+   if (it != end())
+      return {it, false};
+   set(entry.first, entry.second);
+   return {find(entry.first), true};
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void NextSet::set(const key_type& tid, next_t next)
+{
+   const auto k = key(tid);
+   const entry_ptr e(new entry(tid, std::move(next)));
+   if (!m_root)
+   {
+      m_level = 0;
+      m_prefix = prefix(k, 0);
+   }
+   // Raise the root until it covers k
+   while (prefix(k, m_level) != m_prefix)
+   {
+      node::ptr parent(new node(m_level + 1));
+      parent->replace(m_prefix % branching, m_root.get());
+      m_root = std::move(parent);
+      ++m_level;
+      m_prefix >>= branching_bits;
+   }
+   bool inserted = false;
+   m_root = node::assign(m_root.get(), m_level, k, e.get(), inserted);
+   if (inserted)
+      ++m_size;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+auto NextSet::erase(const key_type& tid) -> size_type
+{
+   if (!find_entry(tid))
+      return 0;
+   m_root = node::remove(*m_root, key(tid));
+   --m_size;
+   // Lower the root while it has a single child, so that the levels stay as few as the keys need
+   while (m_root && m_level > 0 &&
+          std::count(m_root->children.begin(), m_root->children.end(), nullptr) == branching - 1)
+   {
+      const auto i = static_cast<unsigned int>(
+         std::find_if(m_root->children.begin(), m_root->children.end(),
+                      [](const void* child) { return child != nullptr; }) -
+         m_root->children.begin());
+      m_root = m_root->child_node(i);
+      --m_level;
+      m_prefix = (m_prefix << branching_bits) | i;
+   }
+   return 1;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+auto NextSet::to_map() const -> map_type
+{
+   return map_type(begin(), end());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+auto NextSet::find_entry(const key_type& tid) const -> const entry*
+{
+   const auto k = key(tid);
+   if (!m_root || prefix(k, m_level) != m_prefix)
+      return nullptr;
+   const node* n = m_root.get();
+   for (auto level = m_level; level > 0; --level)
+   {
+      n = n->child_node(index(k, level));
+      if (!n)
+         return nullptr;
+   }
+   return n->child_entry(index(k, 0));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+} // end namespace program_model
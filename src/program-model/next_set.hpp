@@ -0,0 +1,156 @@
+#pragma once
+
+#include "visible_instruction.hpp"
+
+#include <boost/iterator/iterator_facade.hpp>
+#include <boost/smart_ptr/intrusive_ptr.hpp>
+
+#include <cstdint>
+#include <initializer_list>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------
+/// @file next_set.hpp
+/// @author Susanne van den Elsen
+/// @date 2015-2017
+//--------------------------------------------------------------------------------------------------
+
+
+namespace program_model {
+
+struct next_t
+{
+   visible_instruction_t instr;
+   bool enabled;
+};
+
+inline bool operator==(const next_t& lhs, const next_t& rhs)
+{
+   return lhs.instr == rhs.instr && lhs.enabled == rhs.enabled;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief Persistent map from Thread::tid_t to next_t.
+/// @details The entries are immutable and kept in a trie of nodes with eight children each,
+/// indexed by three bits of the tid at a time. Nodes and entries are shared between copies of a
+/// NextSet: modifying a copy only copies the nodes on the path to the entry that changes, so
+/// consecutive States that differ in a single thread's next instruction share everything else
+/// and a step costs one node per three bits of the tids in use rather than a copy per thread.
+/// The entries are iterated in the order of their tids.
+
+class NextSet
+{
+private:
+   struct node;
+   struct entry;
+   using node_ptr = boost::intrusive_ptr<const node>;
+   using entry_ptr = boost::intrusive_ptr<const entry>;
+
+public:
+   using key_type = Thread::tid_t;
+   using mapped_type = next_t;
+   using value_type = std::pair<const key_type, mapped_type>;
+   using size_type = std::size_t;
+   using map_type = std::unordered_map<key_type, mapped_type>;
+
+   /// @brief Forward iterator over the entries, valid as long as the NextSet is not modified.
+
+   class const_iterator : public boost::iterator_facade<const_iterator, const value_type,
+                                                        boost::forward_traversal_tag>
+   {
+   public:
+      const_iterator() = default;
+
+   private:
+      const_iterator(const node* root, unsigned int level, const entry* current);
+
+      const node* m_root = nullptr;
+      unsigned int m_level = 0;
+      const entry* m_entry = nullptr;
+
+      const value_type& dereference() const;
+      bool equal(const const_iterator&) const;
+      void increment();
+
+      friend class NextSet;
+      friend class boost::iterator_core_access;
+   };
+
+   using iterator = const_iterator;
+
+   /// @{
+   /// Lifetime
+   NextSet();
+   NextSet(std::initializer_list<value_type> entries);
+
+   template <typename InputIt>
+   NextSet(InputIt first, InputIt last)
+   : NextSet()
+   {
+      for (; first != last; ++first)
+         set(first->first, first->second);
+   }
+   /// @}
+
+   bool operator==(const NextSet&) const;
+   bool operator!=(const NextSet&) const;
+
+   const_iterator begin() const;
+   const_iterator end() const;
+   const_iterator cbegin() const;
+   const_iterator cend() const;
+
+   size_type size() const;
+   bool empty() const;
+
+   const_iterator find(const key_type& tid) const;
+   size_type count(const key_type& tid) const;
+
+   /// @throws std::out_of_range if there is no entry for tid.
+
+   const next_t& at(const key_type& tid) const;
+   const next_t& operator[](const key_type& tid) const;
+
+   /// @brief Inserts entry if there is no entry for its key yet.
+
+   std::pair<const_iterator, bool> insert(const value_type& entry);
+
+   /// @brief Inserts or replaces the entry for tid.
+
+   void set(const key_type& tid, next_t next);
+
+   size_type erase(const key_type& tid);
+
+   /// @brief Returns an unordered_map holding copies of the entries.
+
+   map_type to_map() const;
+
+private:
+   /// @brief The root of the trie, null if the NextSet is empty.
+
+   node_ptr m_root;
+
+   /// @brief The level of m_root, where the children of a node at level l are indexed by bits
+   /// [3l, 3l + 3) of the keys and the children at level 0 are the entries.
+
+   unsigned int m_level;
+
+   /// @brief The bits of the keys above the ones that index m_root, shared by all keys.
+
+   std::uint32_t m_prefix;
+
+   size_type m_size;
+
+   const entry* find_entry(const key_type& tid) const;
+
+   friend void intrusive_ptr_add_ref(const node*);
+   friend void intrusive_ptr_release(const node*);
+   friend void intrusive_ptr_add_ref(const entry*);
+   friend void intrusive_ptr_release(const entry*);
+
+}; // end class NextSet
+
+} // end namespace program_model
@@ -13,16 +13,31 @@ const std::string State::mTag = "State";
 //--------------------------------------------------------------------------------------------------
 
 State::State(const Tids& enabled, const NextSet& next)
-: mEnabled(enabled)
+: mEnabled(std::make_shared<const Tids>(enabled))
 , mNext(next)
 {
 }
 
 //--------------------------------------------------------------------------------------------------
 
+State::State(shared_enabled_t, TidsPtr enabled, NextSet next)
+: mEnabled(std::move(enabled))
+, mNext(std::move(next))
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+
+auto State::create(TidsPtr enabled, NextSet next) -> SharedPtr
+{
+   return SharedPtr(new State(shared_enabled_t{}, std::move(enabled), std::move(next)));
+}
+
+//--------------------------------------------------------------------------------------------------
+
 bool State::operator==(const State& other) const
 {
-   return mEnabled == other.mEnabled && mNext == other.mNext;
+   return (mEnabled == other.mEnabled || *mEnabled == *(other.mEnabled)) && mNext == other.mNext;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -35,15 +50,29 @@ std::string State::tag() const
 //--------------------------------------------------------------------------------------------------
 
 const Tids& State::enabled() const
+{
+   return *mEnabled;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+auto State::enabled_ptr() const -> const TidsPtr&
 {
    return mEnabled;
 }
 
 //--------------------------------------------------------------------------------------------------
 
+const NextSet& State::next_set() const
+{
+   return mNext;
+}
+
+//--------------------------------------------------------------------------------------------------
+
 bool State::is_enabled(const Thread::tid_t& tid) const
 {
-   return mEnabled.find(tid) != mEnabled.end();
+   return mEnabled->find(tid) != mEnabled->end();
 }
 
 //--------------------------------------------------------------------------------------------------
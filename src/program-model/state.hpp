@@ -1,8 +1,9 @@
 #pragma once
 
+#include "next_set.hpp"
 #include "visible_instruction.hpp"
 
-#include <unordered_map>
+#include <memory>
 
 //--------------------------------------------------------------------------------------------------
 /// @file state.hpp
@@ -13,31 +14,24 @@
 
 namespace program_model {
 
-struct next_t
-{
-   visible_instruction_t instr;
-   bool enabled;
-};
-
-inline bool operator==(const next_t& lhs, const next_t& rhs)
-{
-   return lhs.instr == rhs.instr && lhs.enabled == rhs.enabled;
-}
-
-// Type definitions
-using NextSet = std::unordered_map<Thread::tid_t, next_t>;
-
-//--------------------------------------------------------------------------------------------------
+/// @details A State shares its enabled set and the entries of its NextSet with the States
+/// it was derived from, so that consecutive States in an Execution only store what changed.
 
 class State
 {
 public:
    using SharedPtr = std::shared_ptr<State>;
+   using TidsPtr = std::shared_ptr<const Tids>;
 
    /// @brief Constructor.
 
    State(const Tids& enabled, const NextSet& next);
-   
+
+   /// @brief Creates a State sharing the given enabled set.
+   /// @note Not a constructor, so that State({...}, {...}) stays unambiguous.
+
+   static SharedPtr create(TidsPtr enabled, NextSet next);
+
    bool operator==(const State&) const;
 
    /// @brief Getter.
@@ -50,6 +44,14 @@ public:
 
    /// @brief Getter.
 
+   const TidsPtr& enabled_ptr() const;
+
+   /// @brief Getter.
+
+   const NextSet& next_set() const;
+
+   /// @brief Getter.
+
    bool is_enabled(const Thread::tid_t& tid) const;
 
    const NextSet::const_iterator next(const Thread::tid_t& tid) const;
@@ -61,9 +63,15 @@ public:
    bool has_next(const Thread::tid_t& tid) const;
 
 private:
+   struct shared_enabled_t
+   {
+   };
+
+   State(shared_enabled_t, TidsPtr enabled, NextSet next);
+
    static const std::string mTag;
 
-   Tids mEnabled;
+   TidsPtr mEnabled;
 
    /// @brief @brief <code>{(next_{this}(p),enabled(this,p)) | p in Tids }</code>.
 
@@ -41,6 +41,26 @@ std::ostream& operator<<(std::ostream& os, const next_t& next)
 
 //--------------------------------------------------------------------------------------------------
 
+std::istream& operator>>(std::istream& is, NextSet& next_set)
+{
+   NextSet::map_type entries{};
+   if (is >> entries)
+   {
+      next_set = NextSet(entries.begin(), entries.end());
+   }
+   return is;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::ostream& operator<<(std::ostream& os, const NextSet& next_set)
+{
+   os << next_set.to_map();
+   return os;
+}
+
+//--------------------------------------------------------------------------------------------------
+
 std::istream& operator>>(std::istream& is, State& state)
 {
    std::string tag{};
@@ -48,7 +68,11 @@ std::istream& operator>>(std::istream& is, State& state)
    {
       if (tag == "State")
       {
-         is >> state.mEnabled >> state.mNext;
+         Tids enabled{};
+         if (is >> enabled >> state.mNext)
+         {
+            state.mEnabled = std::make_shared<const Tids>(std::move(enabled));
+         }
       }
       else
       {
@@ -15,11 +15,15 @@ namespace program_model {
 
 // Forward declarations
 struct next_t;
+class NextSet;
 class State;
 
 std::istream& operator>>(std::istream&, next_t&);
 std::ostream& operator<<(std::ostream&, const next_t&);
 
+std::istream& operator>>(std::istream&, NextSet&);
+std::ostream& operator<<(std::ostream&, const NextSet&);
+
 std::istream& operator>>(std::istream&, State&);
 std::istream& operator>>(std::istream&, std::shared_ptr<State>&);
 std::ostream& operator<<(std::ostream&, const State&);
@@ -0,0 +1,1407 @@
+
+#include "text_trace.hpp"
+
+#include "execution_io.hpp"
+#include "mapped_file.hpp"
+#include "state_io.hpp"
+#include "visible_instruction_io.hpp"
+
+#include <container_io.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <istream>
+#include <limits>
+#include <sstream>
+#include <streambuf>
+#include <unordered_map>
+
+
+namespace program_model {
+
+//--------------------------------------------------------------------------------------------------
+
+namespace {
+
+/// @brief Thrown by the scanner on input that it does not read itself. The loaders then leave
+/// the Transition to operator>>.
+
+struct parse_failure
+{
+};
+
+//--------------------------------------------------------------------------------------------------
+
+struct space_table
+{
+   bool table[256] = {};
+
+   space_table()
+   {
+      for (const unsigned char c : {' ', '\n', '\t', '\r', '\v', '\f'})
+         table[c] = true;
+   }
+};
+
+const space_table spaces{};
+
+bool is_space(const char c)
+{
+   return spaces.table[static_cast<unsigned char>(c)];
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief A range of characters in the mapped file.
+
+struct span_t
+{
+   const char* data;
+   std::size_t size;
+
+   bool operator==(const span_t& other) const
+   {
+      return size == other.size && std::memcmp(data, other.data, size) == 0;
+   }
+
+   bool operator==(const char* str) const
+   {
+      return size == std::strlen(str) && std::memcmp(data, str, size) == 0;
+   }
+};
+
+struct span_hash
+{
+   std::size_t operator()(const span_t& span) const
+   {
+      std::size_t hash = 14695981039346656037ull;
+      for (std::size_t i = 0; i < span.size; ++i)
+         hash = (hash ^ static_cast<unsigned char>(span.data[i])) * 1099511628211ull;
+      return hash;
+   }
+};
+
+//--------------------------------------------------------------------------------------------------
+
+class scanner
+{
+public:
+   scanner(const char* begin, const char* end)
+   : m_pos(begin)
+   , m_end(end)
+   {
+   }
+
+   bool at_end()
+   {
+      skip_space();
+      return m_pos == m_end;
+   }
+
+   char peek()
+   {
+      if (at_end())
+         throw parse_failure();
+      return *m_pos;
+   }
+
+   /// @brief Reads what operator>>(std::istream&, std::string&) reads.
+
+   span_t word()
+   {
+      if (at_end())
+         throw parse_failure();
+      const char* begin = m_pos;
+      while (m_pos != m_end && !is_space(*m_pos))
+         ++m_pos;
+      return {begin, static_cast<std::size_t>(m_pos - begin)};
+   }
+
+   /// @brief Reads a decimal number that fits an int.
+
+   std::int64_t integer()
+   {
+      if (at_end())
+         throw parse_failure();
+      bool negative = false;
+      if (*m_pos == '-' || *m_pos == '+')
+      {
+         negative = *m_pos == '-';
+         ++m_pos;
+      }
+      const char* begin = m_pos;
+      std::int64_t value = 0;
+      while (m_pos != m_end && *m_pos >= '0' && *m_pos <= '9')
+      {
+         value = value * 10 + (*m_pos - '0');
+         if (value > std::numeric_limits<int>::max())
+            throw parse_failure();
+         ++m_pos;
+      }
+      if (m_pos == begin)
+         throw parse_failure();
+      return negative ? -value : value;
+   }
+
+   /// @brief Reads a hexadecimal number with optional 0x prefix, like operator>> with std::hex.
+
+   std::uint64_t hex()
+   {
+      if (at_end())
+         throw parse_failure();
+      if (m_end - m_pos >= 2 && m_pos[0] == '0' && (m_pos[1] == 'x' || m_pos[1] == 'X'))
+         m_pos += 2;
+      const char* begin = m_pos;
+      std::uint64_t value = 0;
+      for (; m_pos != m_end; ++m_pos)
+      {
+         const char c = *m_pos;
+         if (c >= '0' && c <= '9')
+            value = (value << 4) | static_cast<std::uint64_t>(c - '0');
+         else if (c >= 'a' && c <= 'f')
+            value = (value << 4) | static_cast<std::uint64_t>(c - 'a' + 10);
+         else if (c >= 'A' && c <= 'F')
+            value = (value << 4) | static_cast<std::uint64_t>(c - 'A' + 10);
+         else
+            break;
+      }
+      if (m_pos == begin || m_pos - begin > 16)
+         throw parse_failure();
+      return value;
+   }
+
+   void skip_space()
+   {
+      while (m_pos != m_end && is_space(*m_pos))
+         ++m_pos;
+   }
+
+   /// @brief The position of the next token.
+
+   const char* position()
+   {
+      skip_space();
+      return m_pos;
+   }
+
+   /// @brief The position right after the last token read.
+
+   const char* current() const { return m_pos; }
+
+   /// @brief Whether the input ends or continues with whitespace.
+
+   bool at_boundary() const { return m_pos == m_end || is_space(*m_pos); }
+
+   /// @brief Skips text if the next token starts with it and it ends at whitespace.
+
+   bool skip_text(const span_t& text)
+   {
+      skip_space();
+      if (text.size == 0 || static_cast<std::size_t>(m_end - m_pos) < text.size ||
+          std::memcmp(m_pos, text.data, text.size) != 0)
+         return false;
+      const char* after = m_pos + text.size;
+      if (after != m_end && !is_space(*after))
+         return false;
+      m_pos = after;
+      return true;
+   }
+
+   /// @brief Skips literal if the input continues with exactly it.
+   /// @details The literals are a few characters of container structure, which a loop compares
+   /// faster than a call to memcmp.
+
+   bool skip_literal(const std::string& literal)
+   {
+      const std::size_t size = literal.size();
+      if (static_cast<std::size_t>(m_end - m_pos) < size)
+         return false;
+      for (std::size_t i = 0; i < size; ++i)
+      {
+         if (m_pos[i] != literal[i])
+            return false;
+      }
+      m_pos += size;
+      return true;
+   }
+
+   void skip_line()
+   {
+      const void* newline = std::memchr(m_pos, '\n', m_end - m_pos);
+      m_pos = newline ? static_cast<const char*>(newline) + 1 : m_end;
+   }
+
+private:
+   const char* m_pos;
+   const char* m_end;
+
+}; // end class scanner
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief A stream buffer over a range of the mapped file, through which operator>> reads the
+/// Transitions that the scanner leaves to it.
+
+class range_buffer : public std::streambuf
+{
+public:
+   range_buffer(const char* begin, const char* end)
+   {
+      setg(const_cast<char*>(begin), const_cast<char*>(begin), const_cast<char*>(end));
+   }
+
+   /// @brief The position of the next character to read.
+
+   const char* position() const { return gptr(); }
+
+}; // end class range_buffer
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief The text that operator<< writes for a container: empty if it has no elements, and
+/// otherwise open, the elements separated by separator, and close. For a map, key_separator is
+/// written between the key and the value of an element.
+
+struct container_layout
+{
+   std::string empty;
+   std::string open;
+   std::string separator;
+   std::string close;
+   std::string key_separator;
+};
+
+/// @brief The layouts of the enabled set and of the NextSet of a State, and the text written
+/// before each of them.
+/// @details They are derived from what operator<< writes for small States, so that the scanner
+/// follows the container format of the I/O library exactly. If that fails, valid is false and
+/// every State is left to operator>>.
+
+struct state_layout
+{
+   std::string before_enabled;
+   container_layout enabled;
+   std::string before_next_set;
+   container_layout next_set;
+   bool valid = false;
+};
+
+//--------------------------------------------------------------------------------------------------
+
+template <typename T>
+std::string to_text(const T& value)
+{
+   std::stringstream stream;
+   stream << value;
+   return stream.str();
+}
+
+template <typename T>
+bool reads_back(const std::string& text, const T& expected)
+{
+   std::istringstream stream(text);
+   T value{};
+   return (stream >> value) && value == expected;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief Derives open and close from one, the text of a container holding only element, and
+/// then separator from two, the text of a container holding first and second in this order.
+
+bool derive_layout(container_layout& layout, const std::string& one, const std::string& element,
+                   const std::string& two, const std::string& first, const std::string& second)
+{
+   const auto at = one.find(element);
+   if (at == std::string::npos)
+      return false;
+   layout.open = one.substr(0, at);
+   layout.close = one.substr(at + element.size());
+   const auto head = layout.open + first;
+   const auto tail = second + layout.close;
+   if (two.size() < head.size() + tail.size() || two.compare(0, head.size(), head) != 0 ||
+       two.compare(two.size() - tail.size(), tail.size(), tail) != 0)
+      return false;
+   layout.separator = two.substr(head.size(), two.size() - head.size() - tail.size());
+   return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool derive_enabled_layout(container_layout& layout)
+{
+   const Tids none{};
+   const Tids one{7};
+   const Tids two{7, 8};
+   layout.empty = to_text(none);
+   return derive_layout(layout, to_text(one), "7", to_text(two), "7", "8") &&
+          reads_back(layout.empty, none) && reads_back(to_text(one), one) &&
+          reads_back(to_text(two), two);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool derive_next_set_layout(container_layout& layout)
+{
+   static int object = 0;
+   const next_t first{memory_instruction(7, memory_operation::Load, Object(&object), false,
+                                         {"first.c", 1}),
+                      true};
+   const next_t second{lock_instruction(8, lock_operation::Lock, Object(&object), {"second.c", 2}),
+                       false};
+   const NextSet none{};
+   const NextSet one{{7, first}};
+   const NextSet two{{7, first}, {8, second}};
+   const auto one_text = to_text(one);
+   const auto two_text = to_text(two);
+   const auto first_text = to_text(first);
+   const auto second_text = to_text(second);
+
+   // The key is written before the value
+   const auto value_at = one_text.find(first_text);
+   if (value_at == std::string::npos || value_at == 0)
+      return false;
+   const auto key_at = one_text.rfind('7', value_at - 1);
+   if (key_at == std::string::npos)
+      return false;
+   layout.key_separator = one_text.substr(key_at + 1, value_at - key_at - 1);
+   layout.empty = to_text(none);
+
+   const auto element_7 = "7" + layout.key_separator + first_text;
+   const auto element_8 = "8" + layout.key_separator + second_text;
+   // The elements of the unordered map are written in either order
+   return (derive_layout(layout, one_text, element_7, two_text, element_7, element_8) ||
+           derive_layout(layout, one_text, element_7, two_text, element_8, element_7)) &&
+          reads_back(layout.empty, none) && reads_back(one_text, one) && reads_back(two_text, two);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool derive_separators(state_layout& layout)
+{
+   const State state(Tids{7}, NextSet{});
+   const auto text = to_text(state);
+   const auto tag = state.tag();
+   const auto enabled = to_text(state.enabled());
+   const auto next_set = to_text(state.next_set());
+   const auto at = text.find(enabled, tag.size());
+   if (text.compare(0, tag.size(), tag) != 0 || at == std::string::npos || at == tag.size() ||
+       text.size() < at + enabled.size() + next_set.size() ||
+       text.compare(text.size() - next_set.size(), next_set.size(), next_set) != 0)
+      return false;
+   layout.before_enabled = text.substr(tag.size(), at - tag.size());
+   layout.before_next_set = text.substr(
+      at + enabled.size(), text.size() - next_set.size() - at - enabled.size());
+   return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+const state_layout& layout()
+{
+   static const state_layout layout = [] {
+      state_layout derived;
+      derived.valid = derive_separators(derived) && derive_enabled_layout(derived.enabled) &&
+                      derive_next_set_layout(derived.next_set);
+      return derived;
+   }();
+   return layout;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief Throws unless an element follows right after the structure skipped last, as written
+/// by operator<<.
+
+void expect_element(const scanner& in)
+{
+   if (in.at_boundary())
+      throw parse_failure();
+}
+
+/// @brief Skips the text of a container up to its first element.
+/// @returns false if the container is empty, and then skips it whole.
+
+bool open_container(scanner& in, const container_layout& container)
+{
+   // Of two texts where one is a prefix of the other, the longer one is tried first
+   const bool open_first = container.open.size() >= container.empty.size();
+   if (!open_first && in.skip_literal(container.empty))
+      return false;
+   if (in.skip_literal(container.open))
+   {
+      expect_element(in);
+      return true;
+   }
+   if (open_first && in.skip_literal(container.empty))
+      return false;
+   throw parse_failure();
+}
+
+/// @brief Skips the text after an element of a container.
+/// @returns false after the last element.
+
+bool next_element(scanner& in, const container_layout& container)
+{
+   const bool close_first = container.close.size() >= container.separator.size();
+   if (close_first && in.skip_literal(container.close))
+      return false;
+   if (in.skip_literal(container.separator))
+   {
+      expect_element(in);
+      return true;
+   }
+   if (!close_first && in.skip_literal(container.close))
+      return false;
+   throw parse_failure();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief An instruction as it occurs in the text, before it is turned into an object.
+
+struct instruction_token
+{
+   enum class kind
+   {
+      memory,
+      lock,
+      thread_management
+   };
+
+   kind type;
+   Thread::tid_t tid;
+   int operation;
+   bool is_atomic;
+   std::uint64_t operand;
+   Thread::Status thread_status;
+   span_t file;
+   unsigned int line_number;
+
+   bool operator==(const instruction_token& other) const
+   {
+      return type == other.type && tid == other.tid && operation == other.operation &&
+             is_atomic == other.is_atomic && operand == other.operand &&
+             thread_status == other.thread_status && line_number == other.line_number &&
+             file == other.file;
+   }
+};
+
+//--------------------------------------------------------------------------------------------------
+
+int memory_operation_from(const span_t& str)
+{
+   if (str == "Load")
+      return static_cast<int>(memory_operation::Load);
+   if (str == "Store")
+      return static_cast<int>(memory_operation::Store);
+   if (str == "RMW")
+      return static_cast<int>(memory_operation::ReadModifyWrite);
+   throw parse_failure();
+}
+
+int lock_operation_from(const span_t& str)
+{
+   if (str == "Lock")
+      return static_cast<int>(lock_operation::Lock);
+   if (str == "Unlock")
+      return static_cast<int>(lock_operation::Unlock);
+   throw parse_failure();
+}
+
+int thread_management_operation_from(const span_t& str)
+{
+   if (str == "Spawn")
+      return static_cast<int>(thread_management_operation::Spawn);
+   if (str == "Join")
+      return static_cast<int>(thread_management_operation::Join);
+   throw parse_failure();
+}
+
+Thread::Status thread_status_from(const span_t& str)
+{
+   if (str == "START")
+      return Thread::Status::START;
+   if (str == "ENABLED")
+      return Thread::Status::ENABLED;
+   if (str == "DISABLED")
+      return Thread::Status::DISABLED;
+   if (str == "FINISHED")
+      return Thread::Status::FINISHED;
+   throw parse_failure();
+}
+
+bool execution_status_from(const span_t& str, Execution::Status& status)
+{
+   for (const auto candidate : {Execution::Status::RUNNING, Execution::Status::DONE,
+                                Execution::Status::DEADLOCK, Execution::Status::BLOCKED,
+                                Execution::Status::ERROR})
+   {
+      if (str == program_model::to_string(candidate).c_str())
+      {
+         status = candidate;
+         return true;
+      }
+   }
+   return false;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief Reads an instruction in the format of operator<<(std::ostream&, visible_instruction_t).
+/// @param file The file of the previous instruction, which most instructions share; it is
+/// compared instead of scanned, and replaced if it differs.
+
+instruction_token read_instruction(scanner& in, span_t& file)
+{
+   instruction_token token{};
+   const auto type = in.word();
+   if (type == "memory_instruction")
+   {
+      token.type = instruction_token::kind::memory;
+      token.is_atomic = in.word() == "atomic";
+      token.tid = static_cast<Thread::tid_t>(in.integer());
+      token.operation = memory_operation_from(in.word());
+      token.operand = in.hex();
+   }
+   else if (type == "lock_instruction")
+   {
+      token.type = instruction_token::kind::lock;
+      token.tid = static_cast<Thread::tid_t>(in.integer());
+      token.operation = lock_operation_from(in.word());
+      token.operand = in.hex();
+   }
+   else if (type == "thread_management_instruction")
+   {
+      token.type = instruction_token::kind::thread_management;
+      token.tid = static_cast<Thread::tid_t>(in.integer());
+      token.operation = thread_management_operation_from(in.word());
+      token.operand = static_cast<std::uint64_t>(in.integer());
+      token.thread_status = thread_status_from(in.word());
+   }
+   else
+   {
+      throw parse_failure();
+   }
+   if (!in.skip_text(file))
+      file = in.word();
+   token.file = file;
+   token.line_number = static_cast<unsigned int>(in.integer());
+   return token;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief Turns an instruction read by operator>> into a token whose file name is kept in files.
+
+class tokenizer : public boost::static_visitor<instruction_token>
+{
+public:
+   explicit tokenizer(std::deque<std::string>& files)
+   : m_files(files)
+   {
+   }
+
+   instruction_token operator()(const memory_instruction& instr) const
+   {
+      auto token = common(instruction_token::kind::memory, instr);
+      token.is_atomic = instr.is_atomic();
+      token.operand = reinterpret_cast<std::uintptr_t>(instr.operand().address());
+      return token;
+   }
+
+   instruction_token operator()(const lock_instruction& instr) const
+   {
+      auto token = common(instruction_token::kind::lock, instr);
+      token.operand = reinterpret_cast<std::uintptr_t>(instr.operand().address());
+      return token;
+   }
+
+   instruction_token operator()(const thread_management_instruction& instr) const
+   {
+      auto token = common(instruction_token::kind::thread_management, instr);
+      token.operand = static_cast<std::uint64_t>(instr.operand().tid());
+      token.thread_status = instr.operand().status();
+      return token;
+   }
+
+private:
+   std::deque<std::string>& m_files;
+
+   template <typename instruction_t>
+   instruction_token common(const instruction_token::kind type, const instruction_t& instr) const
+   {
+      instruction_token token{};
+      token.type = type;
+      token.tid = instr.tid();
+      token.operation = static_cast<int>(instr.operation());
+      m_files.push_back(instr.meta_data().file_name);
+      token.file = span_t{m_files.back().data(), m_files.back().size()};
+      token.line_number = instr.meta_data().line_number;
+      return token;
+   }
+
+}; // end class tokenizer
+
+//--------------------------------------------------------------------------------------------------
+
+bool read_enabled_flag(scanner& in)
+{
+   const auto flag = in.word();
+   if (flag == "enabled")
+      return true;
+   if (flag == "disabled")
+      return false;
+   throw parse_failure();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief Reads the tag and enabled set of a State into enabled.
+/// @param text The text of the tag and enabled set of the previous State.
+/// @returns false if the text did not change, and then leaves enabled as it is.
+
+bool read_enabled_set(scanner& in, span_t& text, std::vector<Thread::tid_t>& enabled)
+{
+   if (!layout().valid)
+      throw parse_failure();
+   const char* begin = in.position();
+   if (in.skip_text(text))
+      return false;
+   if (!(in.word() == "State") || !in.skip_literal(layout().before_enabled))
+      throw parse_failure();
+   enabled.clear();
+   const auto& container = layout().enabled;
+   if (open_container(in, container))
+   {
+      do
+      {
+         enabled.push_back(static_cast<Thread::tid_t>(in.integer()));
+      } while (next_element(in, container));
+   }
+   text = span_t{begin, static_cast<std::size_t>(in.current() - begin)};
+   return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief Sorts enabled and removes duplicates, unless it is a set already, as operator<< writes
+/// it.
+
+void make_set(std::vector<Thread::tid_t>& enabled)
+{
+   if (std::adjacent_find(enabled.begin(), enabled.end(),
+                          std::greater_equal<Thread::tid_t>()) == enabled.end())
+      return;
+   std::sort(enabled.begin(), enabled.end());
+   enabled.erase(std::unique(enabled.begin(), enabled.end()), enabled.end());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief What the loaders remember of the NextSet entry of a thread in the previous State.
+
+struct entry_cache
+{
+   /// @brief The text of the entry, or nullptr if it is unknown.
+   span_t text{nullptr, 0};
+   /// @brief The length of the instruction at the start of text.
+   std::size_t instr_size = 0;
+   instruction_token token{};
+   bool enabled = false;
+   /// @brief Whether the previous State has an entry for the thread.
+   bool present = false;
+   /// @brief The State that last had an entry for the thread.
+   unsigned int epoch = 0;
+
+   bool known() const { return text.data != nullptr; }
+};
+
+//--------------------------------------------------------------------------------------------------
+
+class entry_caches
+{
+public:
+   /// @brief The file of the last instruction read.
+   span_t last_file{nullptr, 0};
+   /// @brief The number of threads with an entry in the previous State.
+   std::size_t nr_present = 0;
+
+   entry_cache& operator[](const Thread::tid_t tid)
+   {
+      if (tid >= 0 && tid < max_indexed_tid)
+      {
+         if (static_cast<std::size_t>(tid) >= m_indexed.size())
+            m_indexed.resize(tid + 1);
+         return m_indexed[tid];
+      }
+      return m_other[tid];
+   }
+
+   template <typename Function>
+   void for_each(Function&& f)
+   {
+      for (std::size_t tid = 0; tid < m_indexed.size(); ++tid)
+         f(static_cast<Thread::tid_t>(tid), m_indexed[tid]);
+      for (auto& entry : m_other)
+         f(entry.first, entry.second);
+   }
+
+   /// @brief Forgets all but which threads have an entry in next_set.
+
+   void reset(const NextSet& next_set)
+   {
+      for_each([](const Thread::tid_t, entry_cache& entry) { entry = entry_cache{}; });
+      for (const auto& entry : next_set)
+         (*this)[entry.first].present = true;
+      nr_present = next_set.size();
+   }
+
+private:
+   static constexpr Thread::tid_t max_indexed_tid = 1 << 16;
+
+   std::vector<entry_cache> m_indexed;
+   std::unordered_map<Thread::tid_t, entry_cache> m_other;
+
+}; // end class entry_caches
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief How the NextSet entry of a thread differs from the one in the previous State.
+
+enum class entry_change
+{
+   none,
+   enabled,
+   instruction
+};
+
+/// @brief Reads the NextSet of a State, calling f(tid, entry, change) for every thread that has
+/// an entry, after updating its entry_cache.
+/// @details An entry whose text, or whose instruction's text, equals that of the previous
+/// State's entry for the same tid is skipped without tokenizing it. Of duplicate entries only
+/// the first counts, as for operator>>. Threads that no longer have an entry are passed to
+/// erased(tid).
+
+template <typename Function, typename Erased>
+void read_next_set(scanner& in, entry_caches& caches, const unsigned int epoch, Function&& f,
+                   Erased&& erased)
+{
+   const auto& container = layout().next_set;
+   std::size_t nr_entries = 0;
+   std::size_t nr_kept = 0;
+   if (!in.skip_literal(layout().before_next_set))
+      throw parse_failure();
+   if (open_container(in, container))
+   {
+      do
+      {
+         const auto tid = static_cast<Thread::tid_t>(in.integer());
+         if (!in.skip_literal(container.key_separator))
+            throw parse_failure();
+         expect_element(in);
+         auto& entry = caches[tid];
+         if (entry.epoch == epoch)
+         {
+            read_instruction(in, caches.last_file);
+            read_enabled_flag(in);
+            continue;
+         }
+         ++nr_entries;
+         if (entry.present)
+            ++nr_kept;
+         if (entry.present && in.skip_text(entry.text))
+         {
+            entry.epoch = epoch;
+            f(tid, entry, entry_change::none);
+            continue;
+         }
+         const char* begin = in.position();
+         auto change = entry_change::none;
+         if (entry.present && in.skip_text(span_t{entry.text.data, entry.instr_size}))
+         {
+            const bool enabled = read_enabled_flag(in);
+            if (enabled != entry.enabled)
+               change = entry_change::enabled;
+            entry.enabled = enabled;
+         }
+         else
+         {
+            const auto token = read_instruction(in, caches.last_file);
+            entry.instr_size = static_cast<std::size_t>(in.current() - begin);
+            const bool enabled = read_enabled_flag(in);
+            if (!entry.present || !entry.known() || !(entry.token == token))
+               change = entry_change::instruction;
+            else if (enabled != entry.enabled)
+               change = entry_change::enabled;
+            entry.token = token;
+            entry.enabled = enabled;
+         }
+         entry.text = span_t{begin, static_cast<std::size_t>(in.current() - begin)};
+         entry.present = true;
+         entry.epoch = epoch;
+         f(tid, entry, change);
+      } while (next_element(in, container));
+   }
+   if (!in.at_boundary())
+      throw parse_failure();
+   // Unless all threads of the previous State still have an entry
+   if (nr_kept != caches.nr_present)
+   {
+      caches.for_each([epoch, &erased](const Thread::tid_t tid, entry_cache& entry) {
+         if (entry.present && entry.epoch != epoch)
+         {
+            entry.present = false;
+            erased(tid);
+         }
+      });
+   }
+   caches.nr_present = nr_entries;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief Reads the instruction of a Transition.
+/// @details This is usually the instruction of the thread's entry in the previous State, which
+/// is then skipped without tokenizing it and reported through reused.
+
+instruction_token read_transition_instruction(scanner& in, entry_caches& caches, bool& reused)
+{
+   scanner probe = in;
+   if (probe.word() == "memory_instruction")
+      probe.word();
+   const auto& entry = caches[static_cast<Thread::tid_t>(probe.integer())];
+   reused = entry.present && in.skip_text(span_t{entry.text.data, entry.instr_size});
+   return reused ? entry.token : read_instruction(in, caches.last_file);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief The number of Transitions in the file, which takes two lines for each.
+/// @details Unlike std::count, memchr is vectorized, which matters for files of many MB.
+
+std::size_t count_transitions(const mapped_file& file)
+{
+   std::size_t lines = 0;
+   const char* pos = file.begin();
+   while (const void* newline = std::memchr(pos, '\n', file.end() - pos))
+   {
+      pos = static_cast<const char*>(newline) + 1;
+      ++lines;
+   }
+   return lines / 2;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief Builds an Execution, reusing the objects of the previous State for every part of a
+/// State whose text did not change.
+
+class execution_loader
+{
+public:
+   explicit execution_loader(const mapped_file& file)
+   : m_file(file)
+   , m_in(file.begin(), file.end())
+   {
+   }
+
+   Execution load();
+
+   /// @brief Reads s0.
+   /// @returns nullptr if the file does not start with a State.
+
+   State::SharedPtr read_s0();
+
+   /// @brief Reads the next Transition.
+   /// @returns false at the end of the Execution, or at an incomplete Transition.
+
+   bool read_transition(visible_instruction_t& instr, State::SharedPtr& post);
+
+   Execution::Status status() const { return m_status; }
+
+private:
+   const mapped_file& m_file;
+   scanner m_in;
+   Execution::Status m_status = Execution::Status::RUNNING;
+
+   entry_caches m_caches;
+   unsigned int m_epoch = 0;
+
+   std::vector<Thread::tid_t> m_enabled_list;
+   std::vector<Thread::tid_t> m_enabled_scratch;
+   span_t m_enabled_text{nullptr, 0};
+   State::TidsPtr m_enabled = std::make_shared<const Tids>();
+   NextSet m_next;
+
+   std::unordered_map<span_t, std::string, span_hash> m_files;
+   span_t m_last_file{nullptr, 0};
+   const std::string* m_last_file_name = nullptr;
+
+   const std::string& file_name(const span_t& file);
+
+   visible_instruction_t instruction(const instruction_token& token);
+
+   State::SharedPtr read_state();
+
+   /// @brief Continues after a State that operator>> read, ending at position.
+
+   void adopt(const State& state, const char* position);
+
+   void stop();
+
+}; // end class execution_loader
+
+//--------------------------------------------------------------------------------------------------
+
+Execution execution_loader::load()
+{
+   const auto s0 = read_s0();
+   if (!s0)
+      return Execution{};
+   Execution E{s0};
+   E.reserve(count_transitions(m_file));
+   visible_instruction_t instr;
+   State::SharedPtr post;
+   while (read_transition(instr, post))
+      E.push_back(std::move(instr), post);
+   E.set_status(m_status);
+   return E;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+State::SharedPtr execution_loader::read_s0()
+{
+   if (m_in.at_end())
+      return nullptr;
+   const char* begin = m_in.position();
+   try
+   {
+      return read_state();
+   }
+   catch (const parse_failure&)
+   {
+   }
+   range_buffer buffer(begin, m_file.end());
+   std::istream is(&buffer);
+   State::SharedPtr s0;
+   if (!(is >> s0))
+   {
+      stop();
+      return nullptr;
+   }
+   adopt(*s0, buffer.position());
+   return s0;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool execution_loader::read_transition(visible_instruction_t& instr, State::SharedPtr& post)
+{
+   if (m_in.at_end())
+      return false;
+   if (m_in.peek() == '=')
+   {
+      m_in.skip_line();
+      Execution::Status status;
+      if (!m_in.at_end() && execution_status_from(m_in.word(), status))
+         m_status = status;
+      stop();
+      return false;
+   }
+   const char* begin = m_in.position();
+   try
+   {
+      m_in.integer(); // index
+      bool reused = false;
+      const auto token = read_transition_instruction(m_in, m_caches, reused);
+      const auto& entry = m_caches[token.tid];
+      instr = reused || (entry.present && entry.known() && entry.token == token)
+                 ? m_next.find(token.tid)->second.instr
+                 : instruction(token);
+      post = read_state();
+      return true;
+   }
+   catch (const parse_failure&)
+   {
+   }
+   range_buffer buffer(begin, m_file.end());
+   std::istream is(&buffer);
+   int index;
+   if (!(is >> index >> instr >> post))
+   {
+      stop();
+      return false;
+   }
+   adopt(*post, buffer.position());
+   return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+const std::string& execution_loader::file_name(const span_t& file)
+{
+   // Consecutive instructions of the same file mostly share its text
+   if (file.data == m_last_file.data && file.size == m_last_file.size)
+      return *m_last_file_name;
+   auto it = m_files.find(file);
+   if (it == m_files.end())
+      it = m_files.emplace(file, std::string(file.data, file.size)).first;
+   m_last_file = file;
+   m_last_file_name = &it->second;
+   return it->second;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+visible_instruction_t execution_loader::instruction(const instruction_token& token)
+{
+   meta_data_t meta_data{file_name(token.file), token.line_number};
+   switch (token.type)
+   {
+      case instruction_token::kind::memory:
+         return memory_instruction(token.tid, static_cast<memory_operation>(token.operation),
+                                   Object(reinterpret_cast<Object::ptr_t>(token.operand)),
+                                   token.is_atomic, std::move(meta_data));
+      case instruction_token::kind::lock:
+         return lock_instruction(token.tid, static_cast<lock_operation>(token.operation),
+                                 Object(reinterpret_cast<Object::ptr_t>(token.operand)),
+                                 std::move(meta_data));
+      case instruction_token::kind::thread_management:
+         break;
+   }
+   return thread_management_instruction(
+      token.tid, static_cast<thread_management_operation>(token.operation),
+      Thread(static_cast<Thread::tid_t>(token.operand), token.thread_status),
+      std::move(meta_data));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+State::SharedPtr execution_loader::read_state()
+{
+   const bool enabled_read = read_enabled_set(m_in, m_enabled_text, m_enabled_scratch);
+   if (enabled_read)
+      make_set(m_enabled_scratch);
+
+   const auto update = [this](const Thread::tid_t tid, const entry_cache& entry,
+                              const entry_change change) {
+      if (change == entry_change::enabled)
+         m_next.set(tid, next_t{m_next.find(tid)->second.instr, entry.enabled});
+      else if (change == entry_change::instruction)
+         m_next.set(tid, next_t{instruction(entry.token), entry.enabled});
+   };
+   read_next_set(m_in, m_caches, ++m_epoch, update,
+                 [this](const Thread::tid_t tid) { m_next.erase(tid); });
+
+   if (enabled_read && m_enabled_scratch != m_enabled_list)
+   {
+      m_enabled_list.swap(m_enabled_scratch);
+      m_enabled = std::make_shared<const Tids>(m_enabled_list.begin(), m_enabled_list.end());
+   }
+   return State::create(m_enabled, m_next);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void execution_loader::adopt(const State& state, const char* position)
+{
+   m_enabled = state.enabled_ptr();
+   m_enabled_list.assign(state.enabled().begin(), state.enabled().end());
+   m_enabled_text = span_t{nullptr, 0};
+   m_next = state.next_set();
+   m_caches.reset(m_next);
+   m_in = scanner(position, m_file.end());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void execution_loader::stop()
+{
+   m_in = scanner(m_file.end(), m_file.end());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief Fills execution_columns, validating the NextSets without building them.
+
+class columns_loader
+{
+public:
+   explicit columns_loader(const mapped_file& file)
+   : m_file(file)
+   , m_in(file.begin(), file.end())
+   {
+   }
+
+   execution_columns load();
+
+private:
+   const mapped_file& m_file;
+   scanner m_in;
+   execution_columns m_columns;
+   std::vector<Thread::tid_t> m_enabled;
+   span_t m_enabled_text{nullptr, 0};
+   std::unordered_map<span_t, std::uint32_t, span_hash> m_file_ids;
+   span_t m_last_file{nullptr, 0};
+   std::uint32_t m_last_file_id = 0;
+   entry_caches m_caches;
+   unsigned int m_epoch = 0;
+   std::deque<std::string> m_fallback_files;
+
+   void reserve();
+
+   bool read_s0();
+
+   bool read_transition();
+
+   std::uint32_t file_id(const span_t& file);
+
+   void read_state();
+
+   void adopt(const State& state, const char* position);
+
+   void add_enabled_set();
+
+}; // end class columns_loader
+
+//--------------------------------------------------------------------------------------------------
+
+execution_columns columns_loader::load()
+{
+   if (m_in.at_end())
+      return std::move(m_columns);
+   if (!read_s0())
+      return execution_columns{};
+   reserve();
+   while (read_transition())
+   {
+   }
+   return std::move(m_columns);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void columns_loader::reserve()
+{
+   const auto size = count_transitions(m_file);
+   m_columns.tid.reserve(size);
+   m_columns.operation.reserve(size);
+   m_columns.operand.reserve(size);
+   m_columns.is_atomic.reserve(size);
+   m_columns.file.reserve(size);
+   m_columns.line_number.reserve(size);
+   m_columns.enabled_offsets.reserve(size + 2);
+   m_columns.enabled.reserve(m_columns.enabled.size() * (size + 1));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool columns_loader::read_s0()
+{
+   const char* begin = m_in.position();
+   try
+   {
+      read_state();
+   }
+   catch (const parse_failure&)
+   {
+      range_buffer buffer(begin, m_file.end());
+      std::istream is(&buffer);
+      State::SharedPtr s0;
+      if (!(is >> s0))
+         return false;
+      adopt(*s0, buffer.position());
+   }
+   m_columns.enabled_offsets.push_back(0);
+   add_enabled_set();
+   return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool columns_loader::read_transition()
+{
+   if (m_in.at_end())
+      return false;
+   if (m_in.peek() == '=')
+   {
+      m_in.skip_line();
+      Execution::Status status;
+      if (!m_in.at_end() && execution_status_from(m_in.word(), status))
+         m_columns.status = status;
+      return false;
+   }
+   const char* begin = m_in.position();
+   instruction_token token;
+   try
+   {
+      m_in.integer(); // index
+      bool reused = false;
+      token = read_transition_instruction(m_in, m_caches, reused);
+      read_state();
+   }
+   catch (const parse_failure&)
+   {
+      range_buffer buffer(begin, m_file.end());
+      std::istream is(&buffer);
+      int index;
+      visible_instruction_t instr;
+      State::SharedPtr post;
+      if (!(is >> index >> instr >> post))
+         return false;
+      token = boost::apply_visitor(tokenizer(m_fallback_files), instr);
+      adopt(*post, buffer.position());
+   }
+   m_columns.tid.push_back(token.tid);
+   m_columns.operation.push_back(token.operation);
+   m_columns.operand.push_back(static_cast<std::uintptr_t>(token.operand));
+   m_columns.is_atomic.push_back(token.is_atomic ? 1 : 0);
+   m_columns.file.push_back(file_id(token.file));
+   m_columns.line_number.push_back(token.line_number);
+   add_enabled_set();
+   return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::uint32_t columns_loader::file_id(const span_t& file)
+{
+   // Consecutive instructions of the same file mostly share its text
+   if (file.data == m_last_file.data && file.size == m_last_file.size)
+      return m_last_file_id;
+   m_last_file = file;
+   const auto inserted = m_file_ids.emplace(file, m_columns.files.size());
+   if (inserted.second)
+      m_columns.files.emplace_back(file.data, file.size);
+   m_last_file_id = inserted.first->second;
+   return m_last_file_id;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void columns_loader::read_state()
+{
+   read_enabled_set(m_in, m_enabled_text, m_enabled);
+   read_next_set(m_in, m_caches, ++m_epoch,
+                 [](const Thread::tid_t, const entry_cache&, const entry_change) {},
+                 [](const Thread::tid_t) {});
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void columns_loader::adopt(const State& state, const char* position)
+{
+   m_enabled.assign(state.enabled().begin(), state.enabled().end());
+   m_enabled_text = span_t{nullptr, 0};
+   m_caches.reset(state.next_set());
+   m_in = scanner(position, m_file.end());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void columns_loader::add_enabled_set()
+{
+   make_set(m_enabled);
+   m_columns.enabled.insert(m_columns.enabled.end(), m_enabled.begin(), m_enabled.end());
+   m_columns.enabled_offsets.push_back(m_columns.enabled.size());
+}
+
+} // end namespace
+
+//--------------------------------------------------------------------------------------------------
+// text_trace_reader
+//--------------------------------------------------------------------------------------------------
+
+struct text_trace_reader::impl
+{
+   explicit impl(const std::string& file_name)
+   : file(file_name)
+   , loader(file)
+   {
+   }
+
+   const mapped_file file;
+   execution_loader loader;
+};
+
+//--------------------------------------------------------------------------------------------------
+
+text_trace_reader::text_trace_reader(const std::string& file_name)
+: m_impl(std::make_unique<impl>(file_name))
+, m_index(0)
+{
+   m_state = m_impl->loader.read_s0();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+text_trace_reader::~text_trace_reader() = default;
+
+//--------------------------------------------------------------------------------------------------
+
+bool text_trace_reader::initialized() const
+{
+   return m_state != nullptr;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool text_trace_reader::next()
+{
+   if (!m_state || !m_impl->loader.read_transition(m_instr, m_state))
+      return false;
+   ++m_index;
+   return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::size_t text_trace_reader::index() const
+{
+   return m_index;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+const visible_instruction_t& text_trace_reader::instr() const
+{
+   return m_instr;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+const State::SharedPtr& text_trace_reader::state() const
+{
+   return m_state;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Execution::Status text_trace_reader::status() const
+{
+   return m_impl->loader.status();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Execution load_text_execution(const std::string& file_name)
+{
+   const mapped_file file(file_name);
+   return execution_loader(file).load();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+execution_columns load_text_columns(const std::string& file_name)
+{
+   const mapped_file file(file_name);
+   return columns_loader(file).load();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+} // end namespace program_model
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "execution.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------
+/// @file text_trace.hpp
+/// @brief Fast loaders for Executions written with operator<<(std::ostream&, const Execution&).
+/// @author Susanne van den Elsen
+/// @date 2015-2017
+//--------------------------------------------------------------------------------------------------
+///
+/// The loaders map the file into memory and tokenize it without iostreams.
+/// - They accept and reject exactly what operator>>(std::istream&, Execution&) does. The fast
+///   path only takes the layout operator<< writes, which the loaders derive from operator<<
+///   itself; any other text, such as extra whitespace, is handed to operator>> from that point.
+/// - Like operator>>, they stop at the first incomplete Transition, so the record of a process
+///   that did not terminate normally loads up to its last complete step with status RUNNING.
+///
+/// load_text_columns is the entry point for bulk analysis. On the 400 records that the tests of
+/// the real-world test programs leave behind (15.9 MB), it loads about 11x as fast as operator>>
+/// (see tests/benchmark/text_trace_benchmark.cpp). load_text_execution reaches about 5x: the
+/// States and instructions it has to build for every step bound it, so use it only where the
+/// States themselves are needed.
+
+namespace program_model {
+
+/// @brief Columnar view of the Transitions of an Execution, without the NextSets.
+
+struct execution_columns
+{
+   Execution::Status status = Execution::Status::RUNNING;
+
+   /// @brief The interned file names.
+   std::vector<std::string> files;
+
+   /// @{
+   /// One element per Transition.
+   std::vector<Thread::tid_t> tid;
+   /// @brief The operation as given by operation_as_int.
+   std::vector<int> operation;
+   /// @brief The address of the Object or, for thread management instructions, the operand's tid.
+   std::vector<std::uintptr_t> operand;
+   std::vector<char> is_atomic;
+   /// @brief Index into files.
+   std::vector<std::uint32_t> file;
+   std::vector<unsigned int> line_number;
+   /// @}
+
+   /// @brief The enabled sets of s0 and the post-States, in compressed sparse row form: the
+   /// enabled set of the State after Transition i is enabled[enabled_offsets[i], enabled_offsets[i + 1]).
+   std::vector<std::size_t> enabled_offsets;
+   std::vector<Thread::tid_t> enabled;
+
+   /// @brief The number of Transitions.
+
+   std::size_t size() const { return tid.size(); }
+};
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief Loads the Execution in the text file file_name.
+/// @details Prefer load_text_columns when the NextSets are not needed. Consecutive States share
+/// the NextSet entries and enabled sets whose text did not change, without parsing them into new
+/// objects.
+/// @throws std::runtime_error if the file cannot be mapped.
+
+Execution load_text_execution(const std::string& file_name);
+
+/// @brief Loads the Transitions and enabled sets of the Execution in the text file file_name.
+/// @details The NextSets are checked like operator>> does, but not kept.
+/// @throws std::runtime_error if the file cannot be mapped.
+
+execution_columns load_text_columns(const std::string& file_name);
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief Reads the Execution in a text file one Transition at a time.
+/// @details Only the current State is kept; like load_text_execution, consecutive States share
+/// what did not change.
+
+class text_trace_reader
+{
+public:
+   /// @throws std::runtime_error if the file cannot be mapped.
+
+   explicit text_trace_reader(const std::string& file_name);
+   ~text_trace_reader();
+
+   text_trace_reader(const text_trace_reader&) = delete;
+   text_trace_reader& operator=(const text_trace_reader&) = delete;
+
+   /// @brief Whether the file starts with a State.
+
+   bool initialized() const;
+
+   /// @brief Advances to the next Transition.
+   /// @returns false at the end of the Execution or at its first incomplete Transition.
+
+   bool next();
+
+   /// @brief The index of the current Transition, 0 for s0.
+
+   std::size_t index() const;
+
+   /// @pre index() > 0
+
+   const visible_instruction_t& instr() const;
+
+   /// @brief s0 or the post-State of the current Transition.
+
+   const State::SharedPtr& state() const;
+
+   /// @brief The status of the Execution, known once next returned false.
+
+   Execution::Status status() const;
+
+private:
+   struct impl;
+   std::unique_ptr<impl> m_impl;
+   std::size_t m_index;
+   visible_instruction_t m_instr;
+   State::SharedPtr m_state;
+
+}; // end class text_trace_reader
+
+} // end namespace program_model
@@ -6,11 +6,11 @@ namespace program_model {
 
 //--------------------------------------------------------------------------------------------------
 
-Transition::Transition(const int index, StatePtr pre, const instruction_t& instr, StatePtr post)
+Transition::Transition(const int index, StatePtr pre, instruction_t instr, StatePtr post)
 : mIndex(index)
-, mPre(pre)
-, mInstr(instr)
-, mPost(post)
+, mPre(std::move(pre))
+, mInstr(std::move(instr))
+, mPost(std::move(post))
 {
 }
 
@@ -22,7 +22,7 @@ public:
 
    /// @brief Constructor
 
-   Transition(const int index, StatePtr pre, const instruction_t& instr, StatePtr post);
+   Transition(const int index, StatePtr pre, instruction_t instr, StatePtr post);
 
    bool operator==(const Transition&) const;
 
@@ -5,6 +5,8 @@
 
 #include <boost/variant.hpp>
 
+#include <utility>
+
 //--------------------------------------------------------------------------------------------------
 /// @file visible_instruction.hpp
 /// @author Susanne van den Elsen
@@ -48,11 +50,11 @@ public:
 
    visible_instruction(const thread_id_t& tid, const operation_t& operation,
                        const operand_t& operand,
-                       const meta_data_t& meta_data = {"unknown", 0})
+                       meta_data_t meta_data = {"unknown", 0})
    : m_tid(tid)
    , m_operation(operation)
    , m_operand(operand)
-   , m_meta_data(meta_data)
+   , m_meta_data(std::move(meta_data))
    {
    }
 
@@ -104,8 +106,8 @@ public:
 
    memory_instruction(const thread_id_t& tid, const memory_operation& operation,
                       const operand_t& operand, bool is_atomic,
-                      const meta_data_t& meta_data = {"unknown", 0})
-   : base_type(tid, operation, operand, meta_data)
+                      meta_data_t meta_data = {"unknown", 0})
+   : base_type(tid, operation, operand, std::move(meta_data))
    , m_is_atomic(is_atomic)
    {
    }
@@ -148,8 +150,8 @@ public:
    }
 
    lock_instruction(const thread_id_t& tid, const lock_operation& operation,
-                    const operand_t& operand, const meta_data_t& meta_data = {"unknown", 0})
-   : base_type(tid, operation, operand, meta_data)
+                    const operand_t& operand, meta_data_t meta_data = {"unknown", 0})
+   : base_type(tid, operation, operand, std::move(meta_data))
    {
    }
 
@@ -181,8 +183,8 @@ public:
    thread_management_instruction(const thread_id_t& tid,
                                  const thread_management_operation& operation,
                                  const thread_type& thread,
-                                 const meta_data_t& meta_data = {"unknown", 0})
-   : base_type(tid, operation, thread, meta_data)
+                                 meta_data_t meta_data = {"unknown", 0})
+   : base_type(tid, operation, thread, std::move(meta_data))
    {
    }
 
@@ -5,6 +5,8 @@
 
 #include <debug.hpp>
 
+#include <assert.h>
+
 
 namespace scheduler {
 
@@ -21,6 +23,15 @@ controllable_thread::controllable_thread(const program_model::Thread::tid_t tid,
 
 //--------------------------------------------------------------------------------------------------
 
+void controllable_thread::reset(const program_model::Thread::tid_t tid, const pthread_t pid)
+{
+   assert(m_call_stack.empty());
+   m_tid = tid;
+   m_pid = pid;
+}
+
+//--------------------------------------------------------------------------------------------------
+
 void controllable_thread::post_task()
 {
    if (pthread_self() != m_pid)
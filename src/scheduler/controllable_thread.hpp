@@ -23,6 +23,11 @@ public:
    controllable_thread(const program_model::Thread::tid_t tid, const pthread_t pid,
                        const std::thread::id owner_id);
 
+   /// @brief Rebinds a retired controllable_thread to a newly registered thread, so that its
+   /// control handle and call stack can be reused.
+   /// @pre The previous thread has finished (i.e. its call stack is empty).
+   void reset(const program_model::Thread::tid_t tid, const pthread_t pid);
+
    /// @brief Should only be called by the thread to be controlled
    void post_task();
 
@@ -0,0 +1,217 @@
+
+#include "fork_server.hpp"
+
+#include "shared_channel.hpp"
+
+#include <boost/filesystem/operations.hpp>
+
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+
+namespace scheduler {
+
+//--------------------------------------------------------------------------------------------------
+
+namespace {
+
+/// @brief The file descriptors of the pipes in the instrumented program.
+constexpr int control_fd = 198;
+constexpr int status_fd = 199;
+
+constexpr const char* mode_variable = "RECORD_REPLAY_FORK_SERVER";
+constexpr std::int32_t hello = 0x52524653;
+
+bool read_word(const int fd, std::int32_t& word)
+{
+   auto* bytes = reinterpret_cast<char*>(&word);
+   std::size_t done = 0;
+   while (done < sizeof(word))
+   {
+      const auto n = ::read(fd, bytes + done, sizeof(word) - done);
+      if (n < 0 && errno == EINTR)
+         continue;
+      if (n <= 0)
+         return false;
+      done += n;
+   }
+   return true;
+}
+
+bool write_word(const int fd, const std::int32_t word)
+{
+   return ::write(fd, &word, sizeof(word)) == sizeof(word);
+}
+
+/// @brief Waits until fd is readable or the timeout expired.
+/// @returns false on a timeout.
+
+bool wait_readable(const int fd, const boost::optional<fork_server::timeout_t>& timeout)
+{
+   pollfd request{fd, POLLIN, 0};
+   while (true)
+   {
+      const auto n = ::poll(&request, 1, timeout ? static_cast<int>(timeout->count()) : -1);
+      if (n < 0 && errno == EINTR)
+         continue;
+      return n != 0;
+   }
+}
+
+} // end namespace
+
+//--------------------------------------------------------------------------------------------------
+
+fork_server::fork_server(const program_t& program, const boost::filesystem::path& working_dir,
+                         const shared_channel* channel)
+: m_server(-1)
+, m_control(-1)
+, m_status(-1)
+{
+   // Relative to the working directory of the driver
+   auto executable = boost::filesystem::absolute(program).string();
+   // Prepared before forking, the child only makes async-signal-safe calls
+   std::vector<std::string> environment{std::string(mode_variable) + "=1"};
+   if (channel)
+      environment.push_back(std::string(shared_channel::environment_variable) + "=" +
+                            channel->name());
+   for (char** variable = environ; *variable; ++variable)
+      environment.emplace_back(*variable);
+   std::vector<char*> envp;
+   for (auto& variable : environment)
+      envp.push_back(&variable[0]);
+   envp.push_back(nullptr);
+
+   int control[2];
+   int status[2];
+   {
+      // Other threads starting a server must not inherit the pipes before they are marked
+      // close-on-exec, or the server would not see the control pipe close
+      static std::mutex start_mutex;
+      std::lock_guard<std::mutex> lock(start_mutex);
+      if (::pipe(control) != 0)
+         throw std::runtime_error("fork_server: pipe");
+      if (::pipe(status) != 0)
+      {
+         ::close(control[0]);
+         ::close(control[1]);
+         throw std::runtime_error("fork_server: pipe");
+      }
+      for (const auto fd : {control[0], control[1], status[0], status[1]})
+         ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+      m_server = ::fork();
+      if (m_server == 0)
+      {
+         // dup2 clears close-on-exec of the copies
+         if (::dup2(control[0], control_fd) < 0 || ::dup2(status[1], status_fd) < 0)
+            std::_Exit(127);
+         if (!working_dir.empty() && ::chdir(working_dir.c_str()) != 0)
+            std::_Exit(127);
+         char* argv[] = {&executable[0], nullptr};
+         ::execve(executable.c_str(), argv, envp.data());
+         std::_Exit(127);
+      }
+   }
+   ::close(control[0]);
+   ::close(status[1]);
+   m_control = control[1];
+   m_status = status[0];
+
+   std::int32_t word = 0;
+   if (m_server < 0 || !read_word(m_status, word) || word != hello)
+   {
+      stop();
+      throw std::runtime_error("fork_server: " + program.string() + " does not serve forks");
+   }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+fork_server::~fork_server()
+{
+   stop();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void fork_server::stop()
+{
+   if (m_control >= 0)
+      ::close(m_control);
+   if (m_status >= 0)
+      ::close(m_status);
+   m_control = m_status = -1;
+   if (m_server > 0)
+   {
+      int status;
+      ::waitpid(m_server, &status, 0);
+      m_server = -1;
+   }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+int fork_server::run(const boost::optional<timeout_t>& timeout)
+{
+   std::int32_t child = 0;
+   if (!write_word(m_control, 0) || !read_word(m_status, child))
+      throw std::runtime_error("fork_server: the server stopped");
+
+   if (!wait_readable(m_status, timeout))
+      ::kill(child, SIGKILL);
+
+   std::int32_t status = 0;
+   if (!read_word(m_status, status))
+      throw std::runtime_error("fork_server: the server stopped");
+   return status;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// @note Runs during static initialization, when no other threads exist yet.
+
+bool fork_server::serve_if_requested()
+{
+   if (!std::getenv(mode_variable))
+      return false;
+   ::unsetenv(mode_variable);
+   if (!write_word(status_fd, hello))
+      return false;
+
+   std::int32_t request = 0;
+   while (read_word(control_fd, request))
+   {
+      const pid_t child = ::fork();
+      if (child < 0)
+         std::_Exit(1);
+      if (child == 0)
+      {
+         ::close(control_fd);
+         ::close(status_fd);
+         return true;
+      }
+      int status = 0;
+      if (!write_word(status_fd, child) || ::waitpid(child, &status, 0) < 0 ||
+          !write_word(status_fd, status))
+         std::_Exit(1);
+   }
+   std::_Exit(0);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+} // end namespace scheduler
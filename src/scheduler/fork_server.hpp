@@ -0,0 +1,82 @@
+#pragma once
+
+#include <boost/filesystem/path.hpp>
+#include <boost/optional.hpp>
+
+#include <chrono>
+
+#include <sys/types.h>
+
+//--------------------------------------------------------------------------------------------------
+/// @file fork_server.hpp
+/// @brief Runs of an instrumented program forked from an instance that loaded it only once.
+/// @author Susanne van den Elsen
+/// @date 2015-2017
+//--------------------------------------------------------------------------------------------------
+///
+/// Started in fork-server mode, the instrumented program stops while the Scheduler library is
+/// initialized, before the Scheduler is constructed, and waits for requests on a pipe. It
+/// forks a child per request, which goes on to construct the Scheduler, reading the files in
+/// schedules/ as they are at that moment, and to run the program. Every run thus skips
+/// exec-ing and dynamically loading the program.
+///
+/// The server stops before the Scheduler rather than in wrapper_register_main_thread, because
+/// the threads that the Scheduler starts would not survive a fork.
+///
+/// Protocol, in 4-byte words: the server writes a hello on the status pipe once it is ready.
+/// For every request on the control pipe, it writes the pid of the child and, once the child
+/// terminated, its wait status. It exits when the control pipe is closed.
+
+
+namespace scheduler {
+
+// forward declarations
+class shared_channel;
+
+//--------------------------------------------------------------------------------------------------
+
+class fork_server
+{
+public:
+   using program_t = boost::filesystem::path;
+   using timeout_t = std::chrono::milliseconds;
+
+   /// @brief Starts program in fork-server mode, in working_dir if it is given.
+   /// @param channel A channel to pass to the program instead of the exported one, if any.
+   /// @throws std::runtime_error if the program does not start serving.
+
+   explicit fork_server(const program_t& program,
+                        const boost::filesystem::path& working_dir = boost::filesystem::path(),
+                        const shared_channel* channel = nullptr);
+
+   /// @brief Stops the server.
+
+   ~fork_server();
+
+   fork_server(const fork_server&) = delete;
+   fork_server& operator=(const fork_server&) = delete;
+
+   /// @brief Runs the program once, killing it when the timeout expires.
+   /// @returns The wait status of the run.
+   /// @throws std::runtime_error if the server stopped.
+
+   int run(const boost::optional<timeout_t>& timeout = boost::none);
+
+   /// @brief In the instrumented program: serves forks if the program was started by a
+   /// fork_server, and returns in every child.
+   /// @returns Whether the program runs as a child of a fork server.
+
+   static bool serve_if_requested();
+
+private:
+   pid_t m_server;
+   int m_control;
+   int m_status;
+
+   /// @brief Closes the control pipe, which makes the server exit, and waits for it.
+
+   void stop();
+
+}; // end class fork_server
+
+} // end namespace scheduler
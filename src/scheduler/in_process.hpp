@@ -0,0 +1,66 @@
+#pragma once
+
+#include "schedule.hpp"
+
+#include <execution.hpp>
+
+#include <boost/optional.hpp>
+
+#include <functional>
+#include <string>
+
+//--------------------------------------------------------------------------------------------------
+/// @file in_process.hpp
+/// @brief Controlled runs of a function within the calling process.
+/// @author Susanne van den Elsen
+/// @date 2015-2017
+//--------------------------------------------------------------------------------------------------
+///
+/// Each run replaces the Scheduler that the wrappers post to by a fresh one, which takes its
+/// settings and schedule from the caller, records the schedule only and reports the outcome
+/// instead of writing files. The function runs on a new thread that is registered as the main
+/// thread of the run, so it and the threads it spawns have to be instrumented (or call the
+/// wrappers themselves), as the threads of an instrumented program do. The Scheduler that the
+/// library constructed for a program is discarded at the first run, provided that no thread
+/// registered with it.
+///
+/// The threads of a run that ended in a DEADLOCK exit with pthread_exit at the instruction they
+/// block on, and are joined before the run returns. The objects they hold, e.g. locked mutexes,
+/// stay as they are.
+
+
+namespace scheduler {
+
+// forward declarations
+class SchedulerSettings;
+
+//--------------------------------------------------------------------------------------------------
+
+struct iteration_result_t
+{
+   program_model::Execution::Status status;
+   /// @brief The schedule that the Scheduler executed.
+   schedule_t schedule;
+   /// @brief The data races, in the format of an entry of data_races.txt.
+   std::string data_races;
+};
+
+/// @brief Runs body once under the Scheduler, with the given settings and schedule.
+/// @details Runs do not overlap: a concurrent call waits for the previous run to end. An
+/// exception thrown by body is rethrown once the run ended.
+/// @note The settings' partial_order, native_record and flight_recorder options do not apply
+/// to runs within the process.
+
+iteration_result_t run_in_process(const std::function<void()>& body,
+                                  const SchedulerSettings& settings,
+                                  const schedule_t& schedule = schedule_t());
+
+/// @brief Runs body nr_iterations times with the given settings, e.g. to let the Random
+/// strategy explore its interleavings.
+/// @returns The result of the first run that did not end DONE, or boost::none.
+
+boost::optional<iteration_result_t> explore_in_process(const std::function<void()>& body,
+                                                       const SchedulerSettings& settings,
+                                                       const unsigned int nr_iterations);
+
+} // end namespace scheduler
@@ -0,0 +1,278 @@
+
+#include "native_recorder.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+
+
+namespace scheduler {
+
+//--------------------------------------------------------------------------------------------------
+
+namespace {
+
+std::atomic<std::uint64_t> next_recorder_id{1};
+
+} // end namespace
+
+//--------------------------------------------------------------------------------------------------
+
+constexpr std::uint64_t native_recorder::no_version;
+
+//--------------------------------------------------------------------------------------------------
+
+native_recorder::buffer_t::buffer_t(const tid_t tid_)
+: tid(tid_)
+, entries()
+, pending_lock(std::numeric_limits<std::size_t>::max())
+, pending_check(std::numeric_limits<std::size_t>::max())
+, pending_writes(0)
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+
+native_recorder::native_recorder(const unsigned int log2_nr_counters)
+: m_log2_nr_counters(log2_nr_counters)
+, m_counters(new counter_t[std::size_t(1) << log2_nr_counters])
+, m_id(next_recorder_id.fetch_add(1))
+, m_nr_unordered(0)
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void native_recorder::record(const tid_t tid, const int operation, const void* object,
+                             const unsigned int line_number)
+{
+   auto& buf = buffer(tid);
+   acquired(buf);
+   if (operation == static_cast<int>(program_model::lock_operation::Lock))
+   {
+      buf.pending_lock = buf.entries.size();
+      buf.entries.push_back({operation, line_number, object, -1, no_version});
+      return;
+   }
+   // The version is taken last, as close to the instruction as possible
+   buf.entries.push_back({operation, line_number, object, -1, no_version});
+   if (operation == static_cast<int>(program_model::memory_operation::Load))
+      buf.pending_writes =
+         m_counters[counter_index(object)].writes.load(std::memory_order_acquire);
+   buf.entries.back().version = take_version(operation, object);
+   // An Unlock is ordered by the lock it holds, and a Lock takes its version right after the
+   // Unlock executed, which the check would take for an overlap
+   if (operation != static_cast<int>(program_model::lock_operation::Unlock))
+      buf.pending_check = buf.entries.size() - 1;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void native_recorder::record_spawn(const tid_t tid, const tid_t new_tid,
+                                   const unsigned int line_number)
+{
+   auto& buf = buffer(tid);
+   acquired(buf);
+   const auto version = m_spawn_counter.value.fetch_add(1, std::memory_order_relaxed);
+   buf.entries.push_back({static_cast<int>(program_model::thread_management_operation::Spawn),
+                          line_number, nullptr, new_tid, version});
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void native_recorder::record_join(const tid_t tid, const tid_t tid_joined,
+                                  const unsigned int line_number)
+{
+   auto& buf = buffer(tid);
+   acquired(buf);
+   buf.entries.push_back({static_cast<int>(program_model::thread_management_operation::Join),
+                          line_number, nullptr, tid_joined, no_version});
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void native_recorder::finish(const tid_t tid)
+{
+   acquired(buffer(tid));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::vector<partial_order::event_t> native_recorder::merge() const
+{
+   using namespace program_model;
+
+   const std::size_t nr_counters = std::size_t(1) << m_log2_nr_counters;
+   const auto spawn_counter = nr_counters;
+   std::vector<std::uint64_t> next_version(nr_counters + 1, 0);
+
+   std::vector<const buffer_t*> buffers;
+   for (const auto& buf : m_buffers)
+   {
+      if (static_cast<std::size_t>(buf.tid) >= buffers.size())
+         buffers.resize(buf.tid + 1, nullptr);
+      buffers[buf.tid] = &buf;
+   }
+   std::vector<std::size_t> position(buffers.size(), 0);
+   std::vector<bool> spawned(std::max<std::size_t>(buffers.size(), 1), false);
+   spawned[0] = true;
+
+   const auto exhausted = [&buffers, &position](const tid_t tid) {
+      return static_cast<std::size_t>(tid) >= buffers.size() || !buffers[tid] ||
+             position[tid] == buffers[tid]->entries.size();
+   };
+   const auto counter_of = [this, spawn_counter](const entry_t& entry) {
+      return entry.operation == static_cast<int>(thread_management_operation::Spawn)
+                ? spawn_counter
+                : counter_index(entry.object);
+   };
+   const auto ready = [&](const tid_t tid) {
+      if (exhausted(tid) || static_cast<std::size_t>(tid) >= spawned.size() || !spawned[tid])
+         return false;
+      const auto& entry = buffers[tid]->entries[position[tid]];
+      if (entry.operation == static_cast<int>(thread_management_operation::Join))
+         return static_cast<std::size_t>(entry.thread) < spawned.size() &&
+                spawned[entry.thread] && exhausted(entry.thread);
+      return entry.version == next_version[counter_of(entry)];
+   };
+
+   std::vector<partial_order::event_t> events;
+   tid_t current = 0;
+   while (true)
+   {
+      if (!ready(current))
+      {
+         tid_t tid = 0;
+         while (static_cast<std::size_t>(tid) < buffers.size() && !ready(tid))
+            ++tid;
+         if (static_cast<std::size_t>(tid) == buffers.size())
+            break;
+         current = tid;
+      }
+
+      const auto& entry = buffers[current]->entries[position[current]++];
+      if (entry.operation == static_cast<int>(thread_management_operation::Spawn))
+      {
+         if (static_cast<std::size_t>(entry.thread) >= spawned.size())
+            spawned.resize(entry.thread + 1, false);
+         spawned[entry.thread] = true;
+      }
+      if (entry.version != no_version)
+         ++next_version[counter_of(entry)];
+      events.push_back({current, entry.operation, entry.line_number, entry.object});
+   }
+   return events;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::size_t native_recorder::nr_unordered() const
+{
+   return m_nr_unordered.load();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool native_recorder::replayable() const
+{
+   return nr_unordered() == 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool native_recorder::write(const std::string& schedule_file,
+                            const std::string& partial_order_file) const
+{
+   if (!replayable())
+      return false;
+   const auto events = merge();
+
+   schedule_t schedule;
+   for (const auto& event : events)
+      schedule.push_back(event.tid);
+   std::ofstream schedule_stream(schedule_file);
+   schedule_stream << schedule;
+
+   std::ofstream partial_order_stream(partial_order_file);
+   partial_order_stream << partial_order(events);
+   return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// @note A thread keeps its tid until it finishes, and a new thread gets new thread_local
+/// storage. The id tells a buffer of this recorder from one of an earlier recorder.
+
+native_recorder::buffer_t& native_recorder::buffer(const tid_t tid)
+{
+   thread_local std::uint64_t cached_id = 0;
+   thread_local buffer_t* cached = nullptr;
+   if (cached_id != m_id)
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_buffers.emplace_back(tid);
+      cached = &m_buffers.back();
+      cached_id = m_id;
+   }
+   return *cached;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// @note The acquire keeps the instruction, which follows, from executing before its version is
+/// taken. A synchronized access follows the operations of the other thread it synchronizes with,
+/// so its version is larger.
+
+std::uint64_t native_recorder::take_version(const int operation, const void* object)
+{
+   auto& counter = m_counters[counter_index(object)];
+   if (operation != static_cast<int>(program_model::memory_operation::Load))
+      counter.writes.fetch_add(1, std::memory_order_acq_rel);
+   return counter.value.fetch_add(1, std::memory_order_acq_rel);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::size_t native_recorder::counter_index(const void* object) const
+{
+   // Fibonacci hashing, dropping the alignment bits
+   const auto address = reinterpret_cast<std::uintptr_t>(object) >> 2;
+   return static_cast<std::size_t>((std::uint64_t(address) * 0x9E3779B97F4A7C15ull) >>
+                                   (64 - m_log2_nr_counters));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void native_recorder::acquired(buffer_t& buf)
+{
+   if (buf.pending_check != std::numeric_limits<std::size_t>::max())
+   {
+      // The access executed since it took its version. The fences keep it from executing after
+      // the check: a load only has to precede later loads, a store also later loads.
+      const auto& entry = buf.entries[buf.pending_check];
+      const auto& counter = m_counters[counter_index(entry.object)];
+      bool ordered;
+      if (entry.operation == static_cast<int>(program_model::memory_operation::Load))
+      {
+         std::atomic_thread_fence(std::memory_order_acquire);
+         ordered = counter.writes.load(std::memory_order_acquire) == buf.pending_writes;
+      }
+      else
+      {
+         std::atomic_thread_fence(std::memory_order_seq_cst);
+         ordered = counter.value.load(std::memory_order_acquire) == entry.version + 1;
+      }
+      if (!ordered)
+         m_nr_unordered.fetch_add(1, std::memory_order_relaxed);
+      buf.pending_check = std::numeric_limits<std::size_t>::max();
+   }
+   if (buf.pending_lock == std::numeric_limits<std::size_t>::max())
+      return;
+   auto& lock = buf.entries[buf.pending_lock];
+   lock.version = take_version(lock.operation, lock.object);
+   buf.pending_lock = std::numeric_limits<std::size_t>::max();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+} // end namespace scheduler
@@ -0,0 +1,168 @@
+#pragma once
+
+#include "partial_order.hpp"
+#include "schedule.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------
+/// @file native_recorder.hpp
+/// @brief Recording of an execution in which the threads run in their native order.
+/// @author Susanne van den Elsen
+/// @date 2015-2017
+//--------------------------------------------------------------------------------------------------
+
+
+namespace scheduler {
+
+/// @brief Records the order of the visible instructions of threads that run freely, at the cost
+/// of one or two atomic increments and a thread-local append per instruction.
+/// @details Every object hashes to a version counter. A visible instruction takes the next
+/// version of the counter of its object, and the thread logs the instruction with that version
+/// to its own buffer. Objects that share a counter are ordered as if they were the same object,
+/// which only adds order. merge then interleaves the buffers in an order that respects both the
+/// program order of each thread and the versions of each counter.
+///
+/// A Lock takes its version once the thread reaches its next visible instruction or finishes,
+/// that is once the lock is acquired, so that versions follow the order of acquisition. Other
+/// instructions take their version in their wrapper, before they execute: the order between
+/// unsynchronized accesses is the order of their wrappers, which may differ from the order in
+/// which the accesses executed. Such a recording is not replayable, and is rejected: when the
+/// thread reaches its next visible instruction, a write checks that no other version of its
+/// counter was taken since its own, and a load that no write took one. Two conflicting accesses
+/// can only have executed out of the order of their versions if one of them fails this check,
+/// while loads whose windows overlap, which replay in any order, pass it. The check may still
+/// reject a write whose window merely overlaps another access.
+///
+/// Spawns take their version together with the tid of the new thread, so that replaying the
+/// spawns in order hands out the recorded tids.
+
+class native_recorder
+{
+public:
+   using tid_t = program_model::Thread::tid_t;
+
+   /// @brief Constructs a recorder with 2^log2_nr_counters version counters.
+
+   explicit native_recorder(const unsigned int log2_nr_counters = 14);
+
+   native_recorder(const native_recorder&) = delete;
+   native_recorder& operator=(const native_recorder&) = delete;
+
+   /// @brief Records that the calling thread, thread tid, executes a memory or lock instruction
+   /// on object.
+
+   void record(const tid_t tid, const int operation, const void* object,
+               const unsigned int line_number);
+
+   /// @brief Records a spawn by the calling thread, thread tid.
+   /// @param new_tid The tid of the spawned thread.
+   /// @note Has to be called under the lock under which new_tid is handed out.
+
+   void record_spawn(const tid_t tid, const tid_t new_tid, const unsigned int line_number);
+
+   /// @brief Records a join of thread tid_joined by the calling thread, thread tid.
+
+   void record_join(const tid_t tid, const tid_t tid_joined, const unsigned int line_number);
+
+   /// @brief Records that the calling thread, thread tid, finished.
+
+   void finish(const tid_t tid);
+
+   /// @brief A total order of the recorded instructions that respects the recorded order.
+   /// @details Runs of a thread are only interrupted where the recorded order requires so.
+   /// Stops at the first instruction that cannot be placed, which only happens if a thread
+   /// still runs.
+   /// @note Not thread-safe with respect to record: call when the program finished.
+
+   std::vector<partial_order::event_t> merge() const;
+
+   /// @brief The number of memory accesses that failed the check (see native_recorder), whose
+   /// recorded order may thus differ from the order in which they executed.
+
+   std::size_t nr_unordered() const;
+
+   /// @brief Whether merge gives the order in which the accesses executed.
+
+   bool replayable() const;
+
+   /// @brief Writes the schedule and the partial order of merge to the given files, unless the
+   /// recording is not replayable.
+   /// @returns Whether the files were written.
+
+   bool write(const std::string& schedule_file, const std::string& partial_order_file) const;
+
+private:
+   static constexpr std::uint64_t no_version = ~std::uint64_t(0);
+
+   struct entry_t
+   {
+      int operation;
+      unsigned int line_number;
+      /// @brief The operand of a memory or lock instruction.
+      const void* object;
+      /// @brief The spawned or joined thread.
+      tid_t thread;
+      std::uint64_t version;
+   };
+
+   struct buffer_t
+   {
+      explicit buffer_t(const tid_t tid);
+
+      tid_t tid;
+      std::vector<entry_t> entries;
+      /// @brief The index of a Lock that did not take its version yet.
+      std::size_t pending_lock;
+      /// @brief The index of the memory access that did not check its version yet.
+      std::size_t pending_check;
+      /// @brief The number of writes of the counter of a pending Load when it took its version.
+      std::uint64_t pending_writes;
+   };
+
+   /// @brief A counter padded to the size of a cache line, so that threads that access
+   /// different objects rarely share one.
+   struct counter_t
+   {
+      std::atomic<std::uint64_t> value{0};
+      /// @brief The number of versions taken by instructions other than Loads.
+      std::atomic<std::uint64_t> writes{0};
+      char padding[64 - 2 * sizeof(std::atomic<std::uint64_t>)];
+   };
+
+   const unsigned int m_log2_nr_counters;
+   std::unique_ptr<counter_t[]> m_counters;
+   counter_t m_spawn_counter;
+
+   /// @brief Distinguishes recorders in the thread-local cache of buffer.
+   const std::uint64_t m_id;
+
+   std::atomic<std::size_t> m_nr_unordered;
+
+   /// @brief Protects m_buffers while threads add their buffer.
+   std::mutex m_mutex;
+   std::deque<buffer_t> m_buffers;
+
+   buffer_t& buffer(const tid_t tid);
+
+   std::size_t counter_index(const void* object) const;
+
+   /// @brief The next version of the counter of object, for an instruction with operation.
+
+   std::uint64_t take_version(const int operation, const void* object);
+
+   /// @brief Checks the version of the pending memory access of buffer and gives its pending
+   /// Lock its version.
+
+   void acquired(buffer_t& buf);
+
+}; // end class native_recorder
+
+} // end namespace scheduler
@@ -0,0 +1,149 @@
+
+#include "parallel_driver.hpp"
+
+#include "replay.hpp"
+
+#include <boost/filesystem/operations.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+
+namespace scheduler {
+
+//--------------------------------------------------------------------------------------------------
+
+parallel_driver::parallel_driver(const program_t& program, const SchedulerSettings& settings,
+                                 const parallel_options_t& options)
+: m_program(boost::filesystem::absolute(program))
+, m_options(options)
+, m_mutex()
+, m_not_full()
+, m_not_empty()
+, m_queue()
+, m_closed(false)
+, m_nr_submitted(0)
+, m_results()
+, m_workers()
+, m_threads()
+{
+   if (m_options.nr_workers == 0 || m_options.queue_capacity == 0)
+      throw std::invalid_argument("parallel_driver: no workers or no queue");
+
+   for (unsigned int i = 0; i < m_options.nr_workers; ++i)
+   {
+      worker_t worker;
+      worker.dir = boost::filesystem::absolute(m_options.work_dir / std::to_string(i));
+      boost::filesystem::create_directories(worker.dir / "schedules");
+      worker.channel = std::make_unique<shared_channel>(1 << 20, false);
+      if (!worker.channel->write_settings(settings))
+      {
+         std::ofstream ofs((worker.dir / "schedules/settings.txt").string());
+         ofs << settings;
+      }
+      worker.server = std::make_unique<fork_server>(m_program, worker.dir, worker.channel.get());
+      m_workers.push_back(std::move(worker));
+   }
+   // Only now, as the workers' vector must not reallocate under their threads
+   for (auto& worker : m_workers)
+      m_threads.emplace_back([this, &worker] { run(worker); });
+}
+
+//--------------------------------------------------------------------------------------------------
+
+parallel_driver::~parallel_driver()
+{
+   finish();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::size_t parallel_driver::submit(const schedule_t& schedule)
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+   if (m_closed)
+      throw std::logic_error("parallel_driver: submit after finish");
+   m_not_full.wait(lock, [this] { return m_queue.size() < m_options.queue_capacity; });
+   const auto id = m_nr_submitted++;
+   m_queue.push_back({id, schedule});
+   m_not_empty.notify_one();
+   return id;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::vector<parallel_driver::result_t> parallel_driver::finish()
+{
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_closed = true;
+   }
+   m_not_empty.notify_all();
+   for (auto& thread : m_threads)
+   {
+      if (thread.joinable())
+         thread.join();
+   }
+   m_workers.clear();
+
+   std::sort(m_results.begin(), m_results.end(),
+             [](const auto& lhs, const auto& rhs) { return lhs.id < rhs.id; });
+   return m_results;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void parallel_driver::run(worker_t& worker)
+{
+   while (true)
+   {
+      job_t job;
+      {
+         std::unique_lock<std::mutex> lock(m_mutex);
+         m_not_empty.wait(lock, [this] { return m_closed || !m_queue.empty(); });
+         if (m_queue.empty())
+            return;
+         job = std::move(m_queue.front());
+         m_queue.pop_front();
+      }
+      m_not_full.notify_one();
+
+      auto result = run(worker, job);
+
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_results.push_back(std::move(result));
+   }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+parallel_driver::result_t parallel_driver::run(worker_t& worker, const job_t& job)
+{
+   if (!worker.channel->write_schedule(job.schedule))
+   {
+      std::ofstream ofs((worker.dir / "schedules/schedule.txt").string());
+      ofs << job.schedule;
+   }
+
+   result_t result{job.id, boost::none, boost::none};
+   try
+   {
+      if (!worker.server)
+         worker.server = std::make_unique<fork_server>(m_program, worker.dir, worker.channel.get());
+      result.wait_status = worker.server->run(m_options.timeout);
+   }
+   catch (const std::runtime_error&)
+   {
+      // The server stopped, the next run starts a new one
+      worker.server.reset();
+   }
+   result.outcome = worker.channel->result();
+   collect_records(m_options.output_dir / std::to_string(job.id), worker.dir);
+   return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+} // end namespace scheduler
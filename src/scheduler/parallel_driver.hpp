@@ -0,0 +1,124 @@
+#pragma once
+
+#include "fork_server.hpp"
+#include "schedule.hpp"
+#include "scheduler_settings.hpp"
+#include "shared_channel.hpp"
+
+#include <boost/filesystem/path.hpp>
+#include <boost/optional.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------
+/// @file parallel_driver.hpp
+/// @brief Runs of an instrumented program under many schedules at once.
+/// @author Susanne van den Elsen
+/// @date 2015-2017
+//--------------------------------------------------------------------------------------------------
+///
+/// The program reads its input from and writes its records to its working directory, so two
+/// runs in the same directory clobber each other. Every worker of a parallel_driver therefore
+/// owns a working directory, a shared_channel and a fork_server started in that directory,
+/// and runs one schedule at a time. The records of run n are moved to output_dir/n.
+
+
+namespace scheduler {
+
+struct parallel_options_t
+{
+   /// @brief The number of concurrent runs.
+   unsigned int nr_workers = std::max(1u, std::thread::hardware_concurrency());
+   /// @brief The number of submitted runs that may wait for a worker before submit blocks.
+   std::size_t queue_capacity = 64;
+   /// @brief The timeout of every run.
+   boost::optional<std::chrono::milliseconds> timeout;
+   /// @brief Holds the working directories of the workers.
+   boost::filesystem::path work_dir = "./record_replay_work";
+   boost::filesystem::path output_dir = "./record_replay_output";
+};
+
+//--------------------------------------------------------------------------------------------------
+
+class parallel_driver
+{
+public:
+   using program_t = fork_server::program_t;
+
+   struct result_t
+   {
+      /// @brief The number of the run, in order of submission.
+      std::size_t id;
+      /// @brief The wait status of the program, or boost::none if the fork server stopped.
+      boost::optional<int> wait_status;
+      /// @brief The outcome reported by the program, see shared_channel::result.
+      boost::optional<shared_channel::result_t> outcome;
+   };
+
+   /// @brief Starts the workers, which run program under settings.
+   /// @throws std::runtime_error if a worker cannot start the program.
+
+   parallel_driver(const program_t& program, const SchedulerSettings& settings,
+                   const parallel_options_t& options);
+
+   /// @brief Finishes the submitted runs.
+
+   ~parallel_driver();
+
+   parallel_driver(const parallel_driver&) = delete;
+   parallel_driver& operator=(const parallel_driver&) = delete;
+
+   /// @brief Queues a run under schedule, blocking while the queue is full.
+   /// @returns The id of the run.
+
+   std::size_t submit(const schedule_t& schedule);
+
+   /// @brief Waits for all submitted runs and stops the workers.
+   /// @returns The results of all runs, ordered by id.
+
+   std::vector<result_t> finish();
+
+private:
+   struct job_t
+   {
+      std::size_t id;
+      schedule_t schedule;
+   };
+
+   struct worker_t
+   {
+      boost::filesystem::path dir;
+      std::unique_ptr<shared_channel> channel;
+      std::unique_ptr<fork_server> server;
+   };
+
+   program_t m_program;
+   parallel_options_t m_options;
+
+   /// @brief Protects m_queue, m_closed, m_nr_submitted and m_results.
+   std::mutex m_mutex;
+   std::condition_variable m_not_full;
+   std::condition_variable m_not_empty;
+   std::deque<job_t> m_queue;
+   bool m_closed;
+   std::size_t m_nr_submitted;
+   std::vector<result_t> m_results;
+
+   std::vector<worker_t> m_workers;
+   std::vector<std::thread> m_threads;
+
+   void run(worker_t& worker);
+
+   result_t run(worker_t& worker, const job_t& job);
+
+}; // end class parallel_driver
+
+} // end namespace scheduler
@@ -0,0 +1,336 @@
+
+#include "partial_order.hpp"
+
+#include <debug.hpp>
+
+#include <boost/optional.hpp>
+
+#include <algorithm>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <unordered_map>
+
+
+namespace scheduler {
+
+//--------------------------------------------------------------------------------------------------
+
+namespace {
+
+/// @brief The conflicting accesses to an object that later accesses have to wait for.
+
+struct access_history
+{
+   boost::optional<partial_order::step_t> last_write;
+   std::vector<partial_order::step_t> reads;
+};
+
+/// @brief Adds the steps in history that step with the given access kind has to wait for to
+/// predecessors, and records step in history.
+
+void access(access_history& history, const partial_order::step_t step, const bool is_write,
+            std::vector<partial_order::step_t>& predecessors)
+{
+   if (history.last_write)
+      predecessors.push_back(*history.last_write);
+   if (is_write)
+   {
+      predecessors.insert(predecessors.end(), history.reads.begin(), history.reads.end());
+      history.last_write = step;
+      history.reads.clear();
+   }
+   else
+   {
+      history.reads.push_back(step);
+   }
+}
+
+unsigned int get_line_number(const program_model::visible_instruction_t& instr)
+{
+   return boost::apply_visitor(
+      [](const auto& instruction) { return instruction.meta_data().line_number; }, instr);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::vector<partial_order::event_t> events(const program_model::Execution& E)
+{
+   using namespace program_model;
+
+   std::vector<partial_order::event_t> result;
+   result.reserve(E.size());
+   for (const auto& transition : E)
+   {
+      const auto& instr = transition.instr();
+      const void* object = nullptr;
+      if (const auto* memory_instr = boost::get<memory_instruction>(&instr))
+         object = memory_instr->operand().address();
+      else if (const auto* lock_instr = boost::get<lock_instruction>(&instr))
+         object = lock_instr->operand().address();
+      result.push_back({boost::apply_visitor(get_tid(), instr),
+                        boost::apply_visitor(operation_as_int(), instr), get_line_number(instr),
+                        object});
+   }
+   return result;
+}
+
+} // end namespace
+
+//--------------------------------------------------------------------------------------------------
+// partial_order
+//--------------------------------------------------------------------------------------------------
+
+partial_order::partial_order(const program_model::Execution& E)
+: partial_order(events(E))
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+
+partial_order::partial_order(const std::vector<event_t>& events)
+{
+   using namespace program_model;
+
+   std::unordered_map<const void*, access_history> objects;
+   access_history spawns;
+
+   for (const auto& event : events)
+   {
+      const step_t step = size();
+      step_info info{event.tid, event.operation, event.line_number, {}};
+
+      switch (event.operation)
+      {
+      case static_cast<int>(memory_operation::Load):
+         access(objects[event.object], step, false, info.predecessors);
+         break;
+      case static_cast<int>(memory_operation::Store):
+      case static_cast<int>(memory_operation::ReadModifyWrite):
+      case static_cast<int>(lock_operation::Lock):
+      case static_cast<int>(lock_operation::Unlock):
+         access(objects[event.object], step, true, info.predecessors);
+         break;
+      case static_cast<int>(thread_management_operation::Spawn):
+         access(spawns, step, true, info.predecessors);
+         break;
+      default:
+         break;
+      }
+
+      // The program order of the thread is implicit
+      info.predecessors.erase(std::remove_if(info.predecessors.begin(), info.predecessors.end(),
+                                             [this, &info](const auto predecessor) {
+                                                return m_steps[predecessor].tid == info.tid;
+                                             }),
+                              info.predecessors.end());
+      push_back(std::move(info));
+   }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::size_t partial_order::size() const
+{
+   return m_steps.size();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+const partial_order::step_info& partial_order::operator[](const step_t step) const
+{
+   return m_steps[step];
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::size_t partial_order::nr_threads() const
+{
+   return m_thread_steps.size();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+const std::vector<partial_order::step_t>& partial_order::steps_of(const tid_t tid) const
+{
+   return m_thread_steps[tid];
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void partial_order::push_back(step_info info)
+{
+   if (info.tid < 0)
+      throw std::invalid_argument("partial_order: negative tid");
+   for (const auto predecessor : info.predecessors)
+   {
+      if (predecessor >= size())
+         throw std::invalid_argument("partial_order: predecessor does not precede its step");
+   }
+   if (static_cast<std::size_t>(info.tid) >= m_thread_steps.size())
+      m_thread_steps.resize(info.tid + 1);
+   m_thread_steps[info.tid].push_back(size());
+   m_steps.push_back(std::move(info));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::ostream& operator<<(std::ostream& os, const partial_order& order)
+{
+   os << order.size() << "\n";
+   for (std::size_t step = 0; step < order.size(); ++step)
+   {
+      const auto& info = order[step];
+      os << info.tid << " " << info.operation << " " << info.line_number << " "
+         << info.predecessors.size();
+      for (const auto predecessor : info.predecessors)
+         os << " " << predecessor;
+      os << "\n";
+   }
+   return os;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::istream& operator>>(std::istream& is, partial_order& order)
+{
+   order = partial_order();
+   std::size_t nr_steps = 0;
+   is >> nr_steps;
+   for (std::size_t step = 0; is && step < nr_steps; ++step)
+   {
+      partial_order::step_info info;
+      std::size_t nr_predecessors = 0;
+      if (!(is >> info.tid >> info.operation >> info.line_number >> nr_predecessors))
+         break;
+      info.predecessors.resize(nr_predecessors);
+      for (auto& predecessor : info.predecessors)
+         is >> predecessor;
+      try
+      {
+         order.push_back(std::move(info));
+      }
+      catch (const std::invalid_argument&)
+      {
+         is.setstate(std::ios::failbit);
+      }
+   }
+   return is;
+}
+
+//--------------------------------------------------------------------------------------------------
+// partial_order_replay
+//--------------------------------------------------------------------------------------------------
+
+partial_order_replay::partial_order_replay(partial_order order)
+: m_order(std::move(order))
+, m_performed(new std::atomic<bool>[m_order.size()])
+, m_position(m_order.nr_threads(), 0)
+, m_diverged(false)
+, m_nr_waiting(0)
+{
+   for (std::size_t step = 0; step < m_order.size(); ++step)
+      m_performed[step].store(false);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool partial_order_replay::next_step(const tid_t tid, const int operation,
+                                     const unsigned int line_number)
+{
+   if (m_diverged.load())
+      return false;
+
+   perform_previous(tid);
+   if (tid < 0 || static_cast<std::size_t>(tid) >= m_order.nr_threads() ||
+       m_position[tid] == m_order.steps_of(tid).size())
+   {
+      diverge();
+      return false;
+   }
+
+   const auto step = m_order.steps_of(tid)[m_position[tid]++];
+   const auto& info = m_order[step];
+   if (info.operation != operation || info.line_number != line_number)
+   {
+      diverge();
+      return false;
+   }
+
+   DEBUGF_SYNC("partial_order_replay", "next_step", tid, "step " << step << "\n");
+   for (const auto predecessor : info.predecessors)
+      wait_until_performed(predecessor);
+   return !m_diverged.load();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void partial_order_replay::finish(const tid_t tid)
+{
+   if (tid < 0 || static_cast<std::size_t>(tid) >= m_order.nr_threads())
+      return;
+   perform_previous(tid);
+   // The steps left would never be performed
+   if (m_position[tid] != m_order.steps_of(tid).size())
+      diverge();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool partial_order_replay::diverged() const
+{
+   return m_diverged.load();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void partial_order_replay::perform_previous(const tid_t tid)
+{
+   if (tid < 0 || static_cast<std::size_t>(tid) >= m_order.nr_threads() || m_position[tid] == 0)
+      return;
+
+   m_performed[m_order.steps_of(tid)[m_position[tid] - 1]].store(true);
+   // A waiter increments m_nr_waiting before it checks the flag under m_mutex, so either it
+   // sees the flag or it is counted here
+   if (m_nr_waiting.load() > 0)
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_cond.notify_all();
+   }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool partial_order_replay::performed(const step_t step) const
+{
+   return m_performed[step].load();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void partial_order_replay::wait_until_performed(const step_t step)
+{
+   if (performed(step))
+      return;
+
+   ++m_nr_waiting;
+   {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_cond.wait(lock, [this, step] { return performed(step) || m_diverged.load(); });
+   }
+   --m_nr_waiting;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void partial_order_replay::diverge()
+{
+   DEBUGF_SYNC("partial_order_replay", "diverge", "", "\n");
+   m_diverged.store(true);
+   std::lock_guard<std::mutex> lock(m_mutex);
+   m_cond.notify_all();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+} // end namespace scheduler
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <execution.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------
+/// @file partial_order.hpp
+/// @brief Replay of an Execution that only enforces the order between conflicting Transitions.
+/// @author Susanne van den Elsen
+/// @date 2015-2017
+//--------------------------------------------------------------------------------------------------
+
+
+namespace scheduler {
+
+/// @brief The order between the conflicting Transitions of an Execution.
+/// @details Two Transitions conflict if they operate on the same object and
+/// - one of them writes it (Store or ReadModifyWrite), or
+/// - both are lock operations, or
+/// - both are spawns (spawns determine the tids of the new threads).
+/// Each step keeps only its direct predecessors in other threads: a write waits for the last
+/// write and the reads since, a read waits for the last write. The program order of a thread
+/// is implicit.
+///
+/// Text format: the number of steps, followed by one line per step
+/// `tid operation line_number nr_predecessors predecessor...`.
+
+class partial_order
+{
+public:
+   using tid_t = program_model::Thread::tid_t;
+   /// @brief The index of a Transition in the Execution, starting at 0.
+   using step_t = std::size_t;
+
+   struct step_info
+   {
+      tid_t tid;
+      /// @brief The operation of the instruction as given by operation_as_int.
+      int operation;
+      unsigned int line_number;
+      std::vector<step_t> predecessors;
+   };
+
+   /// @brief What the order of a step depends on.
+
+   struct event_t
+   {
+      tid_t tid;
+      /// @brief The operation of the instruction as given by operation_as_int.
+      int operation;
+      unsigned int line_number;
+      /// @brief The operand of a memory or lock instruction, ignored otherwise.
+      const void* object;
+   };
+
+   partial_order() = default;
+
+   explicit partial_order(const program_model::Execution& E);
+
+   /// @brief The partial order of the sequence of events, in execution order.
+
+   explicit partial_order(const std::vector<event_t>& events);
+
+   std::size_t size() const;
+
+   const step_info& operator[](const step_t step) const;
+
+   /// @brief The number of threads, i.e. one more than the largest tid.
+
+   std::size_t nr_threads() const;
+
+   /// @brief The steps of thread tid, in program order.
+
+   const std::vector<step_t>& steps_of(const tid_t tid) const;
+
+   void push_back(step_info info);
+
+private:
+   std::vector<step_info> m_steps;
+   std::vector<std::vector<step_t>> m_thread_steps;
+
+}; // end class partial_order
+
+std::ostream& operator<<(std::ostream&, const partial_order&);
+
+/// @brief Sets the stream's failbit if the steps are malformed.
+
+std::istream& operator>>(std::istream&, partial_order&);
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief Lets the threads of a program run in parallel, holding a thread back only while its
+/// next step has a predecessor that has not been performed yet.
+/// @details Steps are marked performed when their thread reaches its next visible instruction
+/// or finishes, as a visible instruction executes after its wrapper returns. Flags are atomic:
+/// threads only take the mutex to sleep, or to wake sleepers.
+/// @note Every thread only calls next_step and finish for itself.
+
+class partial_order_replay
+{
+public:
+   using tid_t = partial_order::tid_t;
+   using step_t = partial_order::step_t;
+
+   explicit partial_order_replay(partial_order order);
+
+   /// @brief Marks the previous step of tid performed and waits until the predecessors of its
+   /// next step, an instruction with the given operation and line number, are performed.
+   /// @returns false if the replay diverged from the recorded Execution (tid has no next step,
+   /// or its instruction differs), in which case no thread waits anymore.
+
+   bool next_step(const tid_t tid, const int operation, const unsigned int line_number);
+
+   /// @brief Marks the last step of tid performed.
+
+   void finish(const tid_t tid);
+
+   bool diverged() const;
+
+private:
+   partial_order m_order;
+   std::unique_ptr<std::atomic<bool>[]> m_performed;
+
+   /// @brief Per thread, the number of steps it started.
+   /// @details Each element is only accessed by its own thread.
+   std::vector<std::size_t> m_position;
+
+   std::atomic<bool> m_diverged;
+   std::atomic<unsigned int> m_nr_waiting;
+   std::mutex m_mutex;
+   std::condition_variable m_cond;
+
+   void perform_previous(const tid_t tid);
+   bool performed(const step_t step) const;
+   void wait_until_performed(const step_t step);
+   void diverge();
+
+}; // end class partial_order_replay
+
+} // end namespace scheduler
@@ -0,0 +1,761 @@
+
+#include "recorder.hpp"
+
+#include <execution_io.hpp>
+#include <state_io.hpp>
+#include <transition_io.hpp>
+#include <visible_instruction_io.hpp>
+
+#include <error.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <sstream>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+
+
+namespace scheduler {
+
+//--------------------------------------------------------------------------------------------------
+
+namespace {
+
+std::atomic<bool> flight_dump_requested{false};
+
+/// @brief How long a signal handler waits for the emergency flush before it hands the signal on.
+constexpr int emergency_flush_timeout = 2000; // ms
+
+const std::array<int, 7> flushed_signals{
+   {SIGABRT, SIGBUS, SIGFPE, SIGILL, SIGINT, SIGSEGV, SIGTERM}};
+
+/// @brief The dispositions that were installed before ours, to which on_signal hands the signal
+/// on.
+struct sigaction previous_actions[NSIG];
+
+/// @brief Set up once, before the handlers are installed: the handler writes the signal number
+/// to request and waits for a byte on done.
+int request_pipe[2] = {-1, -1};
+int done_pipe[2] = {-1, -1};
+
+/// @brief Protects active_recorder against its destruction while it is flushed.
+std::mutex active_recorder_mutex;
+recorder* active_recorder = nullptr;
+
+void chain(const int signal, siginfo_t* info, void* context)
+{
+   const auto& previous = previous_actions[signal];
+   if (previous.sa_flags & SA_SIGINFO)
+   {
+      if (previous.sa_sigaction)
+         previous.sa_sigaction(signal, info, context);
+   }
+   else if (previous.sa_handler == SIG_DFL)
+   {
+      // The signal is blocked until the handler returns, and then terminates the process
+      ::sigaction(signal, &previous, nullptr);
+      ::raise(signal);
+   }
+   else if (previous.sa_handler != SIG_IGN)
+   {
+      previous.sa_handler(signal);
+   }
+}
+
+/// @brief Has the signal_watcher flush the active recorder and hands the signal on.
+/// @note Only makes async-signal-safe calls: the formatting and writing of the record happen on
+/// the thread of the signal_watcher.
+
+void on_signal(int signal, siginfo_t* info, void* context)
+{
+   const int saved_errno = errno;
+   char byte = 0;
+   // Drop the acknowledgement of an earlier flush that took too long
+   while (::read(done_pipe[0], &byte, 1) == 1)
+      ;
+   byte = static_cast<char>(signal);
+   if (::write(request_pipe[1], &byte, 1) == 1)
+   {
+      pollfd done{done_pipe[0], POLLIN, 0};
+      if (::poll(&done, 1, emergency_flush_timeout) == 1 && ::read(done_pipe[0], &byte, 1) != 1)
+         byte = 0;
+   }
+   errno = saved_errno;
+   chain(signal, info, context);
+}
+
+/// @brief Start routine of the thread that flushes the active recorder on request of on_signal.
+
+void watch_signals()
+{
+   // Leave the signals to the threads that on_signal can wait in
+   sigset_t signals;
+   sigemptyset(&signals);
+   for (const int signal : flushed_signals)
+      sigaddset(&signals, signal);
+   pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+   char byte = 0;
+   while (true)
+   {
+      const auto n = ::read(request_pipe[0], &byte, 1);
+      if (n < 0 && errno == EINTR)
+         continue;
+      if (n != 1)
+         return;
+      {
+         std::lock_guard<std::mutex> lock(active_recorder_mutex);
+         if (active_recorder)
+            active_recorder->emergency_flush();
+      }
+      if (::write(done_pipe[1], &byte, 1) != 1)
+         return;
+   }
+}
+
+/// @brief Opens the pipes, starts the watcher thread and installs on_signal, once per process.
+
+void install_signal_handlers()
+{
+   static std::once_flag installed;
+   std::call_once(installed, [] {
+      if (::pipe(request_pipe) != 0 || ::pipe(done_pipe) != 0)
+         return;
+      // Neither may block the handler
+      ::fcntl(done_pipe[0], F_SETFL, ::fcntl(done_pipe[0], F_GETFL) | O_NONBLOCK);
+      ::fcntl(request_pipe[1], F_SETFL, ::fcntl(request_pipe[1], F_GETFL) | O_NONBLOCK);
+      std::thread(watch_signals).detach();
+
+      struct sigaction action;
+      action.sa_sigaction = on_signal;
+      sigemptyset(&action.sa_mask);
+      action.sa_flags = SA_SIGINFO | SA_RESTART;
+      for (const int signal : flushed_signals)
+         ::sigaction(signal, &action, &previous_actions[signal]);
+   });
+}
+
+void set_active_recorder(recorder* rec)
+{
+   std::lock_guard<std::mutex> lock(active_recorder_mutex);
+   active_recorder = rec;
+}
+
+void reset_active_recorder(recorder* rec)
+{
+   std::lock_guard<std::mutex> lock(active_recorder_mutex);
+   if (active_recorder == rec)
+      active_recorder = nullptr;
+}
+
+} // end namespace
+
+//--------------------------------------------------------------------------------------------------
+// execution_text_sink
+//--------------------------------------------------------------------------------------------------
+
+execution_text_sink::execution_text_sink(const std::string& record_file,
+                                         const std::string& short_record_file)
+: m_record_file(record_file)
+, m_short_record_file(short_record_file)
+, m_s0()
+, m_record_buffer(buffer_size)
+, m_short_record_buffer(buffer_size)
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void execution_text_sink::initial_state(const program_model::State& s0)
+{
+   std::stringstream stream;
+   stream << s0;
+   m_s0 = stream.str();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void execution_text_sink::transition(const program_model::Transition& trans)
+{
+   if (!m_record.is_open())
+   {
+      open();
+   }
+   m_record << program_model::to_string_post(trans) << "\n";
+   m_short_record << program_model::to_short_string(trans) << "\n";
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void execution_text_sink::close(const program_model::Execution::Status& status)
+{
+   if (m_record.is_open())
+   {
+      m_record << "=====\n" << status;
+      m_short_record << status;
+      m_record.close();
+      m_short_record.close();
+   }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void execution_text_sink::flush()
+{
+   if (m_record.is_open())
+   {
+      m_record.flush();
+      m_short_record.flush();
+   }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void execution_text_sink::flush_on_signal()
+{
+   flush();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void execution_text_sink::open()
+{
+   m_record.rdbuf()->pubsetbuf(m_record_buffer.data(), m_record_buffer.size());
+   m_record.open(m_record_file);
+   m_record << m_s0 << "\n";
+   m_short_record.rdbuf()->pubsetbuf(m_short_record_buffer.data(), m_short_record_buffer.size());
+   m_short_record.open(m_short_record_file);
+}
+
+//--------------------------------------------------------------------------------------------------
+// flight_recorder_sink
+//--------------------------------------------------------------------------------------------------
+
+constexpr std::size_t flight_recorder_sink::nr_keyframes;
+constexpr std::size_t flight_recorder_sink::schedule_buffer_size;
+
+//--------------------------------------------------------------------------------------------------
+
+flight_recorder_sink::flight_recorder_sink(const std::size_t capacity,
+                                           const std::size_t keyframe_interval,
+                                           const std::string& tail_file,
+                                           const std::string& schedule_file,
+                                           const std::string& keyframes_file)
+: m_capacity(std::max<std::size_t>(capacity, 1))
+, m_keyframe_interval(std::max<std::size_t>(keyframe_interval, 1))
+, m_tail_file(tail_file)
+, m_schedule_file(schedule_file)
+, m_keyframes_file(keyframes_file)
+, m_run{0, 0}
+, m_schedule_buffer()
+, m_schedule_fd(-1)
+, m_schedule_size(0)
+, m_dumped(false)
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+
+flight_recorder_sink::~flight_recorder_sink()
+{
+   if (m_schedule_fd != -1)
+      ::close(m_schedule_fd);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void flight_recorder_sink::initial_state(const program_model::State& s0)
+{
+   m_keyframes.emplace_back(0, std::make_shared<program_model::State>(s0));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void flight_recorder_sink::transition(const program_model::Transition& trans)
+{
+   const auto tid = boost::apply_visitor(program_model::get_tid(), trans.instr());
+   if (m_run.length > 0 && m_run.tid == tid)
+   {
+      ++m_run.length;
+   }
+   else
+   {
+      if (m_run.length > 0)
+      {
+         std::stringstream run;
+         run << m_run.tid << " " << m_run.length << "\n";
+         m_schedule_buffer += run.str();
+         if (m_schedule_buffer.size() >= schedule_buffer_size)
+            write_schedule_buffer();
+      }
+      m_run = {tid, 1};
+   }
+   if (m_tail.size() == m_capacity)
+      m_tail.pop_front();
+   m_tail.push_back(trans);
+   if (static_cast<std::size_t>(trans.index()) % m_keyframe_interval == 0)
+   {
+      if (m_keyframes.size() == nr_keyframes)
+         m_keyframes.pop_front();
+      m_keyframes.emplace_back(trans.index(), m_tail.back().post_ptr());
+   }
+   dump_if_requested();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void flight_recorder_sink::close(const program_model::Execution::Status& status)
+{
+   if (status != program_model::Execution::Status::DONE)
+      dump(status);
+   if (m_schedule_fd != -1)
+   {
+      ::close(m_schedule_fd);
+      m_schedule_fd = -1;
+      if (!m_dumped)
+         std::remove(m_schedule_file.c_str());
+   }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void flight_recorder_sink::flush()
+{
+   dump_if_requested();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void flight_recorder_sink::flush_on_signal()
+{
+   // As for an Execution that ends other than DONE, but the Execution has not ended
+   flight_dump_requested.store(false);
+   dump(program_model::Execution::Status::RUNNING);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void flight_recorder_sink::request_dump()
+{
+   flight_dump_requested.store(true);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void flight_recorder_sink::dump_if_requested()
+{
+   if (flight_dump_requested.exchange(false))
+      dump(program_model::Execution::Status::RUNNING);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void flight_recorder_sink::dump(const program_model::Execution::Status& status)
+{
+   m_dumped = true;
+   write_schedule_buffer();
+   std::stringstream run;
+   if (m_run.length > 0)
+      run << m_run.tid << " " << m_run.length << "\n";
+   // Not part of m_schedule_size: the last run may still grow
+   write_schedule(run.str(), m_schedule_size);
+   if (m_schedule_fd != -1)
+      ::ftruncate(m_schedule_fd, m_schedule_size + static_cast<off_t>(run.str().size()));
+
+   std::ofstream keyframes_stream(m_keyframes_file);
+   for (const auto& keyframe : m_keyframes)
+      keyframes_stream << keyframe.first << "\n" << *keyframe.second << "\n";
+
+   if (m_tail.empty())
+      return;
+   std::ofstream tail_stream(m_tail_file);
+   tail_stream << m_tail.front().pre() << "\n";
+   for (const auto& trans : m_tail)
+      tail_stream << program_model::to_string_post(trans) << "\n";
+   tail_stream << "=====\n" << status;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void flight_recorder_sink::write_schedule_buffer()
+{
+   write_schedule(m_schedule_buffer, m_schedule_size);
+   m_schedule_size += static_cast<off_t>(m_schedule_buffer.size());
+   m_schedule_buffer.clear();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void flight_recorder_sink::write_schedule(const std::string& data, const off_t offset)
+{
+   if (m_schedule_fd == -1)
+   {
+      m_schedule_fd = ::open(m_schedule_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+      if (m_schedule_fd == -1)
+      {
+         ERROR("flight_recorder_sink::write_schedule", "cannot open " << m_schedule_file);
+         return;
+      }
+   }
+   std::size_t written = 0;
+   while (written < data.size())
+   {
+      const auto n = ::pwrite(m_schedule_fd, data.data() + written, data.size() - written,
+                              offset + static_cast<off_t>(written));
+      if (n < 0 && errno == EINTR)
+         continue;
+      if (n <= 0)
+      {
+         ERROR("flight_recorder_sink::write_schedule", "cannot write " << m_schedule_file);
+         return;
+      }
+      written += static_cast<std::size_t>(n);
+   }
+}
+
+//--------------------------------------------------------------------------------------------------
+// recorder
+//--------------------------------------------------------------------------------------------------
+
+constexpr std::chrono::milliseconds recorder::flush_interval;
+constexpr std::chrono::milliseconds recorder::emergency_lock_timeout;
+
+//--------------------------------------------------------------------------------------------------
+
+recorder::recorder(record_sinks_t sinks)
+: m_sinks(std::move(sinks))
+, m_queue(std::make_unique<event[]>(queue_capacity))
+, m_head(0)
+, m_tail(0)
+, m_queue_mutex()
+, m_queue_cond()
+, m_producer_waiting(false)
+, m_consumer_waiting(false)
+, m_sinks_mutex()
+, m_last_state(nullptr)
+, m_pending(nullptr)
+, m_nr_transitions(0)
+, m_closed(false)
+, m_thread()
+{
+   // In-process, lightweight, partial-order and native runs record nothing here
+   if (m_sinks.empty())
+      return;
+   m_thread = std::thread([this] { return run(); });
+   install_signal_handlers();
+   set_active_recorder(this);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+recorder::~recorder()
+{
+   reset_active_recorder(this);
+   if (m_thread.joinable())
+   {
+      push({event::kind::close, nullptr, nullptr, program_model::Execution::Status::RUNNING});
+      m_thread.join();
+   }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void recorder::start(StatePtr s0)
+{
+   push({event::kind::start, nullptr, std::move(s0), program_model::Execution::Status::RUNNING});
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void recorder::push_step(instruction_ptr instr, StatePtr post)
+{
+   push({event::kind::step, std::move(instr), std::move(post),
+         program_model::Execution::Status::RUNNING});
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void recorder::close(StatePtr final, const program_model::Execution::Status& status)
+{
+   push({event::kind::close, nullptr, std::move(final), status});
+   if (m_thread.joinable())
+   {
+      m_thread.join();
+   }
+   reset_active_recorder(this);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void recorder::emergency_flush()
+{
+   // The recorder thread may be the one that received the signal
+   std::unique_lock<std::timed_mutex> lock(m_sinks_mutex, emergency_lock_timeout);
+   if (lock.owns_lock() && !m_closed)
+   {
+      if (m_pending)
+      {
+         for (auto& sink : m_sinks)
+            sink->transition(*m_pending);
+         m_pending.reset();
+      }
+      for (auto& sink : m_sinks)
+         sink->flush_on_signal();
+   }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void recorder::push(event e)
+{
+   // Without a thread (no sinks, or closed) nobody would empty the ring
+   if (!m_thread.joinable())
+      return;
+   const auto tail = m_tail.load(std::memory_order_relaxed);
+   const auto has_room = [this, tail] {
+      return tail - m_head.load(std::memory_order_acquire) < queue_capacity;
+   };
+   while (!has_room())
+   {
+      wait(m_producer_waiting, has_room, std::chrono::steady_clock::now() + flush_interval);
+   }
+   m_queue[tail % queue_capacity] = std::move(e);
+   m_tail.store(tail + 1, std::memory_order_release);
+   wake(m_consumer_waiting);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void recorder::run()
+{
+   auto last_flush = std::chrono::steady_clock::now();
+   while (true)
+   {
+      auto head = m_head.load(std::memory_order_relaxed);
+      const auto has_events = [this, head] {
+         return m_tail.load(std::memory_order_acquire) != head;
+      };
+      if (!has_events())
+      {
+         if (std::chrono::steady_clock::now() - last_flush < flush_interval)
+         {
+            wait(m_consumer_waiting, has_events, last_flush + flush_interval);
+            continue;
+         }
+         // Write out what the sinks buffer while the scheduler is waiting for the program's
+         // threads, so that little is lost when the process does not terminate normally
+         {
+            std::lock_guard<std::timed_mutex> guard(m_sinks_mutex);
+            flush_sinks();
+         }
+         last_flush = std::chrono::steady_clock::now();
+         continue;
+      }
+      const auto tail = m_tail.load(std::memory_order_acquire);
+      std::lock_guard<std::timed_mutex> guard(m_sinks_mutex);
+      for (; head != tail; ++head)
+      {
+         auto e = std::move(m_queue[head % queue_capacity]);
+         m_head.store(head + 1, std::memory_order_release);
+         wake(m_producer_waiting);
+         handle(e);
+         if (m_closed)
+            return;
+      }
+   }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+template <typename Predicate>
+void recorder::wait(std::atomic<bool>& waiting, Predicate done,
+                    const std::chrono::steady_clock::time_point& deadline)
+{
+   std::unique_lock<std::mutex> lock(m_queue_mutex);
+   waiting.store(true, std::memory_order_relaxed);
+   // Pairs with the fence in wake: either done() sees the other thread's index or the other
+   // thread sees waiting
+   std::atomic_thread_fence(std::memory_order_seq_cst);
+   m_queue_cond.wait_until(lock, deadline, done);
+   waiting.store(false, std::memory_order_relaxed);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void recorder::wake(const std::atomic<bool>& waiting)
+{
+   std::atomic_thread_fence(std::memory_order_seq_cst);
+   if (waiting.load(std::memory_order_relaxed))
+   {
+      std::lock_guard<std::mutex> lock(m_queue_mutex);
+      m_queue_cond.notify_all();
+   }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void recorder::handle(event& e)
+{
+   switch (e.type)
+   {
+      case event::kind::start:
+         m_last_state = std::move(e.post);
+         for (auto& sink : m_sinks)
+            sink->initial_state(*m_last_state);
+         break;
+      case event::kind::step:
+         if (m_pending)
+         {
+            for (auto& sink : m_sinks)
+               sink->transition(*m_pending);
+         }
+         m_pending = std::make_unique<program_model::Transition>(++m_nr_transitions, m_last_state,
+                                                                 *e.instr, e.post);
+         m_last_state = std::move(e.post);
+         break;
+      case event::kind::close:
+         if (m_pending)
+         {
+            if (e.post)
+               m_pending->set_post(e.post);
+            for (auto& sink : m_sinks)
+               sink->transition(*m_pending);
+            m_pending.reset();
+         }
+         for (auto& sink : m_sinks)
+            sink->close(e.status);
+         m_closed = true;
+         break;
+   }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void recorder::flush_sinks()
+{
+   for (auto& sink : m_sinks)
+      sink->flush();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+// unordered_log
+//--------------------------------------------------------------------------------------------------
+
+unordered_log::unordered_log(const std::string& file_name)
+: m_file_name(file_name)
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void unordered_log::append(
+   const std::function<tid_t()>& tid,
+   const std::function<program_model::visible_instruction_t(tid_t)>& create_instruction)
+{
+   auto& local = local_buffer(tid);
+   std::lock_guard<std::mutex> lock(local.mutex);
+   local.instructions.push_back(create_instruction(local.tid));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void unordered_log::write()
+{
+   std::lock_guard<std::mutex> lock(m_buffers_mutex);
+   if (m_buffers.empty())
+      return;
+
+   std::ofstream ofs(m_file_name);
+   for (auto& buffer : m_buffers)
+   {
+      std::lock_guard<std::mutex> buffer_lock(buffer.mutex);
+      for (const auto& instr : buffer.instructions)
+         ofs << instr << "\n";
+   }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+unordered_log::buffer& unordered_log::local_buffer(const std::function<tid_t()>& tid)
+{
+   thread_local const unordered_log* owner = nullptr;
+   thread_local buffer* local = nullptr;
+   if (owner != this)
+   {
+      const auto local_tid = tid();
+      std::lock_guard<std::mutex> lock(m_buffers_mutex);
+      m_buffers.emplace_back();
+      local = &m_buffers.back();
+      local->tid = local_tid;
+      owner = this;
+   }
+   return *local;
+}
+
+//--------------------------------------------------------------------------------------------------
+// schedule_log
+//--------------------------------------------------------------------------------------------------
+
+std::size_t schedule_log::site_hash::operator()(const site_t& site) const
+{
+   return std::hash<std::string>()(site.first) * 31 + site.second;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+schedule_log::schedule_log(const std::string& schedule_file, const std::string& sites_file)
+: m_schedule_file(schedule_file)
+, m_sites_file(sites_file)
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void schedule_log::push_back(const program_model::visible_instruction_t& instr)
+{
+   const auto& meta_data = boost::apply_visitor(program_model::get_meta_data(), instr);
+   const auto site =
+      m_site_ids
+         .emplace(site_t(meta_data.file_name, meta_data.line_number),
+                  static_cast<unsigned int>(m_sites.size()))
+         .first;
+   if (site->second == m_sites.size())
+      m_sites.push_back(&site->first);
+   m_schedule.push_back(boost::apply_visitor(program_model::get_tid(), instr));
+   m_steps.push_back(site->second);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+const schedule_t& schedule_log::schedule() const
+{
+   return m_schedule;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void schedule_log::write(const program_model::Execution::Status& status) const
+{
+   std::ofstream schedule_stream(m_schedule_file);
+   schedule_stream << m_schedule;
+
+   std::ofstream sites_stream(m_sites_file);
+   sites_stream << m_sites.size() << "\n";
+   for (const auto* site : m_sites)
+      sites_stream << site->first << " " << site->second << "\n";
+   for (const auto site_id : m_steps)
+      sites_stream << site_id << "\n";
+   sites_stream << "=====\n" << status;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+} // end namespace scheduler
@@ -0,0 +1,382 @@
+#pragma once
+
+#include "schedule.hpp"
+
+#include <execution.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <sys/types.h>
+
+//--------------------------------------------------------------------------------------------------
+/// @file recorder.hpp
+/// @author Susanne van den Elsen
+/// @date 2015-2017
+//--------------------------------------------------------------------------------------------------
+
+
+namespace scheduler {
+
+/// @brief Consumer of the Transitions built by a recorder.
+/// @details All functions are called from the recorder thread only.
+
+class record_sink
+{
+public:
+   virtual ~record_sink() = default;
+
+   virtual void initial_state(const program_model::State& s0) = 0;
+
+   virtual void transition(const program_model::Transition& trans) = 0;
+
+   virtual void close(const program_model::Execution::Status& status) = 0;
+
+   /// @brief Writes buffered output to its destination.
+
+   virtual void flush() = 0;
+
+   /// @brief Writes out what is needed to inspect the Execution so far, as the process is about
+   /// to be terminated by a signal.
+
+   virtual void flush_on_signal() = 0;
+
+}; // end class record_sink
+
+using record_sinks_t = std::vector<std::unique_ptr<record_sink>>;
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief Streams an Execution to record.txt (in the format of operator<<(ostream, Execution))
+/// and record_short.txt (in the format of to_short_string(Execution)).
+/// @details As before, nothing is written for an Execution without Transitions.
+
+class execution_text_sink : public record_sink
+{
+public:
+   execution_text_sink(const std::string& record_file, const std::string& short_record_file);
+
+   void initial_state(const program_model::State& s0) override;
+   void transition(const program_model::Transition& trans) override;
+   void close(const program_model::Execution::Status& status) override;
+   void flush() override;
+   void flush_on_signal() override;
+
+private:
+   static constexpr std::size_t buffer_size = 1 << 16;
+
+   std::string m_record_file;
+   std::string m_short_record_file;
+
+   /// @brief The initial State, kept until the first Transition opens the files.
+   std::string m_s0;
+
+   std::vector<char> m_record_buffer;
+   std::vector<char> m_short_record_buffer;
+   std::ofstream m_record;
+   std::ofstream m_short_record;
+
+   void open();
+
+}; // end class execution_text_sink
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief Keeps the last capacity Transitions of an Execution and, every keyframe_interval
+/// steps, a keyframe of the State, so that memory stays constant however long the Execution.
+/// @details Writes nothing unless the Execution ends with a status other than DONE, the process
+/// is terminated by a signal (see recorder), or a dump is requested. A dump writes
+/// - the tail: the kept Transitions in the format of record.txt, starting from the pre-State of
+///   the first, so that it reads as an Execution;
+/// - the schedule of the whole Execution so far, which replays up to the end of the tail;
+/// - the last nr_keyframes keyframes, each a line with its step followed by the State.
+///
+/// The schedule is the one part that grows with the Execution, so its completed runs are
+/// streamed to the schedule file as they are produced and only the last run is kept in memory.
+/// A dump appends the last run to what the file holds. The file is removed again if the
+/// Execution ends DONE without a dump.
+
+class flight_recorder_sink : public record_sink
+{
+public:
+   static constexpr std::size_t nr_keyframes = 4;
+
+   /// @{
+   /// Lifetime
+   flight_recorder_sink(const std::size_t capacity, const std::size_t keyframe_interval,
+                        const std::string& tail_file, const std::string& schedule_file,
+                        const std::string& keyframes_file);
+   ~flight_recorder_sink() override;
+   flight_recorder_sink(const flight_recorder_sink&) = delete;
+   flight_recorder_sink& operator=(const flight_recorder_sink&) = delete;
+   /// @}
+
+   void initial_state(const program_model::State& s0) override;
+   void transition(const program_model::Transition& trans) override;
+   void close(const program_model::Execution::Status& status) override;
+   void flush() override;
+   void flush_on_signal() override;
+
+   /// @brief Makes every flight_recorder_sink dump at its next Transition or flush.
+   /// @note Async-signal-safe.
+
+   static void request_dump();
+
+private:
+   using StatePtr = program_model::State::SharedPtr;
+
+   static constexpr std::size_t schedule_buffer_size = 1 << 16;
+
+   std::size_t m_capacity;
+   std::size_t m_keyframe_interval;
+   std::string m_tail_file;
+   std::string m_schedule_file;
+   std::string m_keyframes_file;
+
+   std::deque<program_model::Transition> m_tail;
+   std::deque<std::pair<int, StatePtr>> m_keyframes;
+
+   /// @brief The last run of the schedule, of length 0 before the first Transition.
+   schedule_t::run_t m_run;
+
+   /// @brief The completed runs that have not been written to the schedule file yet.
+   std::string m_schedule_buffer;
+
+   /// @brief The schedule file, opened when it is first written to, or -1.
+   int m_schedule_fd;
+
+   /// @brief The size of the completed runs in the schedule file, after which a dump writes the
+   /// last run.
+   off_t m_schedule_size;
+
+   bool m_dumped;
+
+   void dump_if_requested();
+   void dump(const program_model::Execution::Status& status);
+
+   /// @brief Writes m_schedule_buffer to the schedule file.
+
+   void write_schedule_buffer();
+
+   /// @brief Writes data at offset of the schedule file, opening it if needed.
+
+   void write_schedule(const std::string& data, const off_t offset);
+
+}; // end class flight_recorder_sink
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief Builds the Transitions of an Execution from the steps reported by the Scheduler and
+/// hands them to its record_sinks on a separate thread.
+/// @details The scheduler thread only snapshots the post-State of a step and appends it to a
+/// bounded single-producer single-consumer ring; creating the Transitions and formatting and
+/// writing them happens on the recorder thread. When the ring is full, the scheduler thread waits
+/// for the recorder thread to make room, so that memory stays bounded when the disk is slower
+/// than the scheduler. Each Transition is handed to the sinks one step late, as close can still
+/// replace the post-State of the last step. The sinks write out what they buffer when their
+/// buffers fill up, when the ring runs empty at least flush_interval after the last flush, and
+/// when they are closed.
+///
+/// A recorder without sinks starts no thread and installs no signal handlers; its functions
+/// then do nothing.
+///
+/// On SIGABRT, SIGBUS, SIGFPE, SIGILL, SIGINT, SIGSEGV and SIGTERM the sinks are flushed best
+/// effort (see emergency_flush) before the signal goes on to the disposition that the program
+/// had installed. The handler itself only writes to and polls pipes opened beforehand: a thread
+/// waiting on them does the flush, which the handler waits for a bounded time.
+/// @note push_step and close must be called from a single (the scheduler) thread.
+
+class recorder
+{
+public:
+   using instruction_ptr = std::shared_ptr<const program_model::visible_instruction_t>;
+   using StatePtr = program_model::State::SharedPtr;
+
+   /// @{
+   /// Lifetime
+   explicit recorder(record_sinks_t sinks);
+   ~recorder();
+   recorder(const recorder&) = delete;
+   recorder& operator=(const recorder&) = delete;
+   /// @}
+
+   void start(StatePtr s0);
+
+   void push_step(instruction_ptr instr, StatePtr post);
+
+   /// @brief Replaces the post-State of the last step by final (if not nullptr), sets the
+   /// status of the Execution and waits until the sinks have been closed.
+
+   void close(StatePtr final, const program_model::Execution::Status& status);
+
+   /// @brief Hands the pending Transition to the sinks and has them flush_on_signal, unless the
+   /// recorder thread keeps using them for longer than emergency_lock_timeout.
+
+   void emergency_flush();
+
+private:
+   static constexpr std::chrono::milliseconds flush_interval{100};
+   static constexpr std::chrono::milliseconds emergency_lock_timeout{1000};
+   /// @brief Number of events in the ring, a power of two.
+   static constexpr std::size_t queue_capacity = 1 << 10;
+
+   struct event
+   {
+      enum class kind
+      {
+         start,
+         step,
+         close
+      };
+
+      kind type;
+      instruction_ptr instr;
+      StatePtr post;
+      program_model::Execution::Status status;
+   };
+
+   record_sinks_t m_sinks;
+
+   /// @brief The ring: the scheduler thread appends at m_tail, the recorder thread takes from
+   /// m_head, both counting events since the start.
+   std::unique_ptr<event[]> m_queue;
+   std::atomic<std::size_t> m_head;
+   std::atomic<std::size_t> m_tail;
+
+   /// @brief Only used to sleep while the ring is full (the scheduler thread) or empty (the
+   /// recorder thread). A thread sets its waiting flag before it sleeps, so that the other only
+   /// takes the mutex to wake it.
+   std::mutex m_queue_mutex;
+   std::condition_variable m_queue_cond;
+   std::atomic<bool> m_producer_waiting;
+   std::atomic<bool> m_consumer_waiting;
+
+   /// @brief Protects m_sinks and the data below against emergency_flush.
+   std::timed_mutex m_sinks_mutex;
+
+   StatePtr m_last_state;
+   std::unique_ptr<program_model::Transition> m_pending;
+   int m_nr_transitions;
+   bool m_closed;
+
+   std::thread m_thread;
+
+   /// @brief Appends e to the ring, waiting while it is full.
+
+   void push(event e);
+
+   /// @brief Start routine of m_thread.
+
+   void run();
+
+   /// @brief Sleeps on m_queue_cond until done() or until deadline.
+
+   template <typename Predicate>
+   void wait(std::atomic<bool>& waiting, Predicate done,
+             const std::chrono::steady_clock::time_point& deadline);
+
+   /// @brief Wakes the other thread if it set waiting, after this thread moved m_head or m_tail.
+
+   void wake(const std::atomic<bool>& waiting);
+
+   void handle(event& e);
+
+   void flush_sinks();
+
+}; // end class recorder
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief Log of the visible instructions executed while the Scheduler does not control the
+/// threads.
+/// @details Every thread appends to a buffer of its own, which it finds through a thread_local
+/// pointer, so that appending only takes an uncontended lock. The log keeps the program order
+/// of each thread but has no order between threads.
+
+class unordered_log
+{
+public:
+   using tid_t = program_model::Thread::tid_t;
+
+   explicit unordered_log(const std::string& file_name);
+   unordered_log(const unordered_log&) = delete;
+   unordered_log& operator=(const unordered_log&) = delete;
+
+   /// @param tid Called, once per thread, to obtain the tid of the calling thread.
+
+   void append(const std::function<tid_t()>& tid,
+               const std::function<program_model::visible_instruction_t(tid_t)>& create_instruction);
+
+   /// @brief Writes the instructions to the file, one line each, grouped per thread.
+   /// @details Nothing is written if the log is empty.
+
+   void write();
+
+private:
+   struct buffer
+   {
+      tid_t tid;
+      std::mutex mutex;
+      std::vector<program_model::visible_instruction_t> instructions;
+   };
+
+   std::string m_file_name;
+
+   /// @brief Protects m_buffers.
+   std::mutex m_buffers_mutex;
+   std::deque<buffer> m_buffers;
+
+   buffer& local_buffer(const std::function<tid_t()>& tid);
+
+}; // end class unordered_log
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief Lightweight record of an Execution: the tid and the site (file name and line number)
+/// of each step, without States.
+/// @details write produces two files: the schedule, in the format of schedules/schedule.txt,
+/// and the sites, which lists the distinct sites (`file_name line_number`, the n-th line being
+/// site n) after their number, then the site of each step on a line, and ends with `=====` and
+/// the status, as record.txt does.
+
+class schedule_log
+{
+public:
+   schedule_log(const std::string& schedule_file, const std::string& sites_file);
+
+   void push_back(const program_model::visible_instruction_t& instr);
+
+   const schedule_t& schedule() const;
+
+   void write(const program_model::Execution::Status& status) const;
+
+private:
+   using site_t = std::pair<std::string, unsigned int>;
+
+   struct site_hash
+   {
+      std::size_t operator()(const site_t& site) const;
+   };
+
+   std::string m_schedule_file;
+   std::string m_sites_file;
+
+   schedule_t m_schedule;
+   std::unordered_map<site_t, unsigned int, site_hash> m_site_ids;
+   std::vector<const site_t*> m_sites;
+   std::vector<unsigned int> m_steps;
+
+}; // end class schedule_log
+
+} // end namespace scheduler
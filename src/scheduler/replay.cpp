@@ -16,18 +16,43 @@ namespace scheduler {
 
 //--------------------------------------------------------------------------------------------------
 
-void run_under_schedule(const program_t& program, const schedule_t& schedule,
-                        const boost::optional<timeout_t>& timeout,
-                        const boost::filesystem::path& output_dir)
+namespace {
+
+void run_and_collect_records(const program_t& program, const boost::optional<timeout_t>& timeout,
+                             const boost::filesystem::path& output_dir)
 {
-   write_schedules(schedule);
    utils::sys::fork_process(program.string(), timeout);
+   collect_records(output_dir);
+}
+
+} // end namespace
 
+//--------------------------------------------------------------------------------------------------
+
+void collect_records(const boost::filesystem::path& output_dir,
+                     const boost::filesystem::path& working_dir)
+{
    if (!boost::filesystem::exists(output_dir))
       boost::filesystem::create_directories(output_dir);
 
-   boost::filesystem::rename("./record.txt", output_dir / "record.txt");
-   boost::filesystem::rename("./record_short.txt", output_dir / "record_short.txt");
+   for (const auto* record : {"record.txt", "record_short.txt", "record_states.txt",
+                              "record_free_run.txt", "record_schedule.txt", "record_sites.txt",
+                              "record_partial_order.txt", "record_tail.txt",
+                              "record_tail_schedule.txt", "record_keyframes.txt"})
+   {
+      if (boost::filesystem::exists(working_dir / record))
+         boost::filesystem::rename(working_dir / record, output_dir / record);
+   }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void run_under_schedule(const program_t& program, const schedule_t& schedule,
+                        const boost::optional<timeout_t>& timeout,
+                        const boost::filesystem::path& output_dir)
+{
+   write_schedules(schedule);
+   run_and_collect_records(program, timeout, output_dir);
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -43,6 +68,84 @@ void run_under_schedule(const program_t& program, const schedule_t& schedule,
 
 //--------------------------------------------------------------------------------------------------
 
+void run_under_schedule(const program_t& program, const schedule_t& schedule,
+                        const std::vector<fingerprint_t>& fingerprints,
+                        const boost::optional<timeout_t>& timeout,
+                        const boost::filesystem::path& output_dir)
+{
+   write_schedules(schedule, fingerprints);
+   run_and_collect_records(program, timeout, output_dir);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void run_under_schedule(fork_server& server, const schedule_t& schedule,
+                        const boost::optional<timeout_t>& timeout,
+                        const boost::filesystem::path& output_dir)
+{
+   write_schedules(schedule);
+   server.run(timeout);
+   collect_records(output_dir);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+boost::optional<shared_channel::result_t>
+run_under_schedule(shared_channel& channel, const program_t& program, const schedule_t& schedule,
+                   const boost::optional<timeout_t>& timeout,
+                   const boost::filesystem::path& output_dir)
+{
+   if (!channel.write_schedule(schedule))
+      write_schedules(schedule);
+   run_and_collect_records(program, timeout, output_dir);
+   return channel.result();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+boost::optional<shared_channel::result_t>
+run_under_schedule(shared_channel& channel, fork_server& server, const schedule_t& schedule,
+                   const boost::optional<timeout_t>& timeout,
+                   const boost::filesystem::path& output_dir)
+{
+   if (!channel.write_schedule(schedule))
+      write_schedules(schedule);
+   server.run(timeout);
+   collect_records(output_dir);
+   return channel.result();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void run_under_partial_order(const program_t& program, const program_model::Execution& E,
+                             const boost::optional<timeout_t>& timeout)
+{
+   run_under_partial_order(program, partial_order(E), timeout);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void run_under_partial_order(const program_t& program, const partial_order& order,
+                             const boost::optional<timeout_t>& timeout)
+{
+   write_settings(SchedulerSettings("Random").set_partial_order(true));
+   std::ofstream ofs("schedules/partial_order.txt");
+   ofs << order;
+   ofs.close();
+   utils::sys::fork_process(program.string(), timeout);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void record_natively(const program_t& program, const boost::optional<timeout_t>& timeout,
+                     const boost::filesystem::path& output_dir)
+{
+   run_under_schedule(program, {}, SchedulerSettings("Random").set_native_record(true), timeout,
+                      output_dir);
+}
+
+//--------------------------------------------------------------------------------------------------
+
 namespace detail {
 
 const static boost::filesystem::path llvm_bin = BOOST_PP_STRINGIZE(LLVM_BIN);
@@ -158,7 +261,7 @@ boost::filesystem::path instrument(const program_t& program_source,
 
 void write_settings(const SchedulerSettings& settings)
 {
-   system("test -d schedules || mkdir schedules");
+   boost::filesystem::create_directories("schedules");
    std::ofstream ofs("schedules/settings.txt");
    ofs << settings;
    ofs.close();
@@ -166,12 +269,31 @@ void write_settings(const SchedulerSettings& settings)
 
 //--------------------------------------------------------------------------------------------------
 
+void write_settings(shared_channel& channel, const SchedulerSettings& settings)
+{
+   if (!channel.write_settings(settings))
+      write_settings(settings);
+}
+
+//--------------------------------------------------------------------------------------------------
+
 void write_schedules(const schedule_t& schedule)
 {
-   system("test -d schedules || mkdir schedules");
+   boost::filesystem::create_directories("schedules");
    std::ofstream ofs("schedules/schedule.txt");
    ofs << schedule;
    ofs.close();
+   boost::filesystem::remove("schedules/fingerprints.txt");
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void write_schedules(const schedule_t& schedule, const std::vector<fingerprint_t>& fingerprints)
+{
+   write_schedules(schedule);
+   std::ofstream ofs("schedules/fingerprints.txt");
+   write_fingerprints(ofs, fingerprints);
+   ofs.close();
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -1,12 +1,16 @@
 #pragma once
 
+#include "fork_server.hpp"
+#include "partial_order.hpp"
 #include "schedule.hpp"
+#include "shared_channel.hpp"
 
 #include <boost/filesystem/path.hpp>
 #include <boost/optional.hpp>
 
 #include <chrono>
 #include <string>
+#include <vector>
 
 //--------------------------------------------------------------------------------------------------
 /// @file replay.hpp
@@ -27,6 +31,11 @@ class SchedulerSettings;
 using program_t = boost::filesystem::path;
 using timeout_t = std::chrono::milliseconds;
 
+/// @brief Moves the records that a run of the program in working_dir wrote to output_dir.
+
+void collect_records(const boost::filesystem::path& output_dir,
+                     const boost::filesystem::path& working_dir = ".");
+
 /// @brief Run the program under the settings currently in schedules/settings.txt.
 /// @note If schedules/settings.txt does not exist, the Scheduler may not behave as
 /// expected.
@@ -39,6 +48,44 @@ void run_under_schedule(const program_t&, const schedule_t&, const SchedulerSett
                         const boost::optional<timeout_t>& timeout = boost::none,
                         const boost::filesystem::path& output_dir = "./record_replay_output");
 
+/// @brief Run the program under the schedule, aborting at the first step whose instruction
+/// does not have the expected fingerprint (see fingerprint), e.g. fingerprints(E) when
+/// replaying schedule(E).
+/// @details The Scheduler reports the diverging step and terminates the program instead of
+/// letting its threads run on.
+
+void run_under_schedule(const program_t&, const schedule_t&,
+                        const std::vector<fingerprint_t>& fingerprints,
+                        const boost::optional<timeout_t>& timeout = boost::none,
+                        const boost::filesystem::path& output_dir = "./record_replay_output");
+
+/// @brief Run the program of the fork server under the schedule, in a process forked from the
+/// server instead of a new one.
+
+void run_under_schedule(fork_server&, const schedule_t&,
+                        const boost::optional<timeout_t>& timeout = boost::none,
+                        const boost::filesystem::path& output_dir = "./record_replay_output");
+
+/// @brief Run the program under the schedule, passing the schedule in and the outcome out
+/// through the channel instead of files.
+/// @details The settings are those last written with write_settings(channel, settings), or
+/// else those in schedules/settings.txt. The records other than the schedule and the data
+/// races are still files, and are moved to output_dir.
+/// @returns The outcome of the run, see shared_channel::result.
+
+boost::optional<shared_channel::result_t>
+run_under_schedule(shared_channel&, const program_t&, const schedule_t&,
+                   const boost::optional<timeout_t>& timeout = boost::none,
+                   const boost::filesystem::path& output_dir = "./record_replay_output");
+
+/// @brief As above, in a process forked from the server.
+/// @pre The channel was created before the server, so that the program inherited it.
+
+boost::optional<shared_channel::result_t>
+run_under_schedule(shared_channel&, fork_server&, const schedule_t&,
+                   const boost::optional<timeout_t>& timeout = boost::none,
+                   const boost::filesystem::path& output_dir = "./record_replay_output");
+
 #if defined(LLVM_BIN) && defined(RECORD_REPLAY_BUILD_DIR)
 boost::filesystem::path instrument(const program_t& program_source,
                                    const boost::filesystem::path& output_dir,
@@ -46,10 +93,41 @@ boost::filesystem::path instrument(const program_t& program_source,
                                    const std::string& compiler_options = "");
 #endif
 
+/// @brief Runs the program, enforcing only the order between the conflicting Transitions of E
+/// (see partial_order), so that threads that do not conflict run in parallel.
+/// @details Writes schedules/partial_order.txt and settings selecting partial-order replay.
+
+void run_under_partial_order(const program_t&, const program_model::Execution& E,
+                             const boost::optional<timeout_t>& timeout = boost::none);
+
+void run_under_partial_order(const program_t&, const partial_order&,
+                             const boost::optional<timeout_t>& timeout = boost::none);
+
+/// @brief Runs the program with its threads in their native order, recording the order of
+/// their visible instructions (see native_recorder).
+/// @details Writes record_schedule.txt, which run_under_schedule replays, and
+/// record_partial_order.txt, which run_under_partial_order replays, to output_dir. If racing
+/// accesses may have executed out of their recorded order, writes neither and ends with
+/// status ERROR instead.
+
+void record_natively(const program_t&, const boost::optional<timeout_t>& timeout = boost::none,
+                     const boost::filesystem::path& output_dir = "./record_replay_output");
+
 void write_settings(const SchedulerSettings&);
 
+/// @brief Writes the settings of the next runs in the channel, or in schedules/settings.txt
+/// if they do not fit.
+
+void write_settings(shared_channel&, const SchedulerSettings&);
+
+/// @brief Writes schedules/schedule.txt, removing the fingerprints of an earlier schedule.
+
 void write_schedules(const schedule_t&);
 
+/// @brief Writes schedules/schedule.txt and schedules/fingerprints.txt.
+
+void write_schedules(const schedule_t&, const std::vector<fingerprint_t>& fingerprints);
+
 //--------------------------------------------------------------------------------------------------
 
 } // end namespace scheduler
@@ -1,21 +1,346 @@
 
 #include "schedule.hpp"
 
-// PROGRAM_MODEL
 #include <execution.hpp>
 
-namespace scheduler
+#include <boost/variant/apply_visitor.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <ios>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+
+
+namespace scheduler {
+
+//--------------------------------------------------------------------------------------------------
+
+schedule_t::schedule_t(std::initializer_list<tid_t> tids)
+{
+   for (const auto tid : tids)
+      push_back(tid);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void schedule_t::push_back(const tid_t tid, const std::size_t length)
+{
+   if (length == 0)
+      return;
+   if (!m_runs.empty() && m_runs.back().tid == tid)
+   {
+      m_runs.back().length += length;
+      m_ends.back() += length;
+      return;
+   }
+   m_runs.push_back({tid, length});
+   m_ends.push_back(size() + length);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::size_t schedule_t::size() const
+{
+   return m_ends.empty() ? 0 : m_ends.back();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool schedule_t::empty() const
+{
+   return m_runs.empty();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::size_t schedule_t::nr_runs() const
+{
+   return m_runs.size();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+schedule_t::const_iterator schedule_t::begin() const
+{
+   return m_runs.begin();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+schedule_t::const_iterator schedule_t::end() const
+{
+   return m_runs.end();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+schedule_t::tid_t schedule_t::at(const std::size_t step) const
+{
+   const auto it = std::upper_bound(m_ends.begin(), m_ends.end(), step);
+   if (it == m_ends.end())
+      throw std::out_of_range("schedule_t::at");
+   return m_runs[it - m_ends.begin()].tid;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool operator==(const schedule_t& lhs, const schedule_t& rhs)
+{
+   return lhs.nr_runs() == rhs.nr_runs() &&
+          std::equal(lhs.begin(), lhs.end(), rhs.begin(), [](const auto& run1, const auto& run2) {
+             return run1.tid == run2.tid && run1.length == run2.length;
+          });
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool operator!=(const schedule_t& lhs, const schedule_t& rhs)
+{
+   return !(lhs == rhs);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::ostream& operator<<(std::ostream& os, const schedule_t& schedule)
+{
+   for (const auto& run : schedule)
+      os << run.tid << " " << run.length << "\n";
+   return os;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+namespace {
+
+/// @brief Whether is starts with a schedule in the flat format of earlier versions, e.g.
+/// `<0,0,1,1>`, which lists the tid of every step.
+
+bool is_legacy(std::istream& is)
+{
+   return (is >> std::ws).peek() == '<';
+}
+
+/// @brief Reads a schedule in the flat format, failing is if it is malformed.
+
+void read_legacy(std::istream& is, schedule_t& schedule)
+{
+   is.get();
+   if ((is >> std::ws).peek() == '>')
+   {
+      is.get();
+      return;
+   }
+   schedule_t::tid_t tid;
+   while (is >> tid)
+   {
+      schedule.push_back(tid);
+      // Whitespace may precede every separator
+      const auto separator = (is >> std::ws).get();
+      if (separator == '>')
+         return;
+      if (separator != ',')
+         break;
+   }
+   is.setstate(std::ios::failbit);
+}
+
+} // end namespace
+
+//--------------------------------------------------------------------------------------------------
+
+std::istream& operator>>(std::istream& is, schedule_t& schedule)
+{
+   schedule = schedule_t();
+   if (is_legacy(is))
+   {
+      read_legacy(is, schedule);
+      return is;
+   }
+   schedule_t::tid_t tid;
+   std::size_t length;
+   while (is >> tid >> length)
+      schedule.push_back(tid, length);
+   return is;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+schedule_reader::schedule_reader()
+: schedule_reader(nullptr)
 {
-   //-------------------------------------------------------------------------------------
+}
+
+//--------------------------------------------------------------------------------------------------
 
-   schedule_t schedule(const program_model::Execution& E)
+schedule_reader::schedule_reader(std::unique_ptr<std::istream> input)
+: m_input(std::move(input))
+, m_run{-1, 0}
+, m_position(0)
+{
+   if (m_input && is_legacy(*m_input))
    {
-      schedule_t s;
-      std::transform(E.begin(), E.end(), std::back_inserter(s),
-                     [] (const auto& trans) { return boost::apply_visitor(program_model::get_tid(), trans.instr()); });
-      return s;
+      // Converted to runs up front, as the flat format has to be read whole anyway
+      schedule_t schedule;
+      read_legacy(*m_input, schedule);
+      if (m_input->fail())
+         throw std::invalid_argument("schedule_reader: malformed schedule");
+      auto runs = std::make_unique<std::stringstream>();
+      *runs << schedule;
+      m_input = std::move(runs);
    }
-   
-   //-------------------------------------------------------------------------------------
-    
+}
+
+//--------------------------------------------------------------------------------------------------
+
+schedule_reader schedule_reader::read_from_file(const std::string& file_name)
+{
+   return schedule_reader(std::make_unique<std::ifstream>(file_name));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+boost::optional<schedule_reader::tid_t> schedule_reader::next()
+{
+   if (at_end())
+      return boost::none;
+   --m_run.length;
+   ++m_position;
+   return m_run.tid;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool schedule_reader::at_end()
+{
+   while (m_run.length == 0)
+   {
+      if (!m_input || !(*m_input >> m_run.tid >> m_run.length))
+      {
+         m_input.reset();
+         m_run.length = 0;
+         return true;
+      }
+   }
+   return false;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::size_t schedule_reader::position() const
+{
+   return m_position;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+schedule_t schedule(const program_model::Execution& E)
+{
+   schedule_t s;
+   for (const auto& transition : E)
+      s.push_back(boost::apply_visitor(program_model::get_tid(), transition.instr()));
+   return s;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+namespace {
+
+constexpr fingerprint_t fnv_offset_basis = 0xcbf29ce484222325ull;
+constexpr fingerprint_t fnv_prime = 0x100000001b3ull;
+
+void hash_bytes(fingerprint_t& hash, const void* data, const std::size_t size)
+{
+   const auto* bytes = static_cast<const unsigned char*>(data);
+   for (std::size_t i = 0; i < size; ++i)
+   {
+      hash ^= bytes[i];
+      hash *= fnv_prime;
+   }
+}
+
+void hash_integer(fingerprint_t& hash, const std::int64_t value)
+{
+   // Byte by byte, so that the hash does not depend on the byte order
+   for (unsigned shift = 0; shift < 64; shift += 8)
+   {
+      const auto byte = static_cast<unsigned char>(static_cast<std::uint64_t>(value) >> shift);
+      hash_bytes(hash, &byte, 1);
+   }
+}
+
+} // end namespace
+
+//--------------------------------------------------------------------------------------------------
+
+fingerprint_t fingerprint(const program_model::visible_instruction_t& instr)
+{
+   const auto& meta_data = boost::apply_visitor(program_model::get_meta_data(), instr);
+   fingerprint_t hash = fnv_offset_basis;
+   hash_integer(hash, boost::apply_visitor(program_model::get_tid(), instr));
+   hash_integer(hash, boost::apply_visitor(program_model::operation_as_int(), instr));
+   hash_integer(hash, meta_data.line_number);
+   hash_bytes(hash, meta_data.file_name.data(), meta_data.file_name.size());
+   return hash;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::vector<fingerprint_t> fingerprints(const program_model::Execution& E)
+{
+   std::vector<fingerprint_t> result;
+   result.reserve(E.size());
+   for (const auto& transition : E)
+      result.push_back(fingerprint(transition.instr()));
+   return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+fingerprint_reader::fingerprint_reader()
+: fingerprint_reader(nullptr)
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+
+fingerprint_reader::fingerprint_reader(std::unique_ptr<std::istream> input)
+: m_input(std::move(input))
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+
+fingerprint_reader fingerprint_reader::read_from_file(const std::string& file_name)
+{
+   return fingerprint_reader(std::make_unique<std::ifstream>(file_name));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+boost::optional<fingerprint_t> fingerprint_reader::next()
+{
+   fingerprint_t value;
+   if (!m_input || !(*m_input >> std::hex >> value))
+   {
+      m_input.reset();
+      return boost::none;
+   }
+   return value;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void write_fingerprints(std::ostream& os, const std::vector<fingerprint_t>& fingerprints)
+{
+   os << std::hex;
+   for (const auto value : fingerprints)
+      os << value << "\n";
+   os << std::dec;
+}
+
+//--------------------------------------------------------------------------------------------------
+
 } // end namespace scheduler
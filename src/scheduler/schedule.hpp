@@ -1,33 +1,192 @@
 #pragma once
 
-// PROGRAM_MODEL
 #include <thread.hpp>
+#include <visible_instruction.hpp>
 
-// STL
+#include <boost/optional.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iosfwd>
+#include <memory>
+#include <string>
 #include <vector>
 
-//--------------------------------------------------------------------------------------90
+//--------------------------------------------------------------------------------------------------
 /// @file schedule.hpp
 /// @author Susanne van den Elsen
-/// @date 2015
-//----------------------------------------------------------------------------------------
+/// @date 2015-2017
+//--------------------------------------------------------------------------------------------------
+///
+/// A schedule is stored as a sequence of runs: a run (tid, length) schedules thread tid for length
+/// consecutive steps. The text format has one run per line, `tid length`, so the size of a
+/// schedule scales with its number of context switches instead of its number of steps. The flat
+/// format of earlier versions, the tid of every step between angle brackets (e.g. `<0,0,1,1>`),
+/// is still read and converted to runs.
 
-namespace program_model
-{
-   class Execution;
-   
+
+namespace program_model {
+class Execution;
 } // end namespace program_model
 
-//----------------------------------------------------------------------------------------
+//--------------------------------------------------------------------------------------------------
+
+namespace scheduler {
+
+class schedule_t
+{
+public:
+   using tid_t = program_model::Thread::tid_t;
+
+   struct run_t
+   {
+      tid_t tid;
+      std::size_t length;
+   };
+
+   using runs_t = std::vector<run_t>;
+   using const_iterator = runs_t::const_iterator;
+
+   schedule_t() = default;
+
+   /// @brief Constructs the schedule that schedules the given tids, one step each.
+
+   schedule_t(std::initializer_list<tid_t> tids);
+
+   /// @brief Appends length steps of thread tid, extending the last run if it is of tid.
+
+   void push_back(const tid_t tid, const std::size_t length = 1);
+
+   /// @brief The number of steps.
+
+   std::size_t size() const;
+   bool empty() const;
+
+   std::size_t nr_runs() const;
+
+   /// @{
+   /// @brief Iteration over the runs.
+   const_iterator begin() const;
+   const_iterator end() const;
+   /// @}
+
+   /// @brief The tid scheduled at the given step.
+   /// @note Logarithmic in the number of runs.
+   /// @throws std::out_of_range if step >= size().
+
+   tid_t at(const std::size_t step) const;
+
+private:
+   runs_t m_runs;
+
+   /// @brief The step at which each run ends (exclusive).
+   std::vector<std::size_t> m_ends;
+
+}; // end class schedule_t
+
+bool operator==(const schedule_t&, const schedule_t&);
+bool operator!=(const schedule_t&, const schedule_t&);
+
+std::ostream& operator<<(std::ostream&, const schedule_t&);
+
+/// @brief Reads runs until the end of the input or the first malformed run.
+/// @details Reads a schedule in the flat format whole, failing is if it is malformed.
+
+std::istream& operator>>(std::istream&, schedule_t&);
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief Produces the steps of a schedule in order, reading its runs from a stream only when
+/// the previous run is exhausted.
+
+class schedule_reader
+{
+public:
+   using tid_t = schedule_t::tid_t;
+
+   /// @brief Reader of the empty schedule.
+
+   schedule_reader();
 
-namespace scheduler
+   /// @throws std::invalid_argument if input holds a malformed schedule in the flat format.
+
+   explicit schedule_reader(std::unique_ptr<std::istream> input);
+
+   /// @brief Reads the schedule in the text file file_name.
+   /// @details Yields the empty schedule if the file cannot be opened.
+
+   static schedule_reader read_from_file(const std::string& file_name);
+
+   /// @brief Consumes the next step.
+   /// @returns The tid scheduled at that step or boost::none if the schedule is exhausted.
+
+   boost::optional<tid_t> next();
+
+   /// @brief Whether the schedule is exhausted.
+   /// @note Reads ahead the next run if the current one is exhausted.
+
+   bool at_end();
+
+   /// @brief The number of steps consumed.
+
+   std::size_t position() const;
+
+private:
+   std::unique_ptr<std::istream> m_input;
+   schedule_t::run_t m_run;
+   std::size_t m_position;
+
+}; // end class schedule_reader
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief The schedule of E, one run per uninterrupted sequence of steps of a thread.
+
+schedule_t schedule(const program_model::Execution& E);
+
+//--------------------------------------------------------------------------------------------------
+
+using fingerprint_t = std::uint64_t;
+
+/// @brief Hash of the tid, operation, file name and line number of instr.
+/// @details Operands are left out: the addresses of objects differ between runs. The hash is
+/// FNV-1a, so that it is the same in every process.
+
+fingerprint_t fingerprint(const program_model::visible_instruction_t& instr);
+
+/// @brief The fingerprints of the instructions of E, one per step.
+
+std::vector<fingerprint_t> fingerprints(const program_model::Execution& E);
+
+/// @brief Produces the fingerprints of the steps of a schedule in order, reading them from a
+/// stream only when they are needed.
+/// @details The text format has one hexadecimal fingerprint per line.
+
+class fingerprint_reader
 {
-   //-------------------------------------------------------------------------------------
-   
-   using schedule_t = std::vector<program_model::Thread::tid_t>;
-   
-   schedule_t schedule(const program_model::Execution& E);
-   
-   //-------------------------------------------------------------------------------------
-    
+public:
+   /// @brief Reader of the empty sequence.
+
+   fingerprint_reader();
+
+   explicit fingerprint_reader(std::unique_ptr<std::istream> input);
+
+   /// @brief Reads the fingerprints in the text file file_name.
+   /// @details Yields the empty sequence if the file cannot be opened.
+
+   static fingerprint_reader read_from_file(const std::string& file_name);
+
+   /// @brief Consumes the fingerprint of the next step.
+   /// @returns boost::none if there are no more fingerprints.
+
+   boost::optional<fingerprint_t> next();
+
+private:
+   std::unique_ptr<std::istream> m_input;
+
+}; // end class fingerprint_reader
+
+void write_fingerprints(std::ostream&, const std::vector<fingerprint_t>&);
+
 } // end namespace scheduler
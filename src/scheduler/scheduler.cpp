@@ -2,17 +2,39 @@
 #include "scheduler.hpp"
 
 #include <execution_io.hpp>
+#include <thread_io.hpp>
 #include <visible_instruction_io.hpp>
 
 #include <container_io.hpp>
 #include <debug.hpp>
 #include <error.hpp>
-#include <utils_io.hpp>
 
 #include <boost/range/algorithm/find_if.hpp>
 
+#include <cxxabi.h>
+#include <pthread.h>
+
+#include <atomic>
+#include <csignal>
 #include <exception>
+#include <fstream>
 #include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+//--------------------------------------------------------------------------------------------------
+
+const bool the_fork_server_child = scheduler::fork_server::serve_if_requested();
+
+namespace {
+/// @brief Owns *the_scheduler.
+std::unique_ptr<scheduler::Scheduler> the_scheduler_owner =
+   std::make_unique<scheduler::Scheduler>();
+} // end namespace
+
+std::atomic<scheduler::Scheduler*> the_scheduler{the_scheduler_owner.get()};
 
 
 namespace scheduler {
@@ -31,6 +53,42 @@ std::string pid_to_string(const pthread_t& pid)
    }
    return stream.str();
 }
+
+/// @brief Set by SIGUSR1 when deferred control is triggered by a signal.
+std::atomic<bool> control_requested{false};
+
+void request_control(int)
+{
+   control_requested.store(true);
+}
+
+void request_flight_dump(int)
+{
+   flight_recorder_sink::request_dump();
+}
+
+/// @brief The settings of a run within the process, which records the schedule only.
+
+SchedulerSettings in_process_settings(const SchedulerSettings& settings)
+{
+   auto in_process = settings;
+   in_process.set_partial_order(false)
+      .set_native_record(false)
+      .set_lightweight_record(true)
+      .set_flight_recorder(boost::none);
+   return in_process;
+}
+
+std::unique_ptr<partial_order_replay> read_partial_order(const std::string& file_name)
+{
+   partial_order order;
+   std::ifstream ifs(file_name);
+   if (!(ifs >> order))
+   {
+      ERROR("Scheduler", "reading the partial order from " << file_name);
+   }
+   return std::make_unique<partial_order_replay>(std::move(order));
+}
 } // end namespace
 
 
@@ -43,21 +101,108 @@ class unregistered_thread : public std::exception
 //--------------------------------------------------------------------------------------------------
 
 Scheduler::Scheduler()
-: mLocVars(std::make_unique<LocalVars>())
+: Scheduler(shared_channel::attach(), boost::none)
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Scheduler::Scheduler(const SchedulerSettings& settings, const schedule_t& schedule)
+: Scheduler(nullptr, in_process_input_t{settings, schedule})
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Scheduler::Scheduler(std::unique_ptr<shared_channel> channel,
+                     const boost::optional<in_process_input_t>& input)
+: mChannel(std::move(channel))
+, mInProcess(input.is_initialized())
+, mLocVars(input ? std::make_unique<LocalVars>(input->schedule)
+                 : std::make_unique<LocalVars>(mChannel.get()))
 , mPool()
 , mThreads()
 , mControllableThreads()
+, mRetiredThreads()
+, mJoinedThreads()
 , mNrRegistered(0)
+, mMainThreadRegistered(false)
+, mAbandoned(false)
 , mRegMutex()
+, mMainThreadFinished(false)
 , mRegCond()
 , mStatus(Execution::Status::RUNNING)
 , mStatusMutex()
-, mSettings(SchedulerSettings::read_from_file("schedules/settings.txt"))
-, mSelector(selector_factory(mSettings.strategy_tag()))
+, mSettings([this, &input] {
+   if (input)
+      return in_process_settings(input->settings);
+   const auto settings_input =
+      open_input(mChannel.get(), shared_channel::section::settings, "schedules/settings.txt");
+   return SchedulerSettings::read(*settings_input, "schedules/settings.txt");
+}())
+, mSelector(selector_factory(mSettings))
+, mReleased(false)
+, mEndBlockedThreads(false)
+, mDeferred(mSettings.deferred_control().is_initialized())
+, mNrUncontrolledSteps(0)
+, mFreeRunLog("record_free_run.txt")
+, mPartialOrder(mSettings.partial_order() ? read_partial_order("schedules/partial_order.txt")
+                                           : nullptr)
+, mNativeRecorder(mSettings.native_record() ? std::make_unique<native_recorder>() : nullptr)
+, mRecorder([this] {
+   record_sinks_t sinks;
+   // Only a controlled, fully recorded run hands the recorder steps
+   if (mInProcess || mSettings.lightweight_record() || mSettings.partial_order() ||
+       mSettings.native_record())
+   {
+      return sinks;
+   }
+   if (const auto& flight_recorder = mSettings.flight_recorder())
+   {
+      sinks.push_back(std::make_unique<flight_recorder_sink>(
+         flight_recorder->capacity, flight_recorder->keyframe_interval, "record_tail.txt",
+         "record_tail_schedule.txt", "record_keyframes.txt"));
+   }
+   else
+   {
+      sinks.push_back(std::make_unique<execution_text_sink>("record.txt", "record_short.txt"));
+   }
+   return sinks;
+}())
+, mScheduleLog("record_schedule.txt", "record_sites.txt")
+, mExecutedSchedule()
+, mStateFingerprints()
+, mOutcomeMutex()
+, mOutcomeCond()
+, mOutcome()
 , mThread([this] { return run(); })
 {
    DEBUG_SYNC("Starting Scheduler\n");
-   DEBUG_SYNC("schedule:\t" << mLocVars->schedule() << "\n");
+   if (mSettings.deferred_control() && mSettings.deferred_control()->signal)
+   {
+      std::signal(SIGUSR1, request_control);
+   }
+   if (mSettings.flight_recorder())
+   {
+      std::signal(SIGUSR2, request_flight_dump);
+   }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// @note A Scheduler of which the main thread registered is joined by it.
+
+Scheduler::~Scheduler()
+{
+   bool registered = false;
+   {
+      std::lock_guard<std::mutex> lock(mRegMutex);
+      mAbandoned = true;
+      registered = mMainThreadRegistered.load();
+   }
+   mRegCond.notify_all();
+   if (!registered)
+      join();
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -78,9 +223,21 @@ Thread::tid_t Scheduler::register_thread(const pthread_t& pid,
    {
       tid = get_fresh_tid(lock);
    }
+   // pid may belong to a finished thread that was never joined
+   mThreads.erase(pid);
    mThreads.insert(TidMap::value_type(pid, *tid));
-   mControllableThreads.emplace(std::piecewise_construct, std::forward_as_tuple(*tid),
-                                std::forward_as_tuple(*tid, pid, mThread.get_id()));
+   controllable_thread_ptr thread;
+   if (!mRetiredThreads.empty())
+   {
+      thread = std::move(mRetiredThreads.back());
+      mRetiredThreads.pop_back();
+      thread->reset(*tid, pid);
+   }
+   else
+   {
+      thread = std::make_unique<controllable_thread>(*tid, pid, mThread.get_id());
+   }
+   mControllableThreads.emplace(*tid, std::move(thread));
    mPool.register_thread(*tid);
 
    if (tid == 0)
@@ -97,6 +254,21 @@ program_model::Thread::tid_t Scheduler::post_spawn_instruction(pthread_t* pid,
                                                                const std::string& file_name,
                                                                unsigned int line_number)
 {
+   if (mPartialOrder)
+   {
+      // Spawns are replayed in their recorded order, so the threads get their recorded tids
+      replay_step(static_cast<int>(thread_management_operation::Spawn), line_number);
+      return get_fresh_tid(std::lock_guard<std::mutex>(mRegMutex));
+   }
+   if (mNativeRecorder)
+   {
+      const auto tid = registered_tid();
+      std::lock_guard<std::mutex> lock(mRegMutex);
+      const auto new_tid = get_fresh_tid(lock);
+      mNativeRecorder->record_spawn(tid, new_tid, line_number);
+      return new_tid;
+   }
+
    const auto new_tid = get_fresh_tid(std::lock_guard<std::mutex>(mRegMutex));
 
    post_task([new_tid, &file_name, line_number](const auto tid) {
@@ -115,14 +287,32 @@ program_model::Thread::tid_t Scheduler::post_spawn_instruction(pthread_t* pid,
 void Scheduler::post_join_instruction(pthread_t pid, const std::string& file_name,
                                       unsigned int line_number)
 {
+   if (mPartialOrder)
+   {
+      replay_step(static_cast<int>(thread_management_operation::Join), line_number);
+      forget_joined_thread(pid);
+      return;
+   }
+
    try
    {
       const auto tid_joined = find_tid(pid);
+      if (mNativeRecorder)
+      {
+         mNativeRecorder->record_join(registered_tid(), tid_joined, line_number);
+         forget_joined_thread(pid);
+         return;
+      }
+      if (mDeferred.load())
+      {
+         wait_until_joinable_or_triggered(tid_joined);
+      }
       post_task([tid_joined, &file_name, line_number](const auto tid) {
          return program_model::thread_management_instruction(tid, thread_management_operation::Join,
                                                              program_model::Thread(tid_joined),
                                                              {file_name, line_number});
       });
+      forget_joined_thread(pid);
    }
    catch (const unregistered_thread&)
    {
@@ -135,6 +325,17 @@ void Scheduler::post_join_instruction(pthread_t pid, const std::string& file_nam
 void Scheduler::post_memory_instruction(const int op, const Object& obj, bool is_atomic,
                                         const std::string& file_name, unsigned int line_number)
 {
+   if (mPartialOrder)
+   {
+      replay_step(op, line_number);
+      return;
+   }
+   if (mNativeRecorder)
+   {
+      record_native(op, obj.address(), line_number);
+      return;
+   }
+
    post_task([op, &obj, is_atomic, &file_name, line_number](const auto tid) {
       return program_model::memory_instruction(tid, static_cast<memory_operation>(op), obj,
                                                is_atomic, {file_name, line_number});
@@ -146,6 +347,17 @@ void Scheduler::post_memory_instruction(const int op, const Object& obj, bool is
 void Scheduler::post_lock_instruction(const int op, const Object& obj, const std::string& file_name,
                                       unsigned int line_number)
 {
+   if (mPartialOrder)
+   {
+      replay_step(op, line_number);
+      return;
+   }
+   if (mNativeRecorder)
+   {
+      record_native(op, obj.address(), line_number);
+      return;
+   }
+
    post_task([op, &obj, &file_name, line_number](const auto tid) {
       return program_model::lock_instruction(tid, static_cast<lock_operation>(op), obj,
                                              {file_name, line_number});
@@ -158,7 +370,12 @@ void Scheduler::enter_function(const std::string& function_name)
 {
    DEBUGF_SYNC(thread_str(pthread_self()), "enter_function", function_name, "\n");
 
-   const auto tid = wait_until_registered();
+   if (mDeferred.load() && mSettings.deferred_control()->function == function_name)
+   {
+      take_control();
+   }
+
+   const auto tid = registered_tid();
    get_controllable_thread(tid).enter_function(function_name);
 }
 
@@ -166,24 +383,43 @@ void Scheduler::enter_function(const std::string& function_name)
 
 void Scheduler::exit_function(const std::string& function_name)
 {
-   const auto tid = wait_until_registered();
+   const auto tid = registered_tid();
    try
    {
       get_controllable_thread(tid).exit_function(function_name);
    }
    catch (const controllable_thread::finished&)
    {
-      if (runs_controlled())
+      if (mPartialOrder)
+      {
+         mPartialOrder->finish(tid);
+      }
+      else if (mNativeRecorder)
+      {
+         mNativeRecorder->finish(tid);
+      }
+      else if (mDeferred.load())
+      {
+         // The thread is live in mPool, the Scheduler would wait for it to post
+         mPool.finish(tid);
+      }
+      else if (runs_controlled())
       {
          mPool.yield(tid);
 
          DEBUGF_SYNC(thread_str(tid), "finish", "", "\n");
          mPool.finish(tid);
       }
+      retire_thread(tid);
 
       // The main thread is responsible for joining the scheduler thread
       if (tid == 0)
       {
+         {
+            std::lock_guard<std::mutex> lock(mRegMutex);
+            mMainThreadFinished = true;
+         }
+         mRegCond.notify_all();
          join();
       }
    }
@@ -204,6 +440,66 @@ void Scheduler::join()
    }
 }
 
+//--------------------------------------------------------------------------------------------------
+
+bool Scheduler::posts_instructions() const
+{
+   return !mReleased.load() || mSettings.free_run_log();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Scheduler::take_control()
+{
+   bool deferred = true;
+   if (mDeferred.compare_exchange_strong(deferred, false))
+   {
+      DEBUGF_SYNC("Scheduler", "take_control", "", "after " << mNrUncontrolledSteps.load()
+                                                              << " uncontrolled steps\n");
+      // Taking mRegMutex orders the change before wait_until_triggered's check
+      std::lock_guard<std::mutex> lock(mRegMutex);
+      mRegCond.notify_all();
+   }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Scheduler::main_thread_registered() const
+{
+   return mMainThreadRegistered.load();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+iteration_result_t Scheduler::wait_until_closed()
+{
+   std::unique_lock<std::mutex> lock(mOutcomeMutex);
+   mOutcomeCond.wait(lock, [this] { return mOutcome.is_initialized(); });
+   return *mOutcome;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// @note Only the live threads are joined: a finished thread that was not joined may have been
+/// detached, and then its pid is no longer valid.
+
+void Scheduler::end_deadlocked_run()
+{
+   std::vector<pthread_t> blocked;
+   {
+      std::lock_guard<std::mutex> lock(mRegMutex);
+      for (const auto& thread : mThreads)
+      {
+         if (thread.second != 0 &&
+             mControllableThreads.find(thread.second) != mControllableThreads.end())
+            blocked.push_back(thread.first);
+      }
+   }
+   for (const auto& pid : blocked)
+      pthread_join(pid, nullptr);
+   join();
+}
+
 //--------------------------------------------------------------------------------------------------
 // SCHEDULER INTERNAL
 //--------------------------------------------------------------------------------------------------
@@ -219,12 +515,30 @@ Thread::tid_t Scheduler::get_fresh_tid(const std::lock_guard<std::mutex>& regist
 
 void Scheduler::post_task(const create_instruction_t& create_instruction)
 {
+   // A thread that exits after a deadlock may reach wrappers while it unwinds
+   if (mEndBlockedThreads.load())
+      return;
+
    if (!mMainThreadRegistered.load())
    {
       DEBUGF_SYNC("unregistered thread", "post_task", "", "\n");
       return;
    }
 
+   if (mReleased.load())
+   {
+      if (mSettings.free_run_log())
+         mFreeRunLog.append([this] { return wait_until_registered(); }, create_instruction);
+      return;
+   }
+
+   if (mDeferred.load())
+   {
+      check_trigger();
+      if (mDeferred.load())
+         return;
+   }
+
    const auto tid = wait_until_registered();
    auto instruction = create_instruction(tid);
    DEBUGF_SYNC(thread_str(tid), "post_task",
@@ -235,6 +549,8 @@ void Scheduler::post_task(const create_instruction_t& create_instruction)
       mPool.yield(tid);
       mPool.post(tid, instruction);
       get_controllable_thread(tid).post_task();
+      if (mEndBlockedThreads.load())
+         pthread_exit(nullptr);
    }
 }
 
@@ -260,6 +576,38 @@ program_model::Thread::tid_t Scheduler::wait_until_registered()
 
 //--------------------------------------------------------------------------------------------------
 
+/// @note A thread keeps its tid until it finishes, and a new thread gets new thread_local
+/// storage.
+
+program_model::Thread::tid_t Scheduler::registered_tid()
+{
+   thread_local boost::optional<Thread::tid_t> tid;
+   if (!tid)
+      tid = wait_until_registered();
+   return *tid;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Scheduler::replay_step(const int operation, const unsigned int line_number)
+{
+   if (!mMainThreadRegistered.load())
+      return;
+   mPartialOrder->next_step(registered_tid(), operation, line_number);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Scheduler::record_native(const int operation, const void* object,
+                              const unsigned int line_number)
+{
+   if (!mMainThreadRegistered.load())
+      return;
+   mNativeRecorder->record(registered_tid(), operation, object, line_number);
+}
+
+//--------------------------------------------------------------------------------------------------
+
 Thread::tid_t Scheduler::find_tid(const pthread_t& pid)
 {
    std::lock_guard<std::mutex> guard(mRegMutex);
@@ -277,7 +625,53 @@ controllable_thread& Scheduler::get_controllable_thread(const program_model::Thr
    std::lock_guard<std::mutex> lock(mRegMutex);
    auto it = mControllableThreads.find(tid);
    assert(it != mControllableThreads.end());
-   return it->second;
+   return *(it->second);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Scheduler::retire_thread(const program_model::Thread::tid_t tid)
+{
+   std::lock_guard<std::mutex> lock(mRegMutex);
+   auto it = mControllableThreads.find(tid);
+   assert(it != mControllableThreads.end());
+   mRetiredThreads.push_back(std::move(it->second));
+   mControllableThreads.erase(it);
+   if (mJoinedThreads.erase(tid) > 0)
+   {
+      const auto joined = boost::range::find_if(
+         mThreads, [tid](const auto& entry) { return entry.second == tid; });
+      if (joined != mThreads.end())
+         mThreads.erase(joined);
+   }
+   mRegCond.notify_all();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Scheduler::wait_until_joinable_or_triggered(const program_model::Thread::tid_t tid_joined)
+{
+   std::unique_lock<std::mutex> lock(mRegMutex);
+   mRegCond.wait(lock, [this, tid_joined] {
+      return !mDeferred.load() || mControllableThreads.find(tid_joined) == mControllableThreads.end();
+   });
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Scheduler::forget_joined_thread(const pthread_t& pid)
+{
+   std::lock_guard<std::mutex> lock(mRegMutex);
+   const auto it = boost::range::find_if(
+      mThreads, [&pid](const auto& entry) { return pthread_equal(entry.first, pid); });
+   if (it == mThreads.end())
+      return;
+   // The joined thread may still be running and using its pid, when the Scheduler no longer
+   // controls the execution or scheduled the joiner before the thread retired
+   if (mControllableThreads.find(it->second) == mControllableThreads.end())
+      mThreads.erase(it);
+   else
+      mJoinedThreads.insert(it->second);
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -285,7 +679,20 @@ controllable_thread& Scheduler::get_controllable_thread(const program_model::Thr
 bool Scheduler::runs_controlled()
 {
    const Execution::Status s = status();
-   return s != Execution::Status::BLOCKED && s != Execution::Status::ERROR;
+   return !mPartialOrder && !mNativeRecorder && !mReleased.load() && !mDeferred.load() &&
+          s != Execution::Status::BLOCKED && s != Execution::Status::ERROR;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Scheduler::check_trigger()
+{
+   const auto& trigger = *mSettings.deferred_control();
+   const auto step = mNrUncontrolledSteps.fetch_add(1);
+   if ((trigger.step && step >= *trigger.step) || control_requested.load())
+   {
+      take_control();
+   }
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -331,18 +738,57 @@ std::string Scheduler::thread_str(const pthread_t& pid)
 // on mPool, but this is not checked/enforced.
 void Scheduler::run()
 {
-   wait_until_main_thread_registered();
+   if (!wait_until_main_thread_registered())
+      return;
+   if (mPartialOrder)
+   {
+      wait_until_main_thread_finished();
+      if (mPartialOrder->diverged())
+         report_error("partial-order replay diverged from the recorded execution");
+      else
+         set_status(Execution::Status::DONE);
+      close();
+      return;
+   }
+   if (mNativeRecorder)
+   {
+      wait_until_main_thread_finished();
+      if (mNativeRecorder->write("record_schedule.txt", "record_partial_order.txt"))
+         set_status(Execution::Status::DONE);
+      else
+         report_error("native recording is not replayable: " +
+                      std::to_string(mNativeRecorder->nr_unordered()) +
+                      " accesses may have executed out of their recorded order");
+      close();
+      return;
+   }
+   if (!wait_until_triggered())
+   {
+      set_status(Execution::Status::DONE);
+      close();
+      return;
+   }
    mPool.wait_until_unfinished_threads_have_posted();
    DEBUG_SYNC(mPool << "\n");
 
-   Execution E(mPool.program_state());
+   if (!mSettings.lightweight_record())
+   {
+      mRecorder.start(mPool.program_state());
+      if (mSettings.record_states())
+         mStateFingerprints.push_back(mPool.state_fingerprint());
+   }
 
    while (status() == Execution::Status::RUNNING)
    {
       DEBUG_SYNC("---------- [round" << mLocVars->task_nr() << "]\n");
       if (mLocVars->task_nr() > 0)
       {
-         E.push_back(*mPool.current_task(), mPool.program_state());
+         record_step(mPool.current_task());
+      }
+      if (mSettings.free_run() && mLocVars->schedule().at_end())
+      {
+         release();
+         break;
       }
       try
       {
@@ -351,10 +797,7 @@ void Scheduler::run()
          {
             assert(selection.second >= 0);
             if (!schedule_thread(selection.second))
-            {
-               report_error("selection error");
                break;
-            }
          }
          else
          {
@@ -367,7 +810,8 @@ void Scheduler::run()
       catch (const deadlock_exception& deadlock)
       {
          write_to_stream(std::cout, deadlock.get());
-         E.push_back(mPool.tasks_cbegin()->second, mPool.program_state());
+         record_step(std::make_shared<const program_model::visible_instruction_t>(
+            mPool.tasks_cbegin()->second));
          set_status(Execution::Status::DEADLOCK);
          break;
       }
@@ -377,20 +821,61 @@ void Scheduler::run()
          throw;
       }
    }
-   close(E);
+   close();
 }
 
 //--------------------------------------------------------------------------------------------------
 
 // THREAD (PRIVATE)
 
-void Scheduler::wait_until_main_thread_registered()
+bool Scheduler::wait_until_main_thread_registered()
 {
    std::unique_lock<std::mutex> lock(mRegMutex);
    mRegCond.wait(lock, [this]() {
       DEBUGF_SYNC("Scheduler", "wait_until_main_thread_registered", "", "\n");
-      return mMainThreadRegistered.load();
+      return mMainThreadRegistered.load() || mAbandoned;
    });
+   return mMainThreadRegistered.load();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// @note Locks acquired before the trigger fired are not known to the Scheduler. A thread that is
+/// blocked on such a lock never posts its next task, so the trigger should fire where no thread
+/// waits for a lock held by another.
+
+bool Scheduler::wait_until_triggered()
+{
+   std::unique_lock<std::mutex> lock(mRegMutex);
+   mRegCond.wait(lock, [this] { return !mDeferred.load() || mMainThreadFinished; });
+   return !mDeferred.load();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// @note mReleased is set before the threads are granted execution right, so that they skip
+/// the Scheduler once they run. A thread that is about to wait for its turn finds its
+/// execution right already granted.
+
+void Scheduler::release()
+{
+   DEBUGF_SYNC("Scheduler", "release", "", "after " << mLocVars->task_nr() << " tasks\n");
+   mReleased.store(true);
+   {
+      std::lock_guard<std::mutex> lock(mRegMutex);
+      std::for_each(mControllableThreads.begin(), mControllableThreads.end(),
+                    [](auto& entry) { entry.second->grant_execution_right(); });
+   }
+   wait_until_main_thread_finished();
+   set_status(Execution::Status::DONE);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Scheduler::wait_until_main_thread_finished()
+{
+   std::unique_lock<std::mutex> lock(mRegMutex);
+   mRegCond.wait(lock, [this] { return mMainThreadFinished; });
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -403,18 +888,53 @@ void Scheduler::wait_until_main_thread_registered()
 
 bool Scheduler::schedule_thread(const Thread::tid_t& tid)
 {
-   if (mPool.status_protected(tid) == Thread::Status::ENABLED)
+   const auto thread_status = mPool.status_protected(tid);
+   if (thread_status != Thread::Status::ENABLED)
    {
-      const program_model::visible_instruction_t task = mPool.set_current(tid);
-      DEBUGF_SYNC(
-         "Scheduler", "schedule_thread", tid,
-         "next task = " << boost::apply_visitor(program_model::instruction_to_short_string(), task)
-                        << "\n");
-      get_controllable_thread(tid).grant_execution_right();
-      mLocVars->increase_task_nr();
-      return true;
+      std::stringstream what;
+      what << "selection error at step " << mLocVars->task_nr() + 1 << ": thread " << tid
+           << " is " << thread_status;
+      report_error(what.str());
+      return false;
+   }
+   if (const auto expected = mLocVars->fingerprints().next())
+   {
+      const auto& posted = mPool.task(tid)->second;
+      if (fingerprint(posted) != *expected)
+      {
+         std::stringstream what;
+         what << "replay diverged at step " << mLocVars->task_nr() + 1 << ": thread " << tid
+              << " posted " << posted << " (fingerprint " << std::hex << fingerprint(posted)
+              << "), the schedule expects fingerprint " << *expected;
+         mLocVars->set_diverged();
+         report_error(what.str());
+         return false;
+      }
+   }
+   const program_model::visible_instruction_t task = mPool.set_current(tid);
+   DEBUGF_SYNC(
+      "Scheduler", "schedule_thread", tid,
+      "next task = " << boost::apply_visitor(program_model::instruction_to_short_string(), task)
+                     << "\n");
+   get_controllable_thread(tid).grant_execution_right();
+   mLocVars->increase_task_nr();
+   return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Scheduler::record_step(const recorder::instruction_ptr& task)
+{
+   if (mChannel)
+      mExecutedSchedule.push_back(boost::apply_visitor(program_model::get_tid(), *task));
+   if (mSettings.lightweight_record())
+      mScheduleLog.push_back(*task);
+   else
+   {
+      mRecorder.push_step(task, mPool.program_state());
+      if (mSettings.record_states())
+         mStateFingerprints.push_back(mPool.state_fingerprint());
    }
-   return false;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -430,61 +950,85 @@ void Scheduler::report_error(const std::string& what)
 
 //--------------------------------------------------------------------------------------------------
 
-void Scheduler::close(Execution& E)
+void Scheduler::close()
 {
    DEBUGF_SYNC("Scheduler", "close", "", to_string(status()) << "\n");
    if (!runs_controlled())
    {
       std::lock_guard<std::mutex> lock(mRegMutex);
       std::for_each(mControllableThreads.begin(), mControllableThreads.end(),
-                    [](auto& entry) { entry.second.grant_execution_right(); });
+                    [](auto& entry) { entry.second->grant_execution_right(); });
+   }
+   if (mInProcess)
+   {
+      std::stringstream data_races;
+      for (const auto& data_race : mPool.data_races())
+      {
+         write_to_stream(data_races, data_race);
+      }
+      if (status() == Execution::Status::DEADLOCK)
+      {
+         // The blocked threads exit, see end_deadlocked_run
+         mEndBlockedThreads.store(true);
+         std::lock_guard<std::mutex> lock(mRegMutex);
+         std::for_each(mControllableThreads.begin(), mControllableThreads.end(),
+                       [](auto& entry) { entry.second->grant_execution_right(); });
+      }
+      {
+         std::lock_guard<std::mutex> lock(mOutcomeMutex);
+         mOutcome = iteration_result_t{status(), mScheduleLog.schedule(), data_races.str()};
+      }
+      mOutcomeCond.notify_all();
+      return;
    }
    // finish execution
-   try
+   if (mSettings.lightweight_record())
    {
-      E.last().set_post(mPool.program_state());
+      mRecorder.close(nullptr, status());
+      // Native recording writes its own schedule
+      if (!mNativeRecorder)
+         mScheduleLog.write(status());
    }
-   catch (const std::out_of_range& e)
+   else
    {
-      ERROR("Scheduler::close", e.what());
+      mRecorder.close(mPool.program_state(), status());
+      if (mSettings.record_states() && !mSettings.flight_recorder())
+      {
+         std::ofstream states("record_states.txt");
+         write_fingerprints(states, mStateFingerprints);
+      }
    }
-   E.set_status(status());
-   dump_execution(E);
+   if (mSettings.free_run_log())
+      mFreeRunLog.write();
    dump_data_races();
-
-   if (status() == Execution::Status::DEADLOCK)
-      std::terminate();
-}
-
-//--------------------------------------------------------------------------------------------------
-
-void Scheduler::dump_execution(const Execution& E) const
-{
-   if (!E.empty())
+   if (mChannel)
    {
-      std::ofstream record;
-      record.open("record.txt");
-      record << E;
-      record.close();
-
-      std::ofstream record_short;
-      record_short.open("record_short.txt");
-      record_short << to_short_string(E);
-      record_short.close();
+      std::stringstream schedule;
+      schedule << mExecutedSchedule;
+      mChannel->write(shared_channel::section::executed_schedule, schedule.str());
+      // Last, as it tells the driver that the outcome is complete
+      mChannel->set_status(status());
    }
+
+   // The threads would run on natively, possibly until the timeout
+   if (status() == Execution::Status::DEADLOCK || mLocVars->diverged())
+      std::terminate();
 }
 
 //--------------------------------------------------------------------------------------------------
 
 void Scheduler::dump_data_races() const
 {
-   std::ofstream ofs;
-   ofs.open("data_races.txt", std::ofstream::app);
+   std::stringstream races;
    for (const auto& data_race : mPool.data_races())
    {
-      write_to_stream(ofs, data_race);
+      write_to_stream(races, data_race);
    }
-   ofs << "\n>>>>>\n\n";
+   if (mChannel && mChannel->write(shared_channel::section::data_races, races.str()))
+      return;
+   std::ofstream ofs;
+   ofs.open("data_races.txt", std::ofstream::app);
+   ofs << races.str() << "\n>>>>>\n\n";
    ofs.close();
 }
 
@@ -492,26 +1036,45 @@ void Scheduler::dump_data_races() const
 
 // Class Scheduler::LocalVars
 
-Scheduler::LocalVars::LocalVars()
-: mSchedule()
+Scheduler::LocalVars::LocalVars(const schedule_t& schedule)
+: mSchedule([&schedule] {
+   auto input = std::make_unique<std::stringstream>();
+   *input << schedule;
+   return schedule_reader(std::move(input));
+}())
+, mFingerprints()
 , mTaskNr(0)
+, mDiverged(false)
 {
-   if (!utils::io::read_from_file("schedules/schedule.txt", mSchedule))
-   {
-      ERROR("Scheduler::LocalVars()", "reading schedules/schedule.txt");
-      mSchedule = {};
-   }
 }
 
 //--------------------------------------------------------------------------------------------------
 
-const schedule_t& Scheduler::LocalVars::schedule() const
+Scheduler::LocalVars::LocalVars(const shared_channel* channel)
+: mSchedule(open_input(channel, shared_channel::section::schedule, "schedules/schedule.txt"))
+, mFingerprints(
+     open_input(channel, shared_channel::section::fingerprints, "schedules/fingerprints.txt"))
+, mTaskNr(0)
+, mDiverged(false)
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+
+schedule_reader& Scheduler::LocalVars::schedule()
 {
    return mSchedule;
 }
 
 //--------------------------------------------------------------------------------------------------
 
+fingerprint_reader& Scheduler::LocalVars::fingerprints()
+{
+   return mFingerprints;
+}
+
+//--------------------------------------------------------------------------------------------------
+
 int Scheduler::LocalVars::task_nr() const
 {
    return mTaskNr;
@@ -526,6 +1089,92 @@ void Scheduler::LocalVars::increase_task_nr()
 
 //--------------------------------------------------------------------------------------------------
 
+bool Scheduler::LocalVars::diverged() const
+{
+   return mDiverged;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Scheduler::LocalVars::set_diverged()
+{
+   mDiverged = true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+// Runs within the process
+
+namespace {
+/// @brief Serializes the runs, which share the_scheduler.
+std::mutex in_process_mutex;
+bool in_process_mode = false;
+
+const char* const in_process_function = "record_replay_in_process";
+} // end namespace
+
+//--------------------------------------------------------------------------------------------------
+
+iteration_result_t run_in_process(const std::function<void()>& body,
+                                  const SchedulerSettings& settings, const schedule_t& schedule)
+{
+   std::lock_guard<std::mutex> lock(in_process_mutex);
+   if (!in_process_mode)
+   {
+      if (the_scheduler.load()->main_thread_registered())
+         throw std::logic_error("run_in_process: the program runs under the Scheduler");
+      in_process_mode = true;
+   }
+   the_scheduler_owner.reset();
+   the_scheduler_owner = std::make_unique<Scheduler>(settings, schedule);
+   the_scheduler.store(the_scheduler_owner.get());
+
+   std::exception_ptr exception;
+   std::thread main_thread([&body, &exception] {
+      the_scheduler.load()->register_main_thread();
+      the_scheduler.load()->enter_function(in_process_function);
+      try
+      {
+         body();
+      }
+      catch (const abi::__forced_unwind&)
+      {
+         // The thread exits after a deadlock
+         throw;
+      }
+      catch (...)
+      {
+         exception = std::current_exception();
+      }
+      the_scheduler.load()->exit_function(in_process_function);
+   });
+
+   const auto result = the_scheduler.load()->wait_until_closed();
+   if (result.status == Execution::Status::DEADLOCK)
+      the_scheduler.load()->end_deadlocked_run();
+   main_thread.join();
+   if (exception)
+      std::rethrow_exception(exception);
+   return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+boost::optional<iteration_result_t> explore_in_process(const std::function<void()>& body,
+                                                       const SchedulerSettings& settings,
+                                                       const unsigned int nr_iterations)
+{
+   for (unsigned int i = 0; i < nr_iterations; ++i)
+   {
+      auto result = run_in_process(body, settings);
+      if (result.status != Execution::Status::DONE)
+         return result;
+   }
+   return boost::none;
+}
+
+//--------------------------------------------------------------------------------------------------
+
 } // end namespace scheduler
 
 //--------------------------------------------------------------------------------------------------
@@ -533,21 +1182,21 @@ void Scheduler::LocalVars::increase_task_nr()
 
 void wrapper_register_main_thread()
 {
-   the_scheduler.register_main_thread();
+   the_scheduler.load()->register_main_thread();
 }
 
 //--------------------------------------------------------------------------------------------------
 
 void wrapper_register_thread(const pthread_t* const pid, const int tid)
 {
-   the_scheduler.register_thread(*pid, tid);
+   the_scheduler.load()->register_thread(*pid, tid);
 }
 
 //--------------------------------------------------------------------------------------------------
 
 int wrapper_post_spawn_instruction(pthread_t* pid, const char* file_name, unsigned int line_number)
 {
-   return the_scheduler.post_spawn_instruction(pid, file_name, line_number);
+   return the_scheduler.load()->post_spawn_instruction(pid, file_name, line_number);
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -555,7 +1204,7 @@ int wrapper_post_spawn_instruction(pthread_t* pid, const char* file_name, unsign
 void wrapper_post_pthread_join_instruction(pthread_t pid, const char* file_name,
                                            unsigned int line_number)
 {
-   return the_scheduler.post_join_instruction(pid, file_name, line_number);
+   return the_scheduler.load()->post_join_instruction(pid, file_name, line_number);
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -563,7 +1212,7 @@ void wrapper_post_pthread_join_instruction(pthread_t pid, const char* file_name,
 void wrapper_post_stdthread_join_instruction(std::thread* thr, const char* file_name,
                                              unsigned int line_number)
 {
-   return the_scheduler.post_join_instruction(thr->native_handle(), file_name, line_number);
+   return the_scheduler.load()->post_join_instruction(thr->native_handle(), file_name, line_number);
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -571,8 +1220,10 @@ void wrapper_post_stdthread_join_instruction(std::thread* thr, const char* file_
 void wrapper_post_memory_instruction(int operation, void* operand, bool is_atomic,
                                      const char* file_name, unsigned int line_number)
 {
-   the_scheduler.post_memory_instruction(operation, program_model::Object(operand), is_atomic,
-                                         file_name, line_number);
+   if (!the_scheduler.load()->posts_instructions())
+      return;
+   the_scheduler.load()->post_memory_instruction(operation, program_model::Object(operand), is_atomic,
+                                          file_name, line_number);
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -580,22 +1231,31 @@ void wrapper_post_memory_instruction(int operation, void* operand, bool is_atomi
 void wrapper_post_lock_instruction(int operation, void* operand, const char* file_name,
                                    unsigned int line_number)
 {
-   the_scheduler.post_lock_instruction(operation, program_model::Object(operand), file_name,
-                                       line_number);
+   if (!the_scheduler.load()->posts_instructions())
+      return;
+   the_scheduler.load()->post_lock_instruction(operation, program_model::Object(operand), file_name,
+                                        line_number);
 }
 
 //--------------------------------------------------------------------------------------------------
 
 void wrapper_enter_function(const char* function_name)
 {
-   the_scheduler.enter_function(function_name);
+   the_scheduler.load()->enter_function(function_name);
 }
 
 //--------------------------------------------------------------------------------------------------
 
 void wrapper_exit_function(const char* function_name)
 {
-   the_scheduler.exit_function(function_name);
+   the_scheduler.load()->exit_function(function_name);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void record_replay_take_control()
+{
+   the_scheduler.load()->take_control();
 }
 
 //--------------------------------------------------------------------------------------------------
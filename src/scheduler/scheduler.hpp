@@ -1,16 +1,26 @@
 #pragma once
 
 #include "controllable_thread.hpp"
+#include "fork_server.hpp"
+#include "in_process.hpp"
+#include "native_recorder.hpp"
+#include "partial_order.hpp"
+#include "recorder.hpp"
 #include "schedule.hpp"
 #include "scheduler_settings.hpp"
 #include "selector_register.hpp"
+#include "shared_channel.hpp"
 
 #include <execution.hpp>
 
 #include <boost/optional.hpp>
 
+#include <atomic>
+
+#include <memory>
 #include <thread>
 #include <unordered_map>
+#include <unordered_set>
 
 //--------------------------------------------------------------------------------------------------
 /// @file scheduler.hpp
@@ -32,7 +42,16 @@ class Scheduler
 public:
    /// @{
    /// Lifetime
+
+   /// @brief Constructs the Scheduler of a program, which reads its settings and schedule from
+   /// the shared_channel of the driver or from the files in schedules/.
    Scheduler();
+
+   /// @brief Constructs the Scheduler of a run within the process, see in_process.hpp.
+   Scheduler(const SchedulerSettings& settings, const schedule_t& schedule);
+
+   /// @brief Stops waiting for the main thread if it never registered.
+   ~Scheduler();
    /// @}
 
    // WRAPPERS
@@ -72,25 +91,85 @@ public:
 
    void join();
 
+   /// @brief Whether the wrappers have to post visible instructions.
+   /// @details False once the Scheduler released control in free-run mode, unless the
+   /// free-run log is enabled.
+
+   bool posts_instructions() const;
+
+   /// @brief Fires the trigger of deferred control.
+   /// @details The threads are stopped at their next visible instruction, from where on the
+   /// Scheduler controls and records the execution. Has no effect if the Scheduler already
+   /// controls the program.
+
+   void take_control();
+
+   /// @brief Whether a thread registered as the main thread.
+
+   bool main_thread_registered() const;
+
+   /// @brief Waits until a Scheduler of a run within the process closed.
+   /// @returns The outcome of the run.
+
+   iteration_result_t wait_until_closed();
+
+   /// @brief Joins the threads that a run within the process left blocked in a DEADLOCK, which
+   /// end at the instruction they block on, and the Scheduler thread.
+   /// @note The main thread of the run is left to the caller.
+
+   void end_deadlocked_run();
+
 private:
    // Forward declarations
    class LocalVars;
 
    // Type definitions
    using TidMap = std::unordered_map<pthread_t, const Thread::tid_t>;
-   using Threads = std::unordered_map<program_model::Thread::tid_t, controllable_thread>;
+   using controllable_thread_ptr = std::unique_ptr<controllable_thread>;
+   using Threads = std::unordered_map<program_model::Thread::tid_t, controllable_thread_ptr>;
+
+   /// @brief The settings and the schedule of a run within the process.
+   struct in_process_input_t
+   {
+      const SchedulerSettings& settings;
+      const schedule_t& schedule;
+   };
+
+   /// @brief The channel of the driver, if it passes the input and the outcome through
+   /// shared memory.
+   std::unique_ptr<shared_channel> mChannel;
+
+   /// @brief Set for a run within the process, which reports its outcome in mOutcome instead
+   /// of writing records.
+   bool mInProcess;
 
    std::unique_ptr<LocalVars> mLocVars;
    TaskPool mPool;
 
-   /// @brief Protects mThreads, mNrRegistered and mRegCond.
+   /// @brief Protects mThreads, mControllableThreads, mRetiredThreads, mJoinedThreads,
+   /// mNrRegistered and mRegCond.
    // #todo Look at possibility of using shared_mutex
 
    std::mutex mRegMutex;
+
+   /// @brief Maps the pids of live and finished-but-not-joined threads to their tid.
    TidMap mThreads;
+
+   /// @brief The controllable_threads of the live threads.
    Threads mControllableThreads;
+
+   /// @brief controllable_threads of finished threads, kept for reuse by new threads.
+   std::vector<controllable_thread_ptr> mRetiredThreads;
+
+   /// @brief The live threads that another thread joins, whose pids retire_thread removes.
+   std::unordered_set<Thread::tid_t> mJoinedThreads;
+
    int mNrRegistered;
    std::atomic<bool> mMainThreadRegistered;
+   /// @brief Set when the Scheduler is destroyed before the main thread registered.
+   bool mAbandoned;
+   /// @brief Set when the main thread finished, before it joins mThread.
+   bool mMainThreadFinished;
    std::condition_variable mRegCond;
 
    Execution::Status mStatus;
@@ -99,8 +178,54 @@ private:
    SchedulerSettings mSettings;
    SelectorUniquePtr mSelector;
 
+   /// @brief Set once the Scheduler released control over the threads in free-run mode.
+   std::atomic<bool> mReleased;
+
+   /// @brief Set when a run within the process ended in a DEADLOCK: the blocked threads exit
+   /// once granted execution right, instead of executing their instruction.
+   std::atomic<bool> mEndBlockedThreads;
+
+   /// @brief Set while the threads run uncontrolled until the trigger of deferred control
+   /// fires.
+   std::atomic<bool> mDeferred;
+
+   /// @brief The number of visible instructions that ran before the trigger fired.
+   std::atomic<unsigned int> mNrUncontrolledSteps;
+
+   /// @brief The visible instructions executed after the Scheduler released control.
+   unordered_log mFreeRunLog;
+
+   /// @brief Set in partial-order replay mode, in which the threads synchronize among
+   /// themselves and mThread only waits for the program to finish.
+   std::unique_ptr<partial_order_replay> mPartialOrder;
+
+   /// @brief Set in native recording mode, in which the threads run freely and only log the
+   /// order of their visible instructions.
+   std::unique_ptr<native_recorder> mNativeRecorder;
+
+   /// @brief Builds and writes the Execution, fed by mThread.
+   recorder mRecorder;
+
+   /// @brief Records the schedule instead of mRecorder in lightweight record mode.
+   schedule_log mScheduleLog;
+
+   /// @brief The schedule of the recorded steps, reported through mChannel.
+   schedule_t mExecutedSchedule;
+
+   /// @brief The fingerprints of the recorded States (see TaskPool::state_fingerprint),
+   /// written to record_states.txt along with record.txt if the settings ask for them.
+   std::vector<fingerprint_t> mStateFingerprints;
+
+   /// @brief Protect and signal mOutcome.
+   std::mutex mOutcomeMutex;
+   std::condition_variable mOutcomeCond;
+   boost::optional<iteration_result_t> mOutcome;
+
    std::thread mThread;
 
+   Scheduler(std::unique_ptr<shared_channel> channel,
+             const boost::optional<in_process_input_t>& input);
+
    // SCHEDULER INTERNAL
 
    Thread::tid_t get_fresh_tid(const std::lock_guard<std::mutex>& registration_lock);
@@ -112,12 +237,47 @@ private:
 
    program_model::Thread::tid_t wait_until_registered();
 
+   /// @brief wait_until_registered, remembered by the calling thread.
+
+   program_model::Thread::tid_t registered_tid();
+
+   /// @brief Takes the next step of the calling thread in partial-order replay mode.
+
+   void replay_step(const int operation, const unsigned int line_number);
+
+   /// @brief Records a memory or lock instruction of the calling thread in native recording
+   /// mode.
+
+   void record_native(const int operation, const void* object, const unsigned int line_number);
+
    Thread::tid_t find_tid(const pthread_t& pid);
 
    controllable_thread& get_controllable_thread(const program_model::Thread::tid_t tid);
 
+   /// @brief Moves the controllable_thread of the finished thread tid to mRetiredThreads, and
+   /// forgets its pid if it is joined already (see forget_joined_thread).
+
+   void retire_thread(const program_model::Thread::tid_t tid);
+
+   /// @brief Under deferred control, keeps a joining thread from blocking in pthread_join until
+   /// either the thread tid_joined finished or the trigger fired, in which case the join is
+   /// posted to the Scheduler. A thread blocked in pthread_join would never post a task.
+
+   void wait_until_joinable_or_triggered(const program_model::Thread::tid_t tid_joined);
+
+   /// @brief Removes the pid of a finished thread that is being joined from mThreads, as the
+   /// pid may be reused by the system once the join returns. A joined thread that did not
+   /// retire yet, as its joiner ran first, is left to retire_thread.
+
+   void forget_joined_thread(const pthread_t& pid);
+
    bool runs_controlled();
 
+   /// @brief Fires the trigger of deferred control if one of its conditions holds on a
+   /// visible instruction.
+
+   void check_trigger();
+
    Execution::Status status();
 
    void set_status(const Execution::Status&);
@@ -132,19 +292,39 @@ private:
    void run();
 
    /// @brief Waits until mNrRegistered == LV.nr_threads.
+   /// @returns false if the Scheduler was abandoned before.
+
+   bool wait_until_main_thread_registered();
+
+   /// @brief Waits until the trigger of deferred control fired.
+   /// @returns false if the main thread finished before.
+
+   bool wait_until_triggered();
 
-   void wait_until_main_thread_registered();
+   void wait_until_main_thread_finished();
+
+   /// @brief Grants all threads execution right for the rest of the execution and waits
+   /// until the main thread finished.
+
+   void release();
 
    /// @brief Schedule the next task of given tid.
-   /// @returns true iff scheduling the thread succeeded (i.e. tid is ENABLED.
+   /// @details If schedules/fingerprints.txt gives the fingerprint of the step, the task has
+   /// to match it.
+   /// @returns true iff scheduling the thread succeeded (i.e. tid is ENABLED and its task
+   /// matches the fingerprint), otherwise reports the error.
 
    bool schedule_thread(const Thread::tid_t& tid);
 
+   /// @brief Records the step that executed task, with the post-State and its fingerprint
+   /// unless in lightweight record mode.
+
+   void record_step(const recorder::instruction_ptr& task);
+
    void report_error(const std::string& what);
 
-   void close(Execution& E);
+   void close();
 
-   void dump_execution(const Execution& E) const;
    void dump_data_races() const;
 
 }; // end class Scheduler
@@ -157,12 +337,23 @@ class Scheduler::LocalVars
 {
 public:
    /// @brief Constructor.
+   /// @param channel The channel to read the schedule and the fingerprints from, instead of
+   /// their files, or nullptr.
 
-   LocalVars();
+   explicit LocalVars(const shared_channel* channel);
 
-   /// @brief Getter.
+   /// @brief Constructor for a run within the process, which has no fingerprints.
+
+   explicit LocalVars(const schedule_t& schedule);
+
+   /// @brief The remaining steps of the schedule, read lazily from schedules/schedule.txt.
+
+   schedule_reader& schedule();
+
+   /// @brief The fingerprints of the remaining steps of the schedule, read lazily from
+   /// schedules/fingerprints.txt.
 
-   const schedule_t& schedule() const;
+   fingerprint_reader& fingerprints();
 
    /// @brief Getter.
 
@@ -170,15 +361,25 @@ public:
 
    void increase_task_nr();
 
+   /// @brief Whether the program diverged from the replayed schedule.
+
+   bool diverged() const;
+
+   void set_diverged();
+
 private:
    /// @brief The schedule under which the scheduler is driving the program.
 
-   schedule_t mSchedule;
+   schedule_reader mSchedule;
+
+   fingerprint_reader mFingerprints;
 
    /// @brief Counter of already scheduled tasks.
 
    int mTaskNr;
 
+   bool mDiverged;
+
 }; // end class Scheduler::LocalVars
 } // end namespace scheduler
 
@@ -186,7 +387,13 @@ private:
 
 // Wrapper functions
 
-static scheduler::Scheduler the_scheduler;
+/// @brief Initialized before the_scheduler, so that a fork server forks before the Scheduler
+/// starts its threads.
+extern const bool the_fork_server_child;
+
+/// @brief The Scheduler of the wrapper functions.
+/// @details Replaced by every run within the process, see in_process.hpp.
+extern std::atomic<scheduler::Scheduler*> the_scheduler;
 
 extern "C" {
 
@@ -212,4 +419,8 @@ void wrapper_enter_function(const char* function_name);
 
 void wrapper_exit_function(const char* function_name);
 
+/// @brief Lets a program running under deferred control hand control to the Scheduler.
+
+void record_replay_take_control();
+
 } // end extern "C"
@@ -7,13 +7,28 @@
 // STL
 #include <fstream>
 #include <iostream>
+#include <stdexcept>
 
 namespace scheduler
 {
    //-------------------------------------------------------------------------------------
    
+   const SchedulerSettings::pct_t SchedulerSettings::default_pct{3, 1000};
+   
+   //-------------------------------------------------------------------------------------
+   
    SchedulerSettings::SchedulerSettings(const std::string& strategy_tag)
-   : mStrategyTag(strategy_tag) { }
+   : mStrategyTag(strategy_tag)
+   , mFreeRun(false)
+   , mFreeRunLog(false)
+   , mDeferredControl(boost::none)
+   , mPartialOrder(false)
+   , mNativeRecord(false)
+   , mLightweightRecord(false)
+   , mRecordStates(false)
+   , mFlightRecorder(boost::none)
+   , mPct(default_pct)
+   , mSeed(boost::none) { }
    
    //-------------------------------------------------------------------------------------
    
@@ -24,16 +39,294 @@ namespace scheduler
    
    //-------------------------------------------------------------------------------------
    
+   bool SchedulerSettings::free_run() const
+   {
+      return mFreeRun || mFreeRunLog;
+   }
+   
+   //-------------------------------------------------------------------------------------
+   
+   bool SchedulerSettings::free_run_log() const
+   {
+      return mFreeRunLog;
+   }
+   
+   //-------------------------------------------------------------------------------------
+   
+   const boost::optional<SchedulerSettings::control_trigger_t>&
+   SchedulerSettings::deferred_control() const
+   {
+      return mDeferredControl;
+   }
+   
+   //-------------------------------------------------------------------------------------
+   
+   bool SchedulerSettings::partial_order() const
+   {
+      return mPartialOrder;
+   }
+   
+   //-------------------------------------------------------------------------------------
+   
+   bool SchedulerSettings::native_record() const
+   {
+      return mNativeRecord;
+   }
+   
+   //-------------------------------------------------------------------------------------
+   
+   bool SchedulerSettings::lightweight_record() const
+   {
+      return mLightweightRecord;
+   }
+   
+   //-------------------------------------------------------------------------------------
+   
+   bool SchedulerSettings::record_states() const
+   {
+      return mRecordStates;
+   }
+   
+   //-------------------------------------------------------------------------------------
+   
+   const boost::optional<SchedulerSettings::flight_recorder_t>&
+   SchedulerSettings::flight_recorder() const
+   {
+      return mFlightRecorder;
+   }
+   
+   //-------------------------------------------------------------------------------------
+   
+   const SchedulerSettings::pct_t& SchedulerSettings::pct() const
+   {
+      return mPct;
+   }
+   
+   //-------------------------------------------------------------------------------------
+   
+   const boost::optional<unsigned int>& SchedulerSettings::seed() const
+   {
+      return mSeed;
+   }
+   
+   //-------------------------------------------------------------------------------------
+   
+   SchedulerSettings& SchedulerSettings::set_free_run(const bool free_run)
+   {
+      mFreeRun = free_run;
+      return *this;
+   }
+   
+   //-------------------------------------------------------------------------------------
+   
+   SchedulerSettings& SchedulerSettings::set_free_run_log(const bool free_run_log)
+   {
+      mFreeRunLog = free_run_log;
+      return *this;
+   }
+   
+   //-------------------------------------------------------------------------------------
+   
+   SchedulerSettings&
+   SchedulerSettings::set_deferred_control(const boost::optional<control_trigger_t>& trigger)
+   {
+      mDeferredControl = trigger;
+      return *this;
+   }
+   
+   //-------------------------------------------------------------------------------------
+   
+   SchedulerSettings& SchedulerSettings::set_partial_order(const bool partial_order)
+   {
+      mPartialOrder = partial_order;
+      return *this;
+   }
+   
+   //-------------------------------------------------------------------------------------
+   
+   SchedulerSettings& SchedulerSettings::set_native_record(const bool native_record)
+   {
+      mNativeRecord = native_record;
+      return *this;
+   }
+   
+   //-------------------------------------------------------------------------------------
+   
+   SchedulerSettings& SchedulerSettings::set_lightweight_record(const bool lightweight_record)
+   {
+      mLightweightRecord = lightweight_record;
+      return *this;
+   }
+   
+   //-------------------------------------------------------------------------------------
+   
+   SchedulerSettings& SchedulerSettings::set_record_states(const bool record_states)
+   {
+      mRecordStates = record_states;
+      return *this;
+   }
+   
+   //-------------------------------------------------------------------------------------
+   
+   SchedulerSettings&
+   SchedulerSettings::set_flight_recorder(const boost::optional<flight_recorder_t>& bounds)
+   {
+      mFlightRecorder = bounds;
+      return *this;
+   }
+   
+   //-------------------------------------------------------------------------------------
+   
+   SchedulerSettings& SchedulerSettings::set_pct(const pct_t& pct)
+   {
+      mPct = pct;
+      return *this;
+   }
+   
+   //-------------------------------------------------------------------------------------
+   
+   SchedulerSettings& SchedulerSettings::set_seed(const boost::optional<unsigned int>& seed)
+   {
+      mSeed = seed;
+      return *this;
+   }
+   
+   //-------------------------------------------------------------------------------------
+   
    SchedulerSettings SchedulerSettings::read_from_file(const std::string& filename)
    {
-      std::string strategy_tag = "Random";
       std::ifstream ifs(filename);
-      if (!(ifs >> strategy_tag))
+      return read(ifs, filename);
+   }
+   
+   //-------------------------------------------------------------------------------------
+   
+   SchedulerSettings SchedulerSettings::read(std::istream& is, const std::string& source)
+   {
+      std::string strategy_tag = "Random";
+      bool free_run = false;
+      bool free_run_log = false;
+      boost::optional<control_trigger_t> deferred_control;
+      bool partial_order = false;
+      bool native_record = false;
+      bool lightweight_record = false;
+      bool record_states = false;
+      boost::optional<unsigned int> flight_recorder_capacity;
+      boost::optional<unsigned int> keyframe_interval;
+      pct_t pct = default_pct;
+      boost::optional<unsigned int> seed;
+      const auto read_number = [&source](const std::string& option, const std::size_t pos) {
+         try
+         {
+            return static_cast<unsigned int>(std::stoul(option.substr(pos)));
+         }
+         catch (const std::logic_error&)
+         {
+            ERROR("SchedulerSettings", "invalid option " << option << " in " << source);
+            return 0u;
+         }
+      };
+      const auto trigger = [&deferred_control]() -> control_trigger_t& {
+         if (!deferred_control)
+         {
+            deferred_control = control_trigger_t();
+         }
+         return *deferred_control;
+      };
+      if (!(is >> strategy_tag))
       {
-         ERROR("SchedulerSettings", "reading settings from " << filename);
+         ERROR("SchedulerSettings", "reading settings from " << source);
       }
-      ifs.close();
-      return SchedulerSettings(strategy_tag);
+      std::string option;
+      while (is >> option)
+      {
+         if (option == "free_run")
+         {
+            free_run = true;
+         }
+         else if (option == "free_run_log")
+         {
+            free_run_log = true;
+         }
+         else if (option == "deferred_control")
+         {
+            trigger();
+         }
+         else if (option.compare(0, 13, "trigger_step=") == 0)
+         {
+            trigger().step = read_number(option, 13);
+         }
+         else if (option.compare(0, 17, "trigger_function=") == 0)
+         {
+            trigger().function = option.substr(17);
+         }
+         else if (option == "trigger_signal")
+         {
+            trigger().signal = true;
+         }
+         else if (option == "partial_order")
+         {
+            partial_order = true;
+         }
+         else if (option == "native_record")
+         {
+            native_record = true;
+         }
+         else if (option == "lightweight_record")
+         {
+            lightweight_record = true;
+         }
+         else if (option == "record_states")
+         {
+            record_states = true;
+         }
+         else if (option.compare(0, 16, "flight_recorder=") == 0)
+         {
+            flight_recorder_capacity = read_number(option, 16);
+         }
+         else if (option.compare(0, 18, "keyframe_interval=") == 0)
+         {
+            keyframe_interval = read_number(option, 18);
+         }
+         else if (option.compare(0, 10, "pct_depth=") == 0)
+         {
+            pct.depth = read_number(option, 10);
+         }
+         else if (option.compare(0, 10, "pct_steps=") == 0)
+         {
+            pct.steps = read_number(option, 10);
+         }
+         else if (option.compare(0, 5, "seed=") == 0)
+         {
+            seed = read_number(option, 5);
+         }
+         else
+         {
+            ERROR("SchedulerSettings", "unknown option " << option << " in " << source);
+         }
+      }
+      boost::optional<flight_recorder_t> flight_recorder;
+      if (flight_recorder_capacity)
+      {
+         flight_recorder = flight_recorder_t{
+            *flight_recorder_capacity, keyframe_interval.value_or(*flight_recorder_capacity)};
+      }
+      else if (keyframe_interval)
+      {
+         ERROR("SchedulerSettings", "keyframe_interval without flight_recorder in " << source);
+      }
+      SchedulerSettings settings(strategy_tag);
+      settings.set_free_run(free_run)
+         .set_free_run_log(free_run_log)
+         .set_deferred_control(deferred_control)
+         .set_partial_order(partial_order)
+         .set_native_record(native_record)
+         .set_lightweight_record(lightweight_record)
+         .set_record_states(record_states)
+         .set_flight_recorder(flight_recorder)
+         .set_pct(pct)
+         .set_seed(seed);
+      return settings;
    }
    
    //-------------------------------------------------------------------------------------
@@ -41,6 +334,59 @@ namespace scheduler
    std::ostream& operator<<(std::ostream& os, const SchedulerSettings& settings)
    {
       os << settings.strategy_tag();
+      if (settings.free_run_log())
+      {
+         os << " free_run_log";
+      }
+      else if (settings.free_run())
+      {
+         os << " free_run";
+      }
+      if (const auto& trigger = settings.deferred_control())
+      {
+         os << " deferred_control";
+         if (trigger->step)
+         {
+            os << " trigger_step=" << *trigger->step;
+         }
+         if (trigger->function)
+         {
+            os << " trigger_function=" << *trigger->function;
+         }
+         if (trigger->signal)
+         {
+            os << " trigger_signal";
+         }
+      }
+      if (settings.partial_order())
+      {
+         os << " partial_order";
+      }
+      if (settings.native_record())
+      {
+         os << " native_record";
+      }
+      if (settings.lightweight_record())
+      {
+         os << " lightweight_record";
+      }
+      if (settings.record_states())
+      {
+         os << " record_states";
+      }
+      if (const auto& flight_recorder = settings.flight_recorder())
+      {
+         os << " flight_recorder=" << flight_recorder->capacity
+            << " keyframe_interval=" << flight_recorder->keyframe_interval;
+      }
+      if (settings.strategy_tag() == "PCT")
+      {
+         os << " pct_depth=" << settings.pct().depth << " pct_steps=" << settings.pct().steps;
+      }
+      if (const auto& seed = settings.seed())
+      {
+         os << " seed=" << *seed;
+      }
       return os;
    }
    
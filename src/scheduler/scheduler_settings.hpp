@@ -1,6 +1,10 @@
 #pragma once
 
+// BOOST
+#include <boost/optional.hpp>
+
 // STL
+#include <iosfwd>
 #include <string>
 
 //--------------------------------------------------------------------------------------90
@@ -18,6 +22,56 @@ namespace scheduler
    {
    public:
       
+      //----------------------------------------------------------------------------------
+      
+      /// @brief The conditions on which the Scheduler takes control over a program that
+      /// started running uncontrolled. Whichever fires first triggers. The program can
+      /// always trigger by calling record_replay_take_control.
+      
+      struct control_trigger_t
+      {
+         /// @brief Fires after this number of visible instructions ran uncontrolled.
+         boost::optional<unsigned int> step;
+         
+         /// @brief Fires when a thread enters the function with this name.
+         boost::optional<std::string> function;
+         
+         /// @brief Fires on the next visible instruction after a SIGUSR1.
+         bool signal = false;
+      };
+      
+      //----------------------------------------------------------------------------------
+      
+      /// @brief The bounds of the flight recorder, which keeps only the end of the
+      /// recorded Execution.
+      
+      struct flight_recorder_t
+      {
+         /// @brief The number of Transitions kept.
+         unsigned int capacity;
+         
+         /// @brief The number of steps between two keyframes.
+         unsigned int keyframe_interval;
+      };
+      
+      //----------------------------------------------------------------------------------
+      
+      /// @brief The parameters of the PCT strategy (see pct.hpp).
+      
+      struct pct_t
+      {
+         /// @brief The depth of the bugs it targets: it changes priorities depth - 1 times.
+         unsigned int depth;
+         
+         /// @brief The estimated number of steps of a run, over which it spreads the
+         /// priority changes.
+         unsigned int steps;
+      };
+      
+      /// @brief The PCT parameters unless the settings give others.
+      
+      static const pct_t default_pct;
+      
       //----------------------------------------------------------------------------------
         
       /// @brief Constructor.
@@ -30,13 +84,116 @@ namespace scheduler
       
       const std::string& strategy_tag() const;
       
+      //----------------------------------------------------------------------------------
+      
+      /// @brief Whether the Scheduler releases control over the threads once the
+      /// schedule is exhausted, instead of delegating the selection to the strategy.
+      
+      bool free_run() const;
+      
+      //----------------------------------------------------------------------------------
+      
+      /// @brief Whether the visible instructions executed after the Scheduler released
+      /// control are logged, per thread and without an order between threads.
+      
+      bool free_run_log() const;
+      
+      //----------------------------------------------------------------------------------
+      
+      /// @brief The trigger on which the Scheduler takes control, or boost::none if it
+      /// controls the program from the registration of its main thread onward.
+      
+      const boost::optional<control_trigger_t>& deferred_control() const;
+      
+      //----------------------------------------------------------------------------------
+      
+      /// @brief Whether the Scheduler replays the partial order in
+      /// schedules/partial_order.txt, letting threads run in parallel, instead of
+      /// scheduling one thread at a time.
+      
+      bool partial_order() const;
+      
+      //----------------------------------------------------------------------------------
+      
+      /// @brief Whether the threads run freely while the Scheduler records the order of
+      /// their visible instructions, instead of scheduling one thread at a time.
+      
+      bool native_record() const;
+      
+      //----------------------------------------------------------------------------------
+      
+      /// @brief Whether the Scheduler records only the schedule and the site of each
+      /// step (see schedule_log), instead of the Execution with its States.
+      
+      bool lightweight_record() const;
+      
+      //----------------------------------------------------------------------------------
+      
+      /// @brief Whether the Scheduler writes the fingerprint of every recorded State to
+      /// record_states.txt (see TaskPool::state_fingerprint), for stateful explorations.
+      
+      bool record_states() const;
+      
+      //----------------------------------------------------------------------------------
+      
+      /// @brief The bounds of the flight recorder that replaces the full record, or
+      /// boost::none if the whole Execution is recorded.
+      
+      const boost::optional<flight_recorder_t>& flight_recorder() const;
+      
+      //----------------------------------------------------------------------------------
+      
+      /// @brief The parameters of the PCT strategy, if it is selected.
+      
+      const pct_t& pct() const;
+      
+      //----------------------------------------------------------------------------------
+      
+      /// @brief The seed of the randomized strategies, or boost::none if every run seeds
+      /// them differently.
+      
+      const boost::optional<unsigned int>& seed() const;
+      
+      //----------------------------------------------------------------------------------
+      
+      /// @brief Setters of the options above, returning *this so that they chain, as in
+      /// SchedulerSettings("Random").set_partial_order(true).
+      
+      SchedulerSettings& set_free_run(const bool free_run);
+      SchedulerSettings& set_free_run_log(const bool free_run_log);
+      SchedulerSettings& set_deferred_control(const boost::optional<control_trigger_t>& trigger);
+      SchedulerSettings& set_partial_order(const bool partial_order);
+      SchedulerSettings& set_native_record(const bool native_record);
+      SchedulerSettings& set_lightweight_record(const bool lightweight_record);
+      SchedulerSettings& set_record_states(const bool record_states);
+      SchedulerSettings& set_flight_recorder(const boost::optional<flight_recorder_t>& bounds);
+      SchedulerSettings& set_pct(const pct_t& pct);
+      SchedulerSettings& set_seed(const boost::optional<unsigned int>& seed);
+      
       //----------------------------------------------------------------------------------
         
       /// @note Function to initialize SchedulerSettings object in the initializer list of
       /// Scheduler.
+      /// @details The file holds the strategy tag, optionally followed by the options
+      /// - free_run and free_run_log (which implies free_run);
+      /// - deferred_control and the triggers trigger_step=<n>, trigger_function=<name>
+      ///   and trigger_signal (each of which implies deferred_control);
+      /// - partial_order;
+      /// - native_record;
+      /// - lightweight_record;
+      /// - record_states;
+      /// - flight_recorder=<capacity> and keyframe_interval=<n> (which requires
+      ///   flight_recorder, and defaults to the capacity);
+      /// - pct_depth=<d> and pct_steps=<k>;
+      /// - seed=<n>.
 
       static SchedulerSettings read_from_file(const std::string& filename);
       
+      /// @brief Reads the settings in the format of read_from_file from is, naming source
+      /// in error messages.
+      
+      static SchedulerSettings read(std::istream& is, const std::string& source);
+      
       //----------------------------------------------------------------------------------
         
    private:
@@ -47,6 +204,21 @@ namespace scheduler
 
       std::string mStrategyTag;
       
+      bool mFreeRun;
+      bool mFreeRunLog;
+      
+      boost::optional<control_trigger_t> mDeferredControl;
+      
+      bool mPartialOrder;
+      bool mNativeRecord;
+      bool mLightweightRecord;
+      bool mRecordStates;
+      
+      boost::optional<flight_recorder_t> mFlightRecorder;
+      
+      pct_t mPct;
+      boost::optional<unsigned int> mSeed;
+      
       //----------------------------------------------------------------------------------
         
    }; // end class SchedulerSettings
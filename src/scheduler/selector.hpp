@@ -13,6 +13,7 @@
 
 // STL
 #include <algorithm>
+#include <utility>
 
 using namespace program_model;
 
@@ -42,7 +43,7 @@ namespace scheduler
       
       //----------------------------------------------------------------------------------
         
-      virtual result_t select(TaskPool&, const schedule_t&, const unsigned int task_nr) = 0;
+      virtual result_t select(TaskPool&, schedule_reader&, const unsigned int task_nr) = 0;
       
       //----------------------------------------------------------------------------------
         
@@ -71,18 +72,27 @@ namespace scheduler
       : SelectorBase()
       , Strategy() { }
       
+      //----------------------------------------------------------------------------------
+      
+      /// @brief Constructor passing its arguments, e.g. parameters, to the Strategy.
+      
+      template <typename Arg, typename... Args>
+      explicit Selector(Arg&& arg, Args&&... args)
+      : SelectorBase()
+      , Strategy(std::forward<Arg>(arg), std::forward<Args>(args)...) { }
+      
       //----------------------------------------------------------------------------------
 		
-		/// @details First tries to select the next Thread::tid_t based on the given
-      /// schedule. If (task_nr > schedule.size()) and there is no deadlock, the selection
+		/// @details First tries to select the next Thread::tid_t by consuming a step of the
+      /// given schedule. If the schedule is exhausted and there is no deadlock, the selection
       /// task is delegated to Strategy.
 
-      result_t select(TaskPool& pool, const schedule_t& schedule, const unsigned int task_nr) override
+      result_t select(TaskPool& pool, schedule_reader& schedule, const unsigned int task_nr) override
       {
-         if (task_nr < schedule.size())
+         if (const auto tid = schedule.next())
          {
-            DEBUGF_SYNC("Selector", "select", "", "schedule[" << task_nr << "] = " << schedule[task_nr] << "\n");
-            return result_t(Status::RUNNING, schedule[task_nr]);
+            DEBUGF_SYNC("Selector", "select", "", "schedule[" << task_nr << "] = " << *tid << "\n");
+            return result_t(Status::RUNNING, *tid);
          }
          std::lock_guard<std::mutex> guard(pool.mMutex);
          if (pool.size() > 0)
@@ -0,0 +1,232 @@
+
+#include "shared_channel.hpp"
+
+#include "scheduler_settings.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+
+namespace scheduler {
+
+//--------------------------------------------------------------------------------------------------
+
+namespace {
+
+constexpr std::size_t nr_sections = 5;
+constexpr std::uint32_t magic = 0x52524348;
+constexpr std::uint64_t absent = std::numeric_limits<std::uint64_t>::max();
+constexpr std::int32_t no_status = -1;
+
+std::string unique_name()
+{
+   static std::atomic<unsigned int> counter{0};
+   // Short enough for the limit on segment names of macOS
+   return "/rr_" + std::to_string(::getpid()) + "_" + std::to_string(counter++);
+}
+
+} // end namespace
+
+//--------------------------------------------------------------------------------------------------
+
+struct shared_channel::header
+{
+   std::uint32_t magic;
+   std::int32_t status;
+   std::uint64_t capacity;
+   std::uint64_t sizes[nr_sections];
+
+   char* text(const section s)
+   {
+      return reinterpret_cast<char*>(this + 1) + static_cast<std::size_t>(s) * capacity;
+   }
+};
+
+const char* const shared_channel::environment_variable = "RECORD_REPLAY_CHANNEL";
+
+//--------------------------------------------------------------------------------------------------
+
+shared_channel::shared_channel(const std::size_t section_capacity, const bool exported)
+: m_name(unique_name())
+, m_owner(true)
+, m_exported(exported)
+, m_size(sizeof(header) + nr_sections * section_capacity)
+, m_header(nullptr)
+{
+   const int fd = ::shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+   if (fd < 0)
+      throw std::runtime_error("shared_channel: cannot create " + m_name);
+   void* address = MAP_FAILED;
+   if (::ftruncate(fd, static_cast<off_t>(m_size)) == 0)
+      address = ::mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   ::close(fd);
+   if (address == MAP_FAILED)
+   {
+      ::shm_unlink(m_name.c_str());
+      throw std::runtime_error("shared_channel: cannot map " + m_name);
+   }
+   m_header = static_cast<header*>(address);
+   m_header->magic = magic;
+   m_header->status = no_status;
+   m_header->capacity = section_capacity;
+   std::fill(std::begin(m_header->sizes), std::end(m_header->sizes), absent);
+   if (m_exported)
+      ::setenv(environment_variable, m_name.c_str(), 1);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+shared_channel::shared_channel(const std::string& name, const int fd)
+: m_name(name)
+, m_owner(false)
+, m_exported(false)
+, m_size(0)
+, m_header(nullptr)
+{
+   header head;
+   if (::pread(fd, &head, sizeof(head), 0) != sizeof(head) || head.magic != magic)
+      return;
+   m_size = sizeof(header) + nr_sections * head.capacity;
+   void* address = ::mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   if (address != MAP_FAILED)
+      m_header = static_cast<header*>(address);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+shared_channel::~shared_channel()
+{
+   if (m_header)
+      ::munmap(m_header, m_size);
+   if (m_owner)
+      ::shm_unlink(m_name.c_str());
+   if (m_exported)
+      ::unsetenv(environment_variable);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::unique_ptr<shared_channel> shared_channel::attach()
+{
+   const char* name = std::getenv(environment_variable);
+   if (!name)
+      return nullptr;
+   const int fd = ::shm_open(name, O_RDWR, 0);
+   if (fd < 0)
+      return nullptr;
+   std::unique_ptr<shared_channel> channel(new shared_channel(name, fd));
+   ::close(fd);
+   return channel->m_header ? std::move(channel) : nullptr;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+const std::string& shared_channel::name() const
+{
+   return m_name;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool shared_channel::write_settings(const SchedulerSettings& settings)
+{
+   std::stringstream text;
+   text << settings;
+   return write(section::settings, text.str());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool shared_channel::write_schedule(const schedule_t& schedule,
+                                    const std::vector<fingerprint_t>& fingerprints)
+{
+   m_header->status = no_status;
+   m_header->sizes[static_cast<std::size_t>(section::executed_schedule)] = absent;
+   m_header->sizes[static_cast<std::size_t>(section::data_races)] = absent;
+
+   std::stringstream text;
+   text << schedule;
+   const bool schedule_fits = write(section::schedule, text.str());
+   text.str("");
+   write_fingerprints(text, fingerprints);
+   return write(section::fingerprints, text.str()) && schedule_fits;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+boost::optional<shared_channel::result_t> shared_channel::result() const
+{
+   if (m_header->status == no_status)
+      return boost::none;
+   result_t result{static_cast<program_model::Execution::Status>(m_header->status), boost::none,
+                   read(section::data_races)};
+   if (const auto text = read(section::executed_schedule))
+   {
+      std::stringstream stream(*text);
+      schedule_t schedule;
+      stream >> schedule;
+      result.schedule = std::move(schedule);
+   }
+   return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool shared_channel::write(const section s, const std::string& text)
+{
+   auto& size = m_header->sizes[static_cast<std::size_t>(s)];
+   if (text.size() > m_header->capacity)
+   {
+      size = absent;
+      return false;
+   }
+   std::memcpy(m_header->text(s), text.data(), text.size());
+   size = text.size();
+   return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+boost::optional<std::string> shared_channel::read(const section s) const
+{
+   const auto size = m_header->sizes[static_cast<std::size_t>(s)];
+   if (size == absent)
+      return boost::none;
+   return std::string(m_header->text(s), size);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void shared_channel::set_status(const program_model::Execution::Status& status)
+{
+   m_header->status = static_cast<std::int32_t>(status);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::unique_ptr<std::istream> open_input(const shared_channel* channel,
+                                         const shared_channel::section s,
+                                         const std::string& file_name)
+{
+   if (channel)
+   {
+      if (auto text = channel->read(s))
+         return std::make_unique<std::stringstream>(std::move(*text));
+   }
+   return std::make_unique<std::ifstream>(file_name);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+} // end namespace scheduler
@@ -0,0 +1,151 @@
+#pragma once
+
+#include "schedule.hpp"
+
+#include <execution.hpp>
+
+#include <boost/optional.hpp>
+
+#include <cstddef>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------
+/// @file shared_channel.hpp
+/// @brief Passing the input and the outcome of a run through shared memory instead of files.
+/// @author Susanne van den Elsen
+/// @date 2015-2017
+//--------------------------------------------------------------------------------------------------
+///
+/// The driver creates a POSIX shared-memory segment and exports its name in the environment
+/// variable RECORD_REPLAY_CHANNEL, so that every program it starts afterwards, directly or
+/// through a fork_server, attaches to it. The segment holds a text section per file it
+/// replaces, in the formats of those files:
+///
+/// - in: settings (schedules/settings.txt), schedule (schedules/schedule.txt) and
+///   fingerprints (schedules/fingerprints.txt);
+/// - out: the executed schedule (as record_schedule.txt) and the data races (as an entry of
+///   data_races.txt), next to the status of the run.
+///
+/// A section whose text does not fit falls back to its file, and so does every section when
+/// the program runs without a channel. The driver only reads the out sections after the run
+/// terminated, so the two never access the segment at the same time. While a channel exists,
+/// the programs the driver starts read their input from it, so that runs that take their input
+/// from files should not be started then.
+
+
+namespace scheduler {
+
+// forward declarations
+class SchedulerSettings;
+
+//--------------------------------------------------------------------------------------------------
+
+class shared_channel
+{
+public:
+   enum class section
+   {
+      settings,
+      schedule,
+      fingerprints,
+      executed_schedule,
+      data_races
+   };
+
+   /// @brief What the program wrote in the channel during a run.
+
+   struct result_t
+   {
+      program_model::Execution::Status status;
+      /// @brief boost::none if it did not fit.
+      boost::optional<schedule_t> schedule;
+      /// @brief boost::none if they did not fit, and were appended to data_races.txt.
+      boost::optional<std::string> data_races;
+   };
+
+   /// @brief In the driver: creates a segment with room for section_capacity bytes of text
+   /// per section and, if exported, exports it to the programs started afterwards.
+   /// @details A channel that is not exported is passed to a single fork_server instead, so
+   /// that several can exist at once.
+   /// @throws std::runtime_error if the segment cannot be created.
+
+   explicit shared_channel(const std::size_t section_capacity = 1 << 20,
+                           const bool exported = true);
+
+   /// @brief In the driver: removes the segment and, if exported, the environment variable.
+   /// In the program: unmaps the segment.
+
+   ~shared_channel();
+
+   shared_channel(const shared_channel&) = delete;
+   shared_channel& operator=(const shared_channel&) = delete;
+
+   /// @brief In the program: the channel exported by the driver.
+   /// @returns nullptr if the program was not started by a driver with a channel.
+
+   static std::unique_ptr<shared_channel> attach();
+
+   /// @brief The name of the segment, the value of environment_variable in the program.
+
+   const std::string& name() const;
+
+   /// @brief In the driver: writes the settings of the next runs, in place of the file.
+   /// @returns false if they do not fit, and have to be written to the file.
+
+   bool write_settings(const SchedulerSettings&);
+
+   /// @brief In the driver: writes the schedule of the next run, in place of the files, and
+   /// clears the outcome of the previous run.
+   /// @returns false if the schedule or the fingerprints do not fit, and have to be written to
+   /// the files.
+
+   bool write_schedule(const schedule_t&, const std::vector<fingerprint_t>& fingerprints = {});
+
+   /// @brief In the driver: the outcome of the last run.
+   /// @returns boost::none if the program did not report its status, e.g. because it crashed
+   /// or timed out.
+
+   boost::optional<result_t> result() const;
+
+   /// @brief Stores text in the section, or marks the section as absent if it does not fit.
+   /// @returns Whether the text fits.
+
+   bool write(const section, const std::string& text);
+
+   /// @brief The text of the section.
+   /// @returns boost::none if the section is absent.
+
+   boost::optional<std::string> read(const section) const;
+
+   /// @brief In the program: reports the status of the run.
+
+   void set_status(const program_model::Execution::Status&);
+
+   /// @brief The environment variable through which the driver exports the channel.
+   static const char* const environment_variable;
+
+private:
+   struct header;
+
+   std::string m_name;
+   bool m_owner;
+   bool m_exported;
+   std::size_t m_size;
+   header* m_header;
+
+   shared_channel(const std::string& name, const int fd);
+
+}; // end class shared_channel
+
+/// @brief The input of the program: the section of the channel if there is one and it is
+/// present, or else the file file_name.
+/// @details A stream in a failed state if neither exists.
+
+std::unique_ptr<std::istream> open_input(const shared_channel* channel,
+                                         const shared_channel::section,
+                                         const std::string& file_name);
+
+} // end namespace scheduler
@@ -0,0 +1,108 @@
+#include "pct.hpp"
+
+#include <debug.hpp>
+
+#include <algorithm>
+#include <limits>
+
+#include <assert.h>
+
+
+namespace scheduler {
+
+//--------------------------------------------------------------------------------------------------
+
+PCT::PCT(const SchedulerSettings::pct_t& parameters, const boost::optional<unsigned int>& seed)
+: m_depth(std::max(1u, parameters.depth))
+, m_engine(seed ? *seed : std::random_device()())
+, m_change_points()
+, m_next_tid(0)
+, m_priorities()
+, m_selection()
+, m_enabled()
+{
+   if (parameters.steps == 0)
+      return;
+   const auto nr_change_points = std::min(m_depth - 1, parameters.steps);
+   std::uniform_int_distribution<unsigned int> step(0, parameters.steps - 1);
+   while (m_change_points.size() < nr_change_points)
+   {
+      // The i-th change point lowers to depth - i
+      const auto priority = static_cast<priority_t>(m_depth - 1 - m_change_points.size());
+      m_change_points.emplace(step(m_engine), priority);
+   }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+PCT::result_t PCT::select(const TaskPool& pool, const program_model::Tids& selection,
+                          const unsigned int task_nr) const
+{
+   /// @pre !selection.empty
+   assert(!selection.empty());
+   update(pool, selection);
+   auto tid = m_enabled.begin()->second;
+   const auto change_point = m_change_points.find(task_nr);
+   if (change_point != m_change_points.end())
+   {
+      auto& priority = m_priorities[tid];
+      m_enabled.erase({priority, tid});
+      priority = change_point->second;
+      m_enabled.emplace(priority, tid);
+      DEBUGF_SYNC("PCT", "select", "", "thread " << tid << " drops to priority " << priority);
+      tid = m_enabled.begin()->second;
+   }
+   return result_t(Status::RUNNING, tid);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::size_t PCT::nr_threads() const
+{
+   return m_priorities.size();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void PCT::update(const TaskPool& pool, const program_model::Tids& selection) const
+{
+   // The initial priorities lie above every priority of a change point
+   std::uniform_int_distribution<priority_t> priority(m_depth,
+                                                      std::numeric_limits<priority_t>::max());
+   for (; m_next_tid <= *selection.rbegin(); ++m_next_tid)
+   {
+      // Drawn for threads that finished as well, so that the priorities do not depend on it
+      const auto initial = priority(m_engine);
+      if (!pool.finished(m_next_tid))
+         m_priorities.emplace(m_next_tid, initial);
+   }
+   // Both selections are ordered by tid
+   auto previous = m_selection.begin();
+   auto next = selection.begin();
+   while (previous != m_selection.end() || next != selection.end())
+   {
+      if (previous == m_selection.end() || (next != selection.end() && *next < *previous))
+      {
+         m_enabled.emplace(m_priorities.at(*next), *next);
+         m_selection.insert(previous, *next);
+         ++next;
+      }
+      else if (next == selection.end() || *previous < *next)
+      {
+         const auto tid = *previous;
+         m_enabled.erase({m_priorities.at(tid), tid});
+         if (pool.finished(tid))
+            m_priorities.erase(tid);
+         previous = m_selection.erase(previous);
+      }
+      else
+      {
+         ++previous;
+         ++next;
+      }
+   }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+} // end namespace scheduler
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "scheduler_settings.hpp"
+#include "task_pool.hpp"
+
+#include <execution.hpp>
+#include <state.hpp>
+
+#include <boost/optional.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <random>
+#include <set>
+#include <unordered_map>
+#include <utility>
+
+//--------------------------------------------------------------------------------------------------
+/// @file pct.hpp
+/// @brief Probabilistic Concurrency Testing (Burckhardt et al., "A Randomized Scheduler with
+/// Probabilistic Guarantees of Finding Bugs", ASPLOS 2010).
+/// @author Susanne van den Elsen
+/// @date 2015-2017
+//--------------------------------------------------------------------------------------------------
+///
+/// Every thread gets a random priority above depth when it first shows up, and the enabled
+/// thread with the highest priority runs. At depth - 1 steps chosen at random among the first
+/// steps (see SchedulerSettings::pct_t), the thread about to run drops to a priority below
+/// every initial one: depth - i at the i-th change point. A run of a program with n threads
+/// and at most k steps thus finds a bug of depth d with probability at least 1 / (n k^(d-1)),
+/// where uniform random walks need far more runs for d >= 2.
+///
+/// The enabled threads are ordered by priority in a set, so that a selection takes the first
+/// one and a priority change costs O(log n). Every selection updates the set with the threads
+/// that became enabled or disabled since the previous one, in one pass over both selections,
+/// and forgets the priorities of the threads that finished. As the Scheduler numbers the
+/// threads in order of registration, the new threads are those with a higher tid than any
+/// thread seen before.
+
+
+namespace scheduler {
+
+class PCT
+{
+public:
+   using Status = program_model::Execution::Status;
+   using result_t = std::pair<Status, program_model::Thread::tid_t>;
+
+   /// @param seed If not given, every PCT is seeded differently.
+
+   explicit PCT(const SchedulerSettings::pct_t& parameters = SchedulerSettings::default_pct,
+                const boost::optional<unsigned int>& seed = boost::none);
+
+   result_t select(const TaskPool& pool, const program_model::Tids& selection,
+                   const unsigned int task_nr) const;
+
+   /// @brief The number of threads with a priority, which excludes finished threads.
+
+   std::size_t nr_threads() const;
+
+private:
+   using tid_t = program_model::Thread::tid_t;
+   using priority_t = std::uint64_t;
+
+   unsigned int m_depth;
+   mutable std::mt19937_64 m_engine;
+
+   /// @brief Per change point, the priority that the thread that runs at it drops to.
+   std::map<unsigned int, priority_t> m_change_points;
+
+   /// @brief The lowest tid without a priority.
+   mutable tid_t m_next_tid;
+   /// @brief The priorities of the threads that did not finish.
+   mutable std::unordered_map<tid_t, priority_t> m_priorities;
+   /// @brief The selection of the previous select.
+   mutable program_model::Tids m_selection;
+   /// @brief The threads in m_selection, highest priority first.
+   mutable std::set<std::pair<priority_t, tid_t>, std::greater<std::pair<priority_t, tid_t>>>
+      m_enabled;
+
+   /// @brief Gives new threads their priority and brings m_selection and m_enabled up to date
+   /// with selection.
+   void update(const TaskPool& pool, const program_model::Tids& selection) const;
+
+}; // end class PCT
+
+} // end namespace scheduler
@@ -10,14 +10,21 @@ namespace scheduler {
 
 //--------------------------------------------------------------------------------------------------
 
+Random::Random(const boost::optional<unsigned int>& seed)
+: m_engine(seed ? *seed : std::random_device()())
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+
 Random::result_t Random::select(const TaskPool& pool, const program_model::Tids& selection,
                                 const unsigned int task_nr) const
 {
    /// @pre !selection.empty
    assert(!selection.empty());
-   srand(time(NULL));
    program_model::Tids::iterator it = selection.begin();
-   int index = rand() % selection.size();
+   std::uniform_int_distribution<std::size_t> distribution(0, selection.size() - 1);
+   const auto index = distribution(m_engine);
    std::advance(it, index);
    DEBUGF_SYNC("Random", "select", "", "selection[" << index << "] = " << *it);
    return result_t(Status::RUNNING, *it);
@@ -5,6 +5,10 @@
 #include <execution.hpp>
 #include <state.hpp>
 
+#include <boost/optional.hpp>
+
+#include <random>
+
 //--------------------------------------------------------------------------------------------------
 /// @file random.hpp
 /// @author Susanne van den Elsen
@@ -20,11 +24,18 @@ public:
    using Status = program_model::Execution::Status;
    using result_t = std::pair<Status, program_model::Thread::tid_t>;
 
-   Random() = default;
+   /// @param seed If not given, every Random is seeded differently.
+
+   explicit Random(const boost::optional<unsigned int>& seed = boost::none);
 
    result_t select(const TaskPool& pool, const program_model::Tids& selection,
                    const unsigned int task_nr) const;
 
+private:
+   /// @brief Seeded once, from the given seed or else so that runs within the same second
+   /// differ.
+   mutable std::mt19937 m_engine;
+
 }; // end class Random
 
 } // end namespace scheduler
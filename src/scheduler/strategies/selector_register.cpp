@@ -3,7 +3,9 @@
 
 #include "custom_selector_register.hpp"
 #include "non_preemptive.hpp"
+#include "pct.hpp"
 #include "random.hpp"
+#include "scheduler_settings.hpp"
 
 
 namespace scheduler {
@@ -12,13 +14,25 @@ namespace scheduler {
 
 SelectorUniquePtr selector_factory(const std::string& tag)
 {
+   return selector_factory(SchedulerSettings(tag));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+SelectorUniquePtr selector_factory(const SchedulerSettings& settings)
+{
+   const auto& tag = settings.strategy_tag();
    if (tag == "NonPreemptive")
    {
       return std::make_unique<Selector<NonPreemptive>>();
    }
    else if (tag == "Random")
    {
-      return std::make_unique<Selector<Random>>();
+      return std::make_unique<Selector<Random>>(settings.seed());
+   }
+   else if (tag == "PCT")
+   {
+      return std::make_unique<Selector<PCT>>(settings.pct(), settings.seed());
    }
    else
    {
@@ -11,8 +11,15 @@
 
 namespace scheduler {
 
+// forward declarations
+class SchedulerSettings;
+
 using SelectorUniquePtr = std::unique_ptr<SelectorBase>;
 
 SelectorUniquePtr selector_factory(const std::string& tag);
 
+/// @brief As above, passing the parameters in settings to the strategy of its tag.
+
+SelectorUniquePtr selector_factory(const SchedulerSettings& settings);
+
 } // end namespace scheduler
@@ -7,7 +7,6 @@
 
 #include "debug.hpp"
 #include "utils_io.hpp"
-#include <algorithm/zip_map_values.hpp>
 
 #include <boost/range/adaptor/filtered.hpp>
 #include <boost/range/adaptor/map.hpp>
@@ -20,11 +19,49 @@ namespace scheduler {
 
 //--------------------------------------------------------------------------------------------------
 
+namespace {
+
+/// @brief The component of TaskPool::state_fingerprint that a task, a status or an owned lock
+/// contributes, with a different domain for each.
+/// @details The finalizer of splitmix64, which spreads the bits of value over the key.
+
+fingerprint_t zobrist_key(const unsigned int domain, const fingerprint_t value)
+{
+   auto key = value + 0x9e3779b97f4a7c15ull * (domain + 1);
+   key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ull;
+   key = (key ^ (key >> 27)) * 0x94d049bb133111ebull;
+   return key ^ (key >> 31);
+}
+
+fingerprint_t task_key(const instruction_t& task)
+{
+   return zobrist_key(0, fingerprint(task));
+}
+
+fingerprint_t status_key(const Thread::tid_t tid, const Thread::Status status)
+{
+   return zobrist_key(1, (static_cast<fingerprint_t>(tid) << 8) |
+                            static_cast<fingerprint_t>(status));
+}
+
+/// @brief The key of the lock with the given object id that the thread of lock_instr acquired
+/// with it.
+
+fingerprint_t lock_key(const instruction_t& lock_instr, const fingerprint_t object_id)
+{
+   return zobrist_key(2, fingerprint(lock_instr) ^ zobrist_key(3, object_id));
+}
+
+} // end namespace
+
+//--------------------------------------------------------------------------------------------------
+
 void TaskPool::register_thread(const Thread::tid_t& tid)
 {
    std::lock_guard<std::mutex> guard(mMutex);
    mThreads.insert(Threads::value_type(tid, Thread(tid)));
    const auto thread = mThreads.find(tid);
+   m_state_fingerprint ^= status_key(tid, thread->second.status());
    std::lock_guard<std::mutex> lock(m_objects_mutex);
    m_thread_states.insert(thread_states_t::value_type(tid, thread_state(thread->second)));
    DEBUGF_SYNC("TaskPool", "register_thread", thread->second, "\n");
@@ -40,6 +77,8 @@ void TaskPool::post(const Thread::tid_t& tid, const instruction_t& task)
    /// @pre mTasks.find(tid) == mTasks.end()
    assert(task_it == mTasks.end());
    mTasks.insert(Tasks::value_type(tid, task));
+   m_state_fingerprint ^= task_key(task);
+   m_modified_threads.insert(tid);
    update_object_post(tid, task);
    // cond SIGNAL mModified
    mModified.notify_one();
@@ -61,21 +100,27 @@ void TaskPool::yield(const Thread::tid_t& tid)
 
 void TaskPool::finish(const program_model::Thread::tid_t& tid)
 {
+   std::lock_guard<std::mutex> guard(mMutex);
    std::lock_guard<std::mutex> lock(m_objects_mutex);
-   
+
    auto thread_state = m_thread_states.find(tid);
    if (thread_state == m_thread_states.end())
    {
       throw std::runtime_error("TaskPool::finish");
    }
-   
+
    std::for_each(thread_state->second.begin(), thread_state->second.end(),
                  [this](const auto& join_request) { set_status(join_request.first, program_model::Thread::Status::ENABLED); });
-   
-   set_status_protected(tid, program_model::Thread::Status::FINISHED);
-   
+
    // As soon as the thread is finished, potential waiters for a join are enabled and remain
    // enabled even after a potential join. Joining an unjoinable thread returns an error code.
+   // The thread_state refers to the Thread in mThreads, so both are removed together.
+   m_state_fingerprint ^= status_key(tid, status(tid)) ^ status_key(tid, Thread::Status::FINISHED);
+   m_thread_states.erase(thread_state);
+   mThreads.erase(tid);
+   m_finished_threads.insert(tid);
+   DEBUGF_SYNC("TaskPool", "finish", tid, "\n");
+   mModified.notify_one();
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -85,10 +130,7 @@ void TaskPool::wait_until_unfinished_threads_have_posted()
    std::unique_lock<std::mutex> lock(mMutex);
    mModified.wait(lock, [this] {
       DEBUGF_SYNC("TaskPool", "wait_until_unfinished_threads_have_posted", "", "\n");
-      return std::all_of(mThreads.begin(), mThreads.end(), [this](const auto& thread) {
-         return thread.second.status() == Thread::Status::FINISHED ||
-                mTasks.find(thread.first) != mTasks.end();
-      });
+      return all_live_threads_have_posted();
    });
    DEBUGF_SYNC("TaskPool", "all_unfinished_threads_have_posted", "", "\n");
 }
@@ -114,7 +156,9 @@ instruction_t TaskPool::set_current(const Thread::tid_t& tid)
    /// @pre mTasks.find(tid) != mTasks.end()
    assert(it != mTasks.end());
    mCurrentTask = std::shared_ptr<instruction_t>(new instruction_t(it->second));
+   m_state_fingerprint ^= task_key(it->second);
    mTasks.erase(it); // noexcept
+   m_modified_threads.insert(tid);
    return *mCurrentTask;
 }
 
@@ -127,6 +171,13 @@ bool TaskPool::has_next(const Thread::tid_t& tid) const
 
 //--------------------------------------------------------------------------------------------------
 
+bool TaskPool::finished(const Thread::tid_t& tid) const
+{
+   return m_finished_threads.find(tid) != m_finished_threads.end();
+}
+
+//--------------------------------------------------------------------------------------------------
+
 TaskPool::Tasks::const_iterator TaskPool::task(const Thread::tid_t& tid) const
 {
    return mTasks.find(tid);
@@ -205,32 +256,56 @@ Tids TaskPool::enabled_set_protected()
 
 NextSet TaskPool::nextset_protected()
 {
-   using zip_function_t = std::function<next_t(const instruction_t&, const Thread&)>;
-   const zip_function_t zip_function = [](const auto& task, const auto& thread) {
-      return next_t{task, thread.status() == Thread::Status::ENABLED};
-   };
    std::lock_guard<std::mutex> guard(mMutex);
-   /// @throws std::invalid_argument (rethrow)
-   return utils::algorithm::zip_map_values(mTasks, mThreads, zip_function);
+   NextSet N{};
+   for (const auto& entry : mTasks)
+   {
+      N.set(entry.first, next_t{entry.second, status(entry.first) == Thread::Status::ENABLED});
+   }
+   return N;
 }
 
 //--------------------------------------------------------------------------------------------------
 
-std::unique_ptr<State> TaskPool::program_state()
+State::SharedPtr TaskPool::program_state()
 {
    std::lock_guard<std::mutex> guard(mMutex);
-   NextSet N{};
-   Tids Enabled{};
-   for (const auto& entry : mTasks)
+   std::unique_ptr<Tids> enabled{};
+   for (const auto tid : m_modified_threads)
    {
-      bool enabled = (status(entry.first) == Thread::Status::ENABLED);
-      N.insert(NextSet::value_type(entry.first, next_t{entry.second, enabled}));
-      if (enabled)
+      const auto task = mTasks.find(tid);
+      const bool has_task = task != mTasks.end();
+      const bool is_enabled = has_task && status(tid) == Thread::Status::ENABLED;
+      if (has_task)
       {
-         Enabled.insert(entry.first);
+         const next_t next{task->second, is_enabled};
+         const auto current = m_next_snapshot.find(tid);
+         if (current == m_next_snapshot.end() || !(current->second == next))
+         {
+            m_next_snapshot.set(tid, next);
+         }
+      }
+      else
+      {
+         m_next_snapshot.erase(tid);
+      }
+      const bool was_enabled = m_enabled_snapshot->find(tid) != m_enabled_snapshot->end();
+      if (is_enabled != was_enabled)
+      {
+         if (!enabled)
+            enabled = std::make_unique<Tids>(*m_enabled_snapshot);
+         if (is_enabled)
+            enabled->insert(tid);
+         else
+            enabled->erase(tid);
       }
    }
-   return std::make_unique<State>(std::move(Enabled), std::move(N));
+   m_modified_threads.clear();
+   if (enabled)
+   {
+      m_enabled_snapshot = std::move(enabled);
+   }
+   return State::create(m_enabled_snapshot, m_next_snapshot);
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -243,11 +318,23 @@ std::vector<data_race_t> TaskPool::data_races() const
 
 //--------------------------------------------------------------------------------------------------
 
+fingerprint_t TaskPool::state_fingerprint()
+{
+   std::lock_guard<std::mutex> guard(mMutex);
+   return m_state_fingerprint;
+}
+
+//--------------------------------------------------------------------------------------------------
+
 Thread::Status TaskPool::status(const Thread::tid_t& tid) const
 {
    auto it = mThreads.find(tid);
-   /// @pre mThreads.find(tid) != mThreads.end()
-   assert(it != mThreads.end());
+   if (it == mThreads.end())
+   {
+      /// @pre tid is registered
+      assert(m_finished_threads.find(tid) != m_finished_threads.end());
+      return Thread::Status::FINISHED;
+   }
    return it->second.status();
 }
 
@@ -257,7 +344,13 @@ void TaskPool::set_status(const Thread::tid_t& tid, const Thread::Status& status
 {
    auto thread_it = mThreads.find(tid);
    assert(thread_it != mThreads.end());
-   thread_it->second.set_status(status);
+   if (thread_it->second.status() != status)
+   {
+      m_state_fingerprint ^=
+         status_key(tid, thread_it->second.status()) ^ status_key(tid, status);
+      thread_it->second.set_status(status);
+      m_modified_threads.insert(tid);
+   }
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -274,6 +367,7 @@ void TaskPool::update_object_post(const Thread::tid_t& tid, const instruction_t&
        if (m_objects.find(address) == m_objects.end())
        {
           m_objects.insert(objects_t::value_type(address, object_state(*mem_location)));
+          m_object_ids.emplace(address, m_object_ids.size());
        }
        // Update m_data_races
        auto& operand_state = m_objects.find(address)->second;
@@ -287,8 +381,12 @@ void TaskPool::update_object_post(const Thread::tid_t& tid, const instruction_t&
       if (management_instr->operation() == program_model::thread_management_operation::Join)
       {
          std::lock_guard<std::mutex> lock(m_objects_mutex);
-         auto& operand_state = m_thread_states.find(management_instr->operand().tid())->second;
-         enabled = operand_state.request(*management_instr);
+         auto operand_state = m_thread_states.find(management_instr->operand().tid());
+         // A thread that is no longer live has finished and can be joined right away
+         if (operand_state != m_thread_states.end())
+         {
+            enabled = operand_state->second.request(*management_instr);
+         }
       }
    }
    set_status(tid, (enabled ? Thread::Status::ENABLED : Thread::Status::DISABLED));
@@ -310,6 +408,21 @@ void TaskPool::update_object_yield(const instruction_t& task)
        if (const auto* lock_instr = boost::get<program_model::lock_instruction>(&task))
        {
           const bool is_lock = lock_instr->operation() == program_model::lock_operation::Lock;
+          if (is_lock)
+          {
+             const auto key = lock_key(task, m_object_ids.at(mem_location->address()));
+             m_lock_keys[mem_location->address()] = key;
+             m_state_fingerprint ^= key;
+          }
+          else
+          {
+             const auto key = m_lock_keys.find(mem_location->address());
+             if (key != m_lock_keys.end())
+             {
+                m_state_fingerprint ^= key->second;
+                m_lock_keys.erase(key);
+             }
+          }
           set_status_of_waiting_on(obj->second,
                                    (is_lock ? Thread::Status::DISABLED : Thread::Status::ENABLED));
        }
@@ -331,9 +444,14 @@ void TaskPool::set_status_of_waiting_on(const object_state& object, const Thread
 
 bool TaskPool::all_finished() const
 {
-   return std::all_of(mThreads.begin(), mThreads.end(), [](const auto& thread) {
-      return thread.second.status() != Thread::Status::FINISHED;
-   });
+   return mThreads.empty();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool TaskPool::all_live_threads_have_posted() const
+{
+   return mTasks.size() == mThreads.size();
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -2,12 +2,14 @@
 
 #include "concurrency_error.hpp"
 #include "object_state.hpp"
+#include "schedule.hpp"
 #include "thread_state.hpp"
 
 #include "state.hpp"
 
 #include <thread>
 #include <unordered_map>
+#include <unordered_set>
 
 using namespace program_model;
 
@@ -27,6 +29,11 @@ namespace scheduler {
 /// A TaskPool is equiped with a locking mechanism that allows threads to safely
 /// operate on its data concurrently.
 /// @note The TaskPool assumes that threads don't cheat and post under false id.
+/// @note Finished threads are removed from mThreads and m_thread_states, so that the
+/// per-step work only depends on the number of live threads. Only their tids are kept,
+/// in m_finished_threads, to answer status queries and join requests.
+/// @note The TaskPool keeps a Zobrist fingerprint of its state (see state_fingerprint), which
+/// every change of a task, a thread status or a lock owner updates in constant time.
 
 class TaskPool
 {
@@ -38,6 +45,7 @@ public:
    using Threads = std::unordered_map<Thread::tid_t, Thread>;
    using objects_t = std::unordered_map<object_t::ptr_t, object_state>;
    using thread_states_t = std::unordered_map<Thread::tid_t, thread_state>;
+   using finished_threads_t = std::unordered_set<Thread::tid_t>;
 
    /// @brief Mytex protecting mTasks, mStatus, mNr_registered, and mModified.
 
@@ -73,8 +81,9 @@ public:
 
    void yield(const Thread::tid_t& tid);
    
-   /// @brief Handles a finished thread.
-   
+   /// @brief Handles a finished thread: enables the threads waiting to join it and removes
+   /// it from the live threads.
+
    void finish(const Thread::tid_t& tid);
 
    /// @brief Wait until all unfinished threads have posted a task.
@@ -96,6 +105,11 @@ public:
 
    bool has_next(const Thread::tid_t& tid) const;
 
+   /// @brief Whether Thread tid finished.
+   /// @note Unprotected, as enabled_set.
+
+   bool finished(const Thread::tid_t& tid) const;
+
    /// @brief Find function on mTasks.
 
    Tasks::const_iterator task(const Thread::tid_t& tid) const;
@@ -129,12 +143,26 @@ public:
    NextSet nextset_protected();
 
    /// @brief Creates a program_model::State object from this TaskPool and returns a
-   /// unique_ptr to it.
+   /// shared_ptr to it.
+   /// @details The State is derived from the previously created one: only the entries of
+   /// threads that posted, were scheduled or changed status since are created anew, all
+   /// other entries and (if unchanged) the enabled set are shared with the previous State.
 
-   std::unique_ptr<State> program_state();
+   State::SharedPtr program_state();
 
    std::vector<data_race_t> data_races() const;
 
+   /// @brief mMutex-protected fingerprint of the posted tasks, the statuses of the threads and
+   /// the owners of the locks.
+   /// @details The fingerprint is the xor of a 64-bit key per task, status and owned lock.
+   /// The keys are derived from the tids and the fingerprints of the instructions (see
+   /// scheduler::fingerprint), not from the addresses of objects, so that equal States of
+   /// different runs have equal fingerprints. The key of an owned lock also holds the order
+   /// in which the TaskPool first saw its object, telling apart the locks that a thread took
+   /// at the same site. The values in memory are not part of it.
+
+   fingerprint_t state_fingerprint();
+
 private:
    /// @brief Datastrucure mapping Thread::tid_t's to the associated Thread's posted
    /// next task.
@@ -145,10 +173,23 @@ private:
 
    std::shared_ptr<instruction_t> mCurrentTask;
 
-   /// @brief Datastructure mapping Thread::tid_t's to the associated Thread.
+   /// @brief Datastructure mapping Thread::tid_t's to the associated live Thread.
 
    Threads mThreads;
 
+   /// @brief The tids of the threads that have been removed from mThreads on finishing.
+
+   finished_threads_t m_finished_threads;
+
+   /// @brief The enabled set and NextSet of the State last returned by program_state.
+
+   State::TidsPtr m_enabled_snapshot = std::make_shared<const Tids>();
+   NextSet m_next_snapshot;
+
+   /// @brief The threads whose task or status changed since the last program_state call.
+
+   std::unordered_set<Thread::tid_t> m_modified_threads;
+
    /// @brief Datastructure containing the objects operated on by the program.
 
    objects_t m_objects;
@@ -156,6 +197,19 @@ private:
 
    std::vector<data_race_t> m_data_races;
 
+   /// @brief See state_fingerprint, protected by mMutex.
+
+   fingerprint_t m_state_fingerprint = 0;
+
+   /// @brief The order in which the objects were first posted on, protected by
+   /// m_objects_mutex.
+
+   std::unordered_map<object_t::ptr_t, fingerprint_t> m_object_ids;
+
+   /// @brief The keys of the held locks in m_state_fingerprint, which an unlock removes.
+
+   std::unordered_map<object_t::ptr_t, fingerprint_t> m_lock_keys;
+
    /// @brief Mutex protecting m_objects and m_data_races.
 
    mutable std::mutex m_objects_mutex;
@@ -182,6 +236,11 @@ private:
 
    bool all_finished() const;
 
+   /// @brief Returns whether every live thread has a task in mTasks.
+   /// @details Only live threads can have a posted task, so this is a size comparison.
+
+   bool all_live_threads_have_posted() const;
+
 }; // end class TaskPool
 
 std::ostream& operator<<(std::ostream&, TaskPool&);
@@ -0,0 +1,212 @@
+#include <preemption_bounding.hpp>
+#include <source_dpor.hpp>
+#include <work_stealing.hpp>
+
+#include <replay.hpp>
+#include <scheduler_settings.hpp>
+
+#include <execution_io.hpp>
+#include <text_trace.hpp>
+
+#include <boost/filesystem/operations.hpp>
+
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------
+/// @file explore.cpp
+/// @brief Explores the schedules of an instrumented program systematically.
+/// @details Usage: explore [--timeout ms] [--runs n] [--preemptions k [--stateful | -j w]]
+/// program output_dir. Runs the program under the schedules of source_dpor or, with
+/// --preemptions, under every schedule with at most k preemptions (see preemption_bounding), at
+/// most n of them, with the NonPreemptive strategy completing each run. --stateful prunes the
+/// latter with the State fingerprints in record_states.txt. -j runs them on w workers that
+/// share a work_stealing_frontier, each forking the program from its own fork_server in
+/// output_dir/work/i. The records of run i that did not end DONE are kept in output_dir/i, and
+/// output_dir/results.txt lists `i status steps` for them. Exits with 0 if every explored run
+/// ended DONE, 1 otherwise and 2 on an error.
+//--------------------------------------------------------------------------------------------------
+
+
+namespace {
+
+void usage(const char* name)
+{
+   std::cerr << "usage: " << name
+             << " [--timeout ms] [--runs n] [--preemptions k [--stateful | -j w]] program"
+                " output_dir\n";
+}
+
+void print(const std::vector<exploration::bound_statistics_t>& statistics, const bool stateful)
+{
+   for (std::size_t preemptions = 0; preemptions < statistics.size(); ++preemptions)
+   {
+      const auto& bound = statistics[preemptions];
+      std::cout << preemptions << " preemptions: " << bound.nr_executions << " runs";
+      if (stateful)
+         std::cout << ", " << bound.nr_pruned << " pruned";
+      std::cout << (bound.complete ? "" : " (incomplete)") << "\n";
+   }
+}
+
+} // end namespace
+
+//--------------------------------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+   using namespace scheduler;
+
+   boost::optional<timeout_t> timeout;
+   unsigned long max_runs = 0;
+   boost::optional<unsigned int> max_preemptions;
+   bool stateful = false;
+   unsigned int nr_workers = 1;
+   int arg = 1;
+   try
+   {
+      while (arg + 1 < argc && argv[arg][0] == '-')
+      {
+         const std::string option = argv[arg++];
+         if (option == "--stateful")
+         {
+            stateful = true;
+            continue;
+         }
+         const std::string value = argv[arg++];
+         if (option == "--timeout")
+            timeout = timeout_t(std::stoul(value));
+         else if (option == "--runs")
+            max_runs = std::stoul(value);
+         else if (option == "--preemptions")
+            max_preemptions = static_cast<unsigned int>(std::stoul(value));
+         else if (option == "-j")
+            nr_workers = static_cast<unsigned int>(std::stoul(value));
+         else
+            throw std::invalid_argument(option);
+      }
+   }
+   catch (const std::logic_error&)
+   {
+      usage(argv[0]);
+      return 2;
+   }
+   if (argc - arg != 2 || (stateful && !max_preemptions) || nr_workers == 0 ||
+       (nr_workers > 1 && (!max_preemptions || stateful)))
+   {
+      usage(argv[0]);
+      return 2;
+   }
+   const program_t program = boost::filesystem::absolute(argv[arg]);
+   const boost::filesystem::path output_dir = argv[arg + 1];
+   const auto run_dir = output_dir / "run";
+
+   try
+   {
+      // The explorations need the States of every run, the stateful one their fingerprints
+      write_settings(SchedulerSettings("NonPreemptive").set_record_states(stateful));
+      boost::filesystem::create_directories(output_dir);
+      std::ofstream results((output_dir / "results.txt").string());
+
+      unsigned long nr_runs = 0;
+      bool all_done = true;
+      const auto run = [&program, &timeout, &run_dir](const schedule_t& schedule) {
+         boost::filesystem::remove_all(run_dir);
+         run_under_schedule(program, schedule, timeout, run_dir);
+         return program_model::load_text_execution((run_dir / "record.txt").string());
+      };
+      const auto on_execution = [&](const program_model::Execution& E) {
+         if (E.status() != program_model::Execution::Status::DONE)
+         {
+            all_done = false;
+            results << nr_runs << " " << E.status() << " " << E.size() << "\n";
+            boost::filesystem::rename(run_dir, output_dir / std::to_string(nr_runs));
+         }
+         ++nr_runs;
+         return max_runs == 0 || nr_runs < max_runs;
+      };
+
+      if (max_preemptions && nr_workers > 1)
+      {
+         // The runs of a worker write their records to its own working directory
+         const auto work_dir = boost::filesystem::absolute(output_dir / "work");
+         const auto worker_dir = [&work_dir](const unsigned int worker) {
+            return work_dir / std::to_string(worker);
+         };
+         std::vector<std::unique_ptr<fork_server>> servers;
+         for (unsigned int worker = 0; worker < nr_workers; ++worker)
+         {
+            boost::filesystem::create_directories(worker_dir(worker) / "schedules");
+            std::ofstream settings((worker_dir(worker) / "schedules/settings.txt").string());
+            settings << SchedulerSettings("NonPreemptive");
+            settings.close();
+            servers.push_back(std::make_unique<fork_server>(program, worker_dir(worker)));
+         }
+
+         const auto worker_run = [&](const unsigned int worker, const schedule_t& schedule) {
+            const auto dir = worker_dir(worker);
+            boost::filesystem::remove(dir / "record.txt");
+            std::ofstream ofs((dir / "schedules/schedule.txt").string());
+            ofs << schedule;
+            ofs.close();
+            servers[worker]->run(timeout);
+            return program_model::load_text_execution((dir / "record.txt").string());
+         };
+         const auto worker_on_execution = [&](const unsigned int worker,
+                                              const program_model::Execution& E) {
+            if (E.status() != program_model::Execution::Status::DONE)
+            {
+               all_done = false;
+               results << nr_runs << " " << E.status() << " " << E.size() << "\n";
+               collect_records(output_dir / std::to_string(nr_runs), worker_dir(worker));
+            }
+            ++nr_runs;
+            return max_runs == 0 || nr_runs < max_runs;
+         };
+         const auto statistics = exploration::explore_preemption_bounded(
+            nr_workers, worker_run, *max_preemptions, worker_on_execution);
+         print(statistics.bounds, false);
+         std::cout << statistics.nr_steals << " steals, runs per worker:";
+         for (const auto nr_executions : statistics.nr_executions)
+            std::cout << " " << nr_executions;
+         std::cout << "\n";
+         servers.clear();
+         boost::filesystem::remove_all(work_dir);
+      }
+      else if (max_preemptions)
+      {
+         const auto stateful_run = [&run, &run_dir](const schedule_t& schedule) {
+            exploration::recorded_run_t recorded{run(schedule), {}};
+            auto states =
+               fingerprint_reader::read_from_file((run_dir / "record_states.txt").string());
+            while (const auto state = states.next())
+               recorded.states.push_back(*state);
+            return recorded;
+         };
+         const auto statistics =
+            stateful ? exploration::explore_preemption_bounded(stateful_run, *max_preemptions,
+                                                               on_execution)
+                     : exploration::explore_preemption_bounded(run, *max_preemptions,
+                                                               on_execution);
+         print(statistics, stateful);
+      }
+      else
+      {
+         const auto statistics = exploration::explore(run, on_execution);
+         std::cout << statistics.nr_executions << " runs, " << nr_runs << " traces, "
+                   << statistics.nr_redundant << " redundant ("
+                   << statistics.nr_sleep_set_blocked << " sleep-set blocked)\n";
+      }
+      boost::filesystem::remove_all(run_dir);
+      return all_done ? 0 : 1;
+   }
+   catch (const std::exception& error)
+   {
+      std::cerr << error.what() << "\n";
+      return 2;
+   }
+}
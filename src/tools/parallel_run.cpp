@@ -0,0 +1,129 @@
+#include <parallel_driver.hpp>
+
+#include <execution_io.hpp>
+
+#include <boost/filesystem/operations.hpp>
+
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------
+/// @file parallel_run.cpp
+/// @brief Runs an instrumented program under many schedules concurrently.
+/// @details Usage: parallel-run [-j workers] [--timeout ms] [--queue n] [--strategy tag]
+/// [--runs n] program output_dir [schedule_file...]. Runs the program once under each schedule
+/// file or, without schedule files, n times (default 1) under the empty schedule, so that the
+/// strategy picks every step. The records of run i are moved to output_dir/i, and
+/// output_dir/results.txt lists `i status steps` per run, status being the one the program
+/// reported or `none` if it crashed or timed out. Exits with 0 if every run ended DONE, 1
+/// otherwise and 2 on an error.
+//--------------------------------------------------------------------------------------------------
+
+
+namespace {
+
+void usage(const char* name)
+{
+   std::cerr << "usage: " << name
+             << " [-j workers] [--timeout ms] [--queue n] [--strategy tag] [--runs n] program"
+                " output_dir [schedule_file...]\n";
+}
+
+} // end namespace
+
+//--------------------------------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+   using namespace scheduler;
+
+   parallel_options_t options;
+   std::string strategy_tag = "Random";
+   unsigned long nr_runs = 1;
+   int arg = 1;
+   try
+   {
+      for (; arg + 1 < argc && argv[arg][0] == '-'; arg += 2)
+      {
+         const std::string option = argv[arg];
+         const std::string value = argv[arg + 1];
+         if (option == "-j")
+            options.nr_workers = static_cast<unsigned int>(std::stoul(value));
+         else if (option == "--timeout")
+            options.timeout = std::chrono::milliseconds(std::stoul(value));
+         else if (option == "--queue")
+            options.queue_capacity = std::stoul(value);
+         else if (option == "--strategy")
+            strategy_tag = value;
+         else if (option == "--runs")
+            nr_runs = std::stoul(value);
+         else
+            throw std::invalid_argument(option);
+      }
+   }
+   catch (const std::logic_error&)
+   {
+      usage(argv[0]);
+      return 2;
+   }
+   if (argc - arg < 2)
+   {
+      usage(argv[0]);
+      return 2;
+   }
+   const boost::filesystem::path program = argv[arg];
+   options.output_dir = argv[arg + 1];
+   options.work_dir = options.output_dir / "work";
+   const std::vector<std::string> schedule_files(argv + arg + 2, argv + argc);
+
+   try
+   {
+      parallel_driver driver(program, SchedulerSettings(strategy_tag), options);
+      if (schedule_files.empty())
+      {
+         for (unsigned long i = 0; i < nr_runs; ++i)
+            driver.submit({});
+      }
+      for (const auto& file_name : schedule_files)
+      {
+         std::ifstream ifs(file_name);
+         if (!ifs)
+            throw std::runtime_error("cannot open " + file_name);
+         schedule_t schedule;
+         ifs >> schedule;
+         driver.submit(schedule);
+      }
+
+      bool all_done = true;
+      std::ofstream results((options.output_dir / "results.txt").string());
+      for (const auto& result : driver.finish())
+      {
+         results << result.id << " ";
+         if (result.outcome)
+         {
+            results << result.outcome->status << " ";
+            if (result.outcome->schedule)
+               results << result.outcome->schedule->size();
+            else
+               results << "?";
+         }
+         else
+         {
+            results << "none -";
+         }
+         results << "\n";
+         all_done &=
+            result.outcome && result.outcome->status == program_model::Execution::Status::DONE;
+      }
+      boost::filesystem::remove_all(options.work_dir);
+      return all_done ? 0 : 1;
+   }
+   catch (const std::exception& error)
+   {
+      std::cerr << error.what() << "\n";
+      return 2;
+   }
+}
@@ -0,0 +1,55 @@
+#include <execution_diff.hpp>
+
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+//--------------------------------------------------------------------------------------------------
+/// @file trace_diff.cpp
+/// @brief Reports the first divergence between two recorded Executions.
+/// @details Usage: trace-diff [--per-thread] [--addresses] lhs rhs. Each file is a record.txt
+/// or a binary trace. Objects match by first use, unless --addresses compares their addresses,
+/// which only makes sense for Executions of the same process. Exits with 0 if the Executions
+/// are equal, 1 if they diverge and 2 on an error.
+//--------------------------------------------------------------------------------------------------
+
+
+int main(int argc, char** argv)
+{
+   using namespace program_model;
+
+   auto align = alignment::global;
+   auto match = objects::by_first_use;
+   int arg = 1;
+   for (; arg < argc && argv[arg][0] == '-'; ++arg)
+   {
+      if (std::strcmp(argv[arg], "--per-thread") == 0)
+         align = alignment::per_thread;
+      else if (std::strcmp(argv[arg], "--addresses") == 0)
+         match = objects::by_address;
+      else
+         break;
+   }
+   if (argc - arg != 2)
+   {
+      std::cerr << "usage: " << argv[0] << " [--per-thread] [--addresses] lhs rhs\n";
+      return 2;
+   }
+
+   try
+   {
+      const auto divergence = first_divergence(argv[arg], argv[arg + 1], align, match);
+      if (!divergence)
+      {
+         std::cout << "no divergence\n";
+         return 0;
+      }
+      std::cout << *divergence;
+      return 1;
+   }
+   catch (const std::runtime_error& error)
+   {
+      std::cerr << error.what() << "\n";
+      return 2;
+   }
+}
@@ -0,0 +1,205 @@
+#include "test_program.hpp"
+
+#include <work_stealing.hpp>
+
+#include <replay.hpp>
+#include <scheduler_settings.hpp>
+
+#include <execution_io.hpp>
+#include <text_trace.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/preprocessor/stringize.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------
+/// @file exploration_benchmark.cpp
+/// @brief Measures how the throughput of the parallel preemption-bounded exploration (see
+/// work_stealing.hpp) scales with the number of workers.
+/// @details Usage: ExplorationBenchmark [--preemptions k] [--runs n] [--workers w]
+/// [--synthetic ms] [program...]. Explores every program with 1, 2, 4, ... up to w workers,
+/// by default as many as there are hardware threads, stopping after about n runs, and reports
+/// the runs per second and the speedup over one worker. The programs default to the
+/// instrumented real-world test programs that the tests leave in the test data directory.
+/// --synthetic explores a program of the tests instead, whose runs each take ms milliseconds
+/// without using a core, which shows the overhead of the frontier itself.
+//--------------------------------------------------------------------------------------------------
+
+
+namespace {
+
+namespace fs = boost::filesystem;
+
+using clock_type = std::chrono::steady_clock;
+
+/// @brief Returns the runs of an exploration on the given number of workers, in the workers'
+/// threads.
+
+using make_run_t = std::function<exploration::worker_run_t(const unsigned int nr_workers)>;
+
+struct options_t
+{
+   unsigned int max_preemptions = 2;
+   std::size_t max_runs = 2000;
+   unsigned int max_workers = std::max(1u, std::thread::hardware_concurrency());
+};
+
+/// @brief The instrumented real-world test programs under the test data directory.
+
+std::vector<fs::path> real_world_programs()
+{
+   const auto test_data = fs::path(BOOST_PP_STRINGIZE(TESTS_BUILD_DIR)) / "test_data";
+   std::vector<fs::path> programs;
+   for (const auto* name : {"dining_philosophers.c", "dining_philosophers.cpp", "filesystem.c",
+                            "work_stealing_queue.cpp"})
+   {
+      if (!fs::exists(test_data / name))
+         continue;
+      // One directory per optimization level
+      for (fs::directory_iterator it(test_data / name), end; it != end; ++it)
+      {
+         const auto program = it->path() / "instrumented" / fs::path(name).stem();
+         if (fs::is_regular_file(program))
+            programs.push_back(program);
+      }
+   }
+   return programs;
+}
+
+/// @brief Runs an instrumented program, forking every run from the fork_server of the worker.
+
+make_run_t fork_server_runs(const fs::path& program, const fs::path& work_dir)
+{
+   return [program, work_dir](const unsigned int nr_workers) -> exploration::worker_run_t {
+      auto servers = std::make_shared<std::vector<std::unique_ptr<scheduler::fork_server>>>();
+      for (unsigned int worker = 0; worker < nr_workers; ++worker)
+      {
+         const auto dir = work_dir / std::to_string(worker);
+         fs::create_directories(dir / "schedules");
+         std::ofstream settings((dir / "schedules/settings.txt").string());
+         settings << scheduler::SchedulerSettings("NonPreemptive");
+         settings.close();
+         servers->push_back(std::make_unique<scheduler::fork_server>(program, dir));
+      }
+      return [servers, work_dir](const unsigned int worker,
+                                 const scheduler::schedule_t& schedule) {
+         const auto dir = work_dir / std::to_string(worker);
+         fs::remove(dir / "record.txt");
+         std::ofstream ofs((dir / "schedules/schedule.txt").string());
+         ofs << schedule;
+         ofs.close();
+         (*servers)[worker]->run(std::chrono::milliseconds(3000));
+         return program_model::load_text_execution((dir / "record.txt").string());
+      };
+   };
+}
+
+/// @brief Runs a program of the tests in the process, taking the given time per run.
+
+make_run_t synthetic_runs(const unsigned int milliseconds)
+{
+   using namespace exploration::test;
+   static int x = 0;
+   static int y = 0;
+   static int m = 0;
+   static const program_t program{
+      {store(0, x), lock(0, m), load(0, y), unlock(0, m), store(0, x)},
+      {store(1, y), lock(1, m), load(1, x), unlock(1, m), store(1, y)},
+      {load(2, x), load(2, y), store(2, x), store(2, y)},
+      {load(3, y), store(3, x), load(3, x)}};
+   return [milliseconds](const unsigned int) -> exploration::worker_run_t {
+      return [milliseconds](const unsigned int, const scheduler::schedule_t& schedule) {
+         std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+         return run(program, schedule);
+      };
+   };
+}
+
+void benchmark(const std::string& name, const make_run_t& make_run, const options_t& options)
+{
+   std::vector<unsigned int> nrs_workers;
+   for (unsigned int nr_workers = 1; nr_workers < options.max_workers; nr_workers *= 2)
+      nrs_workers.push_back(nr_workers);
+   nrs_workers.push_back(options.max_workers);
+
+   std::cout << name << "\n";
+   double baseline = 0;
+   for (const auto nr_workers : nrs_workers)
+   {
+      const auto run = make_run(nr_workers);
+      std::size_t nr_runs = 0;
+      const auto start = clock_type::now();
+      const auto statistics = exploration::explore_preemption_bounded(
+         nr_workers, run, options.max_preemptions,
+         [&nr_runs, &options](const unsigned int, const program_model::Execution&) {
+            return ++nr_runs < options.max_runs;
+         });
+      const auto time = std::chrono::duration<double>(clock_type::now() - start).count();
+
+      std::size_t nr_executions = 0;
+      for (const auto executions : statistics.nr_executions)
+         nr_executions += executions;
+      const auto throughput = nr_executions / time;
+      if (nr_workers == 1)
+         baseline = throughput;
+      std::cout << nr_workers << " workers\t" << nr_executions << " runs\t" << throughput
+                << " runs/s\t" << throughput / baseline << "x\t" << statistics.nr_steals
+                << " steals\n";
+   }
+}
+
+} // end namespace
+
+//--------------------------------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+   options_t options;
+   unsigned int synthetic = 0;
+   std::vector<fs::path> programs;
+   for (int arg = 1; arg < argc; ++arg)
+   {
+      const std::string option = argv[arg];
+      if (option == "--preemptions" && arg + 1 < argc)
+         options.max_preemptions = std::stoul(argv[++arg]);
+      else if (option == "--runs" && arg + 1 < argc)
+         options.max_runs = std::stoul(argv[++arg]);
+      else if (option == "--workers" && arg + 1 < argc)
+         options.max_workers = std::max(1ul, std::stoul(argv[++arg]));
+      else if (option == "--synthetic" && arg + 1 < argc)
+         synthetic = std::stoul(argv[++arg]);
+      else
+         programs.push_back(fs::absolute(option));
+   }
+
+   if (synthetic > 0)
+   {
+      benchmark("synthetic, " + std::to_string(synthetic) + " ms per run",
+                synthetic_runs(synthetic), options);
+      return 0;
+   }
+   if (programs.empty())
+      programs = real_world_programs();
+   if (programs.empty())
+   {
+      std::cerr << "no instrumented programs, run the tests first or pass --synthetic ms\n";
+      return 1;
+   }
+
+   const auto work_dir = fs::absolute("exploration_benchmark_work");
+   for (const auto& program : programs)
+   {
+      benchmark(program.string(), fork_server_runs(program, work_dir), options);
+      fs::remove_all(work_dir);
+   }
+   return 0;
+}
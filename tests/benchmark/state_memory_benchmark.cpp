@@ -0,0 +1,119 @@
+#include <task_pool.hpp>
+
+#include <execution.hpp>
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------
+/// @file state_memory_benchmark.cpp
+/// @brief Measures the memory an Execution of States created by TaskPool::program_state takes.
+/// @details Usage: StateMemoryBenchmark [steps] [threads...]. For every number of threads
+/// (by default 2, 8, 32 and 128) the threads take turns executing a store and posting the
+/// next one for the given number of steps (by default 1000000), and the bytes allocated for the
+/// Execution are reported in total and per step, and without the Transitions themselves.
+//--------------------------------------------------------------------------------------------------
+
+
+namespace {
+
+std::atomic<std::size_t> allocated{0};
+
+/// @brief Room in front of every allocation for its size, keeping the alignment of malloc.
+constexpr std::size_t header_size = 16;
+
+} // end namespace
+
+//--------------------------------------------------------------------------------------------------
+
+void* operator new(std::size_t size)
+{
+   auto* block = static_cast<char*>(std::malloc(size + header_size));
+   if (!block)
+      throw std::bad_alloc();
+   *reinterpret_cast<std::size_t*>(block) = size;
+   allocated += size;
+   return block + header_size;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void operator delete(void* pointer) noexcept
+{
+   if (!pointer)
+      return;
+   auto* block = static_cast<char*>(pointer) - header_size;
+   allocated -= *reinterpret_cast<std::size_t*>(block);
+   std::free(block);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+   operator delete(pointer);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+namespace {
+
+void measure(const std::size_t steps, const program_model::Thread::tid_t nr_threads)
+{
+   using namespace program_model;
+
+   std::vector<int> variables(64);
+   const auto store = [&variables](const Thread::tid_t tid, const std::size_t step) {
+      return visible_instruction_t(memory_instruction(
+         tid, memory_operation::Store, Object(&variables[(step / 7) % variables.size()]), false,
+         {"state_memory_benchmark.cpp", static_cast<unsigned int>(step % 100)}));
+   };
+
+   scheduler::TaskPool pool;
+   for (Thread::tid_t tid = 0; tid < nr_threads; ++tid)
+   {
+      pool.register_thread(tid);
+      pool.post(tid, store(tid, 0));
+   }
+
+   const std::size_t before = allocated;
+   {
+      Execution E(pool.program_state());
+      for (std::size_t step = 1; step <= steps; ++step)
+      {
+         const Thread::tid_t tid = step % nr_threads;
+         const auto instr = pool.set_current(tid);
+         pool.yield(tid);
+         pool.post(tid, store(tid, step));
+         E.push_back(instr, pool.program_state());
+      }
+
+      const double bytes = static_cast<double>(allocated - before);
+      const double transition_bytes = static_cast<double>(steps * sizeof(Transition));
+      std::cout << nr_threads << " threads\t" << steps << " steps\t" << bytes / (1 << 20)
+                << " MB\t" << bytes / steps << " B/step\t" << (bytes - transition_bytes) / steps
+                << " B/step without the Transitions\n";
+   }
+}
+
+} // end namespace
+
+//--------------------------------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+   const std::size_t steps = argc > 1 ? std::stoul(argv[1]) : 1000000;
+   std::vector<program_model::Thread::tid_t> nr_threads{};
+   for (int i = 2; i < argc; ++i)
+      nr_threads.push_back(std::stoi(argv[i]));
+   if (nr_threads.empty())
+      nr_threads = {2, 8, 32, 128};
+
+   for (const auto n : nr_threads)
+      measure(steps, n);
+   return 0;
+}
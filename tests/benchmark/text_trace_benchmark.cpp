@@ -0,0 +1,110 @@
+
+#include <execution_io.hpp>
+#include <text_trace.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/preprocessor/stringize.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------
+/// @file text_trace_benchmark.cpp
+/// @brief Compares the load throughput of operator>>(std::istream&, Execution&) with that of
+/// load_text_execution and load_text_columns on all record.txt files under a directory.
+/// @details Usage: TextTraceBenchmark [directory] [repetitions]. The directory defaults to the
+/// test data directory, where the tests of the real-world test programs leave their records.
+/// The loaders take turns in every repetition and each is reported with its fastest one, so
+/// that other load on the machine affects them alike.
+//--------------------------------------------------------------------------------------------------
+
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+/// @brief Loads all files once and keeps the time if it is the fastest so far.
+
+template <typename Function>
+void time_pass(const std::vector<std::string>& files, double& fastest, Function&& load)
+{
+   const auto start = clock_type::now();
+   for (const auto& file : files)
+      load(file);
+   fastest = std::min(fastest, std::chrono::duration<double>(clock_type::now() - start).count());
+}
+
+void report(const std::string& loader, const double time, const double megabytes,
+            const double baseline)
+{
+   std::cout << loader << "\t" << time << " s\t" << megabytes / time << " MB/s\t"
+             << baseline / time << "x\n";
+}
+
+} // end namespace
+
+//--------------------------------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+   using namespace program_model;
+   namespace fs = boost::filesystem;
+
+   const fs::path directory =
+      argc > 1 ? fs::path(argv[1]) : fs::path(BOOST_PP_STRINGIZE(TESTS_BUILD_DIR)) / "test_data";
+   const unsigned repetitions = argc > 2 ? std::stoul(argv[2]) : 5;
+
+   std::vector<std::string> files;
+   std::uintmax_t bytes = 0;
+   for (fs::recursive_directory_iterator it(directory), end; it != end; ++it)
+   {
+      if (fs::is_regular_file(it->path()) && it->path().filename() == "record.txt")
+      {
+         files.push_back(it->path().string());
+         bytes += fs::file_size(it->path());
+      }
+   }
+   if (files.empty())
+   {
+      std::cerr << "no record.txt files under " << directory << "\n";
+      return 1;
+   }
+
+   for (const auto& file : files)
+   {
+      Execution expected{};
+      std::ifstream input(file);
+      input >> expected;
+      if (!(expected == load_text_execution(file)))
+      {
+         std::cerr << "load_text_execution differs from operator>> on " << file << "\n";
+         return 1;
+      }
+   }
+
+   const double megabytes = static_cast<double>(bytes) / (1 << 20);
+   std::cout << files.size() << " records, " << bytes << " bytes, " << repetitions
+             << " repetitions\n";
+
+   auto istream_time = std::numeric_limits<double>::max();
+   auto execution_time = istream_time;
+   auto columns_time = istream_time;
+   for (unsigned i = 0; i < repetitions; ++i)
+   {
+      time_pass(files, istream_time, [](const auto& file) {
+         Execution E{};
+         std::ifstream input(file);
+         input >> E;
+      });
+      time_pass(files, execution_time, [](const auto& file) { load_text_execution(file); });
+      time_pass(files, columns_time, [](const auto& file) { load_text_columns(file); });
+   }
+   report("operator>>", istream_time, megabytes, istream_time);
+   report("load_text_execution", execution_time, megabytes, istream_time);
+   report("load_text_columns", columns_time, megabytes, istream_time);
+   return 0;
+}
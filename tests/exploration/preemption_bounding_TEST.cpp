@@ -0,0 +1,202 @@
+#include "test_program.hpp"
+
+#include <preemption_bounding.hpp>
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+namespace exploration {
+namespace test {
+
+//--------------------------------------------------------------------------------------------------
+
+class PreemptionBoundingTest : public ::testing::Test
+{
+protected:
+   int x = 0;
+   int y = 0;
+   int m = 0;
+
+   struct result_t
+   {
+      std::vector<bound_statistics_t> statistics;
+      std::set<std::string> traces;
+      std::set<std::string> schedules;
+      /// @brief The visited States, see visits.
+      std::set<std::string> visited;
+      unsigned int nr_executions;
+   };
+
+   /// @brief The fingerprints of the States of E: the positions of the threads in their
+   /// programs, which determine the pending instructions, the statuses and the lock owners.
+
+   static std::vector<scheduler::fingerprint_t> states(const program_model::Execution& E)
+   {
+      std::vector<scheduler::fingerprint_t> fingerprints;
+      std::map<tid_t, unsigned int> positions;
+      const auto fingerprint = [&positions] {
+         scheduler::fingerprint_t fingerprint = 0;
+         for (const auto& position : positions)
+            fingerprint = fingerprint * 1000003 + position.first * 1009 + position.second;
+         return fingerprint;
+      };
+      fingerprints.push_back(fingerprint());
+      for (const auto& transition : E)
+      {
+         ++positions[boost::apply_visitor(program_model::get_tid(), transition.instr())];
+         fingerprints.push_back(fingerprint());
+      }
+      return fingerprints;
+   }
+
+   /// @brief The States of E, each with the thread of the step before it.
+
+   static std::set<std::string> visits(const program_model::Execution& E)
+   {
+      std::set<std::string> result;
+      const auto fingerprints = states(E);
+      for (std::size_t step = 0; step < E.size(); ++step)
+      {
+         const auto previous =
+            step == 0 ? -1 : boost::apply_visitor(program_model::get_tid(), E[step].instr());
+         result.insert(std::to_string(fingerprints[step]) + "/" + std::to_string(previous));
+      }
+      return result;
+   }
+
+   static result_t explore(const program_t& program, const unsigned int max_preemptions)
+   {
+      result_t result{{}, {}, {}, {}, 0};
+      result.statistics = explore_preemption_bounded(
+         [&program](const auto& schedule) { return run(program, schedule); }, max_preemptions,
+         [&result](const auto& E) {
+            std::stringstream schedule;
+            schedule << scheduler::schedule(E);
+            result.schedules.insert(schedule.str());
+            result.traces.insert(trace(E));
+            const auto visited = visits(E);
+            result.visited.insert(visited.begin(), visited.end());
+            ++result.nr_executions;
+            return true;
+         });
+      return result;
+   }
+
+   /// @brief As explore, with the States of the runs, collecting the visited States.
+
+   static result_t explore_stateful(const program_t& program,
+                                    const unsigned int max_preemptions)
+   {
+      result_t result{{}, {}, {}, {}, 0};
+      result.statistics = explore_preemption_bounded(
+         [&program](const auto& schedule) {
+            auto E = run(program, schedule);
+            auto fingerprints = states(E);
+            return recorded_run_t{std::move(E), std::move(fingerprints)};
+         },
+         max_preemptions,
+         [&result](const auto& E) {
+            const auto visited = visits(E);
+            result.visited.insert(visited.begin(), visited.end());
+            ++result.nr_executions;
+            return true;
+         });
+      return result;
+   }
+};
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(PreemptionBoundingTest, CountsSchedulesPerBound)
+{
+   // 0011 and 1100; 0110 and 1001; 0101 and 1010
+   const auto result = explore({{store(0, x), store(0, x)}, {store(1, x), store(1, x)}}, 2);
+   ASSERT_EQ(3u, result.statistics.size());
+   for (const auto& bound : result.statistics)
+   {
+      EXPECT_EQ(2u, bound.nr_executions);
+      EXPECT_TRUE(bound.complete);
+   }
+   EXPECT_EQ(6u, result.schedules.size());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(PreemptionBoundingTest, BoundsThePreemptions)
+{
+   const auto result = explore({{store(0, x), store(0, x)}, {store(1, x), store(1, x)}}, 0);
+   ASSERT_EQ(1u, result.statistics.size());
+   EXPECT_EQ(2u, result.nr_executions);
+   EXPECT_TRUE(result.statistics[0].complete);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(PreemptionBoundingTest, SwitchingFromABlockedThreadIsFree)
+{
+   // Thread 1 cannot enter the critical section while thread 0 is in it
+   const auto result = explore({{lock(0, m), store(0, x), unlock(0, m)},
+                                {lock(1, m), store(1, x), unlock(1, m)}},
+                               0);
+   EXPECT_EQ(2u, result.nr_executions);
+   EXPECT_EQ(2u, result.traces.size());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(PreemptionBoundingTest, CoversEveryInterleavingWithoutBound)
+{
+   const program_t program{{store(0, x), load(0, y)}, {store(1, y), load(1, x)}, {load(2, x)}};
+   const auto result = explore(program, 5);
+   // 5! / (2! * 2! * 1!) = 30 interleavings
+   EXPECT_EQ(30u, result.nr_executions);
+   EXPECT_EQ(30u, result.schedules.size());
+   EXPECT_EQ(all_traces(program), result.traces);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(PreemptionBoundingTest, PrunesVisitedStates)
+{
+   int z = 0;
+   const program_t program{{store(0, x), store(0, x), store(0, x)},
+                           {store(1, y), store(1, y), store(1, y)},
+                           {store(2, z), store(2, z)}};
+   const auto stateless = explore(program, 2);
+   const auto stateful = explore_stateful(program, 2);
+   EXPECT_LT(stateful.nr_executions, stateless.nr_executions);
+   std::size_t nr_pruned = 0;
+   for (const auto& bound : stateful.statistics)
+   {
+      EXPECT_TRUE(bound.complete);
+      nr_pruned += bound.nr_pruned;
+   }
+   EXPECT_LT(0u, nr_pruned);
+
+   // Every State is reached with every previous thread it is reached with without pruning
+   EXPECT_EQ(stateless.visited, stateful.visited);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(PreemptionBoundingTest, StopsWhenAsked)
+{
+   const auto statistics = explore_preemption_bounded(
+      [this](const auto& schedule) {
+         return run({{store(0, x), store(0, x)}, {store(1, x), store(1, x)}}, schedule);
+      },
+      2, [](const auto&) { return false; });
+   EXPECT_EQ(1u, statistics[0].nr_executions);
+   EXPECT_FALSE(statistics[0].complete);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+} // end namespace test
+} // end namespace exploration
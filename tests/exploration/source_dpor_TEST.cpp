@@ -0,0 +1,153 @@
+#include "test_program.hpp"
+
+#include <source_dpor.hpp>
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <set>
+#include <string>
+
+
+namespace exploration {
+namespace test {
+
+//--------------------------------------------------------------------------------------------------
+
+class SourceDporTest : public ::testing::Test
+{
+protected:
+   int x = 0;
+   int y = 0;
+   int m = 0;
+   int n = 0;
+
+   struct result_t
+   {
+      statistics_t statistics;
+      /// @brief The traces of the complete Executions, with their number.
+      std::map<std::string, unsigned int> traces;
+      unsigned int nr_deadlocks;
+   };
+
+   static result_t explore(const program_t& program)
+   {
+      std::size_t nr_steps = 0;
+      for (const auto& thread : program)
+         nr_steps += thread.size();
+
+      result_t result{{}, {}, 0};
+      result.statistics = exploration::explore(
+         [&program](const auto& schedule) { return run(program, schedule); },
+         [&result, nr_steps](const auto& E) {
+            if (E.status() == program_model::Execution::Status::DEADLOCK)
+               ++result.nr_deadlocks;
+            else if (E.size() == nr_steps)
+               ++result.traces[trace(E)];
+            return true;
+         });
+      return result;
+   }
+};
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(SourceDporTest, IndependentThreadsNeedOneExecution)
+{
+   // 9! / (3! * 3! * 3!) = 1680 interleavings
+   int z = 0;
+   const auto result = explore({{store(0, x), load(0, x), store(0, x)},
+                                {store(1, y), load(1, y), store(1, y)},
+                                {store(2, z), load(2, z), store(2, z)}});
+   EXPECT_EQ(1u, result.statistics.nr_executions);
+   EXPECT_EQ(1u, result.traces.size());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(SourceDporTest, ReversesARace)
+{
+   const auto result = explore({{store(0, x)}, {store(1, x)}});
+   EXPECT_EQ(2u, result.statistics.nr_executions);
+   EXPECT_EQ(2u, result.traces.size());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(SourceDporTest, ReadsCommute)
+{
+   // Each read is before or after the write
+   const auto result = explore({{store(0, x)}, {load(1, x)}, {load(2, x)}});
+   EXPECT_EQ(4u, result.traces.size());
+   for (const auto& trace : result.traces)
+      EXPECT_EQ(1u, trace.second) << trace.first;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(SourceDporTest, StoreBuffering)
+{
+   // Not both loads can read the initial values
+   const auto result =
+      explore({{store(0, x), load(0, y)}, {store(1, y), load(1, x)}});
+   EXPECT_EQ(3u, result.traces.size());
+   for (const auto& trace : result.traces)
+      EXPECT_EQ(1u, trace.second) << trace.first;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(SourceDporTest, EveryTraceOnce)
+{
+   const program_t program{{store(0, x), load(0, y), store(0, y)},
+                           {load(1, x), store(1, y)},
+                           {load(2, y), store(2, x)}};
+   const auto result = explore(program);
+   std::set<std::string> traces;
+   for (const auto& trace : result.traces)
+      traces.insert(trace.first);
+   EXPECT_EQ(all_traces(program), traces);
+   for (const auto& trace : result.traces)
+      EXPECT_EQ(1u, trace.second) << trace.first;
+   EXPECT_EQ(result.statistics.nr_executions,
+             result.traces.size() + result.statistics.nr_redundant);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(SourceDporTest, CriticalSections)
+{
+   const auto result = explore({{lock(0, m), store(0, x), unlock(0, m)},
+                                {lock(1, m), store(1, x), unlock(1, m)}});
+   EXPECT_EQ(2u, result.traces.size());
+   EXPECT_EQ(0u, result.nr_deadlocks);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(SourceDporTest, FindsADeadlock)
+{
+   const auto result = explore({{lock(0, m), lock(0, n), unlock(0, n), unlock(0, m)},
+                                {lock(1, n), lock(1, m), unlock(1, m), unlock(1, n)}});
+   EXPECT_EQ(1u, result.nr_deadlocks);
+   EXPECT_EQ(2u, result.traces.size());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(SourceDporTest, RejectsADivergedRun)
+{
+   source_dpor dpor;
+   ASSERT_TRUE(dpor.next_schedule());
+   EXPECT_THROW(dpor.next_schedule(), std::logic_error);
+   dpor.add_execution(run({{store(0, x)}, {store(1, x)}}, {}));
+   const auto schedule = dpor.next_schedule();
+   ASSERT_TRUE(schedule);
+   EXPECT_THROW(dpor.add_execution(run({{store(0, x)}, {store(1, x)}}, {})),
+                std::invalid_argument);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+} // end namespace test
+} // end namespace exploration
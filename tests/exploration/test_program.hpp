@@ -0,0 +1,188 @@
+#pragma once
+
+#include <schedule.hpp>
+
+#include <execution.hpp>
+#include <state.hpp>
+#include <visible_instruction.hpp>
+
+#include <functional>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------
+/// @file test_program.hpp
+/// @brief An interpreter of programs of straight-line threads that exist from the start, for
+/// testing explorations without instrumenting a program.
+/// @author Susanne van den Elsen
+/// @date 2015-2017
+//--------------------------------------------------------------------------------------------------
+
+
+namespace exploration {
+namespace test {
+
+using tid_t = program_model::Thread::tid_t;
+using program_t = std::vector<std::vector<program_model::visible_instruction_t>>;
+
+//--------------------------------------------------------------------------------------------------
+
+inline program_model::memory_instruction load(const tid_t tid, int& var)
+{
+   using namespace program_model;
+   return memory_instruction(tid, memory_operation::Load, Object(&var), false);
+}
+
+inline program_model::memory_instruction store(const tid_t tid, int& var)
+{
+   using namespace program_model;
+   return memory_instruction(tid, memory_operation::Store, Object(&var), false);
+}
+
+inline program_model::lock_instruction lock(const tid_t tid, int& mutex)
+{
+   using namespace program_model;
+   return lock_instruction(tid, lock_operation::Lock, Object(&mutex));
+}
+
+inline program_model::lock_instruction unlock(const tid_t tid, int& mutex)
+{
+   using namespace program_model;
+   return lock_instruction(tid, lock_operation::Unlock, Object(&mutex));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief Runs program under schedule, after which the thread of the previous step runs on
+/// while it is enabled, as under the NonPreemptive strategy.
+
+inline program_model::Execution run(const program_t& program,
+                                    const scheduler::schedule_t& schedule)
+{
+   using namespace program_model;
+
+   std::vector<std::size_t> positions(program.size(), 0);
+   std::set<void*> locked;
+   const auto state = [&program, &positions, &locked] {
+      Tids enabled;
+      NextSet next;
+      for (std::size_t tid = 0; tid < program.size(); ++tid)
+      {
+         if (positions[tid] == program[tid].size())
+            continue;
+         const auto& instr = program[tid][positions[tid]];
+         const auto* lock_instr = boost::get<lock_instruction>(&instr);
+         const bool is_enabled = !lock_instr ||
+                                 lock_instr->operation() == lock_operation::Unlock ||
+                                 !locked.count(lock_instr->operand().address());
+         next.set(tid, {instr, is_enabled});
+         if (is_enabled)
+            enabled.insert(tid);
+      }
+      return std::make_shared<State>(enabled, next);
+   };
+
+   Execution E(state());
+   boost::optional<tid_t> current;
+   while (!E.final().enabled().empty())
+   {
+      const auto& enabled = E.final().enabled();
+      if (E.size() < schedule.size())
+         current = schedule.at(E.size());
+      else if (!current || !enabled.count(*current))
+         current = *enabled.begin();
+      const auto instr = program[*current][positions[*current]++];
+      if (const auto* lock_instr = boost::get<lock_instruction>(&instr))
+      {
+         if (lock_instr->operation() == lock_operation::Lock)
+            locked.insert(lock_instr->operand().address());
+         else
+            locked.erase(lock_instr->operand().address());
+      }
+      E.push_back(instr, state());
+   }
+   E.set_status(E.final().next_set().empty() ? Execution::Status::DONE
+                                             : Execution::Status::DEADLOCK);
+   return E;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief Identifies the trace of E: per object, the order of its conflicting accesses.
+
+inline std::string trace(const program_model::Execution& E)
+{
+   using namespace program_model;
+
+   // Per object, groups of accesses of which consecutive reads form one group
+   std::map<void*, std::vector<std::multiset<std::string>>> accesses;
+   std::map<tid_t, unsigned int> positions;
+   for (const auto& transition : E)
+   {
+      const auto& instr = transition.instr();
+      const auto tid = boost::apply_visitor(get_tid(), instr);
+      const auto operand = boost::get<Object>(boost::apply_visitor(get_operand(), instr));
+      const auto* memory_instr = boost::get<memory_instruction>(&instr);
+      const bool is_read = memory_instr && memory_instr->operation() == memory_operation::Load;
+      auto& groups = accesses[operand.address()];
+      if (!is_read || groups.empty() || groups.back().begin()->front() != 'r')
+         groups.emplace_back();
+      groups.back().insert((is_read ? "r" : "w") + std::to_string(tid) + "." +
+                           std::to_string(positions[tid]++));
+   }
+   std::stringstream key;
+   for (const auto& object : accesses)
+   {
+      for (const auto& group : object.second)
+      {
+         for (const auto& access : group)
+            key << access << " ";
+         key << "| ";
+      }
+      key << "\n";
+   }
+   return key.str();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief The traces of all interleavings of program, which may not use locks.
+
+inline std::set<std::string> all_traces(const program_t& program)
+{
+   std::set<std::string> traces;
+   std::vector<std::size_t> remaining;
+   for (const auto& thread : program)
+      remaining.push_back(thread.size());
+   std::vector<tid_t> tids;
+   std::function<void()> interleave = [&] {
+      bool complete = true;
+      for (std::size_t tid = 0; tid < remaining.size(); ++tid)
+      {
+         if (remaining[tid] == 0)
+            continue;
+         complete = false;
+         --remaining[tid];
+         tids.push_back(static_cast<tid_t>(tid));
+         interleave();
+         tids.pop_back();
+         ++remaining[tid];
+      }
+      if (!complete)
+         return;
+      scheduler::schedule_t schedule;
+      for (const auto tid : tids)
+         schedule.push_back(tid);
+      traces.insert(trace(run(program, schedule)));
+   };
+   interleave();
+   return traces;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+} // end namespace test
+} // end namespace exploration
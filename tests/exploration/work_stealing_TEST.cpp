@@ -0,0 +1,160 @@
+#include "test_program.hpp"
+
+#include <work_stealing.hpp>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <mutex>
+#include <numeric>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+
+namespace exploration {
+namespace test {
+
+//--------------------------------------------------------------------------------------------------
+
+class WorkStealingTest : public ::testing::Test
+{
+protected:
+   int x = 0;
+   int y = 0;
+
+   static std::string to_string(const scheduler::schedule_t& schedule)
+   {
+      std::stringstream stream;
+      stream << schedule;
+      return stream.str();
+   }
+};
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(WorkStealingTest, FrontierTakesOwnPrefixesLastFirstAndStealsFirstFirst)
+{
+   work_stealing_frontier frontier(2);
+   frontier.push(0, {0});
+   frontier.push(0, {1});
+   frontier.push(0, {2});
+
+   EXPECT_EQ(scheduler::schedule_t({2}), *frontier.pop(0));
+   EXPECT_EQ(scheduler::schedule_t({0}), *frontier.pop(1));
+   EXPECT_EQ(1u, frontier.nr_steals());
+   EXPECT_EQ(scheduler::schedule_t({1}), *frontier.pop(1));
+   for (int i = 0; i < 3; ++i)
+      frontier.done();
+
+   EXPECT_FALSE(frontier.pop(0));
+   EXPECT_FALSE(frontier.pop(1));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(WorkStealingTest, IdleWorkerWaitsForPrefixesOfOthers)
+{
+   work_stealing_frontier frontier(2);
+   frontier.push(0, {0});
+   ASSERT_TRUE(frontier.pop(0));
+
+   std::thread thief([&frontier] {
+      const auto stolen = frontier.pop(1);
+      ASSERT_TRUE(stolen);
+      EXPECT_EQ(scheduler::schedule_t({0, 1}), *stolen);
+      frontier.done();
+      EXPECT_FALSE(frontier.pop(1));
+   });
+   std::this_thread::sleep_for(std::chrono::milliseconds(10));
+   frontier.push(0, {0, 1});
+   frontier.done();
+   thief.join();
+   EXPECT_FALSE(frontier.pop(0));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(WorkStealingTest, RunsTheSchedulesOfTheSequentialExploration)
+{
+   int z = 0;
+   const program_t program{{store(0, x), load(0, y)}, {store(1, y), load(1, x)}, {store(2, z)}};
+   const unsigned int max_preemptions = 2;
+
+   std::set<std::string> sequential;
+   const auto sequential_statistics = explore_preemption_bounded(
+      [&program](const auto& schedule) { return run(program, schedule); }, max_preemptions,
+      [&sequential](const auto& E) {
+         sequential.insert(to_string(scheduler::schedule(E)));
+         return true;
+      });
+
+   std::multiset<std::string> parallel;
+   const auto statistics = explore_preemption_bounded(
+      4,
+      [&program](const unsigned int, const auto& schedule) {
+         // Long enough for the other workers to steal
+         std::this_thread::sleep_for(std::chrono::milliseconds(1));
+         return run(program, schedule);
+      },
+      max_preemptions,
+      [&parallel](const unsigned int, const auto& E) {
+         parallel.insert(to_string(scheduler::schedule(E)));
+         return true;
+      });
+
+   EXPECT_EQ(sequential, std::set<std::string>(parallel.begin(), parallel.end()));
+   EXPECT_EQ(sequential.size(), parallel.size());
+   ASSERT_EQ(sequential_statistics.size(), statistics.bounds.size());
+   for (std::size_t bound = 0; bound < statistics.bounds.size(); ++bound)
+   {
+      EXPECT_EQ(sequential_statistics[bound].nr_executions,
+                statistics.bounds[bound].nr_executions);
+      EXPECT_TRUE(statistics.bounds[bound].complete);
+   }
+   EXPECT_EQ(parallel.size(), std::accumulate(statistics.nr_executions.begin(),
+                                              statistics.nr_executions.end(), std::size_t(0)));
+   EXPECT_LT(0u, statistics.nr_steals);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(WorkStealingTest, StopsWhenAsked)
+{
+   const program_t program{{store(0, x), store(0, x)}, {store(1, x), store(1, x)}};
+   const auto statistics = explore_preemption_bounded(
+      2, [&program](const unsigned int, const auto& schedule) { return run(program, schedule); },
+      2, [](const unsigned int, const auto&) { return false; });
+   // The run of the other worker may have started before the first run ended
+   EXPECT_GE(2u, statistics.bounds[0].nr_executions);
+   EXPECT_FALSE(statistics.bounds[0].complete);
+   EXPECT_EQ(0u, statistics.bounds[1].nr_executions);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(WorkStealingTest, RethrowsTheErrorOfAWorker)
+{
+   const program_t program{{store(0, x), store(0, x)}, {store(1, x), store(1, x)}};
+   std::mutex mutex;
+   unsigned int nr_runs = 0;
+   EXPECT_THROW(explore_preemption_bounded(
+                   3,
+                   [&](const unsigned int, const auto& schedule) {
+                      {
+                         std::lock_guard<std::mutex> lock(mutex);
+                         if (++nr_runs == 3)
+                            throw std::runtime_error("run failed");
+                      }
+                      return run(program, schedule);
+                   },
+                   2, [](const unsigned int, const auto&) { return true; }),
+                std::runtime_error);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+} // end namespace test
+} // end namespace exploration
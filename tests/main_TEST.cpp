@@ -1,7 +1,20 @@
 
 #include "instrumentation_TEST.cpp"
 #include "scheduler_TEST.cpp"
+#include <execution_diff_TEST.cpp>
 #include <execution_io_TEST.cpp>
+#include <native_recorder_TEST.cpp>
+#include <next_set_TEST.cpp>
+#include <partial_order_TEST.cpp>
+#include <pct_TEST.cpp>
+#include <preemption_bounding_TEST.cpp>
+#include <recorder_TEST.cpp>
+#include <schedule_TEST.cpp>
+#include <source_dpor_TEST.cpp>
+#include <scheduler_settings_TEST.cpp>
+#include <shared_channel_TEST.cpp>
+#include <task_pool_TEST.cpp>
+#include <work_stealing_TEST.cpp>
 
 #include <gtest/gtest.h>
 
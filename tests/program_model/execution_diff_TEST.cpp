@@ -0,0 +1,169 @@
+#include <binary_trace.hpp>
+#include <execution_diff.hpp>
+#include <execution_io.hpp>
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <sstream>
+
+
+namespace program_model {
+namespace test {
+
+class ExecutionDiffTest : public ::testing::Test
+{
+protected:
+   int var_1 = 0;
+   int var_2 = 0;
+
+   memory_instruction store(const Thread::tid_t tid, int& var, const unsigned int line)
+   {
+      return memory_instruction{tid, memory_operation::Store, Object(&var), false,
+                                {"test_file", line}};
+   }
+
+   /// @brief An Execution of threads 0 and 1 executing the given instructions.
+
+   Execution execution(const std::vector<visible_instruction_t>& instructions)
+   {
+      const auto state = std::make_shared<State>(Tids{0, 1}, NextSet{});
+      Execution E{state};
+      for (const auto& instr : instructions)
+         E.push_back(instr, state);
+      E.set_status(Execution::Status::DONE);
+      return E;
+   }
+
+   void write_text(const std::string& file_name, const Execution& E)
+   {
+      std::ofstream output_file(file_name);
+      output_file << E;
+   }
+};
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(ExecutionDiffTest, EqualAcrossFormats)
+{
+   const auto E = execution({store(0, var_1, 1), store(1, var_2, 2), store(0, var_1, 3)});
+   write_text("execution_diff_TEST_lhs.txt", E);
+   {
+      std::ofstream output_file("execution_diff_TEST_rhs.bin", std::ios::binary);
+      write_binary(output_file, E);
+   }
+   EXPECT_FALSE(first_divergence("execution_diff_TEST_lhs.txt", "execution_diff_TEST_rhs.bin"));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(ExecutionDiffTest, ShiftedInterleaving)
+{
+   write_text("execution_diff_TEST_lhs.txt",
+              execution({store(0, var_1, 1), store(1, var_2, 2), store(0, var_1, 3)}));
+   write_text("execution_diff_TEST_rhs.txt",
+              execution({store(1, var_2, 2), store(0, var_1, 1), store(0, var_1, 3)}));
+
+   const auto divergence =
+      first_divergence("execution_diff_TEST_lhs.txt", "execution_diff_TEST_rhs.txt");
+   ASSERT_TRUE(divergence);
+   EXPECT_EQ(divergence_t::kind::instruction, divergence->what);
+   EXPECT_EQ(1u, divergence->lhs.step);
+   EXPECT_EQ(1u, divergence->rhs.step);
+   EXPECT_FALSE(divergence->tid);
+
+   EXPECT_FALSE(first_divergence("execution_diff_TEST_lhs.txt", "execution_diff_TEST_rhs.txt",
+                                 alignment::per_thread));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(ExecutionDiffTest, PerThreadDivergence)
+{
+   write_text("execution_diff_TEST_lhs.txt",
+              execution({store(0, var_1, 1), store(1, var_2, 2), store(0, var_1, 3),
+                         store(1, var_2, 4)}));
+   write_text("execution_diff_TEST_rhs.txt",
+              execution({store(1, var_2, 2), store(1, var_2, 5), store(0, var_1, 1),
+                         store(0, var_1, 3)}));
+
+   const auto divergence = first_divergence(
+      "execution_diff_TEST_lhs.txt", "execution_diff_TEST_rhs.txt", alignment::per_thread);
+   ASSERT_TRUE(divergence);
+   EXPECT_EQ(divergence_t::kind::instruction, divergence->what);
+   ASSERT_TRUE(divergence->tid);
+   EXPECT_EQ(1, *divergence->tid);
+   EXPECT_EQ(4u, divergence->lhs.step);
+   EXPECT_EQ(2u, divergence->rhs.step);
+   ASSERT_EQ(1u, divergence->context.count(1));
+   EXPECT_EQ(1u, divergence->context.at(1).nr_steps);
+   EXPECT_EQ(1u, divergence->context.at(0).nr_steps);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(ExecutionDiffTest, LengthAndState)
+{
+   const auto E = execution({store(0, var_1, 1), store(1, var_2, 2)});
+   write_text("execution_diff_TEST_lhs.txt", E);
+   auto E_longer = E;
+   E_longer.push_back(store(0, var_1, 3), std::make_shared<State>(Tids{1}, NextSet{}));
+   write_text("execution_diff_TEST_rhs.txt", E_longer);
+
+   auto divergence =
+      first_divergence("execution_diff_TEST_lhs.txt", "execution_diff_TEST_rhs.txt");
+   ASSERT_TRUE(divergence);
+   EXPECT_EQ(divergence_t::kind::length, divergence->what);
+   EXPECT_EQ(3u, divergence->lhs.step);
+   ASSERT_TRUE(divergence->lhs.status);
+   EXPECT_EQ(Execution::Status::DONE, *divergence->lhs.status);
+   EXPECT_EQ(3u, divergence->rhs.step);
+
+   auto E_other_state = execution({store(0, var_1, 1)});
+   E_other_state.push_back(store(1, var_2, 2), std::make_shared<State>(Tids{1}, NextSet{}));
+   write_text("execution_diff_TEST_rhs.txt", E_other_state);
+   divergence = first_divergence("execution_diff_TEST_lhs.txt", "execution_diff_TEST_rhs.txt");
+   ASSERT_TRUE(divergence);
+   EXPECT_EQ(divergence_t::kind::state, divergence->what);
+   EXPECT_EQ(2u, divergence->lhs.step);
+   EXPECT_EQ(std::vector<Thread::tid_t>{0}, divergence->differing_threads);
+
+   std::stringstream report;
+   report << *divergence;
+   EXPECT_NE(std::string::npos, report.str().find("differing threads"));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(ExecutionDiffTest, ObjectsMatchByFirstUse)
+{
+   // The same program in another process, where the variables have other addresses
+   int var_3 = 0;
+   int var_4 = 0;
+   write_text("execution_diff_TEST_lhs.txt",
+              execution({store(0, var_1, 1), store(1, var_2, 2), store(0, var_1, 3)}));
+   write_text("execution_diff_TEST_rhs.txt",
+              execution({store(0, var_3, 1), store(1, var_4, 2), store(0, var_3, 3)}));
+   EXPECT_FALSE(first_divergence("execution_diff_TEST_lhs.txt", "execution_diff_TEST_rhs.txt"));
+   EXPECT_FALSE(first_divergence("execution_diff_TEST_lhs.txt", "execution_diff_TEST_rhs.txt",
+                                 alignment::per_thread));
+
+   auto divergence = first_divergence("execution_diff_TEST_lhs.txt", "execution_diff_TEST_rhs.txt",
+                                      alignment::global, objects::by_address);
+   ASSERT_TRUE(divergence);
+   EXPECT_EQ(divergence_t::kind::instruction, divergence->what);
+   EXPECT_EQ(1u, divergence->lhs.step);
+
+   // Thread 0 stores to the variable of thread 1
+   write_text("execution_diff_TEST_rhs.txt",
+              execution({store(0, var_3, 1), store(1, var_4, 2), store(0, var_4, 3)}));
+   divergence = first_divergence("execution_diff_TEST_lhs.txt", "execution_diff_TEST_rhs.txt");
+   ASSERT_TRUE(divergence);
+   EXPECT_EQ(divergence_t::kind::instruction, divergence->what);
+   EXPECT_EQ(3u, divergence->lhs.step);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+} // end namespace test
+} // end namespace program_model
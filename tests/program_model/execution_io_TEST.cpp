@@ -1,21 +1,71 @@
 
+#include <binary_trace.hpp>
 #include <execution_io.hpp>
+#include <text_trace.hpp>
 
 #include <gtest/gtest.h>
 
 #include <fstream>
+#include <sstream>
 
 
 namespace program_model {
 namespace test {
 
-TEST(ExecutionRoundtripTest, ExecutionRoundTrip)
+//--------------------------------------------------------------------------------------------------
+
+namespace {
+
+/// @brief The position of the n-th State (counting from 0) in the text of an Execution.
+
+std::size_t state_position(const std::string& text, const unsigned n)
+{
+   auto position = text.find("State");
+   for (unsigned i = 0; i < n; ++i)
+      position = text.find("State", position + 1);
+   return position;
+}
+
+/// @brief Writes text to file_name and expects the text loaders to read it as operator>> does.
+/// @returns What operator>> reads.
+
+Execution expect_loaded_as_by_operator(const std::string& text, const std::string& file_name)
+{
+   {
+      std::ofstream output_file(file_name);
+      output_file << text;
+   }
+   Execution expected{};
+   std::ifstream input_file(file_name);
+   input_file >> expected;
+
+   EXPECT_TRUE(expected == load_text_execution(file_name));
+   const auto columns = load_text_columns(file_name);
+   EXPECT_EQ(expected.size(), columns.size());
+   EXPECT_EQ(expected.status(), columns.status);
+   return expected;
+}
+
+} // end namespace
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief Builds the Execution that the round trips write and read back.
+
+class ExecutionRoundtripTest : public ::testing::Test
 {
+protected:
    int var_1 = 0;
-   std::atomic<int> var_2;
-   var_2.store(0);
+   std::atomic<int> var_2{0};
    std::mutex mut_1;
-   
+
+   Execution execution_write();
+};
+
+//--------------------------------------------------------------------------------------------------
+
+Execution ExecutionRoundtripTest::execution_write()
+{
    // state_0
    NextSet next_0 = {
       {0, next_t{thread_management_instruction{0, thread_management_operation::Spawn, Thread(1), {"test_file", 1}}, true}},
@@ -81,7 +131,15 @@ TEST(ExecutionRoundtripTest, ExecutionRoundTrip)
    execution_write.push_back(next_5[1].instr, state_6); // lock
    execution_write.push_back(next_6[1].instr, state_7); // unlock
    execution_write.push_back(next_7[0].instr, state_8); // join
-   
+   execution_write.set_status(Execution::Status::DONE);
+   return execution_write;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(ExecutionRoundtripTest, ExecutionRoundTrip)
+{
+   auto execution_write = this->execution_write();
    {
       std::ofstream output_file("execution_io_TEST.txt");
       output_file << execution_write;
@@ -97,5 +155,139 @@ TEST(ExecutionRoundtripTest, ExecutionRoundTrip)
 
 //--------------------------------------------------------------------------------------------------
 
+TEST_F(ExecutionRoundtripTest, BinaryRoundTrip)
+{
+   auto execution_write = this->execution_write();
+   {
+      std::ofstream output_file("execution_io_TEST.bin", std::ios::binary);
+      write_binary(output_file, execution_write);
+   }
+
+   const auto execution_read = read_binary("execution_io_TEST.bin");
+   ASSERT_TRUE(execution_write == execution_read);
+
+   const binary_trace trace("execution_io_TEST.bin");
+   ASSERT_EQ(execution_write.size(), trace.size());
+   auto cursor = trace.begin();
+   while (cursor.next())
+   {
+      const auto& transition = execution_write[cursor.index()];
+      EXPECT_TRUE(transition.instr() == trace.instruction(cursor.instr()));
+      for (std::size_t thread = 0; thread < cursor.nr_threads(); ++thread)
+      {
+         const auto tid = trace.threads()[thread];
+         EXPECT_EQ(transition.post().is_enabled(tid), cursor.is_enabled(thread));
+         EXPECT_EQ(transition.post().has_next(tid), cursor.next_instr(thread) != nullptr);
+      }
+   }
+   EXPECT_EQ(execution_write.size(), cursor.index());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(ExecutionRoundtripTest, BinaryRandomAccess)
+{
+   auto execution_write = this->execution_write();
+   {
+      std::ofstream output_file("execution_io_TEST.bin", std::ios::binary);
+      write_binary(output_file, execution_write, 3);
+   }
+
+   const binary_trace trace("execution_io_TEST.bin");
+   ASSERT_EQ(3u, trace.keyframe_interval());
+   ASSERT_TRUE(execution_write.s0() == *trace.state(trace.seek(0)));
+   for (std::size_t index = 1; index <= execution_write.size(); ++index)
+   {
+      const auto cursor = trace.seek(index);
+      EXPECT_EQ(index, cursor.index());
+      EXPECT_TRUE(execution_write[index].instr() == trace.instruction(cursor.instr()));
+      EXPECT_TRUE(execution_write[index].post() == *trace.state(cursor));
+      EXPECT_TRUE(execution_write[index] == trace.transition(index));
+   }
+
+   const auto window = trace.window(3, 4);
+   ASSERT_EQ(4u, window.size());
+   for (const auto& transition : window)
+      EXPECT_TRUE(execution_write[transition.index()] == transition);
+   EXPECT_EQ(2u, trace.window(7, 4).size());
+   EXPECT_THROW(trace.seek(execution_write.size() + 1), std::out_of_range);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(ExecutionRoundtripTest, TextLoaderRoundTrip)
+{
+   auto execution_write = this->execution_write();
+   {
+      std::ofstream output_file("execution_io_TEST.txt");
+      output_file << execution_write;
+   }
+
+   const auto execution_read = load_text_execution("execution_io_TEST.txt");
+   ASSERT_TRUE(execution_write == execution_read);
+
+   const auto columns = load_text_columns("execution_io_TEST.txt");
+   ASSERT_EQ(execution_write.size(), columns.size());
+   EXPECT_EQ(execution_write.status(), columns.status);
+   for (std::size_t index = 1; index <= columns.size(); ++index)
+   {
+      const auto& transition = execution_write[index];
+      EXPECT_EQ(boost::apply_visitor(program_model::get_tid(), transition.instr()),
+                columns.tid[index - 1]);
+      const auto& meta_data = boost::apply_visitor(program_model::get_meta_data(), transition.instr());
+      EXPECT_EQ(meta_data.file_name, columns.files[columns.file[index - 1]]);
+      EXPECT_EQ(meta_data.line_number, columns.line_number[index - 1]);
+      const Tids enabled(columns.enabled.begin() + columns.enabled_offsets[index],
+                         columns.enabled.begin() + columns.enabled_offsets[index + 1]);
+      EXPECT_EQ(transition.post().enabled(), enabled);
+   }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(ExecutionRoundtripTest, TextLoaderRejectsWhatOperatorRejects)
+{
+   auto execution_write = this->execution_write();
+   std::stringstream stream;
+   stream << execution_write;
+
+   // The enabled flag of an entry of the fourth State runs into the structure after it
+   auto glued_flag = stream.str();
+   const auto flag = glued_flag.find("enabled", state_position(glued_flag, 3));
+   glued_flag.erase(flag + 7, glued_flag.find_first_not_of(" \t", flag + 7) - flag - 7);
+   const auto execution_read = expect_loaded_as_by_operator(glued_flag, "execution_io_TEST.txt");
+   EXPECT_EQ(2u, execution_read.size());
+   EXPECT_EQ(Execution::Status::RUNNING, execution_read.status());
+
+   // The enabled set of the fourth State opens with another bracket
+   auto other_bracket = stream.str();
+   const auto open = other_bracket.find_first_not_of(" \t", state_position(other_bracket, 3) + 5);
+   other_bracket[open] = other_bracket[open] == '{' ? '[' : '{';
+   EXPECT_GT(execution_write.size(),
+             expect_loaded_as_by_operator(other_bracket, "execution_io_TEST.txt").size());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(ExecutionRoundtripTest, TextLoaderAcceptsOtherWhitespace)
+{
+   auto execution_write = this->execution_write();
+   std::stringstream stream;
+   stream << execution_write;
+
+   // Double the spaces in the fourth State, which the loaders leave to operator>>, and continue
+   // after it
+   auto text = stream.str();
+   const auto begin = state_position(text, 3);
+   const auto end = text.find('\n', begin);
+   std::string line;
+   for (const char c : text.substr(begin, end - begin))
+      line += c == ' ' ? std::string("  ") : std::string(1, c);
+   text.replace(begin, end - begin, line);
+   EXPECT_TRUE(execution_write == expect_loaded_as_by_operator(text, "execution_io_TEST.txt"));
+}
+
+//--------------------------------------------------------------------------------------------------
+
 } // end namespace test
 } // end namespace program_model
@@ -0,0 +1,208 @@
+#include <next_set.hpp>
+
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+
+namespace program_model {
+namespace test {
+
+class NextSetTest : public ::testing::Test
+{
+protected:
+   int var = 0;
+
+   next_t next(const Thread::tid_t tid, const unsigned int line, const bool enabled = true)
+   {
+      return {memory_instruction{tid, memory_operation::Store, Object(&var), false,
+                                 {"test_file", line}},
+              enabled};
+   }
+
+   /// @brief The entries of next_set in iteration order.
+
+   static std::vector<std::pair<Thread::tid_t, next_t>> entries(const NextSet& next_set)
+   {
+      return {next_set.begin(), next_set.end()};
+   }
+};
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(NextSetTest, EmptyNextSet)
+{
+   const NextSet next_set{};
+   EXPECT_TRUE(next_set.empty());
+   EXPECT_EQ(0u, next_set.size());
+   EXPECT_EQ(next_set.end(), next_set.begin());
+   EXPECT_EQ(next_set.end(), next_set.find(0));
+   EXPECT_EQ(0u, next_set.count(0));
+   EXPECT_THROW(next_set.at(0), std::out_of_range);
+   EXPECT_EQ(NextSet{}, next_set);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(NextSetTest, EntriesAreIteratedInTheOrderOfTheirTids)
+{
+   const std::vector<Thread::tid_t> tids{std::numeric_limits<Thread::tid_t>::min(),
+                                         -9,
+                                         -1,
+                                         0,
+                                         1,
+                                         7,
+                                         8,
+                                         63,
+                                         64,
+                                         1 << 20,
+                                         std::numeric_limits<Thread::tid_t>::max()};
+
+   NextSet next_set{};
+   for (auto it = tids.rbegin(); it != tids.rend(); ++it)
+      next_set.set(*it, next(*it, 1));
+   ASSERT_EQ(tids.size(), next_set.size());
+
+   std::vector<Thread::tid_t> iterated{};
+   for (const auto& entry : next_set)
+      iterated.push_back(entry.first);
+   EXPECT_EQ(tids, iterated);
+
+   for (const auto tid : tids)
+   {
+      ASSERT_NE(next_set.end(), next_set.find(tid));
+      EXPECT_EQ(tid, next_set.find(tid)->first);
+      EXPECT_EQ(next(tid, 1), next_set.at(tid));
+   }
+   EXPECT_EQ(0u, next_set.count(2));
+   EXPECT_EQ(0u, next_set.count(-2));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(NextSetTest, SetReplacesAndInsertKeeps)
+{
+   NextSet next_set{{0, next(0, 1)}};
+   next_set.set(0, next(0, 2));
+   EXPECT_EQ(next(0, 2), next_set.at(0));
+
+   const auto inserted = next_set.insert({0, next(0, 3)});
+   EXPECT_FALSE(inserted.second);
+   EXPECT_EQ(next(0, 2), inserted.first->second);
+
+   const auto added = next_set.insert({1, next(1, 3)});
+   EXPECT_TRUE(added.second);
+   EXPECT_EQ(1, added.first->first);
+   EXPECT_EQ(2u, next_set.size());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(NextSetTest, ModifyingACopySharesTheUnchangedEntries)
+{
+   NextSet original{};
+   for (Thread::tid_t tid = 0; tid < 100; ++tid)
+      original.set(tid, next(tid, 1));
+
+   NextSet copy = original;
+   copy.set(42, next(42, 2, false));
+   copy.erase(7);
+   copy.set(100, next(100, 1));
+
+   // The original is unchanged
+   EXPECT_EQ(100u, original.size());
+   EXPECT_EQ(next(42, 1), original.at(42));
+   EXPECT_EQ(1u, original.count(7));
+   EXPECT_EQ(0u, original.count(100));
+
+   EXPECT_EQ(100u, copy.size());
+   EXPECT_EQ(next(42, 2, false), copy.at(42));
+   EXPECT_EQ(0u, copy.count(7));
+   for (Thread::tid_t tid = 0; tid < 100; ++tid)
+   {
+      if (tid != 7 && tid != 42)
+         EXPECT_EQ(&original.at(tid), &copy.at(tid));
+   }
+   EXPECT_NE(original, copy);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(NextSetTest, EqualityDoesNotDependOnTheOrderOfModifications)
+{
+   NextSet lhs{};
+   lhs.set(3, next(3, 1));
+   lhs.set(1000, next(1000, 1));
+   lhs.set(5, next(5, 1));
+
+   NextSet rhs{};
+   rhs.set(5, next(5, 1));
+   rhs.set(2000, next(2000, 1));
+   rhs.set(3, next(3, 2));
+   rhs.erase(2000);
+   rhs.set(1000, next(1000, 1));
+   EXPECT_NE(lhs, rhs);
+
+   rhs.set(3, next(3, 1));
+   EXPECT_EQ(lhs, rhs);
+   EXPECT_EQ(entries(lhs), entries(rhs));
+
+   // Erasing everything leaves an empty NextSet
+   for (const auto tid : {3, 5, 1000})
+      EXPECT_EQ(1u, rhs.erase(tid));
+   EXPECT_EQ(0u, rhs.erase(3));
+   EXPECT_TRUE(rhs.empty());
+   EXPECT_EQ(rhs.end(), rhs.begin());
+   EXPECT_EQ(NextSet{}, rhs);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(NextSetTest, BehavesLikeAMap)
+{
+   std::mt19937 random(2017);
+   std::uniform_int_distribution<Thread::tid_t> tid_distribution(-40, 300);
+   std::uniform_int_distribution<int> operation_distribution(0, 3);
+
+   std::map<Thread::tid_t, next_t> expected{};
+   NextSet next_set{};
+   std::vector<NextSet> snapshots{};
+   std::vector<std::map<Thread::tid_t, next_t>> expected_snapshots{};
+   for (unsigned int step = 0; step < 5000; ++step)
+   {
+      const auto tid = tid_distribution(random);
+      if (operation_distribution(random) == 0)
+      {
+         EXPECT_EQ(expected.erase(tid), next_set.erase(tid));
+      }
+      else
+      {
+         expected[tid] = next(tid, step);
+         next_set.set(tid, next(tid, step));
+      }
+      if (step % 100 == 0)
+      {
+         snapshots.push_back(next_set);
+         expected_snapshots.push_back(expected);
+      }
+      ASSERT_EQ(expected.size(), next_set.size());
+   }
+
+   snapshots.push_back(next_set);
+   expected_snapshots.push_back(expected);
+   using entries_t = std::vector<std::pair<Thread::tid_t, next_t>>;
+   for (std::size_t i = 0; i < snapshots.size(); ++i)
+   {
+      const entries_t expected_entries(expected_snapshots[i].begin(), expected_snapshots[i].end());
+      EXPECT_EQ(expected_entries, entries(snapshots[i]));
+   }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+} // end namespace test
+} // end namespace program_model
@@ -0,0 +1,171 @@
+#include <scheduler.hpp>
+
+#include <visible_instruction.hpp>
+
+#include <gtest/gtest.h>
+
+#include <dirent.h>
+#include <pthread.h>
+
+
+namespace scheduler {
+namespace test {
+
+//--------------------------------------------------------------------------------------------------
+
+/// @brief The wrapper calls of an instrumented program, made by hand.
+
+namespace {
+
+const int load = static_cast<int>(program_model::memory_operation::Load);
+const int store = static_cast<int>(program_model::memory_operation::Store);
+const int lock = static_cast<int>(program_model::lock_operation::Lock);
+const int unlock = static_cast<int>(program_model::lock_operation::Unlock);
+
+int counter = 0;
+
+void* increment(void*)
+{
+   wrapper_enter_function("increment");
+   wrapper_post_memory_instruction(load, &counter, false, __FILE__, __LINE__);
+   const int value = counter;
+   wrapper_post_memory_instruction(store, &counter, false, __FILE__, __LINE__);
+   counter = value + 1;
+   wrapper_exit_function("increment");
+   return nullptr;
+}
+
+void lock_in_order(pthread_mutex_t* outer, pthread_mutex_t* inner)
+{
+   wrapper_post_lock_instruction(lock, outer, __FILE__, __LINE__);
+   pthread_mutex_lock(outer);
+   wrapper_post_lock_instruction(lock, inner, __FILE__, __LINE__);
+   pthread_mutex_lock(inner);
+   wrapper_post_lock_instruction(unlock, inner, __FILE__, __LINE__);
+   pthread_mutex_unlock(inner);
+   wrapper_post_lock_instruction(unlock, outer, __FILE__, __LINE__);
+   pthread_mutex_unlock(outer);
+}
+
+void* lock_forward(void* mutexes)
+{
+   wrapper_enter_function("lock_forward");
+   auto* pair = static_cast<pthread_mutex_t*>(mutexes);
+   lock_in_order(&pair[0], &pair[1]);
+   wrapper_exit_function("lock_forward");
+   return nullptr;
+}
+
+/// @brief Runs start_routine on two threads and joins them.
+
+void run_twice(void* (*start_routine)(void*))
+{
+   pthread_t pids[2];
+   for (auto& pid : pids)
+   {
+      const int tid = wrapper_post_spawn_instruction(&pid, __FILE__, __LINE__);
+      pthread_create(&pid, nullptr, start_routine, nullptr);
+      wrapper_register_thread(&pid, tid);
+   }
+   for (const auto& pid : pids)
+   {
+      wrapper_post_pthread_join_instruction(pid, __FILE__, __LINE__);
+      pthread_join(pid, nullptr);
+   }
+}
+
+void increment_twice()
+{
+   counter = 0;
+   run_twice(increment);
+}
+
+/// @brief The number of threads of the process.
+
+std::size_t nr_threads()
+{
+   std::size_t nr = 0;
+   DIR* tasks = opendir("/proc/self/task");
+   while (const auto* entry = readdir(tasks))
+   {
+      if (entry->d_name[0] != '.')
+         ++nr;
+   }
+   closedir(tasks);
+   return nr;
+}
+
+} // end namespace
+
+//--------------------------------------------------------------------------------------------------
+
+TEST(InProcessTest, ReplaysTheExecutedSchedule)
+{
+   const SchedulerSettings settings("Random");
+   const auto recorded = run_in_process(increment_twice, settings);
+   ASSERT_EQ(program_model::Execution::Status::DONE, recorded.status);
+   const int recorded_counter = counter;
+
+   for (int i = 0; i < 10; ++i)
+   {
+      const auto replayed = run_in_process(increment_twice, settings, recorded.schedule);
+      EXPECT_EQ(program_model::Execution::Status::DONE, replayed.status);
+      EXPECT_EQ(recorded.schedule, replayed.schedule);
+      EXPECT_EQ(recorded_counter, counter);
+   }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST(InProcessTest, ExploresTheInterleavings)
+{
+   const auto sequential = run_in_process(increment_twice, SchedulerSettings("NonPreemptive"));
+   EXPECT_EQ(program_model::Execution::Status::DONE, sequential.status);
+   EXPECT_EQ(2, counter);
+
+   bool lost_update = false;
+   for (int i = 0; i < 200 && !lost_update; ++i)
+   {
+      const auto result = run_in_process(increment_twice, SchedulerSettings("Random"));
+      ASSERT_EQ(program_model::Execution::Status::DONE, result.status);
+      lost_update = counter == 1;
+   }
+   EXPECT_TRUE(lost_update);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST(InProcessTest, ReportsADeadlock)
+{
+   const auto deadlocked = [] {
+      // Left locked by the threads of a deadlocked run, hence never freed
+      auto* mutexes = new pthread_mutex_t[2];
+      pthread_mutex_init(&mutexes[0], nullptr);
+      pthread_mutex_init(&mutexes[1], nullptr);
+      pthread_t pid;
+      const int tid = wrapper_post_spawn_instruction(&pid, __FILE__, __LINE__);
+      pthread_create(&pid, nullptr, lock_forward, mutexes);
+      wrapper_register_thread(&pid, tid);
+      lock_in_order(&mutexes[1], &mutexes[0]);
+      wrapper_post_pthread_join_instruction(pid, __FILE__, __LINE__);
+      pthread_join(pid, nullptr);
+   };
+   // After a first run, as a run replaces the Scheduler of the program and its threads
+   run_in_process(increment_twice, SchedulerSettings("NonPreemptive"));
+   const auto threads_before = nr_threads();
+   const auto result = explore_in_process(deadlocked, SchedulerSettings("Random"), 200);
+   ASSERT_TRUE(result);
+   EXPECT_EQ(program_model::Execution::Status::DEADLOCK, result->status);
+   // The blocked threads and the Scheduler thread ended
+   EXPECT_EQ(threads_before, nr_threads());
+
+   // The next run does not depend on the deadlocked threads
+   EXPECT_EQ(program_model::Execution::Status::DONE,
+             run_in_process(increment_twice, SchedulerSettings("NonPreemptive")).status);
+   EXPECT_EQ(2, counter);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+} // end namespace test
+} // end namespace scheduler
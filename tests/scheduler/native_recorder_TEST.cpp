@@ -0,0 +1,157 @@
+
+#include <native_recorder.hpp>
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <thread>
+
+
+namespace scheduler {
+namespace test {
+
+//--------------------------------------------------------------------------------------------------
+
+TEST(NativeRecorderTest, MergeFollowsVersions)
+{
+   using namespace program_model;
+
+   int x = 0;
+   int y = 0;
+   std::mutex m;
+   const auto load = static_cast<int>(memory_operation::Load);
+   const auto store = static_cast<int>(memory_operation::Store);
+   const auto lock = static_cast<int>(lock_operation::Lock);
+   const auto unlock = static_cast<int>(lock_operation::Unlock);
+
+   native_recorder recorder;
+   recorder.record_spawn(0, 1, 1);
+   recorder.record(0, store, &x, 2);
+   std::thread thread1([&] {
+      recorder.record(1, load, &x, 10);
+      recorder.record(1, lock, &m, 11);
+      recorder.record(1, store, &y, 12);
+      recorder.finish(1);
+   });
+   thread1.join();
+   // The Lock of thread 0 is acquired after the one of thread 1
+   recorder.record(0, lock, &m, 3);
+   recorder.record(0, unlock, &m, 4);
+   recorder.record_join(0, 1, 5);
+   recorder.finish(0);
+
+   const auto events = recorder.merge();
+   ASSERT_EQ(8u, events.size());
+   schedule_t schedule;
+   for (const auto& event : events)
+      schedule.push_back(event.tid);
+   EXPECT_EQ((schedule_t{0, 0, 1, 1, 1, 0, 0, 0}), schedule);
+   EXPECT_EQ(10u, events[2].line_number);
+   EXPECT_EQ(static_cast<int>(thread_management_operation::Join), events[7].operation);
+
+   const partial_order order(events);
+   EXPECT_EQ(std::vector<partial_order::step_t>{1}, order[2].predecessors);
+   EXPECT_EQ(std::vector<partial_order::step_t>{3}, order[5].predecessors);
+
+   // Nothing orders the load of x after the store, which had not been checked yet
+   EXPECT_FALSE(recorder.replayable());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST(NativeRecorderTest, MergeStopsAtUnfinishedThread)
+{
+   int x = 0;
+   std::mutex m;
+   const auto store = static_cast<int>(program_model::memory_operation::Store);
+   const auto lock = static_cast<int>(program_model::lock_operation::Lock);
+
+   native_recorder recorder;
+   recorder.record_spawn(0, 1, 1);
+   std::thread thread1([&] {
+      recorder.record(1, store, &x, 10);
+      recorder.record(1, lock, &m, 11);
+   });
+   thread1.join();
+   recorder.record(0, store, &x, 2);
+   recorder.finish(0);
+
+   // Thread 1 did not finish, so its Lock has no version and is left out
+
+   const auto events = recorder.merge();
+   ASSERT_EQ(3u, events.size());
+   EXPECT_EQ(1, events[1].tid);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST(NativeRecorderTest, RejectsAccessesOutOfTheirRecordedOrder)
+{
+   int x = 0;
+   std::mutex m;
+   const auto load = static_cast<int>(program_model::memory_operation::Load);
+   const auto store = static_cast<int>(program_model::memory_operation::Store);
+   const auto unlock = static_cast<int>(program_model::lock_operation::Unlock);
+
+   // The Unlock ends the store before thread 1 loads
+   native_recorder ordered;
+   ordered.record_spawn(0, 1, 1);
+   ordered.record(0, store, &x, 2);
+   ordered.record(0, unlock, &m, 3);
+   std::thread([&] {
+      ordered.record(1, load, &x, 10);
+      ordered.finish(1);
+   }).join();
+   ordered.finish(0);
+   EXPECT_TRUE(ordered.replayable());
+
+   // Thread 1 takes a version while the store of thread 0 may still have to execute
+   native_recorder racing;
+   racing.record_spawn(0, 1, 1);
+   racing.record(0, store, &x, 2);
+   std::thread([&] {
+      racing.record(1, store, &x, 10);
+      racing.finish(1);
+   }).join();
+   racing.finish(0);
+   EXPECT_EQ(1u, racing.nr_unordered());
+   EXPECT_FALSE(racing.write("native_recorder_TEST_schedule.txt",
+                             "native_recorder_TEST_partial_order.txt"));
+   EXPECT_FALSE(std::ifstream("native_recorder_TEST_schedule.txt").is_open());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST(NativeRecorderTest, OverlappingLoadsStayReplayable)
+{
+   int x = 0;
+   const auto load = static_cast<int>(program_model::memory_operation::Load);
+   const auto store = static_cast<int>(program_model::memory_operation::Store);
+
+   // Thread 1 loads x while the load of thread 0 may still have to execute
+   native_recorder loads;
+   loads.record_spawn(0, 1, 1);
+   loads.record(0, load, &x, 2);
+   std::thread([&] {
+      loads.record(1, load, &x, 10);
+      loads.finish(1);
+   }).join();
+   loads.finish(0);
+   EXPECT_TRUE(loads.replayable());
+
+   // A store in the window of a load does conflict with it
+   native_recorder racing;
+   racing.record_spawn(0, 1, 1);
+   racing.record(0, load, &x, 2);
+   std::thread([&] {
+      racing.record(1, store, &x, 10);
+      racing.finish(1);
+   }).join();
+   racing.finish(0);
+   EXPECT_EQ(1u, racing.nr_unordered());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+} // end namespace test
+} // end namespace scheduler
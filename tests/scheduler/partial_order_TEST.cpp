@@ -0,0 +1,155 @@
+
+#include <partial_order.hpp>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <thread>
+
+
+namespace scheduler {
+namespace test {
+
+//--------------------------------------------------------------------------------------------------
+
+TEST(PartialOrderTest, ConflictingAccesses)
+{
+   using namespace program_model;
+
+   int x = 0;
+   int y = 0;
+   std::mutex m;
+
+   const auto state = std::make_shared<State>(Tids{0, 1}, NextSet());
+   Execution E(state);
+   // 0
+   E.push_back(thread_management_instruction(0, thread_management_operation::Spawn, Thread(1),
+                                             {"file", 1}),
+               state);
+   // 1, 2: concurrent reads of x
+   E.push_back(memory_instruction(0, memory_operation::Load, Object(&x), false, {"file", 2}), state);
+   E.push_back(memory_instruction(1, memory_operation::Load, Object(&x), false, {"file", 10}), state);
+   // 3: write of x waits for both reads
+   E.push_back(memory_instruction(1, memory_operation::Store, Object(&x), false, {"file", 11}),
+               state);
+   // 4: disjoint object
+   E.push_back(memory_instruction(0, memory_operation::Store, Object(&y), false, {"file", 3}), state);
+   // 5, 6: lock operations on m are totally ordered
+   E.push_back(lock_instruction(0, lock_operation::Lock, Object(&m), {"file", 4}), state);
+   E.push_back(lock_instruction(0, lock_operation::Unlock, Object(&m), {"file", 5}), state);
+   E.push_back(lock_instruction(1, lock_operation::Lock, Object(&m), {"file", 12}), state);
+   // 8: read after a write
+   E.push_back(memory_instruction(0, memory_operation::Load, Object(&x), false, {"file", 6}), state);
+
+   const partial_order order(E);
+   ASSERT_EQ(9u, order.size());
+   ASSERT_EQ(2u, order.nr_threads());
+   EXPECT_EQ((std::vector<partial_order::step_t>{0, 1, 4, 5, 6, 8}), order.steps_of(0));
+   EXPECT_EQ((std::vector<partial_order::step_t>{2, 3, 7}), order.steps_of(1));
+
+   EXPECT_TRUE(order[1].predecessors.empty());
+   EXPECT_TRUE(order[2].predecessors.empty());
+   // The read of thread 1 is implied by program order
+   EXPECT_EQ(std::vector<partial_order::step_t>{1}, order[3].predecessors);
+   EXPECT_TRUE(order[4].predecessors.empty());
+   EXPECT_EQ(std::vector<partial_order::step_t>{6}, order[7].predecessors);
+   EXPECT_EQ(std::vector<partial_order::step_t>{3}, order[8].predecessors);
+   EXPECT_EQ(static_cast<int>(lock_operation::Lock), order[7].operation);
+   EXPECT_EQ(12u, order[7].line_number);
+
+   std::stringstream stream;
+   stream << order;
+   partial_order read;
+   ASSERT_TRUE(stream >> read);
+   ASSERT_EQ(order.size(), read.size());
+   for (std::size_t step = 0; step < order.size(); ++step)
+   {
+      EXPECT_EQ(order[step].tid, read[step].tid);
+      EXPECT_EQ(order[step].predecessors, read[step].predecessors);
+   }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST(PartialOrderTest, ReplayDiverges)
+{
+   partial_order order;
+   order.push_back({0, 1, 2, {}});
+   order.push_back({1, 1, 3, {0}});
+
+   partial_order_replay replay(std::move(order));
+   EXPECT_TRUE(replay.next_step(0, 1, 2));
+   replay.finish(0);
+   EXPECT_TRUE(replay.next_step(1, 1, 3));
+   EXPECT_FALSE(replay.diverged());
+   EXPECT_FALSE(replay.next_step(1, 1, 4));
+   EXPECT_TRUE(replay.diverged());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST(PartialOrderTest, ReplayWaitsForPredecessorsOfOtherThreads)
+{
+   using namespace program_model;
+
+   int x = 0;
+   int y = 0;
+
+   const auto state = std::make_shared<State>(Tids{0, 1}, NextSet());
+   Execution E(state);
+   // 0, 3 by thread 0 and 1, 2 by thread 1: each read waits for the write of the other thread
+   E.push_back(memory_instruction(0, memory_operation::Store, Object(&x), false, {"file", 1}), state);
+   E.push_back(memory_instruction(1, memory_operation::Load, Object(&x), false, {"file", 10}), state);
+   E.push_back(memory_instruction(1, memory_operation::Store, Object(&y), false, {"file", 11}),
+               state);
+   E.push_back(memory_instruction(0, memory_operation::Load, Object(&y), false, {"file", 2}), state);
+
+   const partial_order order(E);
+   partial_order_replay replay(order);
+   std::mutex mutex;
+   std::vector<partial_order::step_t> performed;
+   const auto perform = [&](const partial_order::step_t step) {
+      EXPECT_TRUE(replay.next_step(order[step].tid, order[step].operation,
+                                   order[step].line_number));
+      std::lock_guard<std::mutex> lock(mutex);
+      performed.push_back(step);
+   };
+
+   int read_x = 0;
+   int read_y = 0;
+   std::atomic<bool> started_1{false};
+   std::thread thread_1([&] {
+      perform(1);
+      started_1 = true;
+      read_x = x;
+      perform(2);
+      y = 2;
+      replay.finish(1);
+   });
+   // Thread 1 waits for the store of thread 0
+   std::this_thread::sleep_for(std::chrono::milliseconds(20));
+   EXPECT_FALSE(started_1);
+
+   std::thread thread_0([&] {
+      perform(0);
+      x = 1;
+      perform(3);
+      read_y = y;
+      replay.finish(0);
+   });
+   thread_0.join();
+   thread_1.join();
+
+   // As in the replay of the total order
+   EXPECT_EQ((std::vector<partial_order::step_t>{0, 1, 2, 3}), performed);
+   EXPECT_EQ(1, read_x);
+   EXPECT_EQ(2, read_y);
+   EXPECT_FALSE(replay.diverged());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+} // end namespace test
+} // end namespace scheduler
@@ -0,0 +1,120 @@
+#include <pct.hpp>
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+
+namespace scheduler {
+namespace test {
+
+//--------------------------------------------------------------------------------------------------
+
+class PCTTest : public ::testing::Test
+{
+protected:
+   TaskPool pool;
+
+   PCTTest()
+   {
+      for (Thread::tid_t tid = 0; tid < 4; ++tid)
+         pool.register_thread(tid);
+   }
+
+   /// @brief The selections of strategy in steps steps, from the same enabled threads.
+
+   std::vector<Thread::tid_t> select(const PCT& strategy, const program_model::Tids& enabled,
+                                     const unsigned int steps)
+   {
+      std::vector<Thread::tid_t> selected;
+      for (unsigned int step = 0; step < steps; ++step)
+      {
+         const auto result = strategy.select(pool, enabled, step);
+         EXPECT_EQ(program_model::Execution::Status::RUNNING, result.first);
+         EXPECT_EQ(1u, enabled.count(result.second));
+         selected.push_back(result.second);
+      }
+      return selected;
+   }
+
+   static unsigned int nr_switches(const std::vector<Thread::tid_t>& selected)
+   {
+      unsigned int switches = 0;
+      for (std::size_t step = 1; step < selected.size(); ++step)
+         switches += selected[step] != selected[step - 1] ? 1 : 0;
+      return switches;
+   }
+};
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(PCTTest, SameSeedSelectsTheSameThreads)
+{
+   const SchedulerSettings::pct_t parameters{3, 100};
+   const PCT lhs(parameters, 7u);
+   const PCT rhs(parameters, 7u);
+   EXPECT_EQ(select(lhs, {0, 1, 2, 3}, 100), select(rhs, {0, 1, 2, 3}, 100));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(PCTTest, RunsTheHighestPriorityThreadUntilAChangePoint)
+{
+   // Depth 1 has no change points
+   const PCT strategy({1, 100}, 11u);
+   const auto selected = select(strategy, {0, 1, 2}, 50);
+   EXPECT_EQ(0u, nr_switches(selected));
+
+   // The thread with the next highest priority runs while the first one is disabled
+   program_model::Tids enabled{0, 1, 2};
+   enabled.erase(selected.front());
+   const auto next = select(strategy, enabled, 10);
+   EXPECT_EQ(0u, nr_switches(next));
+   EXPECT_EQ(selected, select(strategy, {0, 1, 2}, 50));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(PCTTest, ChangesPrioritiesDepthMinusOneTimes)
+{
+   for (unsigned int seed = 0; seed < 20; ++seed)
+   {
+      // Every change point drops the running thread below the threads that did not run yet
+      const PCT strategy({3, 40}, seed);
+      EXPECT_EQ(2u, nr_switches(select(strategy, {0, 1, 2, 3}, 40)));
+   }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(PCTTest, GivesNewThreadsAPriority)
+{
+   const PCT strategy({1, 10}, 3u);
+   select(strategy, {0}, 2);
+   const auto selected = select(strategy, {0, 1, 2}, 1).front();
+   // Tid 1 and 2 show up together, and keep their priorities
+   EXPECT_EQ(selected, select(strategy, {0, 1, 2}, 1).front());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(PCTTest, ForgetsFinishedThreads)
+{
+   const PCT strategy({1, 10}, 5u);
+   const auto selected = select(strategy, {0, 1, 2, 3}, 1).front();
+   EXPECT_EQ(4u, strategy.nr_threads());
+
+   pool.finish(2);
+   pool.finish(3);
+   program_model::Tids live{0, 1};
+   const auto next = select(strategy, live, 5);
+   EXPECT_EQ(2u, strategy.nr_threads());
+   EXPECT_EQ(0u, nr_switches(next));
+   if (live.count(selected) > 0)
+      EXPECT_EQ(selected, next.front());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+} // end namespace test
+} // end namespace scheduler
@@ -0,0 +1,275 @@
+
+#include <recorder.hpp>
+
+#include <execution_io.hpp>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+
+namespace scheduler {
+namespace test {
+
+//--------------------------------------------------------------------------------------------------
+
+TEST(ScheduleLogTest, WritesScheduleAndSites)
+{
+   using namespace program_model;
+
+   int x = 0;
+   schedule_log log("schedule_log_test_schedule.txt", "schedule_log_test_sites.txt");
+   log.push_back(memory_instruction(0, memory_operation::Store, Object(&x), false, {"a.c", 3}));
+   log.push_back(memory_instruction(0, memory_operation::Load, Object(&x), false, {"a.c", 4}));
+   log.push_back(memory_instruction(1, memory_operation::Store, Object(&x), false, {"a.c", 3}));
+   EXPECT_EQ((schedule_t{0, 0, 1}), log.schedule());
+   log.write(Execution::Status::DONE);
+
+   schedule_t schedule;
+   std::ifstream schedule_stream("schedule_log_test_schedule.txt");
+   schedule_stream >> schedule;
+   EXPECT_EQ(log.schedule(), schedule);
+
+   std::ifstream sites_stream("schedule_log_test_sites.txt");
+   std::stringstream sites;
+   sites << sites_stream.rdbuf();
+   EXPECT_EQ("2\na.c 3\na.c 4\n0\n1\n0\n=====\nDONE", sites.str());
+
+   std::remove("schedule_log_test_schedule.txt");
+   std::remove("schedule_log_test_sites.txt");
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST(FlightRecorderTest, DumpsTailOnDeadlock)
+{
+   using namespace program_model;
+
+   int x = 0;
+   const auto state = std::make_shared<State>(Tids{0, 1}, NextSet());
+   flight_recorder_sink sink(2, 2, "flight_test_tail.txt", "flight_test_schedule.txt",
+                             "flight_test_keyframes.txt");
+   sink.initial_state(*state);
+   for (int index = 1; index <= 5; ++index)
+   {
+      sink.transition(Transition(
+         index, state,
+         memory_instruction(index / 2, memory_operation::Store, Object(&x), false, {"a.c", 1}),
+         state));
+   }
+   sink.close(Execution::Status::DEADLOCK);
+
+   schedule_t schedule;
+   std::ifstream schedule_stream("flight_test_schedule.txt");
+   schedule_stream >> schedule;
+   EXPECT_EQ((schedule_t{0, 1, 1, 2, 2}), schedule);
+
+   Execution tail;
+   std::ifstream tail_stream("flight_test_tail.txt");
+   tail_stream >> tail;
+   EXPECT_EQ(2u, tail.size());
+   EXPECT_EQ(Execution::Status::DEADLOCK, tail.status());
+
+   // Keyframes at steps 0, 2 and 4
+   std::ifstream keyframes_stream("flight_test_keyframes.txt");
+   std::string line;
+   std::size_t nr_lines = 0;
+   while (std::getline(keyframes_stream, line))
+      ++nr_lines;
+   EXPECT_EQ(6u, nr_lines);
+
+   for (const auto* file : {"flight_test_tail.txt", "flight_test_schedule.txt",
+                            "flight_test_keyframes.txt"})
+      std::remove(file);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST(FlightRecorderTest, DumpsTailOnSignal)
+{
+   using namespace program_model;
+
+   int x = 0;
+   const auto state = std::make_shared<State>(Tids{0}, NextSet());
+   flight_recorder_sink sink(2, 2, "flight_test_tail.txt", "flight_test_schedule.txt",
+                             "flight_test_keyframes.txt");
+   sink.initial_state(*state);
+   for (int index = 1; index <= 3; ++index)
+   {
+      sink.transition(Transition(
+         index, state, memory_instruction(0, memory_operation::Store, Object(&x), false, {"a.c", 1}),
+         state));
+   }
+   sink.flush_on_signal();
+
+   Execution tail;
+   std::ifstream tail_stream("flight_test_tail.txt");
+   ASSERT_TRUE(tail_stream.is_open());
+   tail_stream >> tail;
+   EXPECT_EQ(2u, tail.size());
+   EXPECT_EQ(Execution::Status::RUNNING, tail.status());
+
+   for (const auto* file : {"flight_test_tail.txt", "flight_test_schedule.txt",
+                            "flight_test_keyframes.txt"})
+      std::remove(file);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST(FlightRecorderTest, StreamsTheSchedule)
+{
+   using namespace program_model;
+
+   // Enough runs to write out the buffered schedule several times
+   constexpr int nr_steps = 100000;
+   int x = 0;
+   const auto state = std::make_shared<State>(Tids{0, 1}, NextSet());
+   flight_recorder_sink sink(2, 1000, "flight_test_tail.txt", "flight_test_schedule.txt",
+                             "flight_test_keyframes.txt");
+   sink.initial_state(*state);
+   schedule_t expected;
+   for (int index = 1; index <= nr_steps; ++index)
+   {
+      const Thread::tid_t tid = (index / 3) % 2;
+      expected.push_back(tid);
+      sink.transition(Transition(
+         index, state, memory_instruction(tid, memory_operation::Store, Object(&x), false,
+                                          {"a.c", 1}),
+         state));
+      // A dump in the middle of a run, which goes on afterwards
+      if (index == nr_steps / 2)
+      {
+         sink.flush_on_signal();
+         schedule_t schedule;
+         std::ifstream schedule_stream("flight_test_schedule.txt");
+         schedule_stream >> schedule;
+         EXPECT_EQ(expected, schedule);
+      }
+   }
+   sink.close(Execution::Status::DEADLOCK);
+
+   schedule_t schedule;
+   std::ifstream schedule_stream("flight_test_schedule.txt");
+   schedule_stream >> schedule;
+   EXPECT_EQ(expected, schedule);
+
+   for (const auto* file : {"flight_test_tail.txt", "flight_test_schedule.txt",
+                            "flight_test_keyframes.txt"})
+      std::remove(file);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST(FlightRecorderTest, RemovesTheScheduleWhenDone)
+{
+   using namespace program_model;
+
+   int x = 0;
+   const auto state = std::make_shared<State>(Tids{0, 1}, NextSet());
+   flight_recorder_sink sink(2, 2, "flight_test_tail.txt", "flight_test_schedule.txt",
+                             "flight_test_keyframes.txt");
+   sink.initial_state(*state);
+   for (int index = 1; index <= 100000; ++index)
+   {
+      sink.transition(Transition(
+         index, state,
+         memory_instruction(index % 2, memory_operation::Store, Object(&x), false, {"a.c", 1}),
+         state));
+   }
+   sink.close(Execution::Status::DONE);
+
+   EXPECT_FALSE(std::ifstream("flight_test_schedule.txt").is_open());
+   EXPECT_FALSE(std::ifstream("flight_test_tail.txt").is_open());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+namespace {
+
+/// @brief Sink that is slower than the scheduler and keeps the index of each Transition.
+
+class slow_sink : public record_sink
+{
+public:
+   explicit slow_sink(std::vector<int>& indices)
+   : m_indices(indices)
+   {
+   }
+
+   void initial_state(const program_model::State&) override
+   {
+   }
+
+   void transition(const program_model::Transition& trans) override
+   {
+      if (trans.index() % 256 == 0)
+         std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      m_indices.push_back(trans.index());
+   }
+
+   void close(const program_model::Execution::Status&) override
+   {
+   }
+
+   void flush() override
+   {
+   }
+
+   void flush_on_signal() override
+   {
+   }
+
+private:
+   std::vector<int>& m_indices;
+};
+
+} // end namespace
+
+//--------------------------------------------------------------------------------------------------
+
+TEST(RecorderTest, WaitsForASlowSink)
+{
+   using namespace program_model;
+
+   constexpr int nr_steps = 10000;
+   int x = 0;
+   std::vector<int> indices;
+   {
+      record_sinks_t sinks;
+      sinks.push_back(std::make_unique<slow_sink>(indices));
+      recorder rec(std::move(sinks));
+      const auto state = std::make_shared<State>(Tids{0}, NextSet());
+      rec.start(state);
+      const auto instr = std::make_shared<const visible_instruction_t>(
+         memory_instruction(0, memory_operation::Store, Object(&x), false, {"a.c", 1}));
+      for (int step = 0; step < nr_steps; ++step)
+         rec.push_step(instr, state);
+      rec.close(nullptr, Execution::Status::DONE);
+   }
+   ASSERT_EQ(static_cast<std::size_t>(nr_steps), indices.size());
+   for (int index = 0; index < nr_steps; ++index)
+      EXPECT_EQ(index + 1, indices[index]);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST(RecorderTest, DoesNothingWithoutSinks)
+{
+   using namespace program_model;
+
+   recorder rec{record_sinks_t()};
+   const auto state = std::make_shared<State>(Tids{0}, NextSet());
+   rec.start(state);
+   rec.close(state, Execution::Status::DONE);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+} // end namespace test
+} // end namespace scheduler
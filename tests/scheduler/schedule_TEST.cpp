@@ -0,0 +1,138 @@
+
+#include <schedule.hpp>
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <stdexcept>
+
+
+namespace scheduler {
+namespace test {
+
+//--------------------------------------------------------------------------------------------------
+
+TEST(ScheduleTest, RunLength)
+{
+   const schedule_t schedule = {0, 0, 0, 1, 1, 0, 2, 2, 2, 2};
+
+   EXPECT_EQ(10u, schedule.size());
+   EXPECT_EQ(4u, schedule.nr_runs());
+   EXPECT_EQ(0, schedule.at(2));
+   EXPECT_EQ(1, schedule.at(3));
+   EXPECT_EQ(0, schedule.at(5));
+   EXPECT_EQ(2, schedule.at(9));
+   EXPECT_THROW(schedule.at(10), std::out_of_range);
+
+   schedule_t appended;
+   appended.push_back(0, 3);
+   appended.push_back(1, 2);
+   appended.push_back(0);
+   appended.push_back(2, 1);
+   appended.push_back(2, 3);
+   EXPECT_EQ(schedule, appended);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST(ScheduleTest, ReaderRoundTrip)
+{
+   const schedule_t schedule = {0, 0, 1, 1, 1, 0};
+
+   std::stringstream stream;
+   stream << schedule;
+   EXPECT_EQ("0 2\n1 3\n0 1\n", stream.str());
+
+   schedule_t read;
+   stream >> read;
+   EXPECT_EQ(schedule, read);
+
+   schedule_reader reader(std::make_unique<std::istringstream>("0 2\n1 3\n0 1\n"));
+   for (const auto tid : {0, 0, 1, 1, 1, 0})
+   {
+      EXPECT_FALSE(reader.at_end());
+      const auto next = reader.next();
+      ASSERT_TRUE(next);
+      EXPECT_EQ(tid, *next);
+   }
+   EXPECT_TRUE(reader.at_end());
+   EXPECT_FALSE(reader.next());
+   EXPECT_EQ(6u, reader.position());
+
+   schedule_reader empty;
+   EXPECT_FALSE(empty.next());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST(ScheduleTest, ReadsTheFlatFormat)
+{
+   schedule_t read;
+   std::istringstream flat("<0,0,1,1,1,0>\n");
+   EXPECT_TRUE(flat >> read);
+   EXPECT_EQ((schedule_t{0, 0, 1, 1, 1, 0}), read);
+
+   std::istringstream empty(" <>");
+   EXPECT_TRUE(empty >> read);
+   EXPECT_TRUE(read.empty());
+
+   std::istringstream spaced("< 0 ,0 , 1\t>");
+   EXPECT_TRUE(spaced >> read);
+   EXPECT_EQ((schedule_t{0, 0, 1}), read);
+
+   std::istringstream malformed("<0,1,x>");
+   EXPECT_FALSE(malformed >> read);
+   std::istringstream unseparated("<0 1>");
+   EXPECT_FALSE(unseparated >> read);
+
+   schedule_reader reader(std::make_unique<std::istringstream>("<1,1,0>"));
+   for (const auto tid : {1, 1, 0})
+      EXPECT_EQ(tid, *reader.next());
+   EXPECT_TRUE(reader.at_end());
+
+   EXPECT_THROW(schedule_reader(std::make_unique<std::istringstream>("<1,1")),
+                std::invalid_argument);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST(ScheduleTest, Fingerprints)
+{
+   using namespace program_model;
+
+   int var = 0;
+   const visible_instruction_t load =
+      memory_instruction{0, memory_operation::Load, Object(&var), false, {"file", 1}};
+   int other_var = 0;
+   const visible_instruction_t other_operand =
+      memory_instruction{0, memory_operation::Load, Object(&other_var), false, {"file", 1}};
+   const visible_instruction_t store =
+      memory_instruction{0, memory_operation::Store, Object(&var), false, {"file", 1}};
+   const visible_instruction_t other_tid =
+      memory_instruction{1, memory_operation::Load, Object(&var), false, {"file", 1}};
+   const visible_instruction_t other_line =
+      memory_instruction{0, memory_operation::Load, Object(&var), false, {"file", 2}};
+
+   EXPECT_EQ(fingerprint(load), fingerprint(other_operand));
+   EXPECT_NE(fingerprint(load), fingerprint(store));
+   EXPECT_NE(fingerprint(load), fingerprint(other_tid));
+   EXPECT_NE(fingerprint(load), fingerprint(other_line));
+
+   const std::vector<fingerprint_t> fingerprints = {fingerprint(load), fingerprint(store), 0};
+   std::stringstream stream;
+   write_fingerprints(stream, fingerprints);
+   fingerprint_reader reader(std::make_unique<std::istringstream>(stream.str()));
+   for (const auto expected : fingerprints)
+   {
+      const auto next = reader.next();
+      ASSERT_TRUE(next);
+      EXPECT_EQ(expected, *next);
+   }
+   EXPECT_FALSE(reader.next());
+   EXPECT_FALSE(fingerprint_reader().next());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+} // end namespace test
+} // end namespace scheduler
@@ -0,0 +1,114 @@
+
+#include <scheduler_settings.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+
+
+namespace scheduler {
+namespace test {
+
+//--------------------------------------------------------------------------------------------------
+
+TEST(SchedulerSettingsTest, FreeRunOptions)
+{
+   const std::string file_name = "scheduler_settings_test.txt";
+   for (const auto& settings : {SchedulerSettings("NonPreemptive"),
+                                SchedulerSettings("Random").set_free_run(true),
+                                SchedulerSettings("Random").set_free_run_log(true)})
+   {
+      {
+         std::ofstream ofs(file_name);
+         ofs << settings;
+      }
+      const auto read = SchedulerSettings::read_from_file(file_name);
+      EXPECT_EQ(settings.strategy_tag(), read.strategy_tag());
+      EXPECT_EQ(settings.free_run(), read.free_run());
+      EXPECT_EQ(settings.free_run_log(), read.free_run_log());
+   }
+   std::remove(file_name.c_str());
+
+   EXPECT_TRUE(SchedulerSettings("Random").set_free_run_log(true).free_run());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST(SchedulerSettingsTest, DeferredControl)
+{
+   const std::string file_name = "scheduler_settings_test.txt";
+   {
+      std::ofstream ofs(file_name);
+      ofs << "Random trigger_step=100 trigger_function=worker";
+   }
+   auto read = SchedulerSettings::read_from_file(file_name);
+   ASSERT_TRUE(read.deferred_control());
+   EXPECT_EQ(100u, *read.deferred_control()->step);
+   EXPECT_EQ("worker", *read.deferred_control()->function);
+   EXPECT_FALSE(read.deferred_control()->signal);
+
+   SchedulerSettings::control_trigger_t trigger;
+   trigger.signal = true;
+   {
+      std::ofstream ofs(file_name);
+      ofs << SchedulerSettings("Random").set_deferred_control(trigger);
+   }
+   read = SchedulerSettings::read_from_file(file_name);
+   ASSERT_TRUE(read.deferred_control());
+   EXPECT_FALSE(read.deferred_control()->step);
+   EXPECT_FALSE(read.deferred_control()->function);
+   EXPECT_TRUE(read.deferred_control()->signal);
+   std::remove(file_name.c_str());
+
+   EXPECT_FALSE(SchedulerSettings("Random").deferred_control());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST(SchedulerSettingsTest, StrategyParameters)
+{
+   const std::string file_name = "scheduler_settings_test.txt";
+   {
+      std::ofstream ofs(file_name);
+      ofs << "PCT pct_depth=2 seed=42";
+   }
+   auto read = SchedulerSettings::read_from_file(file_name);
+   EXPECT_EQ("PCT", read.strategy_tag());
+   EXPECT_EQ(2u, read.pct().depth);
+   EXPECT_EQ(SchedulerSettings::default_pct.steps, read.pct().steps);
+   ASSERT_TRUE(read.seed());
+   EXPECT_EQ(42u, *read.seed());
+
+   {
+      std::ofstream ofs(file_name);
+      ofs << SchedulerSettings("PCT").set_pct({4, 500}).set_seed(7u);
+   }
+   read = SchedulerSettings::read_from_file(file_name);
+   EXPECT_EQ(4u, read.pct().depth);
+   EXPECT_EQ(500u, read.pct().steps);
+   EXPECT_EQ(7u, *read.seed());
+   std::remove(file_name.c_str());
+
+   EXPECT_FALSE(SchedulerSettings("Random").seed());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST(SchedulerSettingsTest, RecordStates)
+{
+   const std::string file_name = "scheduler_settings_test.txt";
+   {
+      std::ofstream ofs(file_name);
+      ofs << SchedulerSettings("NonPreemptive").set_record_states(true);
+   }
+   EXPECT_TRUE(SchedulerSettings::read_from_file(file_name).record_states());
+   std::remove(file_name.c_str());
+
+   EXPECT_FALSE(SchedulerSettings("NonPreemptive").record_states());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+} // end namespace test
+} // end namespace scheduler
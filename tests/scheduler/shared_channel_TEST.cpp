@@ -0,0 +1,97 @@
+#include <scheduler_settings.hpp>
+#include <shared_channel.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <istream>
+
+
+namespace scheduler {
+namespace test {
+
+//--------------------------------------------------------------------------------------------------
+
+TEST(SharedChannelTest, InputAndOutcome)
+{
+   shared_channel driver;
+   driver.write_settings(SchedulerSettings("NonPreemptive").set_free_run(true));
+   EXPECT_TRUE(driver.write_schedule({0, 0, 1}, {0x1234, 0xabcd, 0x5678}));
+   EXPECT_FALSE(driver.result());
+
+   const auto program = shared_channel::attach();
+   ASSERT_TRUE(program);
+   const auto settings_input =
+      open_input(program.get(), shared_channel::section::settings, "no_settings.txt");
+   const auto settings = SchedulerSettings::read(*settings_input, "channel");
+   EXPECT_EQ("NonPreemptive", settings.strategy_tag());
+   EXPECT_TRUE(settings.free_run());
+
+   schedule_reader schedule(
+      open_input(program.get(), shared_channel::section::schedule, "no_schedule.txt"));
+   EXPECT_EQ(0, *schedule.next());
+   EXPECT_EQ(0, *schedule.next());
+   EXPECT_EQ(1, *schedule.next());
+   EXPECT_TRUE(schedule.at_end());
+
+   fingerprint_reader fingerprints(
+      open_input(program.get(), shared_channel::section::fingerprints, "no_fingerprints.txt"));
+   EXPECT_EQ(0x1234u, *fingerprints.next());
+
+   EXPECT_TRUE(program->write(shared_channel::section::executed_schedule, "1 2\n0 1\n"));
+   program->set_status(program_model::Execution::Status::DONE);
+
+   const auto result = driver.result();
+   ASSERT_TRUE(result);
+   EXPECT_EQ(program_model::Execution::Status::DONE, result->status);
+   ASSERT_TRUE(result->schedule);
+   EXPECT_EQ(schedule_t({1, 1, 0}), *result->schedule);
+   EXPECT_FALSE(result->data_races);
+
+   // The next schedule clears the outcome
+   driver.write_schedule({1});
+   EXPECT_FALSE(driver.result());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST(SharedChannelTest, FallsBackToFiles)
+{
+   const std::string file_name = "shared_channel_test_schedule.txt";
+   {
+      std::ofstream ofs(file_name);
+      ofs << schedule_t{2, 3};
+   }
+
+   shared_channel driver(4);
+   EXPECT_FALSE(driver.write_schedule({0, 1, 0, 1}));
+   const auto program = shared_channel::attach();
+   ASSERT_TRUE(program);
+   schedule_reader schedule(
+      open_input(program.get(), shared_channel::section::schedule, file_name));
+   EXPECT_EQ(2, *schedule.next());
+   EXPECT_EQ(3, *schedule.next());
+   EXPECT_TRUE(schedule.at_end());
+   std::remove(file_name.c_str());
+
+   EXPECT_FALSE(open_input(nullptr, shared_channel::section::schedule, file_name)->good());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST(SharedChannelTest, ExportedWhileItExists)
+{
+   {
+      shared_channel driver;
+      EXPECT_TRUE(std::getenv(shared_channel::environment_variable));
+   }
+   EXPECT_FALSE(std::getenv(shared_channel::environment_variable));
+   EXPECT_FALSE(shared_channel::attach());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+} // end namespace test
+} // end namespace scheduler
@@ -0,0 +1,259 @@
+#include <task_pool.hpp>
+
+#include <state_io.hpp>
+#include <visible_instruction_io.hpp>
+
+#include <gtest/gtest.h>
+
+
+namespace scheduler {
+namespace test {
+
+//--------------------------------------------------------------------------------------------------
+
+class TaskPoolTest : public ::testing::Test
+{
+protected:
+   int x = 0;
+   int y = 0;
+   int m = 0;
+   int n = 0;
+
+   program_model::visible_instruction_t store(const Thread::tid_t tid, int& var,
+                                              const unsigned int line)
+   {
+      using namespace program_model;
+      return memory_instruction(tid, memory_operation::Store, Object(&var), false,
+                                {"test.cpp", line});
+   }
+
+   program_model::visible_instruction_t lock(const Thread::tid_t tid,
+                                             const program_model::lock_operation operation,
+                                             const unsigned int line)
+   {
+      return lock(tid, operation, m, line);
+   }
+
+   program_model::visible_instruction_t lock(const Thread::tid_t tid,
+                                             const program_model::lock_operation operation,
+                                             int& mutex, const unsigned int line)
+   {
+      using namespace program_model;
+      return lock_instruction(tid, operation, Object(&mutex), {"test.cpp", line});
+   }
+
+   program_model::visible_instruction_t join(const Thread::tid_t tid, const Thread::tid_t joined,
+                                             const unsigned int line)
+   {
+      using namespace program_model;
+      return thread_management_instruction(tid, thread_management_operation::Join,
+                                           Thread(joined), {"test.cpp", line});
+   }
+
+   /// @brief Executes the task of tid.
+
+   static void step(TaskPool& pool, const Thread::tid_t tid)
+   {
+      pool.set_current(tid);
+      pool.yield(tid);
+   }
+};
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(TaskPoolTest, EqualStatesHaveEqualFingerprints)
+{
+   TaskPool lhs;
+   lhs.register_thread(0);
+   lhs.register_thread(1);
+   lhs.post(0, store(0, x, 1));
+   lhs.post(1, store(1, y, 2));
+
+   TaskPool rhs;
+   rhs.register_thread(1);
+   rhs.register_thread(0);
+   rhs.post(1, store(1, y, 2));
+   rhs.post(0, store(0, x, 1));
+
+   EXPECT_EQ(lhs.state_fingerprint(), rhs.state_fingerprint());
+
+   rhs.register_thread(2);
+   EXPECT_NE(lhs.state_fingerprint(), rhs.state_fingerprint());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(TaskPoolTest, StepsUpdateTheFingerprint)
+{
+   TaskPool pool;
+   pool.register_thread(0);
+   pool.post(0, store(0, x, 1));
+   const auto before = pool.state_fingerprint();
+
+   step(pool, 0);
+   EXPECT_NE(before, pool.state_fingerprint());
+   pool.post(0, store(0, x, 2));
+   EXPECT_NE(before, pool.state_fingerprint());
+
+   // The same task as before the step
+   step(pool, 0);
+   pool.post(0, store(0, x, 1));
+   EXPECT_EQ(before, pool.state_fingerprint());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(TaskPoolTest, LockOwnersArePartOfTheFingerprint)
+{
+   using program_model::lock_operation;
+
+   TaskPool unlocked;
+   unlocked.register_thread(0);
+   unlocked.register_thread(1);
+   unlocked.post(0, store(0, x, 3));
+   unlocked.post(1, store(1, y, 4));
+
+   TaskPool pool;
+   pool.register_thread(0);
+   pool.register_thread(1);
+   pool.post(1, store(1, y, 4));
+   pool.post(0, lock(0, lock_operation::Lock, 1));
+   step(pool, 0);
+   pool.post(0, store(0, x, 3));
+   const auto locked = pool.state_fingerprint();
+   EXPECT_NE(unlocked.state_fingerprint(), locked);
+
+   // Thread 1 blocks on the lock
+   step(pool, 1);
+   pool.post(1, lock(1, lock_operation::Lock, 5));
+   EXPECT_EQ(program_model::Thread::Status::DISABLED, pool.status_protected(1));
+   const auto blocked = pool.state_fingerprint();
+
+   step(pool, 0);
+   pool.post(0, lock(0, lock_operation::Unlock, 2));
+   step(pool, 0);
+   EXPECT_EQ(program_model::Thread::Status::ENABLED, pool.status_protected(1));
+   pool.post(0, store(0, x, 3));
+   EXPECT_NE(blocked, pool.state_fingerprint());
+
+   TaskPool waiting;
+   waiting.register_thread(0);
+   waiting.register_thread(1);
+   waiting.post(0, store(0, x, 3));
+   waiting.post(1, lock(1, lock_operation::Lock, 5));
+   EXPECT_EQ(waiting.state_fingerprint(), pool.state_fingerprint());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(TaskPoolTest, LocksTakenAtTheSameSiteHaveDifferentKeys)
+{
+   using program_model::lock_operation;
+
+   TaskPool unlocked;
+   unlocked.register_thread(0);
+   unlocked.post(0, store(0, x, 3));
+
+   TaskPool pool;
+   pool.register_thread(0);
+   pool.post(0, lock(0, lock_operation::Lock, m, 1));
+   step(pool, 0);
+   pool.post(0, lock(0, lock_operation::Lock, n, 1));
+   step(pool, 0);
+   pool.post(0, store(0, x, 3));
+   EXPECT_NE(unlocked.state_fingerprint(), pool.state_fingerprint());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(TaskPoolTest, FinishedThreadsAreRemovedAndCanBeJoined)
+{
+   TaskPool pool;
+   pool.register_thread(0);
+   pool.register_thread(1);
+   pool.post(0, store(0, x, 1));
+
+   // Thread 0 waits for thread 1
+   step(pool, 0);
+   pool.post(0, join(0, 1, 2));
+   EXPECT_EQ(program_model::Thread::Status::DISABLED, pool.status_protected(0));
+
+   pool.finish(1);
+   EXPECT_EQ(program_model::Thread::Status::FINISHED, pool.status_protected(1));
+   EXPECT_EQ(program_model::Tids({0}), pool.enabled_set_protected());
+   // The finished thread has no task to wait for
+   pool.wait_until_unfinished_threads_have_posted();
+
+   // Joining an already finished thread does not block
+   pool.register_thread(2);
+   pool.post(2, join(2, 1, 3));
+   EXPECT_EQ(program_model::Thread::Status::ENABLED, pool.status_protected(2));
+   EXPECT_EQ(program_model::Tids({0, 2}), pool.enabled_set_protected());
+
+   step(pool, 0);
+   pool.finish(0);
+   step(pool, 2);
+   pool.finish(2);
+   // Returns as no live thread remains
+   pool.wait_all_finished();
+   EXPECT_EQ(0u, pool.enabled_set_protected().size());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+TEST_F(TaskPoolTest, ProgramStatesShareWhatDidNotChange)
+{
+   using program_model::lock_operation;
+   using program_model::State;
+
+   TaskPool pool;
+   pool.register_thread(0);
+   pool.register_thread(1);
+   pool.post(0, store(0, x, 1));
+   pool.post(1, lock(1, lock_operation::Lock, 2));
+   const auto s0 = pool.program_state();
+   EXPECT_EQ(State(pool.enabled_set_protected(), pool.nextset_protected()), *s0);
+
+   step(pool, 0);
+   pool.post(0, lock(0, lock_operation::Lock, 3));
+   const auto s1 = pool.program_state();
+   EXPECT_EQ(State(pool.enabled_set_protected(), pool.nextset_protected()), *s1);
+   EXPECT_EQ(s0->enabled_ptr(), s1->enabled_ptr());
+   EXPECT_EQ(&s0->next_set().at(1), &s1->next_set().at(1));
+   EXPECT_FALSE(s0->next_set().at(0) == s1->next_set().at(0));
+
+   // Thread 1 blocks on the lock that thread 0 takes
+   step(pool, 0);
+   pool.post(0, store(0, x, 4));
+   const auto s2 = pool.program_state();
+   EXPECT_EQ(State(pool.enabled_set_protected(), pool.nextset_protected()), *s2);
+   EXPECT_EQ(program_model::Tids({0}), s2->enabled());
+   EXPECT_FALSE(s2->next_set().at(1).enabled);
+   EXPECT_EQ(s1->next_set().at(1).instr, s2->next_set().at(1).instr);
+
+   // Nothing changed since the last State
+   const auto s3 = pool.program_state();
+   EXPECT_EQ(s2->enabled_ptr(), s3->enabled_ptr());
+   EXPECT_EQ(&s2->next_set().at(0), &s3->next_set().at(0));
+   EXPECT_EQ(&s2->next_set().at(1), &s3->next_set().at(1));
+
+   step(pool, 0);
+   pool.post(0, lock(0, lock_operation::Unlock, 5));
+   step(pool, 0);
+   pool.finish(0);
+   const auto s4 = pool.program_state();
+   EXPECT_EQ(State(pool.enabled_set_protected(), pool.nextset_protected()), *s4);
+   EXPECT_EQ(program_model::Tids({1}), s4->enabled());
+   EXPECT_EQ(1u, s4->next_set().size());
+   EXPECT_TRUE(s4->next_set().at(1).enabled);
+
+   // The earlier States are unchanged
+   EXPECT_EQ(program_model::Tids({0, 1}), s0->enabled());
+   EXPECT_EQ(store(0, x, 1), s0->next_set().at(0).instr);
+   EXPECT_EQ(2u, s2->next_set().size());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+} // end namespace test
+} // end namespace scheduler
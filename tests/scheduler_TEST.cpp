@@ -1,6 +1,7 @@
 
 #include "include/test_helpers.hpp"
 
+#include <parallel_driver.hpp>
 #include <replay.hpp>
 
 #include <gtest/gtest.h>
@@ -42,6 +43,43 @@ TEST_P(SchedulerDeadlockSanitityCheck, SchedulerDoesNotEndInDeadlockOnMultipleRu
                                                     test_output_dir() / "records"));
 }
 
+TEST_P(SchedulerDeadlockSanitityCheck, ForkServerRunsDoNotEndInDeadlock)
+{
+   const auto instrumented_executable = scheduler::instrument(
+      detail::test_programs_dir / GetParam().test_program, test_output_dir() / "instrumented",
+      GetParam().optimization_level, GetParam().compiler_options);
+
+   scheduler::fork_server server(instrumented_executable);
+   for (int i = 0; i < 500; ++i)
+      ASSERT_NO_THROW(scheduler::run_under_schedule(server, {}, std::chrono::milliseconds(3000),
+                                                    test_output_dir() / "records"));
+}
+
+TEST_P(SchedulerDeadlockSanitityCheck, ParallelRunsDoNotEndInDeadlock)
+{
+   const auto instrumented_executable = scheduler::instrument(
+      detail::test_programs_dir / GetParam().test_program, test_output_dir() / "instrumented",
+      GetParam().optimization_level, GetParam().compiler_options);
+
+   scheduler::parallel_options_t options;
+   options.nr_workers = 4;
+   options.timeout = std::chrono::milliseconds(3000);
+   options.work_dir = test_output_dir() / "work";
+   options.output_dir = test_output_dir() / "parallel_records";
+   scheduler::parallel_driver driver(instrumented_executable,
+                                     scheduler::SchedulerSettings("Random"), options);
+   for (int i = 0; i < 500; ++i)
+      driver.submit({});
+
+   const auto results = driver.finish();
+   ASSERT_EQ(500u, results.size());
+   for (const auto& result : results)
+   {
+      ASSERT_TRUE(result.outcome);
+      EXPECT_NE(program_model::Execution::Status::DEADLOCK, result.outcome->status);
+   }
+}
+
 INSTANTIATE_TEST_CASE_P(
    RealWorldPrograms, SchedulerDeadlockSanitityCheck,
    ::testing::Values(                                                                       //